@@ -36,12 +36,17 @@ CAENVX2750PhaTrigger::CAENVX2750PhaTrigger(VX2750EventSegment& module) :
 
 /**
  * operator()
+ *    The time taken by the check and whether it found data are recorded
+ *    in the module's readout statistics.
  *    @return bool - true if the module has data to read.
  */
 bool
 CAENVX2750PhaTrigger::operator()()
 {
-    return m_module.getModule()->hasData();
+    std::uint64_t start = VX2750ModuleStatistics::now();
+    bool result = m_module.getModule()->hasData();
+    m_module.getStatistics().poll(VX2750ModuleStatistics::now() - start, result);
+    return result;
 }
 /**
  * return reference to the module:
@@ -49,6 +49,7 @@ void set_tracing(bool onoff) {   // always legal but no-op if no tracing compile
     if (enableTracing && (!logfile_established)) {
         daqlog::setLogFile(logfile);
         daqlog::setLogLevel(daqlog::Trace);
+        daqlog::setAsynchronous(true);   // Don't stall readout on the log file.
         logfile_established = true;
     }
 #endif
@@ -68,7 +69,8 @@ void set_tracing(bool onoff) {   // always legal but no-op if no tracing compile
      *        include textual error information from FELib.
      */
     Dig2Device::Dig2Device(const char* hostOrPid, bool isusb) :
-        m_deviceHandle(0), m_endpointHandle(0)   // start with invalid values.
+        m_deviceHandle(0), m_endpointHandle(0),   // start with invalid values.
+        m_readTimeouts(0)
     {
         std::stringstream uristream;
         uristream << scheme << "://";
@@ -684,6 +686,7 @@ void set_tracing(bool onoff) {   // always legal but no-op if no tracing compile
         // we'll get Stop.
         
 
+        if (status == CAEN_FELib_Timeout) m_readTimeouts++;
         if ((status == CAEN_FELib_Timeout ) ||  (status == CAEN_FELib_Stop)) return false;
         if((status != CAEN_FELib_Success) ) {
             std::stringstream strMessage;
@@ -40,6 +40,7 @@ namespace caen_nscldaq {
     private:
         std::uint64_t m_deviceHandle;
         std::uint64_t m_endpointHandle;
+        mutable std::uint64_t m_readTimeouts;   // ReadData calls that timed out.
     public:
         Dig2Device(const char* hostOrPid, bool isUsb = false);
         virtual ~Dig2Device();
@@ -119,6 +120,7 @@ namespace caen_nscldaq {
         bool ReadData(int timeout, int argc, void** argv) const;
         bool hasData() const;
                              // True if a device has data.
+        std::uint64_t getReadTimeouts() const { return m_readTimeouts; }
                              
     private:
         std::string devPath(const char* devParName) const;
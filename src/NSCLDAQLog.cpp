@@ -29,6 +29,13 @@
 #include <time.h>
 #include <string.h>
 #include <ios>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
 
 #ifdef HAVE_BOOST_LOG
 
@@ -48,6 +55,13 @@ static daqlog::logLevel defaultLevel(daqlog::Info);
 static daqlog::logLevel loggingLevel(defaultLevel);
 static std::string logFile;
 
+// Asynchronous logging policy (see daqlog::setAsynchronous and
+// daqlog::setFlushPolicy).
+
+static std::atomic<bool> asynchronous(false);
+static std::atomic<unsigned> flushMilliseconds(250);  // The writer reads these.
+static std::atomic<size_t>   flushBytes(64*1024);
+
 // Since no header is supplied, this class is only used by
 // the api exported by NSCLDAQLog.h
 
@@ -58,6 +72,32 @@ static std::string logFile;
 
 namespace daqlog {
   void reset();
+  
+    /**
+     * A formatted message waiting for the asynchronous writer.
+     */
+    struct LogRecord {
+        std::atomic<LogRecord*> s_pNext;
+        logLevel                s_level;
+        std::string             s_text;
+    };
+    /**
+     *  LogQueue
+     *     Lock-free multiple producer, single consumer queue of log records
+     *     (D. Vyukov's intrusive MPSC queue).  push never blocks or spins
+     *     so any thread can log.  Only the writer thread may pop.
+     */
+    class LogQueue {
+    private:
+        std::atomic<LogRecord*> m_pHead;       // Most recently pushed.
+        LogRecord*              m_pTail;       // Next to pop (consumer only).
+        LogRecord               m_stub;
+    public:
+        LogQueue();
+        void       push(LogRecord* pRecord);
+        LogRecord* pop();
+    };
+    
     class BoostLogWrapper {
 #ifdef HAVE_BOOST_LOG
     private:
@@ -65,24 +105,111 @@ namespace daqlog {
 #endif
     private:
         static BoostLogWrapper* m_pInstance;
+        
+        // Asynchronous writer:
+        
+        LogQueue                 m_queue;
+        std::atomic<std::thread*> m_pWriter;
+        std::mutex               m_writerLock;     // start/stop of the writer.
+        std::mutex               m_wakeLock;
+        std::condition_variable  m_wake;           // Writer waits on this.
+        std::condition_variable  m_flushed;        // flush() waits on this.
+        std::atomic<bool>        m_urgent;
+        std::atomic<bool>        m_stopping;       // Writer: drain and exit.
+        std::atomic<bool>        m_closing;        // Log: don't queue.
+        std::atomic<unsigned>    m_producers;      // Logs deciding to queue.
+        std::atomic<size_t>      m_pendingBytes;
+        std::atomic<unsigned long> m_queued;       // Records pushed.
+        unsigned long            m_written;        // Records written+flushed.
+        unsigned long            m_flushTarget;    // Wanted by flush().
+        
         BoostLogWrapper();
     public:
+        ~BoostLogWrapper();
         static BoostLogWrapper* getInstance();
         void Log(logLevel level, const char* msg);
         void Log(logLevel level, const std::string& msg) {
             Log(level, msg.c_str());
         }
+        void flush();
+        void stopWriter();
     public:
 #ifdef HAVE_BOOST_LOG
         static boost::log::trivial::severity_level mapSeverity(logLevel level);
 #endif
     static const char* severityString(logLevel level);
+    private:
+        void format(std::string& result, logLevel level, const char* msg);
+        void emit(logLevel level, const std::string& text);
+        void flushSink();
+        void startWriter();
+        void wakeWriter();
+        void writer();
+        static void atExit();
 
     friend void daqlog::reset();
+    friend void daqlog::setAsynchronous(bool);
 };                           // daqlog::BoostLogWrapper
 
 };                           // daqlog
 
+// Implementation of daqlog::LogQueue
+
+/**
+ * constructor
+ *    The queue always contains at least the stub record.
+ */
+daqlog::LogQueue::LogQueue() :
+    m_pHead(&m_stub), m_pTail(&m_stub)
+{
+    m_stub.s_pNext.store(nullptr, std::memory_order_relaxed);
+}
+/**
+ * push
+ *    Add a record to the queue.  Wait free: one atomic exchange and a store.
+ *  @param pRecord - the record.  The queue (really its consumer) now owns it.
+ */
+void
+daqlog::LogQueue::push(LogRecord* pRecord)
+{
+    pRecord->s_pNext.store(nullptr, std::memory_order_relaxed);
+    LogRecord* pPrior = m_pHead.exchange(pRecord, std::memory_order_acq_rel);
+    pPrior->s_pNext.store(pRecord, std::memory_order_release);
+}
+/**
+ * pop
+ *    Remove the oldest record.
+ *  @return LogRecord* - the record, which the caller must delete, or nullptr
+ *          if the queue is empty (or a push is in the middle of linking in
+ *          the only remaining record; that one will be there next time).
+ */
+daqlog::LogRecord*
+daqlog::LogQueue::pop()
+{
+    LogRecord* pTail = m_pTail;
+    LogRecord* pNext = pTail->s_pNext.load(std::memory_order_acquire);
+    if (pTail == &m_stub) {
+        if (!pNext) return nullptr;
+        m_pTail = pNext;
+        pTail   = pNext;
+        pNext   = pNext->s_pNext.load(std::memory_order_acquire);
+    }
+    if (pNext) {
+        m_pTail = pNext;
+        return pTail;
+    }
+    if (pTail != m_pHead.load(std::memory_order_acquire)) {
+        return nullptr;                      // Push in progress.
+    }
+    push(&m_stub);
+    pNext = pTail->s_pNext.load(std::memory_order_acquire);
+    if (pNext) {
+        m_pTail = pNext;
+        return pTail;
+    }
+    return nullptr;
+}
+
 // Implementation of daqlog::BoostLogWrapper
 
 daqlog::BoostLogWrapper* daqlog::BoostLogWrapper::m_pInstance(0);
@@ -94,7 +221,11 @@ daqlog::BoostLogWrapper* daqlog::BoostLogWrapper::m_pInstance(0);
  *      filter.
  *  @note this is private invoked by getInstance when m_pInstance is null.
  */
-daqlog::BoostLogWrapper::BoostLogWrapper()
+daqlog::BoostLogWrapper::BoostLogWrapper() :
+    m_pWriter(nullptr), m_urgent(false), m_stopping(false), m_closing(false),
+    m_producers(0),
+    m_pendingBytes(0),
+    m_queued(0), m_written(0), m_flushTarget(0)
 {
     if (logFile.empty()) {
         throw std::logic_error("daqlog::BoostLogWrapper - no log file set");
@@ -130,32 +261,295 @@ daqlog::BoostLogWrapper::getInstance()
     
     return m_pInstance;
 }
+/**
+ * destructor
+ *    Writes anything still queued before going away.
+ */
+daqlog::BoostLogWrapper::~BoostLogWrapper()
+{
+    stopWriter();
+}
 /**
  * Log
  *   The heart of the logging subsystem;
  *   If HAVE_BOOST_LOG Is set, then we can log via the BOOST_LOG_TRIVIAL macro
  *   we just need to map the loggingLevel to the boost severity level.
  *
+ *   In asynchronous mode the message is formatted and queued for the writer
+ *   thread; we never wait on the file.  Error messages wake the writer at
+ *   once and Fatal messages wait until they've been flushed to the file
+ *   since the program is most likely about to exit.
+ *
+ *   A message is only queued while the writer is running and not being
+ *   stopped.  stopWriter waits for Logs that have decided to queue before
+ *   letting the writer do its final drain, so nothing can be queued after
+ *   it and left behind.  Otherwise the message is written directly.
+ *
  * @param level - the daqlog::logLevel at which to log.
  * @param msg   - the messgae to log.
  */
 void
 daqlog::BoostLogWrapper::Log(daqlog::logLevel level, const char*msg)
+{
+    if (level < loggingLevel) return;          // Don't bother formatting.
+    
+    if (asynchronous.load() && !m_pWriter) startWriter();
+    
+    // Counting ourselves before looking at m_closing (both sequentially
+    // consistent) means stopWriter either sees us or we see it closing:
+    
+    bool   queued  = false;
+    size_t bytes   = 0;
+    size_t pending = 0;
+    m_producers.fetch_add(1);
+    if (asynchronous.load() && m_pWriter && !m_closing.load()) {
+        LogRecord* pRecord = new LogRecord;
+        pRecord->s_level = level;
+        format(pRecord->s_text, level, msg);
+        bytes   = pRecord->s_text.size();       // The writer owns it once pushed.
+        pending = m_pendingBytes.fetch_add(bytes) + bytes;
+        m_queue.push(pRecord);
+        m_queued.fetch_add(1, std::memory_order_release);
+        queued = true;
+    }
+    m_producers.fetch_sub(1);
+    
+    if (queued) {
+        size_t limit = flushBytes.load();
+        if (level == Fatal) {
+            flush();
+        } else if ((level == Error) || ((pending >= limit) && (pending - bytes < limit))) {
+            wakeWriter();
+        }
+    } else {
+        std::string text;
+        format(text, level, msg);
+        emit(level, text);
+        flushSink();
+    }
+}
+/**
+ * flush
+ *    Wait until everything logged before the call has been written and
+ *    flushed to the log file.  Returns at once when not logging
+ *    asynchronously.
+ */
+void
+daqlog::BoostLogWrapper::flush()
+{
+    if (!m_pWriter) return;
+    
+    std::unique_lock<std::mutex> lock(m_wakeLock);
+    unsigned long target = m_queued.load(std::memory_order_acquire);
+    if (target > m_flushTarget) m_flushTarget = target;
+    m_urgent = true;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [this, target]() {
+        return (m_written >= target) || !m_pWriter;
+    });
+}
+/**
+ * stopWriter
+ *    Stop the asynchronous writer thread (if running) after it has written
+ *    everything that has been queued.  Logs made while it's stopping are
+ *    written directly.  Subsequent messages are queued again if
+ *    asynchronous logging is still enabled.
+ */
+void
+daqlog::BoostLogWrapper::stopWriter()
+{
+    std::lock_guard<std::mutex> guard(m_writerLock);
+    std::thread* pWriter = m_pWriter;
+    if (pWriter) {
+        // Logs that decided to queue before they could see m_closing
+        // must have pushed before the writer's final drain:
+        
+        m_closing = true;
+        while (m_producers.load()) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_wakeLock);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        pWriter->join();
+        delete pWriter;
+        {
+            std::lock_guard<std::mutex> lock(m_wakeLock);
+            m_pWriter = nullptr;
+            m_stopping = false;
+            m_closing  = false;
+        }
+        m_flushed.notify_all();
+    }
+}
+/**
+ * format
+ *    Produce the log line for a message.  ctime_r is only called when the
+ *    second changes (per thread).
+ *  @param result - receives the formatted line.
+ *  @param level  - message severity.
+ *  @param msg    - the message.
+ */
+void
+daqlog::BoostLogWrapper::format(std::string& result, logLevel level, const char* msg)
+{
+    static thread_local time_t lastTime(0);
+    static thread_local char   timebuf[64];
+    time_t now = time(nullptr);
+    if (now != lastTime) {
+        ctime_r(&now, timebuf);
+        timebuf[strlen(timebuf) - 1] = '\0';  // Kill the \n
+        lastTime = now;
+    }
+    const char* sev = severityString(level);
+    result.reserve(strlen(timebuf) + strlen(sev) + strlen(msg) + 8);
+    result = "(";
+    result += timebuf;
+    result += ")  ";
+    result += sev;
+    result += " : ";
+    result += msg;
+}
+/**
+ * emit
+ *    Hand a formatted line to boost logging.
+ */
+void
+daqlog::BoostLogWrapper::emit(logLevel level, const std::string& text)
 {
 #ifdef HAVE_BOOST_LOG
     boost::log::trivial::severity_level sev = mapSeverity(level);
-    time_t now = time(nullptr);
-    char timebuf[256];
-    ctime_r(&now, timebuf);
-    timebuf[strlen(timebuf) - 1] = '\0';  // Kill the \n
-    BOOST_LOG_STREAM_WITH_PARAMS(
-        ::boost::log::trivial::logger::get(),
-        (boost::log::keywords::severity = sev)
-    )
-     << "(" << timebuf << ")  " <<  severityString(level)  << " : "  << msg ;
+    auto& logger(::boost::log::trivial::logger::get());
+    boost::log::record rec = logger.open_record(boost::log::keywords::severity = sev);
+    if (rec) {
+        boost::log::record_ostream strm(rec);
+        strm << text;
+        strm.flush();
+        logger.push_record(boost::move(rec));
+    }
+#endif
+}
+/**
+ * flushSink
+ *    Flush the log file.
+ */
+void
+daqlog::BoostLogWrapper::flushSink()
+{
+#ifdef HAVE_BOOST_LOG
     m_pLogSink->flush();
 #endif
 }
+/**
+ * startWriter
+ *    Start the writer thread if it's not already running.  The first time,
+ *    arrange for queued messages to be written when the program exits.
+ */
+void
+daqlog::BoostLogWrapper::startWriter()
+{
+    static std::once_flag registered;
+    std::lock_guard<std::mutex> guard(m_writerLock);
+    if (!m_pWriter) {
+        std::call_once(registered, []() {
+#ifdef HAVE_BOOST_LOG
+            // Make sure boost's logger is constructed before we register
+            // so that it's still around when our handler runs:
+            
+            ::boost::log::trivial::logger::get();
+#endif
+            std::atexit(atExit);
+        });
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        m_pWriter = new std::thread([this]() { writer(); });
+    }
+}
+/**
+ * wakeWriter
+ *    Get the writer to drain the queue now rather than at its next
+ *    scheduled flush.  The lock is only held to set the flag so the writer
+ *    can't miss the notification.
+ */
+void
+daqlog::BoostLogWrapper::wakeWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        m_urgent = true;
+    }
+    m_wake.notify_one();
+}
+/**
+ * writer
+ *    Body of the writer thread.  Sleeps for the flush interval or until
+ *    woken, writes everything that's queued as one batch and flushes the
+ *    file once per batch.  Exits when stopping and the queue is empty.
+ */
+void
+daqlog::BoostLogWrapper::writer()
+{
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_wakeLock);
+            m_wake.wait_for(
+                lock, std::chrono::milliseconds(flushMilliseconds.load()),
+                [this]() {
+                    return m_urgent.load() || m_stopping.load() ||
+                        (m_written < m_flushTarget);
+                }
+            );
+            m_urgent = false;
+            stopping = m_stopping;
+        }
+        unsigned long nWritten = 0;
+        size_t        nBytes   = 0;
+        LogRecord* pRecord;
+        while ((pRecord = m_queue.pop())) {
+            emit(pRecord->s_level, pRecord->s_text);
+            nBytes += pRecord->s_text.size();
+            nWritten++;
+            delete pRecord;
+        }
+        if (nWritten) {
+            // Boost creates some of its per thread state the first time
+            // this thread logs.  Registering again now makes our handler
+            // run before that's destroyed:
+            
+            static std::once_flag registered;
+            std::call_once(registered, []() { std::atexit(atExit); });
+            flushSink();
+            m_pendingBytes.fetch_sub(nBytes);
+            std::lock_guard<std::mutex> lock(m_wakeLock);
+            m_written += nWritten;
+        }
+        m_flushed.notify_all();
+        
+        // A push that was mid-link when we drained is picked up by going
+        // around again:
+        
+        if (stopping && (m_written >= m_queued.load(std::memory_order_acquire))) {
+            break;
+        }
+    }
+}
+/**
+ * atExit
+ *    atexit handler - write whatever is still queued.  Anything logged
+ *    from here on (e.g. by destructors) is written directly since there
+ *    won't be a writer to drain it.
+ */
+void
+daqlog::BoostLogWrapper::atExit()
+{
+    asynchronous = false;
+    CriticalSection lock(instanceLock);
+    if (m_pInstance) {
+        m_pInstance->stopWriter();
+    }
+}
 /**
  * severityString
  *    Return a const char* pointing at a string matching the severit passed in.
@@ -269,6 +663,31 @@ daqlog::BoostLogWrapper::mapSeverity(daqlog::logLevel level)
     loggingLevel = level;
  }
  
+ void daqlog::setAsynchronous(bool enable)
+ {
+    asynchronous = enable;
+    if (!enable) {
+        // Anything already queued is written before we return:
+        
+        CriticalSection lock(instanceLock);
+        if (daqlog::BoostLogWrapper::m_pInstance) {
+            daqlog::BoostLogWrapper::m_pInstance->stopWriter();
+        }
+    }
+ }
+ 
+ void daqlog::setFlushPolicy(unsigned milliseconds, size_t bytes)
+ {
+    flushMilliseconds = milliseconds;
+    flushBytes        = bytes;
+ }
+ 
+ void daqlog::flush()
+ {
+    daqlog::BoostLogWrapper* pInstance = daqlog::BoostLogWrapper::getInstance();
+    pInstance->flush();
+ }
+ 
  // For testing.
  
  namespace daqlog {
@@ -276,6 +695,7 @@ daqlog::BoostLogWrapper::mapSeverity(daqlog::logLevel level)
  {
     loggingLevel = defaultLevel;
     logFile = "";
+    asynchronous = false;
     
     delete daqlog::BoostLogWrapper::m_pInstance;
     daqlog::BoostLogWrapper::m_pInstance = nullptr;
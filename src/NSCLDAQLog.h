@@ -22,6 +22,7 @@
 #ifndef DAQLOG_H
 #define DAQLOG_H
 #include <string>
+#include <cstddef>
 
 namespace daqlog {
     
@@ -71,5 +72,16 @@ namespace daqlog {
         setLogFile(filename.c_str());
     }
     
+    // Asynchronous logging.  Messages are formatted by the caller and
+    // queued to a writer thread that writes them in batches.  The file is
+    // flushed every milliseconds ms, or sooner once bytes of messages are
+    // waiting, and at once for Error and Fatal messages (the latter also
+    // wait for the flush).  flush() waits until everything logged so far
+    // is in the file.
+    
+    void setAsynchronous(bool enable);
+    void setFlushPolicy(unsigned milliseconds, size_t bytes);
+    void flush();
+    
 };
 #endif
\ No newline at end of file
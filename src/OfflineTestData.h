@@ -0,0 +1,122 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  OfflineTestData.h
+ *  @brief: Build event file data in memory for the offline tool tests.
+ */
+#ifndef OFFLINETESTDATA_H
+#define OFFLINETESTDATA_H
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace offline_test {
+
+typedef std::vector<std::uint8_t> Bytes;
+
+template<class T> void put(Bytes& b, T value)
+{
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&value);
+    b.insert(b.end(), p, p + sizeof(T));
+}
+inline void append(Bytes& b, const Bytes& more)
+{
+    b.insert(b.end(), more.begin(), more.end());
+}
+// A hit as VX2750EventSegment::read writes it preceded by its word count.
+// The analog probe 1 samples are 0, 10, 20...; digital probe n's samples
+// are n, n+1, n+2...
+
+inline Bytes hit(
+    const char* module, std::uint16_t channel, std::uint64_t ns,
+    std::uint16_t energy, std::uint32_t nSamples = 0
+)
+{
+    Bytes b;
+    put<std::uint32_t>(b, 0);
+    b.insert(b.end(), module, module + strlen(module) + 1);
+    if (b.size() % 2) b.push_back(0);
+    put<std::uint16_t>(b, channel);
+    put<std::uint64_t>(b, ns);
+    put<std::uint64_t>(b, ns/8);                    // raw timestamp.
+    put<std::uint16_t>(b, 3);                       // fine timestamp.
+    put<std::uint16_t>(b, energy);
+    put<std::uint16_t>(b, 0x11);                    // low priority flags.
+    put<std::uint16_t>(b, 0x22);                    // high priority flags.
+    put<std::uint16_t>(b, 1);                       // downsample.
+    put<std::uint16_t>(b, 0);                       // fail flags.
+    put<std::uint16_t>(b, 5);
+    put<std::uint32_t>(b, nSamples);
+    for (std::uint32_t i = 0; i < nSamples; i++) put<std::uint32_t>(b, i*10);
+    put<std::uint16_t>(b, 6);
+    put<std::uint32_t>(b, 0);
+    for (int p = 0; p < 4; p++) {
+        put<std::uint16_t>(b, p);
+        put<std::uint32_t>(b, nSamples);
+        for (std::uint32_t i = 0; i < nSamples; i++) b.push_back(p + i);
+    }
+    if (b.size() % 2) b.push_back(0);
+    std::uint32_t words = b.size()/sizeof(std::uint16_t);
+    memcpy(b.data(), &words, sizeof(words));
+    return b;
+}
+// A ring item, with a body header if sid >= 0:
+
+inline Bytes item(std::uint32_t type, const Bytes& body, int sid = -1, std::uint64_t ts = 0)
+{
+    Bytes b;
+    put<std::uint32_t>(b, 0);
+    put<std::uint32_t>(b, type);
+    if (sid >= 0) {
+        put<std::uint32_t>(b, 20);
+        put<std::uint64_t>(b, ts);
+        put<std::uint32_t>(b, sid);
+        put<std::uint32_t>(b, 0);
+    } else {
+        put<std::uint32_t>(b, 0);
+    }
+    append(b, body);
+    std::uint32_t size = b.size();
+    memcpy(b.data(), &size, sizeof(size));
+    return b;
+}
+// An event builder fragment whose payload is a physics item holding a hit:
+
+inline Bytes fragment(std::uint32_t sid, std::uint64_t ts, const Bytes& hitData)
+{
+    Bytes payload = item(30, hitData, sid, ts);
+    Bytes b;
+    put<std::uint64_t>(b, ts);
+    put<std::uint32_t>(b, sid);
+    put<std::uint32_t>(b, payload.size());
+    put<std::uint32_t>(b, 0);
+    append(b, payload);
+    return b;
+}
+// An event built body from fragments:
+
+inline Bytes built(const std::vector<Bytes>& fragments)
+{
+    Bytes b;
+    put<std::uint32_t>(b, 0);
+    for (auto& f : fragments) append(b, f);
+    std::uint32_t size = b.size();
+    memcpy(b.data(), &size, sizeof(size));
+    return b;
+}
+}                                   // offline_test namespace
+#endif
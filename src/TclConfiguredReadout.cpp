@@ -28,7 +28,8 @@
 #include <CAENVx2750PhaTrigger.h>
 #include <VX2750MultiModuleEventSegment.h>
 #include <VX2750TclConfig.h>
-#include <VX2750TclConfig.h>
+#include <VX2750ConnectionPool.h>
+#include <VX2750ConfigWatcher.h>
 
 #include <TCLInterpreter.h>
 #include <TCLVariable.h>
@@ -59,9 +60,25 @@ TclConfiguredReadout::TclConfiguredReadout(
     m_pCurrentTrigger(nullptr),
     m_pCurrentConfiguration(nullptr),
     m_pCurrentEventSegment(nullptr),
-    m_configFile(configFile)
+    m_configFile(configFile),
+    m_pConnections(new VX2750ConnectionPool),
+    m_pWatcher(new VX2750ConfigWatcher(configFile, "v27xxpha"))
 {
     memset(m_priorDigest, 0, sizeof(m_priorDigest));    // Force initial configuration.        
+    
+    // If we can't watch the file, fall back to processing it at initialize():
+    
+    try {
+        std::string snapshot = m_configFile + ".snapshot";
+        m_pWatcher->setSnapshotFile(snapshot.c_str());
+        m_pWatcher->start();
+    }
+    catch (std::exception& e) {
+        std::cerr << "Unable to watch " << configFile << " for changes: " << e.what()
+            << "\nThe configuration will be processed at each begin run\n";
+        delete m_pWatcher;
+        m_pWatcher = nullptr;
+    }
 }
 
 /**
@@ -71,11 +88,12 @@ TclConfiguredReadout::TclConfiguredReadout(
  *    as the program lifetime.
  */
 TclConfiguredReadout::~TclConfiguredReadout() {
+    delete m_pWatcher;                    // Stops the parse thread.
     delete m_pTrigger;
     deleteTrigger();
     delete m_pCurrentConfiguration;
     delete m_pCurrentEventSegment;
-    
+    delete m_pConnections;                // After the segments that use it.
 }
 //////////////////////////////////////////////////////////////////////////////
 // Define modules:
@@ -103,6 +121,7 @@ TclConfiguredReadout::addModule(
         .s_isUsb            = isUsb
     };
     m_modules.push_back(info);
+    if (m_pWatcher) m_pWatcher->addRequiredModule(name);
 }
 
 /**
@@ -151,12 +170,27 @@ TclConfiguredReadout::onBegin()
  * initialize
  *    Called just prior to data taking to do hardware initialization....
  *    which is called prior to beginning the run.
+ *    If the configuration file is being watched, it's already been parsed
+ *    and validated in the background and we just take the new configuration
+ *    if there is one.  Otherwise we re-process the file if its MD5 digest
+ *    changed.
+ *    Pooled connections to modules we no longer read out are closed.
  */
 void
 TclConfiguredReadout::initialize() {
+    VX2750TclConfig* pNewConfig(nullptr);
+    bool changed;
+    if (m_pWatcher) {
+        pNewConfig = m_pWatcher->takeStaged();   // Throws if the config is bad.
+        changed    = pNewConfig != nullptr;
+    } else {
+        changed = configChanged();
+    }
     // Kill off the previous readout stuff.
+    // If a prior attempt failed, there's no event segment and we must rebuild
+    // even if the file did not change.
     
-  if (configChanged()) {
+  if (changed || !m_pCurrentEventSegment) {
     m_pTrigger->clear();
     delete m_pCurrentConfiguration;
     m_pCurrentConfiguration = nullptr;
@@ -164,7 +198,11 @@ TclConfiguredReadout::initialize() {
     delete m_pCurrentEventSegment;
     m_pCurrentEventSegment = nullptr;
     
-    readConfiguration();         // Won't return on error
+    if (pNewConfig) {
+        m_pCurrentConfiguration = pNewConfig;
+    } else {
+        readConfiguration();     // Won't return on error
+    }
     checkModuleConfiguration();  // won't return on error.
     createTrigger();             // also create the modules in the trigger.
     
@@ -174,6 +212,14 @@ TclConfiguredReadout::initialize() {
     
     m_pCurrentEventSegment->setConfigChanged();
   }
+    std::vector<VX2750ConnectionPool::Key> connections;
+    for (auto& m : m_modules) {
+        connections.push_back(
+            VX2750ConnectionPool::Key(m.s_ConnectionString, m.s_isUsb)
+        );
+    }
+    m_pConnections->retain(connections);
+    
     m_pCurrentEventSegment->initialize();
     
 }
@@ -331,6 +377,7 @@ TclConfiguredReadout::checkModuleConfiguration() {
  *    - We create a new mutlmodule trigger.
  *    - We create a VX2750MultiModuleEventSegment
  *    - For each module in m_modules we make a VX2750EventSegment
+ *      which gets its connection from m_pConnections.
  *    - We create a trigger for that module and add it to the multimodule trigger.
  *
  */
@@ -343,7 +390,8 @@ TclConfiguredReadout::createTrigger() {
         auto pSegment =
             new VX2750EventSegment(
                 m_pExperiment, m.s_sourceId, m.s_name.c_str(),
-                m_pCurrentConfiguration, m.s_ConnectionString.c_str(), m.s_isUsb
+                m_pCurrentConfiguration, m.s_ConnectionString.c_str(), m.s_isUsb,
+                m_pConnections
         );
         auto pModuleTrigger = new CAENVX2750PhaTrigger(*pSegment);
         m_pCurrentTrigger->addTrigger(pModuleTrigger);
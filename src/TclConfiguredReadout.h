@@ -41,6 +41,8 @@ namespace caen_nscldaq {
     class VX2750MultiTrigger;
     class VX2750MultiModuleEventSegment;
     class VX2750TclConfig;
+    class VX2750ConnectionPool;
+    class VX2750ConfigWatcher;
 };
 
 /**
@@ -64,6 +66,11 @@ namespace caen_nscldaq {
  *       m_pCurrentConfiguration - the current configuration.
  *       m_pCurrentEventSegment  - multmodule event segment.
  *       m_configFile - Name of the configuration file.
+ *       m_pConnections - Module connections.  These outlive the event segments
+ *                     so a configuration change does not require reconnecting.
+ *       m_pWatcher - Parses/validates the configuration file in the background
+ *                     whenever it changes.  nullptr if that's not possible in
+ *                     which case the file is processed at initialize().
  *
  * @note The current VX2750MultiTrigger contains the individual modules.
  * 
@@ -86,6 +93,8 @@ private:
    caen_nscldaq::VX2750TclConfig*               m_pCurrentConfiguration;
    caen_nscldaq::VX2750MultiModuleEventSegment* m_pCurrentEventSegment;
    std::string                                  m_configFile;
+   caen_nscldaq::VX2750ConnectionPool*          m_pConnections;
+   caen_nscldaq::VX2750ConfigWatcher*           m_pWatcher;
    std::uint8_t                                 m_priorDigest[MD5_DIGEST_LENGTH];
 public:
     TclConfiguredReadout(const char* configFile, CExperiment* pExperiment);
@@ -0,0 +1,103 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ColumnFormat.cpp
+* @brief    Implement the non-template parts of the column format.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ColumnFormat.h"
+
+namespace caen_offline {
+
+const char VX2750ColumnFormat::MAGIC[8] = {'V', 'X', '2', '7', '5', '0', 'C', '1'};
+const std::uint32_t VX2750ColumnFormat::VERSION;
+const std::uint32_t VX2750ColumnFormat::GROUP_MAGIC;
+
+/**
+ * hitColumns
+ *    The columns VX2750ColumnWriter writes for hits.  The first columns
+ *    are the scalar hit fields.  The module is an index into the module
+ *    name dictionary.  Timestamps are delta encoded as they mostly increase.
+ *  @param traces - if true the trace columns follow: for each of
+ *             analog1, analog2, digital1..digital4 a type column (xxx.type),
+ *             a length column (xxx.n) and the samples (xxx).
+ *  @return std::vector<Column> - the columns.
+ */
+std::vector<VX2750ColumnFormat::Column>
+VX2750ColumnFormat::hitColumns(bool traces)
+{
+    std::vector<Column> result = {
+        {"module",        U16, VARINT},
+        {"sourceid",      U32, VARINT},
+        {"channel",       U16, VARINT},
+        {"timestamp",     U64, DELTA},
+        {"rawtimestamp",  U64, DELTA},
+        {"finetimestamp", U16, VARINT},
+        {"energy",        U16, VARINT},
+        {"lowflags",      U16, VARINT},
+        {"highflags",     U16, VARINT},
+        {"downsample",    U16, VARINT},
+        {"failflags",     U16, VARINT}
+    };
+    if (traces) {
+        const char* probes[6] = {
+            "analog1", "analog2", "digital1", "digital2", "digital3", "digital4"
+        };
+        for (int i = 0; i < 6; i++) {
+            std::string name(probes[i]);
+            Column type    = {name + ".type", U16, VARINT};
+            Column length  = {name + ".n", U32, VARINT};
+            Column samples = {name, i < 2 ? U32 : U8, i < 2 ? DELTA : PLAIN};
+            result.push_back(type);
+            result.push_back(length);
+            result.push_back(samples);
+        }
+    }
+    return result;
+}
+/**
+ * typeSize
+ *   @param type - a column type.
+ *   @return std::size_t - bytes in a PLAIN value of that type.
+ */
+std::size_t
+VX2750ColumnFormat::typeSize(Type type)
+{
+    switch (type) {
+    case U8:
+        return 1;
+    case U16:
+        return 2;
+    case U32:
+        return 4;
+    default:
+        return 8;
+    }
+}
+/**
+ * pad
+ *   @param bytes - a size.
+ *   @return std::size_t - bytes rounded up to a multiple of 8.
+ */
+std::size_t
+VX2750ColumnFormat::pad(std::size_t bytes)
+{
+    return (bytes + 7) & ~std::size_t(7);
+}
+}                                     // caen_offline namespace
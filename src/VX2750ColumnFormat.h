@@ -0,0 +1,274 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ColumnFormat.h
+* @brief    Layout and encodings of columnar hit files.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750COLUMNFORMAT_H
+#define VX2750COLUMNFORMAT_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace caen_offline {
+/**
+ * @class VX2750ColumnFormat
+ *    Describes the columnar hit file format written by VX2750ColumnWriter
+ *    and read by VX2750ColumnReader.  All integers are little endian.
+ *
+ *\verbatim
+ *    +------------------------------------+
+ *    | "VX2750C1"                         |  magic
+ *    | uint32_t version, uint32_t columns |
+ *    | per column: uint8_t type,          |
+ *    |   uint8_t codec, uint16_t name     |
+ *    |   length, name                     |
+ *    |   (padded to 8 bytes)              |
+ *    +------------------------------------+
+ *    | Row group                          |  repeated
+ *    |   uint32_t 'VXRG', uint32_t rows   |
+ *    |   uint64_t event file offset of    |
+ *    |            the first hit           |
+ *    |   per column: ColumnChunk          |
+ *    |   column data, each padded to 8    |
+ *    +------------------------------------+
+ *    | module name dictionary:            |
+ *    |   uint32_t count, then per name    |
+ *    |   uint16_t length, name            |
+ *    | uint64_t row group offsets         |
+ *    | Trailer                            |
+ *    +------------------------------------+
+ *\endverbatim
+ *
+ *    Each row group has its own directory of column chunks so readers can
+ *    find any column of any group without touching the others.  Together
+ *    with the per chunk minimum and maximum, whole groups or columns (e.g.
+ *    traces) can be skipped.  Offsets are from the start of the file.
+ *
+ *    The schema gives each column's codec.  A column chunk whose values
+ *    are mostly runs of the same value (e.g. module or flags) is written RLE
+ *    instead; the chunk's directory entry gives the codec actually used.
+ *
+ *    Trace columns are list columns: a column of lengths (one per row),
+ *    named e.g. analog1.n, and a column of the concatenated samples
+ *    (analog1).
+ */
+class VX2750ColumnFormat {
+public:
+    static const char          MAGIC[8];
+    static const std::uint32_t VERSION = 1;
+    static const std::uint32_t GROUP_MAGIC = 0x47525856;     // "VXRG"
+
+    enum Type  { U8 = 0, U16 = 1, U32 = 2, U64 = 3 };
+    enum Codec {
+        PLAIN = 0,            // Fixed width.
+        VARINT = 1,           // LEB128.
+        DELTA = 2,            // LEB128 of zigzagged differences.
+        RLE = 3               // LEB128 value, LEB128 run length pairs.
+    };
+
+    struct Column {
+        std::string s_name;
+        Type        s_type;
+        Codec       s_codec;
+    };
+#pragma pack(push, 1)
+    struct ColumnChunk {
+        std::uint32_t s_codec;          // Codec actually used for this chunk.
+        std::uint32_t s_unused;
+        std::uint64_t s_offset;
+        std::uint64_t s_bytes;
+        std::uint64_t s_nValues;
+        std::uint64_t s_min;
+        std::uint64_t s_max;
+    };
+    struct GroupHeader {
+        std::uint32_t s_magic;
+        std::uint32_t s_rows;
+        std::uint64_t s_firstItemOffset;
+    };
+    struct Trailer {
+        std::uint64_t s_dictionaryOffset;
+        std::uint64_t s_groupTableOffset;
+        std::uint64_t s_nGroups;
+        std::uint64_t s_nRows;
+        char          s_magic[8];
+    };
+#pragma pack(pop)
+
+    static std::vector<Column> hitColumns(bool traces);
+    static std::size_t typeSize(Type type);
+    static std::size_t pad(std::size_t bytes);
+
+    template<class T>
+    static Codec chooseCodec(Codec codec, const T* pValues, std::size_t n);
+
+    template<class T>
+    static void encode(
+        Codec codec, Type type, const T* pValues, std::size_t n,
+        std::vector<std::uint8_t>& out, std::uint64_t& min, std::uint64_t& max
+    );
+    template<class T>
+    static void decode(
+        Codec codec, Type type, const std::uint8_t* p, std::size_t bytes,
+        std::size_t n, T* pValues
+    );
+private:
+    static void putVarint(std::uint64_t v, std::vector<std::uint8_t>& out) {
+        while (v >= 0x80) {
+            out.push_back((v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        out.push_back(v);
+    }
+    static std::uint64_t getVarint(const std::uint8_t*& p, const std::uint8_t* pEnd) {
+        std::uint64_t v = 0;
+        unsigned shift = 0;
+        do {
+            if (p == pEnd || shift > 63) throw std::runtime_error("Column chunk is corrupt");
+            v |= std::uint64_t(*p & 0x7f) << shift;
+            shift += 7;
+        } while (*p++ & 0x80);
+        return v;
+    }
+};
+
+/**
+ * chooseCodec
+ *    Decide how to encode a column chunk.  Columns whose values are
+ *    mostly runs (fewer than one run per four values) are run length
+ *    encoded, others use the schema's codec.
+ *  @param codec   - the column's codec from the schema.
+ *  @param pValues - the values.
+ *  @param n       - how many.
+ *  @return Codec  - the codec to use.
+ */
+template<class T>
+VX2750ColumnFormat::Codec
+VX2750ColumnFormat::chooseCodec(Codec codec, const T* pValues, std::size_t n)
+{
+    std::size_t runs = n ? 1 : 0;
+    for (std::size_t i = 1; i < n; i++) {
+        if (pValues[i] != pValues[i-1]) runs++;
+    }
+    return (runs*4 < n) ? RLE : codec;
+}
+/**
+ * encode
+ *    Append encoded values to a buffer.
+ *  @param codec   - the encoding.
+ *  @param type    - the stored width (PLAIN only).
+ *  @param pValues - the values.
+ *  @param n       - how many.
+ *  @param out     - the encoded values are appended here.
+ *  @param[out] min, max - the smallest and largest value (0 if n is 0).
+ */
+template<class T>
+void
+VX2750ColumnFormat::encode(
+    Codec codec, Type type, const T* pValues, std::size_t n,
+    std::vector<std::uint8_t>& out, std::uint64_t& min, std::uint64_t& max
+)
+{
+    min = n ? ~std::uint64_t(0) : 0;
+    max = 0;
+    std::uint64_t prior = 0;
+    std::size_t width = typeSize(type);
+    for (std::size_t i = 0; i < n; i++) {
+        std::uint64_t v = pValues[i];
+        if (v < min) min = v;
+        if (v > max) max = v;
+        if (codec == RLE) {
+            std::uint64_t run = 1;
+            while (i + 1 < n && pValues[i+1] == pValues[i]) {
+                run++;
+                i++;
+            }
+            putVarint(v, out);
+            putVarint(run, out);
+            continue;
+        }
+        if (codec == PLAIN) {
+            for (std::size_t b = 0; b < width; b++) {
+                out.push_back(v >> (8*b));
+            }
+            continue;
+        }
+        if (codec == DELTA) {
+            std::int64_t d = static_cast<std::int64_t>(v - prior);
+            prior = v;
+            v = (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63);
+        }
+        putVarint(v, out);
+    }
+}
+/**
+ * decode
+ *    Decode a column chunk.
+ *  @param codec   - the encoding.
+ *  @param type    - the stored width (PLAIN only).
+ *  @param p       - the encoded data.
+ *  @param bytes   - its size.
+ *  @param n       - number of values to decode.
+ *  @param pValues - where the values go (n of them).
+ *  @throw std::runtime_error - the data runs out before n values are decoded.
+ */
+template<class T>
+void
+VX2750ColumnFormat::decode(
+    Codec codec, Type type, const std::uint8_t* p, std::size_t bytes,
+    std::size_t n, T* pValues
+)
+{
+    const std::uint8_t* pEnd = p + bytes;
+    std::uint64_t prior = 0;
+    std::size_t width = typeSize(type);
+    for (std::size_t i = 0; i < n; i++) {
+        std::uint64_t v = 0;
+        if (codec == RLE) {
+            v = getVarint(p, pEnd);
+            std::uint64_t run = getVarint(p, pEnd);
+            if (run == 0 || run > n - i) throw std::runtime_error("Column chunk is corrupt");
+            for (std::uint64_t r = 0; r < run; r++) {
+                pValues[i++] = static_cast<T>(v);
+            }
+            i--;
+            continue;
+        }
+        if (codec == PLAIN) {
+            if (std::size_t(pEnd - p) < width) throw std::runtime_error("Column chunk is truncated");
+            for (std::size_t b = 0; b < width; b++) {
+                v |= std::uint64_t(p[b]) << (8*b);
+            }
+            p += width;
+        } else {
+            v = getVarint(p, pEnd);
+            if (codec == DELTA) {
+                prior += (v >> 1) ^ (~(v & 1) + 1);
+                v = prior;
+            }
+        }
+        pValues[i] = static_cast<T>(v);
+    }
+}
+}                                     // caen_offline namespace
+#endif
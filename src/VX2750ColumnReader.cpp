@@ -0,0 +1,239 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ColumnReader.cpp
+* @brief    Implement the columnar hit file reader.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ColumnReader.h"
+#include <stdexcept>
+#include <system_error>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace caen_offline {
+
+/**
+ * constructor
+ *    Map the file and read its schema, dictionary and group table.
+ *  @param filename - the file.
+ *  @throw std::system_error - the file can't be opened or mapped.
+ *  @throw std::runtime_error - the file isn't a complete columnar hit file.
+ */
+VX2750ColumnReader::VX2750ColumnReader(const char* filename) :
+    m_filename(filename), m_pData(nullptr), m_size(0), m_rows(0)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info)) {
+        int e = errno;
+        close(fd);
+        throw std::system_error(e, std::generic_category(), filename);
+    }
+    m_size = info.st_size;
+    if (m_size < sizeof(VX2750ColumnFormat::Trailer)) {
+        close(fd);
+        invalid("too small");
+    }
+    void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int e = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+        throw std::system_error(e, std::generic_category(), filename);
+    }
+    m_pData = reinterpret_cast<const std::uint8_t*>(p);
+
+    try {
+        parse();
+    }
+    catch (...) {
+        munmap(p, m_size);
+        throw;
+    }
+}
+/**
+ * destructor
+ */
+VX2750ColumnReader::~VX2750ColumnReader()
+{
+    munmap(const_cast<std::uint8_t*>(m_pData), m_size);
+}
+/**
+ * findColumn
+ *   @param name - a column name.
+ *   @return int - its index or -1 if there's no such column.
+ */
+int
+VX2750ColumnReader::findColumn(const std::string& name) const
+{
+    for (std::size_t i = 0; i < m_columns.size(); i++) {
+        if (m_columns[i].s_name == name) return i;
+    }
+    return -1;
+}
+/**
+ * groupHeader
+ *   @param group - row group index.
+ *   @return const GroupHeader& - its header.
+ *   @throw std::out_of_range - no such group.
+ */
+const VX2750ColumnFormat::GroupHeader&
+VX2750ColumnReader::groupHeader(std::size_t group) const
+{
+    return *reinterpret_cast<const VX2750ColumnFormat::GroupHeader*>(
+        m_pData + m_groups.at(group)
+    );
+}
+/**
+ * columnChunk
+ *   @param group  - row group index.
+ *   @param column - column index.
+ *   @return const ColumnChunk& - where the column's data is in the group
+ *            and its statistics.
+ *   @throw std::out_of_range - no such group or column.
+ */
+const VX2750ColumnFormat::ColumnChunk&
+VX2750ColumnReader::columnChunk(std::size_t group, std::size_t column) const
+{
+    if (column >= m_columns.size()) {
+        throw std::out_of_range("Column index out of range");
+    }
+    const std::uint8_t* pGroup = m_pData + m_groups.at(group);
+    return reinterpret_cast<const VX2750ColumnFormat::ColumnChunk*>(
+        pGroup + sizeof(VX2750ColumnFormat::GroupHeader)
+    )[column];
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * parse
+ *    Read the header and footer.  Everything is checked against the file
+ *    size so later accesses don't need to be.
+ */
+void
+VX2750ColumnReader::parse()
+{
+    // Header and schema:
+
+    const std::uint8_t* p = m_pData;
+    const std::uint8_t* pEnd = m_pData + m_size;
+    if (memcmp(p, VX2750ColumnFormat::MAGIC, sizeof(VX2750ColumnFormat::MAGIC))) {
+        invalid("bad magic number");
+    }
+    p += sizeof(VX2750ColumnFormat::MAGIC);
+    std::uint32_t counts[2];
+    memcpy(counts, p, sizeof(counts));
+    p += sizeof(counts);
+    if (counts[0] != VX2750ColumnFormat::VERSION) invalid("unsupported version");
+    for (std::uint32_t i = 0; i < counts[1]; i++) {
+        if (pEnd - p < 4) invalid("truncated schema");
+        VX2750ColumnFormat::Column c;
+        c.s_type  = static_cast<VX2750ColumnFormat::Type>(p[0]);
+        c.s_codec = static_cast<VX2750ColumnFormat::Codec>(p[1]);
+        std::uint16_t length = p[2] | (p[3] << 8);
+        p += 4;
+        if (pEnd - p < length) invalid("truncated schema");
+        if (c.s_type > VX2750ColumnFormat::U64 || c.s_codec > VX2750ColumnFormat::RLE) {
+            invalid("unknown column type or codec");
+        }
+        c.s_name.assign(reinterpret_cast<const char*>(p), length);
+        p += length;
+        m_columns.push_back(c);
+    }
+
+    // Trailer, dictionary and group table:
+
+    VX2750ColumnFormat::Trailer trailer;
+    memcpy(&trailer, pEnd - sizeof(trailer), sizeof(trailer));
+    if (memcmp(trailer.s_magic, VX2750ColumnFormat::MAGIC, sizeof(trailer.s_magic))) {
+        invalid("no trailer (was the file closed?)");
+    }
+    std::uint64_t trailerOffset = m_size - sizeof(trailer);
+    if (trailer.s_groupTableOffset > trailerOffset ||
+        trailer.s_nGroups > (trailerOffset - trailer.s_groupTableOffset)/sizeof(std::uint64_t) ||
+        trailer.s_dictionaryOffset > trailer.s_groupTableOffset) {
+        invalid("corrupt trailer");
+    }
+    m_rows = trailer.s_nRows;
+
+    p = m_pData + trailer.s_dictionaryOffset;
+    const std::uint8_t* pDictEnd = m_pData + trailer.s_groupTableOffset;
+    if (pDictEnd - p < 4) invalid("truncated module dictionary");
+    std::uint32_t nModules;
+    memcpy(&nModules, p, sizeof(nModules));
+    p += sizeof(nModules);
+    for (std::uint32_t i = 0; i < nModules; i++) {
+        if (pDictEnd - p < 2) invalid("truncated module dictionary");
+        std::uint16_t length = p[0] | (p[1] << 8);
+        p += 2;
+        if (pDictEnd - p < length) invalid("truncated module dictionary");
+        m_modules.push_back(std::string(reinterpret_cast<const char*>(p), length));
+        p += length;
+    }
+
+    m_groups.resize(trailer.s_nGroups);
+    memcpy(
+        m_groups.data(), m_pData + trailer.s_groupTableOffset,
+        trailer.s_nGroups * sizeof(std::uint64_t)
+    );
+    std::size_t directoryBytes =
+        m_columns.size() * sizeof(VX2750ColumnFormat::ColumnChunk);
+    for (std::size_t g = 0; g < m_groups.size(); g++) {
+        if (m_groups[g] + sizeof(VX2750ColumnFormat::GroupHeader) + directoryBytes >
+            trailer.s_dictionaryOffset) {
+            invalid("row group offset out of range");
+        }
+        if (groupHeader(g).s_magic != VX2750ColumnFormat::GROUP_MAGIC) {
+            invalid("bad row group magic number");
+        }
+        for (std::size_t c = 0; c < m_columns.size(); c++) {
+            auto& chunk(columnChunk(g, c));
+            if (chunk.s_codec > VX2750ColumnFormat::RLE) {
+                invalid("unknown column chunk codec");
+            }
+            if (chunk.s_offset > trailer.s_dictionaryOffset ||
+                chunk.s_bytes > trailer.s_dictionaryOffset - chunk.s_offset) {
+                invalid("column chunk out of range");
+            }
+        }
+    }
+}
+/**
+ * invalid
+ *    Report an invalid file.
+ *  @param why - what's wrong with it.
+ *  @throw std::runtime_error - always.
+ */
+void
+VX2750ColumnReader::invalid(const char* why) const
+{
+    std::string msg = m_filename;
+    msg += ": not a valid columnar hit file: ";
+    msg += why;
+    throw std::runtime_error(msg);
+}
+}                                     // caen_offline namespace
@@ -0,0 +1,100 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ColumnReader.h
+* @brief    Read columnar hit files.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750COLUMNREADER_H
+#define VX2750COLUMNREADER_H
+#include "VX2750ColumnFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caen_offline {
+/**
+ * @class VX2750ColumnReader
+ *    Maps a columnar hit file (see VX2750ColumnFormat) and gives access to
+ *    its row groups column by column.  Only the column chunks that are read
+ *    are touched so, e.g., summing energies never pages in the traces.
+ *    The reader is immutable once constructed so several threads can read
+ *    groups at the same time.
+ */
+class VX2750ColumnReader {
+private:
+    std::string                             m_filename;
+    const std::uint8_t*                     m_pData;
+    std::size_t                             m_size;
+    std::vector<VX2750ColumnFormat::Column> m_columns;
+    std::vector<std::string>                m_modules;
+    std::vector<std::uint64_t>              m_groups;
+    std::uint64_t                           m_rows;
+public:
+    VX2750ColumnReader(const char* filename);
+    virtual ~VX2750ColumnReader();
+private:
+    VX2750ColumnReader(const VX2750ColumnReader&);
+    VX2750ColumnReader& operator=(const VX2750ColumnReader&);
+public:
+    const std::vector<VX2750ColumnFormat::Column>& getColumns() const {
+        return m_columns;
+    }
+    const std::vector<std::string>& getModules() const { return m_modules; }
+    std::size_t   groups() const { return m_groups.size(); }
+    std::uint64_t rows() const   { return m_rows; }
+
+    int findColumn(const std::string& name) const;
+    const VX2750ColumnFormat::GroupHeader& groupHeader(std::size_t group) const;
+    const VX2750ColumnFormat::ColumnChunk& columnChunk(
+        std::size_t group, std::size_t column
+    ) const;
+
+    template<class T>
+    void read(std::size_t group, std::size_t column, std::vector<T>& values) const;
+private:
+    void parse();
+    [[noreturn]] void invalid(const char* why) const;
+};
+/**
+ * read
+ *    Decode one column of a row group.
+ *  @param group  - the row group index.
+ *  @param column - the column index.
+ *  @param[out] values - the values (resized to fit).  T should be at least
+ *                as wide as the column's type.
+ *  @throw std::runtime_error - the chunk is corrupt.
+ */
+template<class T>
+void
+VX2750ColumnReader::read(
+    std::size_t group, std::size_t column, std::vector<T>& values
+) const
+{
+    auto& chunk(columnChunk(group, column));
+    auto& c(m_columns[column]);
+    values.resize(chunk.s_nValues);
+    VX2750ColumnFormat::decode(
+        static_cast<VX2750ColumnFormat::Codec>(chunk.s_codec), c.s_type,
+        m_pData + chunk.s_offset, chunk.s_bytes, chunk.s_nValues, values.data()
+    );
+}
+}                                     // caen_offline namespace
+#endif
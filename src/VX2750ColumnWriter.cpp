@@ -0,0 +1,378 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ColumnWriter.cpp
+* @brief    Implement the columnar hit file writer and exporter.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ColumnWriter.h"
+#include <stdexcept>
+#include <system_error>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+namespace caen_offline {
+
+const std::size_t VX2750ColumnExporter::DEFAULT_GROUP_ROWS;
+const std::size_t VX2750ColumnExporter::MAX_TRACE_BYTES;
+
+/**
+ * constructor
+ *    Create the file and write its header.
+ *  @param filename - file to create (truncated if it exists).
+ *  @param traces   - if true, trace columns are written.
+ *  @throw std::system_error - the file can't be created or written.
+ */
+VX2750ColumnWriter::VX2750ColumnWriter(const char* filename, bool traces) :
+    m_filename(filename), m_fd(-1), m_traces(traces),
+    m_columns(VX2750ColumnFormat::hitColumns(traces)),
+    m_offset(0), m_rows(0)
+{
+    m_fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (m_fd < 0) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+    std::vector<std::uint8_t> header(
+        VX2750ColumnFormat::MAGIC, VX2750ColumnFormat::MAGIC + sizeof(VX2750ColumnFormat::MAGIC)
+    );
+    std::uint32_t counts[2] = {VX2750ColumnFormat::VERSION, std::uint32_t(m_columns.size())};
+    header.insert(
+        header.end(), reinterpret_cast<std::uint8_t*>(counts),
+        reinterpret_cast<std::uint8_t*>(counts + 2)
+    );
+    for (auto& c : m_columns) {
+        header.push_back(c.s_type);
+        header.push_back(c.s_codec);
+        std::uint16_t length = c.s_name.size();
+        header.push_back(length & 0xff);
+        header.push_back(length >> 8);
+        header.insert(header.end(), c.s_name.begin(), c.s_name.end());
+    }
+    header.resize(VX2750ColumnFormat::pad(header.size()), 0);
+    try {
+        write(header.data(), header.size());
+    }
+    catch (...) {
+        ::close(m_fd);
+        throw;
+    }
+}
+/**
+ * destructor
+ *    If close was not called, the file is closed without its trailer, which
+ *    readers will reject.
+ */
+VX2750ColumnWriter::~VX2750ColumnWriter()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+/**
+ * moduleId
+ *    @param name - a module name.
+ *    @return std::uint16_t - its index in the module dictionary.  New names
+ *           are added.
+ */
+std::uint16_t
+VX2750ColumnWriter::moduleId(const char* name)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto p = m_moduleIds.find(name);
+    if (p != m_moduleIds.end()) return p->second;
+
+    std::uint16_t id = m_modules.size();
+    m_modules.push_back(name);
+    m_moduleIds[name] = id;
+    return id;
+}
+/**
+ * writeGroup
+ *    Write a row group built by an exporter.  The column chunk offsets
+ *    in the group are relative to the group and are made absolute here.
+ *  @param group - the group image.
+ *  @param rows  - rows in the group.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750ColumnWriter::writeGroup(std::vector<std::uint8_t>& group, std::uint32_t rows)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    VX2750ColumnFormat::ColumnChunk* pDirectory =
+        reinterpret_cast<VX2750ColumnFormat::ColumnChunk*>(
+            group.data() + sizeof(VX2750ColumnFormat::GroupHeader)
+        );
+    for (std::size_t i = 0; i < m_columns.size(); i++) {
+        pDirectory[i].s_offset += m_offset;
+    }
+    m_groupOffsets.push_back(m_offset);
+    m_rows += rows;
+    write(group.data(), group.size());
+}
+/**
+ * close
+ *    Write the module dictionary, group table and trailer and close the file.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750ColumnWriter::close()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_fd < 0) return;
+
+    std::vector<std::uint8_t> footer;
+    VX2750ColumnFormat::Trailer trailer;
+    trailer.s_dictionaryOffset = m_offset;
+
+    std::uint32_t count = m_modules.size();
+    footer.insert(
+        footer.end(), reinterpret_cast<std::uint8_t*>(&count),
+        reinterpret_cast<std::uint8_t*>(&count + 1)
+    );
+    for (auto& name : m_modules) {
+        std::uint16_t length = name.size();
+        footer.push_back(length & 0xff);
+        footer.push_back(length >> 8);
+        footer.insert(footer.end(), name.begin(), name.end());
+    }
+    footer.resize(VX2750ColumnFormat::pad(footer.size()), 0);
+
+    trailer.s_groupTableOffset = m_offset + footer.size();
+    trailer.s_nGroups = m_groupOffsets.size();
+    trailer.s_nRows = m_rows;
+    memcpy(trailer.s_magic, VX2750ColumnFormat::MAGIC, sizeof(trailer.s_magic));
+
+    const std::uint8_t* pGroups =
+        reinterpret_cast<const std::uint8_t*>(m_groupOffsets.data());
+    footer.insert(footer.end(), pGroups, pGroups + m_groupOffsets.size()*sizeof(std::uint64_t));
+    const std::uint8_t* pTrailer = reinterpret_cast<const std::uint8_t*>(&trailer);
+    footer.insert(footer.end(), pTrailer, pTrailer + sizeof(trailer));
+
+    write(footer.data(), footer.size());
+    if (::close(m_fd)) {
+        m_fd = -1;
+        throw std::system_error(errno, std::generic_category(), m_filename);
+    }
+    m_fd = -1;
+}
+/**
+ * write
+ *    Write a block of data, retrying partial writes.  Must be called with
+ *    m_lock held (or from the constructor).
+ *  @param pData - the data.
+ *  @param bytes - how much.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750ColumnWriter::write(const void* pData, std::size_t bytes)
+{
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(pData);
+    while (bytes) {
+        ssize_t n = ::write(m_fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), m_filename);
+        }
+        p       += n;
+        bytes   -= n;
+        m_offset += n;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+// VX2750ColumnExporter
+
+/**
+ * constructor
+ *  @param writer    - writes our row groups.
+ *  @param groupRows - rows per group.
+ */
+VX2750ColumnExporter::VX2750ColumnExporter(
+    VX2750ColumnWriter& writer, std::size_t groupRows
+) :
+    m_writer(writer), m_groupRows(groupRows ? groupRows : 1), m_rows(0),
+    m_firstItemOffset(0), m_traceBytes(0), m_lastModule(0)
+{
+    for (auto& c : m_scalars) c.reserve(m_groupRows);
+}
+/**
+ * destructor
+ *    Rows not flushed are lost.
+ */
+VX2750ColumnExporter::~VX2750ColumnExporter()
+{}
+/**
+ * hit
+ *    Add a hit to the row group, writing the group if it's full.
+ *  @param hit - the hit.
+ */
+void
+VX2750ColumnExporter::hit(const VX2750Hit& hit)
+{
+    if (m_rows == 0) m_firstItemOffset = hit.s_itemOffset;
+
+    std::uint64_t values[SCALAR_COLUMNS] = {
+        moduleId(hit.s_moduleName), hit.s_sourceId, hit.s_channel,
+        hit.s_timestamp, hit.s_rawTimestamp, hit.s_fineTimestamp,
+        hit.s_energy, hit.s_lowPriorityFlags, hit.s_highPriorityFlags,
+        hit.s_downSampleSelection, hit.s_failFlags
+    };
+    for (int i = 0; i < SCALAR_COLUMNS; i++) {
+        m_scalars[i].push_back(values[i]);
+    }
+    if (m_writer.hasTraces()) {
+        for (int i = 0; i < 2; i++) {
+            auto& probe(hit.s_analogProbes[i]);
+            m_probeTypes[i].push_back(probe.s_type);
+            m_probeLengths[i].push_back(probe.s_nSamples);
+            m_analog[i].insert(
+                m_analog[i].end(), probe.s_pSamples, probe.s_pSamples + probe.s_nSamples
+            );
+            m_traceBytes += probe.s_nSamples * sizeof(std::uint32_t);
+        }
+        for (int i = 0; i < 4; i++) {
+            auto& probe(hit.s_digitalProbes[i]);
+            m_probeTypes[i+2].push_back(probe.s_type);
+            m_probeLengths[i+2].push_back(probe.s_nSamples);
+            m_digital[i].insert(
+                m_digital[i].end(), probe.s_pSamples, probe.s_pSamples + probe.s_nSamples
+            );
+            m_traceBytes += probe.s_nSamples;
+        }
+    }
+    m_rows++;
+    if (m_rows >= m_groupRows || m_traceBytes >= MAX_TRACE_BYTES) {
+        flush();
+    }
+}
+/**
+ * flush
+ *    Encode and write the row group if it has any rows.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750ColumnExporter::flush()
+{
+    if (m_rows == 0) return;
+
+    auto& columns(m_writer.getColumns());
+    VX2750ColumnFormat::GroupHeader header;
+    header.s_magic = VX2750ColumnFormat::GROUP_MAGIC;
+    header.s_rows  = m_rows;
+    header.s_firstItemOffset = m_firstItemOffset;
+
+    std::size_t directory = sizeof(header);
+    std::size_t dataStart = VX2750ColumnFormat::pad(
+        directory + columns.size()*sizeof(VX2750ColumnFormat::ColumnChunk)
+    );
+    m_group.assign(dataStart, 0);
+    memcpy(m_group.data(), &header, sizeof(header));
+
+    unsigned c = 0;
+    for (int i = 0; i < SCALAR_COLUMNS; i++) {
+        addColumn(c++, m_scalars[i], directory);
+    }
+    if (m_writer.hasTraces()) {
+        for (int i = 0; i < 6; i++) {
+            addColumn(c++, m_probeTypes[i], directory);
+            addColumn(c++, m_probeLengths[i], directory);
+            if (i < 2) {
+                addColumn(c++, m_analog[i], directory);
+            } else {
+                addColumn(c++, m_digital[i-2], directory);
+            }
+        }
+    }
+    m_writer.writeGroup(m_group, m_rows);
+    clear();
+}
+/**
+ * moduleId
+ *    Module ids come from the writer.  We keep the ones we've seen and
+ *    check the last one first so the writer's lock is rarely needed.
+ *  @param name - module name.
+ *  @return std::uint16_t - its id.
+ */
+std::uint16_t
+VX2750ColumnExporter::moduleId(const char* name)
+{
+    if (m_lastModule < m_moduleCache.size() &&
+        m_moduleCache[m_lastModule].s_name == name) {
+        return m_moduleCache[m_lastModule].s_id;
+    }
+    for (m_lastModule = 0; m_lastModule < m_moduleCache.size(); m_lastModule++) {
+        if (m_moduleCache[m_lastModule].s_name == name) {
+            return m_moduleCache[m_lastModule].s_id;
+        }
+    }
+    Module m = {name, m_writer.moduleId(name)};
+    m_moduleCache.push_back(m);
+    return m.s_id;
+}
+/**
+ * clear
+ *    Empty the row group, keeping the storage.
+ */
+void
+VX2750ColumnExporter::clear()
+{
+    for (auto& c : m_scalars) c.clear();
+    for (auto& c : m_probeTypes) c.clear();
+    for (auto& c : m_probeLengths) c.clear();
+    for (auto& c : m_analog) c.clear();
+    for (auto& c : m_digital) c.clear();
+    m_rows = 0;
+    m_traceBytes = 0;
+}
+/**
+ * addColumn
+ *    Encode a column onto the end of the group and fill in its directory
+ *    entry.  The data are padded to 8 bytes.
+ *  @param index     - column index.
+ *  @param values    - the column's values.
+ *  @param directory - offset of the directory in the group.
+ */
+template<class T>
+void
+VX2750ColumnExporter::addColumn(
+    unsigned index, const std::vector<T>& values, std::size_t directory
+)
+{
+    auto& column(m_writer.getColumns()[index]);
+    VX2750ColumnFormat::ColumnChunk chunk;
+    chunk.s_codec   = VX2750ColumnFormat::chooseCodec(
+        column.s_codec, values.data(), values.size()
+    );
+    chunk.s_unused  = 0;
+    chunk.s_offset  = m_group.size();
+    chunk.s_nValues = values.size();
+    VX2750ColumnFormat::encode(
+        static_cast<VX2750ColumnFormat::Codec>(chunk.s_codec), column.s_type,
+        values.data(), values.size(), m_group,
+        chunk.s_min, chunk.s_max
+    );
+    chunk.s_bytes = m_group.size() - chunk.s_offset;
+    m_group.resize(VX2750ColumnFormat::pad(m_group.size()), 0);
+    memcpy(
+        m_group.data() + directory + index*sizeof(chunk), &chunk, sizeof(chunk)
+    );
+}
+}                                     // caen_offline namespace
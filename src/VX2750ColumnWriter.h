@@ -0,0 +1,123 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ColumnWriter.h
+* @brief    Write decoded hits to a columnar hit file.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750COLUMNWRITER_H
+#define VX2750COLUMNWRITER_H
+#include "VX2750ColumnFormat.h"
+#include "VX2750OfflineDecoder.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+namespace caen_offline {
+/**
+ * @class VX2750ColumnWriter
+ *    Owns a columnar hit file (see VX2750ColumnFormat).  Row groups are
+ *    built by VX2750ColumnExporter objects, normally one per decoding
+ *    thread, and written as they fill.  Writing groups and assigning module
+ *    ids are thread-safe.  Groups from different threads are written in the
+ *    order they fill; each group records the event file offset of its first
+ *    hit so file order can be restored.
+ */
+class VX2750ColumnWriter {
+private:
+    std::string                            m_filename;
+    int                                    m_fd;
+    bool                                   m_traces;
+    std::vector<VX2750ColumnFormat::Column> m_columns;
+
+    std::mutex                             m_lock;
+    std::uint64_t                          m_offset;       // Next write offset.
+    std::vector<std::uint64_t>             m_groupOffsets;
+    std::uint64_t                          m_rows;
+    std::map<std::string, std::uint16_t>   m_moduleIds;
+    std::vector<std::string>               m_modules;
+public:
+    VX2750ColumnWriter(const char* filename, bool traces);
+    virtual ~VX2750ColumnWriter();
+private:
+    VX2750ColumnWriter(const VX2750ColumnWriter&);
+    VX2750ColumnWriter& operator=(const VX2750ColumnWriter&);
+public:
+    bool hasTraces() const { return m_traces; }
+    const std::vector<VX2750ColumnFormat::Column>& getColumns() const {
+        return m_columns;
+    }
+
+    std::uint16_t moduleId(const char* name);
+    void          writeGroup(std::vector<std::uint8_t>& group, std::uint32_t rows);
+    void          close();
+private:
+    void write(const void* pData, std::size_t bytes);
+};
+/**
+ * @class VX2750ColumnExporter
+ *    A hit visitor that collects hits into a row group and gives the group
+ *    to a VX2750ColumnWriter when it has enough rows (or, with traces, enough
+ *    trace data).  Call flush once decoding is done to write the partial
+ *    last group.
+ */
+class VX2750ColumnExporter : public VX2750HitVisitor {
+public:
+    static const std::size_t DEFAULT_GROUP_ROWS = 65536;
+    static const std::size_t MAX_TRACE_BYTES = 64*1024*1024;
+private:
+    enum { SCALAR_COLUMNS = 11 };
+    struct Module {
+        std::string   s_name;
+        std::uint16_t s_id;
+    };
+
+    VX2750ColumnWriter&        m_writer;
+    std::size_t                m_groupRows;
+    std::size_t                m_rows;
+    std::uint64_t              m_firstItemOffset;
+    std::vector<std::uint64_t> m_scalars[SCALAR_COLUMNS];
+    std::vector<std::uint64_t> m_probeTypes[6];
+    std::vector<std::uint64_t> m_probeLengths[6];
+    std::vector<std::uint32_t> m_analog[2];
+    std::vector<std::uint8_t>  m_digital[4];
+    std::size_t                m_traceBytes;
+    std::vector<Module>        m_moduleCache;
+    unsigned                   m_lastModule;
+    std::vector<std::uint8_t>  m_group;
+public:
+    VX2750ColumnExporter(
+        VX2750ColumnWriter& writer, std::size_t groupRows = DEFAULT_GROUP_ROWS
+    );
+    virtual ~VX2750ColumnExporter();
+
+    virtual void hit(const VX2750Hit& hit);
+    void flush();
+private:
+    std::uint16_t moduleId(const char* name);
+    void clear();
+    template<class T>
+    void addColumn(
+        unsigned index, const std::vector<T>& values, std::size_t directory
+    );
+};
+}                                     // caen_offline namespace
+#endif
@@ -0,0 +1,427 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ConfigSnapshot.cpp
+* @brief    Implement binary configuration snapshots.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ConfigSnapshot.h"
+#include "VX2750PHAConfiguration.h"
+#include <openssl/md5.h>
+#include <stdexcept>
+#include <memory>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+namespace caen_nscldaq {
+
+static const char MAGIC[8] = {'V', 'X', '2', '7', 'S', 'N', 'A', 'P'};
+static_assert(MD5_DIGEST_LENGTH == 16, "Snapshot header digest size mismatch");
+
+/**
+ * constructor
+ *    Map the snapshot and index it.
+ * @param file - path to the snapshot file.
+ * @throw std::runtime_error - the file can't be opened/mapped or is not a
+ *        snapshot this version of the software understands.  Callers
+ *        should treat this as 'no snapshot' and process the configuration
+ *        file.
+ */
+VX2750ConfigSnapshot::VX2750ConfigSnapshot(const std::string& file) :
+    m_file(file), m_pMap(nullptr), m_size(0)
+{
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(file + ": " + strerror(errno));
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        int e = errno;
+        close(fd);
+        throw std::runtime_error(file + ": " + strerror(e));
+    }
+    m_size = info.st_size;
+    if (m_size < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error(file + " is too small to be a configuration snapshot");
+    }
+    m_pMap = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                         // The mapping keeps the file.
+    if (m_pMap == MAP_FAILED) {
+        m_pMap = nullptr;
+        throw std::runtime_error(file + ": mmap failed: " + strerror(errno));
+    }
+    // Check the header and index the snapshot:
+
+    try {
+        Header h;
+        memcpy(&h, m_pMap, sizeof(Header));
+        if (memcmp(h.s_magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error(file + " is not a configuration snapshot");
+        }
+        if ((h.s_version != VERSION) || (h.s_headerSize != sizeof(Header))) {
+            throw std::runtime_error(file + " is a snapshot from a different software version");
+        }
+        if (h.s_totalSize != m_size) {
+            throw std::runtime_error(file + " is truncated");
+        }
+        m_digest = std::string(reinterpret_cast<char*>(h.s_digest), sizeof(h.s_digest));
+
+        size_t offset = sizeof(Header);
+        for (int i = 0; i < h.s_nSources; i++) {
+            m_sources.push_back(getString(offset));
+        }
+        for (int i = 0; i < h.s_nModules; i++) {
+            std::string name = getString(offset);
+            m_moduleOffsets[name] = offset;
+
+            std::uint32_t nParams = getU32(offset);     // Skip the parameters.
+            for (int p = 0; p < nParams; p++) {
+                getString(offset);
+                getString(offset);
+            }
+        }
+    }
+    catch (...) {
+        unmap();
+        throw;
+    }
+}
+/**
+ * destructor
+ */
+VX2750ConfigSnapshot::~VX2750ConfigSnapshot()
+{
+    unmap();
+}
+/**
+ * isCurrent
+ *    @return bool - true if the source files and the parameter table still
+ *                  have the digest recorded in the snapshot.
+ */
+bool
+VX2750ConfigSnapshot::isCurrent() const
+{
+    return snapshotDigest(m_sources) == m_digest;
+}
+/**
+ * listModules
+ *   @return std::vector<std::string> - names of the modules in the snapshot.
+ */
+std::vector<std::string>
+VX2750ConfigSnapshot::listModules() const
+{
+    std::vector<std::string> result;
+    for (auto& m : m_moduleOffsets) {
+        result.push_back(m.first);
+    }
+    return result;
+}
+/**
+ * createModule
+ *    Create a module configuration from the snapshot.
+ * @param name - name of the module.
+ * @return VX2750PHAModuleConfiguration* - new configuration owned by the caller.
+ * @throw std::invalid_argument - no such module in the snapshot.
+ * @throw std::string - the snapshot has a parameter that's not defined.
+ */
+VX2750PHAModuleConfiguration*
+VX2750ConfigSnapshot::createModule(const std::string& name) const
+{
+    auto p = m_moduleOffsets.find(name);
+    if (p == m_moduleOffsets.end()) {
+        throw std::invalid_argument(m_file + " has no configuration for " + name);
+    }
+    std::unique_ptr<VX2750PHAModuleConfiguration> pResult(
+        new VX2750PHAModuleConfiguration(name.c_str())
+    );
+    restore(*pResult, p->second);
+    return pResult.release();
+}
+/**
+ * createModules
+ *    Create all module configurations in the snapshot.  They are copies
+ *    of a single prototype and share (copy-on-write) its parameter
+ *    definitions, so this costs one set of definitions plus the values
+ *    that differ from the defaults.
+ * @param[out] modules - the configurations are added to this map.  The caller
+ *                owns them.  On failure, nothing is added.
+ */
+void
+VX2750ConfigSnapshot::createModules(Modules& modules) const
+{
+    VX2750PHAModuleConfiguration prototype("snapshot");
+    Modules result;
+    try {
+        for (auto& m : m_moduleOffsets) {
+            auto pConfig = new VX2750PHAModuleConfiguration(prototype);
+            result[m.first] = pConfig;
+            pConfig->setName(m.first.c_str());
+            restore(*pConfig, m.second);
+        }
+    }
+    catch (...) {
+        for (auto& m : result) {
+            delete m.second;
+        }
+        throw;
+    }
+    modules.insert(result.begin(), result.end());
+}
+/**
+ * write
+ *    Write a snapshot.  The snapshot is first written to a temporary
+ *    file which is renamed to the final file so that readers never see
+ *    a partial snapshot.
+ * @param file - path to the snapshot file.
+ * @param sources - the files the configurations were built from.  These
+ *                  are digested and the digest stored in the snapshot.
+ * @param modules - the (validated) module configurations.
+ * @throw std::runtime_error - unable to write the snapshot.
+ */
+void
+VX2750ConfigSnapshot::write(
+    const std::string& file, const std::vector<std::string>& sources,
+    const Modules& modules
+)
+{
+    std::vector<char> buffer(sizeof(Header));
+    for (auto& s : sources) {
+        putString(buffer, s);
+    }
+    for (auto& m : modules) {
+        putString(buffer, m.first);
+        auto params = m.second->cget();
+        putU32(buffer, params.size());
+        for (auto& p : params) {
+            putString(buffer, p.first);
+            putString(buffer, p.second);
+        }
+    }
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.s_magic, MAGIC, sizeof(MAGIC));
+    h.s_version    = VERSION;
+    h.s_headerSize = sizeof(Header);
+    h.s_totalSize  = buffer.size();
+    std::string digest = snapshotDigest(sources);
+    memcpy(h.s_digest, digest.data(), sizeof(h.s_digest));
+    h.s_nSources   = sources.size();
+    h.s_nModules   = modules.size();
+    memcpy(buffer.data(), &h, sizeof(Header));
+
+    std::string tempFile = file + ".tmp";
+    int fd = open(tempFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(tempFile + ": " + strerror(errno));
+    }
+    const char* p = buffer.data();
+    size_t remaining = buffer.size();
+    while (remaining) {
+        ssize_t n = ::write(fd, p, remaining);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int e = errno;
+            close(fd);
+            unlink(tempFile.c_str());
+            throw std::runtime_error(tempFile + ": " + strerror(e));
+        }
+        p         += n;
+        remaining -= n;
+    }
+    close(fd);
+    if (rename(tempFile.c_str(), file.c_str()) < 0) {
+        int e = errno;
+        unlink(tempFile.c_str());
+        throw std::runtime_error(file + ": " + strerror(e));
+    }
+}
+/**
+ * digestFiles
+ *    Compute the MD5 digest of a set of files.  The file names are included
+ *    so that e.g. swapping the contents of two files changes the digest.
+ *    Files that can't be read contribute only their names - making the
+ *    digest differ from that of any readable version of the file.
+ * @param files - the files to digest.
+ * @return std::string - MD5_DIGEST_LENGTH bytes of binary digest.
+ */
+std::string
+VX2750ConfigSnapshot::digestFiles(const std::vector<std::string>& files)
+{
+    MD5_CTX c;
+    MD5_Init(&c);
+    for (auto& f : files) {
+        MD5_Update(&c, f.c_str(), f.size() + 1);
+        int fd = open(f.c_str(), O_RDONLY);
+        if (fd < 0) {
+            MD5_Update(&c, "\xff", 1);        // Unreadable marker.
+            continue;
+        }
+        std::uint8_t buffer[8192];
+        ssize_t bytes;
+        while ((bytes = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            MD5_Update(&c, buffer, bytes);
+        }
+        if (bytes < 0) MD5_Update(&c, "\xff", 1);
+        close(fd);
+    }
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    MD5_Final(digest, &c);
+    return std::string(reinterpret_cast<char*>(digest), MD5_DIGEST_LENGTH);
+}
+/**
+ * schemaDigest
+ *    Compute the MD5 digest of the parameter table: the name and default
+ *    value of every module configuration parameter.  Restored values are
+ *    not validated and parameters left at their defaults are not restored
+ *    explicitly, so a snapshot written by software with a different
+ *    parameter table must not be used.  Changes that only alter a
+ *    parameter's legal values aren't seen here; bump VERSION for those.
+ * @return std::string - MD5_DIGEST_LENGTH bytes of binary digest.
+ */
+std::string
+VX2750ConfigSnapshot::schemaDigest()
+{
+    static const std::string digest = []() {
+        VX2750PHAModuleConfiguration defaults("schema");
+        MD5_CTX c;
+        MD5_Init(&c);
+        for (auto& p : defaults.cget()) {          // In name order.
+            MD5_Update(&c, p.first.c_str(), p.first.size() + 1);
+            MD5_Update(&c, p.second.c_str(), p.second.size() + 1);
+        }
+        unsigned char result[MD5_DIGEST_LENGTH];
+        MD5_Final(result, &c);
+        return std::string(reinterpret_cast<char*>(result), MD5_DIGEST_LENGTH);
+    }();
+    return digest;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * snapshotDigest
+ *    The digest recorded in a snapshot: that of the parameter table and
+ *    the source files together.
+ * @param sources - the source files.
+ * @return std::string - MD5_DIGEST_LENGTH bytes of binary digest.
+ */
+std::string
+VX2750ConfigSnapshot::snapshotDigest(const std::vector<std::string>& sources)
+{
+    std::string both = schemaDigest() + digestFiles(sources);
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    MD5(reinterpret_cast<const unsigned char*>(both.data()), both.size(), digest);
+    return std::string(reinterpret_cast<char*>(digest), MD5_DIGEST_LENGTH);
+}
+/**
+ * unmap
+ *    Release the mapping (if there is one).
+ */
+void
+VX2750ConfigSnapshot::unmap()
+{
+    if (m_pMap) {
+        munmap(m_pMap, m_size);
+        m_pMap = nullptr;
+    }
+}
+/**
+ * getU32
+ *    Get a uint32_t from the snapshot.
+ * @param[inout] offset - offset of the value, advanced past it.
+ * @return std::uint32_t
+ * @throw std::runtime_error - the value runs off the end of the snapshot.
+ */
+std::uint32_t
+VX2750ConfigSnapshot::getU32(size_t& offset) const
+{
+    if (offset + sizeof(std::uint32_t) > m_size) {
+        throw std::runtime_error(m_file + " is corrupted");
+    }
+    std::uint32_t result;
+    memcpy(&result, static_cast<const char*>(m_pMap) + offset, sizeof(result));
+    offset += sizeof(result);
+    return result;
+}
+/**
+ * getString
+ *    Get a string from the snapshot.
+ * @param[inout] offset - offset of the string, advanced past it.
+ * @return std::string
+ * @throw std::runtime_error - the string runs off the end of the snapshot.
+ */
+std::string
+VX2750ConfigSnapshot::getString(size_t& offset) const
+{
+    std::uint32_t n = getU32(offset);
+    if (offset + n > m_size) {
+        throw std::runtime_error(m_file + " is corrupted");
+    }
+    std::string result(static_cast<const char*>(m_pMap) + offset, n);
+    offset += n;
+    return result;
+}
+/**
+ * restore
+ *    Restore the parameter values of a module.  The values were validated
+ *    before the snapshot was written so they're not validated again.
+ *    Values that are the same as the current ones are not set so that
+ *    copies only hold the parameters that differ from their prototype.
+ * @param config - the configuration to restore into.
+ * @param offset - offset of the module's parameter count.
+ */
+void
+VX2750ConfigSnapshot::restore(VX2750PHAModuleConfiguration& config, size_t offset) const
+{
+    std::uint32_t nParams = getU32(offset);
+    for (int i = 0; i < nParams; i++) {
+        std::string name  = getString(offset);
+        std::string value = getString(offset);
+        if (config.cget(name) != value) {       // Defaults stay shared.
+            config.configureUnchecked(name, value);
+        }
+    }
+}
+/**
+ * putU32
+ *    Append a uint32_t to a buffer.
+ */
+void
+VX2750ConfigSnapshot::putU32(std::vector<char>& buffer, std::uint32_t value)
+{
+    const char* p = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), p, p + sizeof(value));
+}
+/**
+ * putString
+ *    Append a string to a buffer.
+ */
+void
+VX2750ConfigSnapshot::putString(std::vector<char>& buffer, const std::string& s)
+{
+    putU32(buffer, s.size());
+    buffer.insert(buffer.end(), s.begin(), s.end());
+}
+}                                           // caen_nscldaq namespace.
@@ -0,0 +1,108 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ConfigSnapshot.h
+* @brief    Binary snapshots of validated module configurations.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750CONFIGSNAPSHOT_H
+#define VX2750CONFIGSNAPSHOT_H
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+namespace caen_nscldaq {
+class VX2750PHAModuleConfiguration;
+
+/**
+ * @class VX2750ConfigSnapshot
+ *    Processing a configuration file (Tcl or XML) means running the
+ *    interpreter/parser and validating every parameter.  Once a set of
+ *    module configurations has been validated it can be written to a
+ *    binary snapshot.  The snapshot records the files the configuration
+ *    was built from and an MD5 digest of their contents and of the
+ *    parameter table (see schemaDigest).  If the digest still matches when
+ *    the snapshot is loaded, the configurations are restored directly from
+ *    the (mmapped) snapshot with no parsing or validation.
+ *
+ *    Only the files given to write are tracked.  For the Tcl configuration
+ *    these are the configuration file and the files it sources.  Anything
+ *    else the script reads (e.g. with open, or environment variables) is
+ *    not tracked and changes to it are not noticed; delete the snapshot
+ *    after changing such inputs.
+ *
+ *    Snapshot layout (native byte order):
+ *    -   Header (see below).
+ *    -   s_nSources strings - the source files.
+ *    -   s_nModules modules each of which is a name string, a uint32_t
+ *        parameter count and that many name/value string pairs.
+ *    Strings are a uint32_t length followed by that many bytes.
+ */
+class VX2750ConfigSnapshot {
+public:
+    static const std::uint32_t VERSION = 1;
+    typedef std::map<std::string, VX2750PHAModuleConfiguration*> Modules;
+private:
+    struct Header {
+        char          s_magic[8];
+        std::uint32_t s_version;
+        std::uint32_t s_headerSize;
+        std::uint64_t s_totalSize;
+        std::uint8_t  s_digest[16];
+        std::uint32_t s_nSources;
+        std::uint32_t s_nModules;
+    };
+    std::string                    m_file;
+    void*                          m_pMap;
+    size_t                         m_size;
+    std::string                    m_digest;
+    std::vector<std::string>       m_sources;
+    std::map<std::string, size_t>  m_moduleOffsets;   // name -> offset of param count.
+public:
+    VX2750ConfigSnapshot(const std::string& file);
+    virtual ~VX2750ConfigSnapshot();
+private:
+    VX2750ConfigSnapshot(const VX2750ConfigSnapshot&);
+    VX2750ConfigSnapshot& operator=(const VX2750ConfigSnapshot&);
+public:
+    const std::vector<std::string>& sources() const { return m_sources; }
+    bool isCurrent() const;
+    std::vector<std::string> listModules() const;
+    VX2750PHAModuleConfiguration* createModule(const std::string& name) const;
+    void createModules(Modules& modules) const;
+
+    static void write(
+        const std::string& file, const std::vector<std::string>& sources,
+        const Modules& modules
+    );
+    static std::string digestFiles(const std::vector<std::string>& files);
+    static std::string schemaDigest();
+private:
+    void        unmap();
+    static std::string snapshotDigest(const std::vector<std::string>& sources);
+    std::uint32_t getU32(size_t& offset) const;
+    std::string   getString(size_t& offset) const;
+    void          restore(VX2750PHAModuleConfiguration& config, size_t offset) const;
+    static void   putU32(std::vector<char>& buffer, std::uint32_t value);
+    static void   putString(std::vector<char>& buffer, const std::string& s);
+};
+}                                        // caen_nscldaq namespace.
+#endif
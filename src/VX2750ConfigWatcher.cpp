@@ -0,0 +1,504 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ConfigWatcher.cpp
+* @brief    Implement the background configuration parser/watcher.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ConfigWatcher.h"
+#include "VX2750TclConfig.h"
+#include "VX2750ConfigSnapshot.h"
+#include <TCLInterpreter.h>
+#include <TCLVariable.h>
+#include <Exception.h>
+#include <tcl.h>
+
+#include <stdexcept>
+#include <iostream>
+#include <sstream>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+namespace caen_nscldaq {
+
+// Wraps the source command so we know which files the configuration pulls in:
+
+static const char* sourceWrapper =
+    "rename source __vx2750_source\n"
+    "set ::__vx2750_sourced [list]\n"
+    "proc source args {\n"
+    "    lappend ::__vx2750_sourced [file normalize [lindex $args end]]\n"
+    "    uplevel 1 [linsert $args 0 __vx2750_source]\n"
+    "}\n";
+
+static const unsigned DEBOUNCE_MS(250);      // Quiet time after a change.
+
+/**
+ * constructor
+ *    The thread is not started until start is called so that required
+ *    modules can be added first.
+ * @param configFile - path to the configuration file.
+ * @param commandName - name of the configuration command the file uses.
+ */
+VX2750ConfigWatcher::VX2750ConfigWatcher(
+    const char* configFile, const char* commandName
+) :
+    m_configFile(configFile), m_commandName(commandName),
+    m_firstParse(true),
+    m_inotifyFd(-1), m_stopFd(-1), m_parsing(false), m_pStaged(nullptr)
+{}
+/**
+ * destructor
+ *    Stop the thread and release any configuration that was never taken.
+ */
+VX2750ConfigWatcher::~VX2750ConfigWatcher()
+{
+    stop();
+    delete m_pStaged;
+}
+/**
+ * start
+ *    Start the watcher thread.  The thread does an initial parse and then
+ *    watches for changes.
+ * @throw std::runtime_error - inotify or the stop eventfd could not be
+ *        created.  The caller can then fall back to parsing at begin run.
+ */
+void
+VX2750ConfigWatcher::start()
+{
+    if (m_thread.joinable()) return;                 // Already running.
+
+    m_inotifyFd = inotify_init1(IN_CLOEXEC);
+    if (m_inotifyFd < 0) {
+        throw std::runtime_error(std::string("inotify_init1 failed: ") + strerror(errno));
+    }
+    m_stopFd = eventfd(0, EFD_CLOEXEC);
+    if (m_stopFd < 0) {
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+        throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+    }
+    m_parsing = true;                    // Initial parse is pending.
+    m_thread  = std::thread(&VX2750ConfigWatcher::threadMain, this);
+}
+/**
+ * stop
+ *    Stop the thread (if it's running) and close the file descriptors.
+ */
+void
+VX2750ConfigWatcher::stop()
+{
+    if (m_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(m_stopFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Failed to signal the configuration watcher to stop\n";
+        }
+        m_thread.join();
+    }
+    clearWatches();
+    if (m_inotifyFd >= 0) close(m_inotifyFd);
+    if (m_stopFd >= 0) close(m_stopFd);
+    m_inotifyFd = -1;
+    m_stopFd    = -1;
+
+    std::lock_guard<std::mutex> l(m_lock);
+    m_parsing = false;
+    m_parsed.notify_all();
+}
+/**
+ * addRequiredModule
+ *    Add a module name that must be in the configuration for it to be valid.
+ *    This only affects subsequent parses.
+ * @param pName - name of the module.
+ */
+void
+VX2750ConfigWatcher::addRequiredModule(const char* pName)
+{
+    std::lock_guard<std::mutex> l(m_lock);
+    m_requiredModules.insert(pName);
+}
+/**
+ * setSnapshotFile
+ *    Set the file in which a binary snapshot of the most recent good
+ *    configuration is kept.  If, when the watcher starts, the snapshot
+ *    is for the current contents of the configuration files, the
+ *    configuration is loaded from it rather than processing the files.
+ *    Must be called before start.
+ * @param pFile - path to the snapshot file. Empty to disable snapshots.
+ */
+void
+VX2750ConfigWatcher::setSnapshotFile(const char* pFile)
+{
+    m_snapshotFile = pFile;
+}
+/**
+ * takeStaged
+ *    Take the most recently parsed configuration.  If a parse is in progress
+ *    we wait for it to finish.
+ * @return VX2750TclConfig* - the new configuration which is now owned by the
+ *           caller.  nullptr if there's been no change since the last take.
+ * @throw std::string - the most recent parse failed; the string
+ *           describes the error.
+ */
+VX2750TclConfig*
+VX2750ConfigWatcher::takeStaged()
+{
+    std::unique_lock<std::mutex> l(m_lock);
+    m_parsed.wait(l, [this]() { return !m_parsing; });
+
+    if (!m_error.empty()) {
+        throw m_error;
+    }
+    VX2750TclConfig* result = m_pStaged;
+    m_pStaged = nullptr;
+    return result;
+}
+/**
+ * watchedFiles
+ *   @return std::vector<std::string> - the (normalized) paths being watched.
+ */
+std::vector<std::string>
+VX2750ConfigWatcher::watchedFiles()
+{
+    std::lock_guard<std::mutex> l(m_lock);
+    return std::vector<std::string>(m_watchedFiles.begin(), m_watchedFiles.end());
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private methods - these run in the watcher thread.
+
+/**
+ * threadMain
+ *    Parse, wait for a change, repeat until told to stop.
+ */
+void
+VX2750ConfigWatcher::threadMain()
+{
+    while (true) {
+        parse();
+        if (!waitForChange()) break;
+
+        std::lock_guard<std::mutex> l(m_lock);
+        m_parsing = true;
+    }
+}
+/**
+ * parse
+ *    Parse the configuration file in a private interpreter, validate it
+ *    and stage the result (or error).  The set of watched files is updated
+ *    to the configuration file and everything it sourced (even if there was an
+ *    error so that fixing the error will trigger a re-parse).
+ */
+void
+VX2750ConfigWatcher::parse()
+{
+    std::set<std::string> required;
+    {
+        std::lock_guard<std::mutex> l(m_lock);
+        required = m_requiredModules;
+    }
+    std::set<std::string> files;
+    files.insert(normalize(m_configFile));
+
+    VX2750TclConfig* pConfig(nullptr);
+    std::string      error;
+    bool             fromSnapshot(false);
+    {
+        CTCLInterpreter interp;
+        
+        // If Readout is restarting, and nothing changed, the snapshot
+        // gives us the configuration without running the script:
+        
+        if (m_firstParse) {
+            m_firstParse = false;
+            fromSnapshot = loadSnapshot(interp, pConfig, files);
+        }
+        if (!fromSnapshot) {
+            try {
+                interp.GlobalEval(sourceWrapper);
+                pConfig = new VX2750TclConfig(interp, m_commandName.c_str());
+                interp.EvalFile(m_configFile);
+            }
+            catch (CException& e) {
+                error = e.ReasonText();
+                error += "\n" + getTclTraceback(interp);
+            }
+            catch (std::string s) {
+                error = s + "\n" + getTclTraceback(interp);
+            }
+            catch (std::exception& e) {
+                error = e.what();
+                error += "\n" + getTclTraceback(interp);
+            }
+            catch (...) {
+                error = "Unanticipated exception type caught while processing the configuration file.\n";
+                error += getTclTraceback(interp);
+            }
+            auto sourced = sourcedFiles(interp);
+            files.insert(sourced.begin(), sourced.end());
+        }
+    }
+    if (error.empty()) {
+        auto names = pConfig->listModules();
+        std::set<std::string> configured(names.begin(), names.end());
+        for (auto& m : required) {
+            if (configured.count(m) == 0) {
+                error += m_configFile + " Does not have a configuration for module ";
+                error += m;
+                error += "\n";
+            }
+        }
+    }
+    if (error.empty() && !fromSnapshot) {
+        writeSnapshot(*pConfig, files);
+    }
+    if (!error.empty()) {
+        delete pConfig;
+        pConfig = nullptr;
+        std::cerr << "Error in configuration file " << m_configFile << ":\n"
+            << error << std::endl;
+    }
+    updateWatches(files);
+
+    std::lock_guard<std::mutex> l(m_lock);
+    delete m_pStaged;                        // Superseded if never taken.
+    m_pStaged = pConfig;
+    m_error   = error;
+    m_parsing = false;
+    m_parsed.notify_all();
+}
+/**
+ * loadSnapshot
+ *    Try to get the configuration from the snapshot file.
+ * @param interp - interpreter on which to create the configuration command.
+ * @param[out] pConfig - the configuration if successful.
+ * @param[inout] files - the snapshot's source files are added to this.
+ * @return bool - true if the configuration was loaded from the snapshot.
+ *      false if there's no snapshot file, it's not for the current
+ *      contents of the configuration files or it can't be used.
+ */
+bool
+VX2750ConfigWatcher::loadSnapshot(
+    CTCLInterpreter& interp, VX2750TclConfig*& pConfig, std::set<std::string>& files
+)
+{
+    if (m_snapshotFile.empty()) return false;
+    try {
+        VX2750ConfigSnapshot snapshot(m_snapshotFile);
+        if (!snapshot.isCurrent()) return false;
+        
+        VX2750ConfigSnapshot::Modules modules;
+        snapshot.createModules(modules);
+        pConfig = new VX2750TclConfig(interp, m_commandName.c_str());
+        for (auto& m : modules) {
+            pConfig->addModule(m.first, m.second);
+        }
+        files.insert(snapshot.sources().begin(), snapshot.sources().end());
+        return true;
+    }
+    catch (...) {                // Any failure means just process the file.
+        delete pConfig;
+        pConfig = nullptr;
+        return false;
+    }
+}
+/**
+ * writeSnapshot
+ *    Write the snapshot of a successfully processed configuration.
+ *    Failure to write it just means the next start will process the
+ *    configuration file so that's only reported.
+ * @param config - the configuration.
+ * @param files  - the files it was built from.
+ */
+void
+VX2750ConfigWatcher::writeSnapshot(
+    VX2750TclConfig& config, const std::set<std::string>& files
+)
+{
+    if (m_snapshotFile.empty()) return;
+    try {
+        VX2750ConfigSnapshot::Modules modules;
+        for (auto& name : config.listModules()) {
+            modules[name] = config.getModule(name.c_str());
+        }
+        std::vector<std::string> sources(files.begin(), files.end());
+        VX2750ConfigSnapshot::write(m_snapshotFile, sources, modules);
+    }
+    catch (std::exception& e) {
+        std::cerr << "Unable to write configuration snapshot " << m_snapshotFile
+            << ": " << e.what() << std::endl;
+    }
+}
+/**
+ * waitForChange
+ *    Block until one of the watched files changes or we're asked to stop.
+ *    Once a change is seen, we wait until things have been quiet for
+ *    DEBOUNCE_MS as editors may write files in several steps.
+ * @return bool - true if a file changed, false if we should stop.
+ */
+bool
+VX2750ConfigWatcher::waitForChange()
+{
+    const size_t bufsize = 16*(sizeof(struct inotify_event) + NAME_MAX + 1);
+    alignas(struct inotify_event) char buffer[bufsize];
+    bool changed = false;
+
+    while (true) {
+        struct pollfd fds[2];
+        fds[0].fd = m_stopFd;     fds[0].events = POLLIN; fds[0].revents = 0;
+        fds[1].fd = m_inotifyFd;  fds[1].events = POLLIN; fds[1].revents = 0;
+
+        int status = poll(fds, 2, changed ? DEBOUNCE_MS : -1);
+        if (status < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Configuration watcher poll failed: " << strerror(errno)
+                << " no longer watching " << m_configFile << std::endl;
+            return false;
+        }
+        if (fds[0].revents & POLLIN) return false;  // Stop requested.
+        if (status == 0) return true;               // Quiet after a change.
+
+        ssize_t n = read(m_inotifyFd, buffer, bufsize);
+        if (n <= 0) continue;
+
+        for (char* p = buffer; p < buffer + n; ) {
+            struct inotify_event* pEvent = reinterpret_cast<struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + pEvent->len;
+
+            auto dir = m_watchedDirs.find(pEvent->wd);
+            if ((dir != m_watchedDirs.end()) && pEvent->len) {
+                std::string path = dir->second + "/" + pEvent->name;
+                std::lock_guard<std::mutex> l(m_lock);
+                if (m_watchedFiles.count(path)) changed = true;
+            }
+        }
+    }
+}
+/**
+ * updateWatches
+ *    Watch the directories of a new set of files.
+ * @param files - the normalized paths of the files to watch.
+ */
+void
+VX2750ConfigWatcher::updateWatches(const std::set<std::string>& files)
+{
+    clearWatches();
+
+    std::set<std::string> dirs;
+    for (auto& f : files) {
+        dirs.insert(f.substr(0, f.rfind('/')));
+    }
+    for (auto& d : dirs) {
+        int wd = inotify_add_watch(
+            m_inotifyFd, d.empty() ? "/" : d.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+        );
+        if (wd < 0) {
+            std::cerr << "Unable to watch " << d << " for configuration changes: "
+                << strerror(errno) << std::endl;
+        } else {
+            m_watchedDirs[wd] = d;
+        }
+    }
+    std::lock_guard<std::mutex> l(m_lock);
+    m_watchedFiles = files;
+}
+/**
+ * clearWatches
+ *    Remove all inotify watches.
+ */
+void
+VX2750ConfigWatcher::clearWatches()
+{
+    for (auto& w : m_watchedDirs) {
+        inotify_rm_watch(m_inotifyFd, w.first);
+    }
+    m_watchedDirs.clear();
+}
+/**
+ * sourcedFiles
+ *    Return the set of files the configuration sourced (recorded by our wrapper
+ *    of the source command).
+ * @param interp - the interpreter that processed the configuration.
+ * @return std::set<std::string> - normalized file paths.
+ */
+std::set<std::string>
+VX2750ConfigWatcher::sourcedFiles(CTCLInterpreter& interp)
+{
+    std::set<std::string> result;
+    CTCLVariable sourced(&interp, "::__vx2750_sourced", false);
+    const char* pList = sourced.Get(TCL_GLOBAL_ONLY);
+    if (pList) {
+        int argc;
+        const char** argv;
+        if (Tcl_SplitList(interp.getInterpreter(), pList, &argc, &argv) == TCL_OK) {
+            for (int i = 0; i < argc; i++) {
+                result.insert(normalize(argv[i]));
+            }
+            Tcl_Free(reinterpret_cast<char*>(argv));
+        }
+    }
+    return result;
+}
+/**
+ * getTclTraceback
+ *    Pulls the value of the global errorInfo variable which is the traceback
+ *    for any Tcl error thrown in evaluating a script.
+ *  @param interp - interpreter whose traceback we're trying to get
+ *  @return std::string - value of errorInfo.
+ */
+std::string
+VX2750ConfigWatcher::getTclTraceback(CTCLInterpreter& interp)
+{
+    std::string result;
+
+    CTCLVariable info(&interp, "errorInfo", false);
+    const char* pTrace = info.Get();
+    if (pTrace) result = pTrace;
+
+    return result;
+}
+/**
+ * normalize
+ *    Produce an absolute path with symbolic links resolved.  If the file
+ *    does not exist (yet), we just make the path absolute.
+ * @param path - the path to normalize.
+ * @return std::string
+ */
+std::string
+VX2750ConfigWatcher::normalize(const std::string& path)
+{
+    char resolved[PATH_MAX];
+    if (realpath(path.c_str(), resolved)) {
+        return std::string(resolved);
+    }
+    if (!path.empty() && (path[0] == '/')) return path;
+
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd))) {
+        return std::string(cwd) + "/" + path;
+    }
+    return path;
+}
+}                                          // caen_nscldaq namespace.
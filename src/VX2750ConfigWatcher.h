@@ -0,0 +1,113 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ConfigWatcher.h
+* @brief    Background parse/validation of the Tcl configuration file.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750CONFIGWATCHER_H
+#define VX2750CONFIGWATCHER_H
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class CTCLInterpreter;
+
+namespace caen_nscldaq {
+class VX2750TclConfig;
+
+/**
+ * @class VX2750ConfigWatcher
+ *    Processing the configuration file at begin run takes time.  This class
+ *    runs a thread that:
+ *    -  Parses the configuration file (in its own Tcl interpreter) into a
+ *       staged VX2750TclConfig and validates that all required modules
+ *       are configured.
+ *    -  Uses inotify to watch the configuration file and every file it
+ *       sources.  When any of them changes, the file is re-parsed
+ *       and re-validated.
+ *
+ *    At begin run, the readout just takes the staged configuration
+ *    (if there is a new one).  Errors in the configuration are reported
+ *    on stderr as soon as the file is saved rather than at begin run.
+ *
+ *    If a snapshot file is set, each good configuration is also saved
+ *    as a VX2750ConfigSnapshot so that when Readout restarts with
+ *    unchanged configuration files, the configuration is loaded from the
+ *    snapshot instead of running the script.
+ *
+ *    We watch the directories containing the files rather than the files
+ *    themselves because many editors save by writing a new file and renaming
+ *    it over the old one.
+ */
+class VX2750ConfigWatcher {
+private:
+    std::string              m_configFile;
+    std::string              m_commandName;        // Config command (v27xxpha).
+    std::string              m_snapshotFile;       // Empty if not snapshotting.
+    bool                     m_firstParse;
+    std::set<std::string>    m_requiredModules;
+    int                      m_inotifyFd;
+    int                      m_stopFd;             // eventfd to stop the thread.
+    std::map<int, std::string> m_watchedDirs;      // wd -> directory.
+    std::set<std::string>    m_watchedFiles;       // Normalized paths.
+    std::thread              m_thread;
+
+    // Everything below is shared with the thread and guarded by m_lock:
+
+    std::mutex               m_lock;
+    std::condition_variable  m_parsed;
+    bool                     m_parsing;
+    VX2750TclConfig*         m_pStaged;            // New config not yet taken.
+    std::string              m_error;              // Nonempty if latest parse failed.
+public:
+    VX2750ConfigWatcher(const char* configFile, const char* commandName = "v27xxpha");
+    virtual ~VX2750ConfigWatcher();
+private:
+    VX2750ConfigWatcher(const VX2750ConfigWatcher&);
+    VX2750ConfigWatcher& operator=(const VX2750ConfigWatcher&);
+public:
+    void setSnapshotFile(const char* pFile);
+    void start();
+    void stop();
+    void addRequiredModule(const char* pName);
+    VX2750TclConfig* takeStaged();
+    std::vector<std::string> watchedFiles();
+
+private:
+    void threadMain();
+    void parse();
+    bool loadSnapshot(
+        CTCLInterpreter& interp, VX2750TclConfig*& pConfig,
+        std::set<std::string>& files
+    );
+    void writeSnapshot(VX2750TclConfig& config, const std::set<std::string>& files);
+    bool waitForChange();
+    void updateWatches(const std::set<std::string>& files);
+    void clearWatches();
+    static std::set<std::string> sourcedFiles(CTCLInterpreter& interp);
+    static std::string getTclTraceback(CTCLInterpreter& interp);
+    static std::string normalize(const std::string& path);
+};
+}                                         // caen_nscldaq namespace.
+#endif
@@ -0,0 +1,191 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ConnectionPool.cpp
+* @brief    Implement the module connection pool.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ConnectionPool.h"
+#include "VX2750Pha.h"
+#include <stdexcept>
+#include <set>
+
+namespace caen_nscldaq {
+
+/**
+ * constructor
+ *    The pool starts out empty.
+ */
+VX2750ConnectionPool::VX2750ConnectionPool()
+{}
+/**
+ * destructor
+ *    Disconnects from all modules.
+ */
+VX2750ConnectionPool::~VX2750ConnectionPool()
+{
+    clear();
+}
+/**
+ * get
+ *    Return the connection to a module, connecting if there's not yet
+ *    a connection.
+ * @param pHostOrPid - host name/IP or USB PID of the module.
+ * @param isUsb      - true if the module is USB connected.
+ * @return VX2750Pha* - the module.  This is owned by the pool.
+ * @note  Exceptions from the connection attempt propagate out of us
+ *        and no entry is made in the pool.
+ */
+VX2750Pha*
+VX2750ConnectionPool::get(const char* pHostOrPid, bool isUsb)
+{
+    Key key(pHostOrPid, isUsb);
+    auto p = m_connections.find(key);
+    if (p != m_connections.end()) {
+        return p->second.s_pModule;
+    }
+    Connection connection;
+    connection.s_pModule = connect(pHostOrPid, isUsb);
+    m_connections[key] = connection;
+    return connection.s_pModule;
+}
+/**
+ * drop
+ *    Disconnect from a module.  This is normally done if we believe the
+ *    connection has gone bad so that the next get reconnects.
+ *    It is a no-op if there's no connection.
+ * @param pHostOrPid - host name/IP or USB PID of the module.
+ * @param isUsb      - true if the module is USB connected.
+ */
+void
+VX2750ConnectionPool::drop(const char* pHostOrPid, bool isUsb)
+{
+    auto p = m_connections.find(Key(pHostOrPid, isUsb));
+    if (p != m_connections.end()) {
+        disconnect(p->second.s_pModule);
+        m_connections.erase(p);
+    }
+}
+/**
+ * clear
+ *    Disconnect from all modules.
+ */
+void
+VX2750ConnectionPool::clear()
+{
+    for (auto& c : m_connections) {
+        disconnect(c.second.s_pModule);
+    }
+    m_connections.clear();
+}
+/**
+ * retain
+ *    Disconnect from all modules other than the ones listed.  This is
+ *    done when the run begins so that modules removed from the readout
+ *    don't stay connected (and unavailable to other programs).
+ * @param keys - (host or PID, isUsb) of the modules still read out.
+ *               Modules listed that aren't connected are ignored.
+ */
+void
+VX2750ConnectionPool::retain(const std::vector<Key>& keys)
+{
+    std::set<Key> keep(keys.begin(), keys.end());
+    auto p = m_connections.begin();
+    while (p != m_connections.end()) {
+        if (keep.count(p->first)) {
+            ++p;
+        } else {
+            disconnect(p->second.s_pModule);
+            p = m_connections.erase(p);
+        }
+    }
+}
+/**
+ * isConnected
+ *   @param pHostOrPid - host name/IP or USB PID of the module.
+ *   @param isUsb      - true if the module is USB connected.
+ *   @return bool - true if the pool holds a connection to that module.
+ */
+bool
+VX2750ConnectionPool::isConnected(const char* pHostOrPid, bool isUsb) const
+{
+    return m_connections.count(Key(pHostOrPid, isUsb)) > 0;
+}
+/**
+ * getConfigDigest
+ *   @param pHostOrPid - host name/IP or USB PID of the module.
+ *   @param isUsb      - true if the module is USB connected.
+ *   @return std::string - digest of the configuration last loaded into the
+ *                     module.  Empty if there's no connection or the
+ *                     module has not (successfully) been configured.
+ */
+std::string
+VX2750ConnectionPool::getConfigDigest(const char* pHostOrPid, bool isUsb) const
+{
+    auto p = m_connections.find(Key(pHostOrPid, isUsb));
+    if (p != m_connections.end()) {
+        return p->second.s_configDigest;
+    }
+    return std::string();
+}
+/**
+ * setConfigDigest
+ *    Record the digest of the configuration loaded into a module.
+ *  @param pHostOrPid - host name/IP or USB PID of the module.
+ *  @param isUsb      - true if the module is USB connected.
+ *  @param digest     - the digest.
+ *  @throw std::logic_error - there's no connection to that module.
+ */
+void
+VX2750ConnectionPool::setConfigDigest(
+    const char* pHostOrPid, bool isUsb, const std::string& digest
+)
+{
+    auto p = m_connections.find(Key(pHostOrPid, isUsb));
+    if (p == m_connections.end()) {
+        throw std::logic_error("Setting config digest for an unconnected module");
+    }
+    p->second.s_configDigest = digest;
+}
+/**
+ * connect
+ *    Make a new connection to a module.
+ * @param pHostOrPid - host name/IP or USB PID of the module.
+ * @param isUsb      - true if the module is USB connected.
+ * @return VX2750Pha* - the new module object.
+ */
+VX2750Pha*
+VX2750ConnectionPool::connect(const char* pHostOrPid, bool isUsb)
+{
+    return new VX2750Pha(pHostOrPid, isUsb);
+}
+/**
+ * disconnect
+ *    Destroy a module object and with it the connection.
+ * @param pModule - the module as returned from connect.
+ * @note our destructor can only call this implementation; derived classes
+ *       that override it must clear() in their own destructors.
+ */
+void
+VX2750ConnectionPool::disconnect(VX2750Pha* pModule)
+{
+    delete pModule;
+}
+
+}                                      // caen_nscldaq namespace.
@@ -0,0 +1,83 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ConnectionPool.h
+* @brief    Keep module connections open across configuration reloads.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750CONNECTIONPOOL_H
+#define VX2750CONNECTIONPOOL_H
+#include <string>
+#include <map>
+#include <vector>
+#include <utility>
+
+namespace caen_nscldaq {
+class VX2750Pha;
+
+/**
+ * @class VX2750ConnectionPool
+ *    Opening a connection to a module (especially over Ethernet) can take
+ *    seconds.  When the configuration of a TclConfiguredReadout changes,
+ *    its event segments are all destroyed and re-created.  If those segments
+ *    are given a connection pool, they get their VX2750Pha objects from the
+ *    pool rather than creating them, so a configuration change only
+ *    re-pushes the parameters to already connected modules.
+ *
+ *    Connections are keyed by the connection string (host or PID) and
+ *    the USB flag.  The pool owns the VX2750Pha objects it hands out.
+ *    Along with each connection, the pool remembers the digest of the
+ *    configuration last loaded into the module so that unchanged modules
+ *    need not be reconfigured at all.
+ *
+ *    Connections to modules that are no longer read out would otherwise be
+ *    held forever; retain disconnects from them.
+ */
+class VX2750ConnectionPool {
+public:
+    typedef std::pair<std::string, bool> Key;   // Host or PID, isUsb.
+private:
+    struct Connection {
+        VX2750Pha*  s_pModule;
+        std::string s_configDigest;           // Digest of loaded configuration.
+    };
+    std::map<Key, Connection>  m_connections;
+public:
+    VX2750ConnectionPool();
+    virtual ~VX2750ConnectionPool();
+private:
+    VX2750ConnectionPool(const VX2750ConnectionPool&);
+    VX2750ConnectionPool& operator=(const VX2750ConnectionPool&);
+public:
+    VX2750Pha* get(const char* pHostOrPid, bool isUsb);
+    void       drop(const char* pHostOrPid, bool isUsb);
+    void       clear();
+    void       retain(const std::vector<Key>& keys);
+    bool       isConnected(const char* pHostOrPid, bool isUsb) const;
+    std::string getConfigDigest(const char* pHostOrPid, bool isUsb) const;
+    void       setConfigDigest(
+        const char* pHostOrPid, bool isUsb, const std::string& digest
+    );
+    size_t     size() const { return m_connections.size(); }
+protected:
+    virtual VX2750Pha* connect(const char* pHostOrPid, bool isUsb);
+    virtual void       disconnect(VX2750Pha* pModule);
+};
+}                                      // caen_nscldaq namespace.
+#endif
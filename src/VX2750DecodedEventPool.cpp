@@ -0,0 +1,160 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750DecodedEventPool.cpp
+* @brief    Implement the decoded event storage arena.
+* @author   Ron Fox
+*
+*/
+#include "VX2750DecodedEventPool.h"
+#include <stdexcept>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+namespace caen_nscldaq {
+
+const std::size_t VX2750DecodedEventPool::CACHE_LINE;
+const std::size_t VX2750DecodedEventPool::HUGE_PAGE;
+
+/**
+ * constructor
+ *    No storage is allocated until the first reserve.
+ *  @param hugePages - if true, the storage will be requested on
+ *                     transparent huge pages.
+ */
+VX2750DecodedEventPool::VX2750DecodedEventPool(bool hugePages) :
+    m_pStorage(nullptr), m_size(0), m_allocated(0), m_hugePages(hugePages),
+    m_mapped(false)
+{}
+/**
+ * destructor
+ */
+VX2750DecodedEventPool::~VX2750DecodedEventPool()
+{
+    release();
+}
+/**
+ * reserve
+ *    Ensure the pool has at least the requested number of bytes.
+ *    If it already does, this is a no-op which is the normal case from the
+ *    second run on.
+ *  @param bytes - number of bytes required.
+ *  @return std::uint8_t* - pointer to the (cache line aligned) storage.
+ *  @throw std::bad_alloc - if the storage can't be allocated.
+ *  @note if the pool grows, any pointers previously carved from it are invalid.
+ */
+std::uint8_t*
+VX2750DecodedEventPool::reserve(std::size_t bytes)
+{
+    if (bytes > m_size) {
+        release();
+        allocate(bytes);
+    }
+    return m_pStorage;
+}
+/**
+ * setHugePages
+ *    Change the huge page preference.  If this changes, existing storage
+ *    is released and the next reserve allocates with the new preference.
+ * @param enable - true to request transparent huge pages.
+ */
+void
+VX2750DecodedEventPool::setHugePages(bool enable)
+{
+    if (enable != m_hugePages) {
+        release();
+        m_hugePages = enable;
+    }
+}
+/**
+ * release
+ *    Return the storage.
+ */
+void
+VX2750DecodedEventPool::release()
+{
+    if (m_pStorage) {
+        if (m_mapped) {
+            munmap(m_pStorage, m_allocated);
+        } else {
+            free(m_pStorage);
+        }
+    }
+    m_pStorage  = nullptr;
+    m_size      = 0;
+    m_allocated = 0;
+    m_mapped    = false;
+}
+/**
+ * roundUp
+ *    Round a byte count up to a multiple of a boundary.
+ *  @param bytes - the byte count.
+ *  @param boundary - the boundary (defaults to a cache line).
+ *  @return std::size_t
+ */
+std::size_t
+VX2750DecodedEventPool::roundUp(std::size_t bytes, std::size_t boundary)
+{
+    return ((bytes + boundary - 1)/boundary) * boundary;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities
+
+/**
+ * allocate
+ *    Allocate storage.  If huge pages are requested we mmap a huge page
+ *    multiple and advise the kernel to back it with huge pages; if that
+ *    fails we fall back to ordinary aligned storage.  Either way, the storage
+ *    is zeroed which faults the pages in.
+ * @param bytes - minimum size required.
+ */
+void
+VX2750DecodedEventPool::allocate(std::size_t bytes)
+{
+    if (bytes == 0) return;
+
+    if (m_hugePages) {
+        std::size_t size = roundUp(bytes, HUGE_PAGE);
+        void* p = mmap(
+            nullptr, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+        );
+        if (p != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(p, size, MADV_HUGEPAGE);     // Advisory - failure is ok.
+#endif
+            m_pStorage  = static_cast<std::uint8_t*>(p);
+            m_allocated = size;
+            m_mapped    = true;
+        }
+    }
+    if (!m_pStorage) {
+        std::size_t size = roundUp(bytes);
+        void* p;
+        if (posix_memalign(&p, CACHE_LINE, size)) {
+            throw std::bad_alloc();
+        }
+        m_pStorage  = static_cast<std::uint8_t*>(p);
+        m_allocated = size;
+        m_mapped    = false;
+    }
+    memset(m_pStorage, 0, m_allocated);
+    m_size = m_allocated;
+}
+}                                        // caen_nscldaq namespace.
@@ -0,0 +1,83 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750DecodedEventPool.h
+* @brief    Storage arena for the probe buffers of decoded events.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750DECODEDEVENTPOOL_H
+#define VX2750DECODEDEVENTPOOL_H
+#include <cstddef>
+#include <cstdint>
+
+namespace caen_nscldaq {
+/**
+ * @class VX2750DecodedEventPool
+ *    Provides a single block of storage from which the probe (trace) buffers
+ *    of VX2750Pha::DecodedEvent structs are carved (see
+ *    VX2750Pha::setupDecodedBuffer(DecodedEvent&, VX2750DecodedEventPool&)).
+ *    Rather than allocating and freeing six arrays each time a run starts,
+ *    pauses or resumes, the owner of the pool (normally an event segment)
+ *    keeps it for its lifetime.  The pool only ever grows, so once it's large
+ *    enough for the module's configuration no further allocation happens.
+ *
+ *    -  The storage is aligned on a cache line and the probe buffers carved
+ *       from it are each rounded up to a cache line multiple.
+ *    -  Optionally the storage is requested on transparent huge pages
+ *       which reduces TLB pressure for large, multi-hit batches.
+ *    -  The storage is touched when allocated so that page faults happen
+ *       before data taking rather than on the first hits.
+ *
+ *    Growing the pool invalidates any buffers that were carved from it; the
+ *    decoded events must be set up again.
+ */
+class VX2750DecodedEventPool {
+public:
+    static const std::size_t CACHE_LINE = 64;
+    static const std::size_t HUGE_PAGE  = 2*1024*1024;
+private:
+    std::uint8_t* m_pStorage;
+    std::size_t   m_size;                 // Usable bytes.
+    std::size_t   m_allocated;            // Bytes actually allocated.
+    bool          m_hugePages;            // Want THP backing.
+    bool          m_mapped;               // Storage came from mmap.
+public:
+    VX2750DecodedEventPool(bool hugePages = false);
+    virtual ~VX2750DecodedEventPool();
+private:
+    VX2750DecodedEventPool(const VX2750DecodedEventPool&);
+    VX2750DecodedEventPool& operator=(const VX2750DecodedEventPool&);
+public:
+    std::uint8_t* reserve(std::size_t bytes);
+    void          setHugePages(bool enable);
+    void          release();
+
+    // Selectors:
+
+    std::uint8_t* data()      { return m_pStorage; }
+    std::size_t   size() const { return m_size; }
+    bool          hugePages() const { return m_hugePages; }
+    bool          isMapped() const { return m_mapped; }
+
+    static std::size_t roundUp(std::size_t bytes, std::size_t boundary = CACHE_LINE);
+private:
+    void allocate(std::size_t bytes);
+};
+}                                      // caen_nscldaq namespace.
+#endif
@@ -0,0 +1,453 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750EnergyHistogrammer.cpp
+* @brief    Implement the quick look energy histogrammer.
+* @author   Ron Fox
+*
+*/
+#include "VX2750EnergyHistogrammer.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace caen_offline {
+
+const unsigned      VX2750EnergyHistogrammer::CHANNELS;
+const unsigned      VX2750EnergyHistogrammer::DEFAULT_ENERGY_BINS;
+const unsigned      VX2750EnergyHistogrammer::DEFAULT_TIME_ENERGY_BINS;
+const std::uint64_t VX2750EnergyHistogrammer::DEFAULT_TIME_BIN;
+const std::size_t   VX2750EnergyHistogrammer::MAX_TIME_BYTES;
+const char          VX2750EnergyHistogrammer::MAGIC[8] = {
+    'V', 'X', '2', '7', '5', '0', 'H', '1'
+};
+const std::uint32_t VX2750EnergyHistogrammer::VERSION;
+const std::uint32_t VX2750EnergyHistogrammer::ENERGY_BY_CHANNEL;
+const std::uint32_t VX2750EnergyHistogrammer::ENERGY_VS_TIME;
+
+// Bits in a hit's energy:
+
+static const unsigned ENERGY_BITS = 16;
+
+/**
+ * energyShift
+ *  @param bins - number of energy bins.
+ *  @return unsigned - shift that takes an energy to its bin.
+ *  @throw std::invalid_argument - bins is not a power of 2 no bigger than
+ *         the energy range.
+ */
+static unsigned
+energyShift(unsigned bins)
+{
+    for (unsigned bits = 0; bits <= ENERGY_BITS; bits++) {
+        if (bins == (1U << bits)) return ENERGY_BITS - bits;
+    }
+    throw std::invalid_argument("Energy bins must be a power of 2 no larger than 65536");
+}
+/**
+ * maxTimeRows
+ *  @param bins - energy bins per energy vs. time row.
+ *  @return std::uint64_t - the most rows that fit in MAX_TIME_BYTES.
+ */
+static std::uint64_t
+maxTimeRows(unsigned bins)
+{
+    return VX2750EnergyHistogrammer::MAX_TIME_BYTES / (bins*sizeof(std::uint64_t));
+}
+/**
+ * reserveRows
+ *    Make room for more energy vs. time rows.  Capacity grows
+ *    geometrically, as a vector's does, but never past the row limit so
+ *    the histogram's memory really is bounded by MAX_TIME_BYTES.
+ *  @param counts  - the histogram's counts.
+ *  @param rows    - rows it will need.
+ *  @param bins    - energy bins per row.
+ *  @param maxRows - the row limit.
+ */
+static void
+reserveRows(
+    std::vector<std::uint64_t>& counts, std::uint64_t rows, unsigned bins,
+    std::uint64_t maxRows
+)
+{
+    std::uint64_t needed = rows*bins;
+    if (needed <= counts.capacity()) return;
+    std::uint64_t capacity = std::max(needed, std::uint64_t(2*counts.capacity()));
+    counts.reserve(std::min(capacity, maxRows*bins));
+}
+/**
+ * timeRow
+ *    Find the energy vs. time row for a time bin, adding rows as needed.
+ *  @param h       - the module's histograms.
+ *  @param timeBin - the time bin.
+ *  @param bins    - energy bins per row.
+ *  @return std::uint64_t* - the row or nullptr if the histogram would need
+ *          more than MAX_TIME_BYTES.
+ */
+static std::uint64_t*
+timeRow(
+    VX2750EnergyHistogrammer::ModuleHistograms& h, std::uint64_t timeBin, unsigned bins
+)
+{
+    std::uint64_t maxRows = maxTimeRows(bins);
+    std::uint64_t rows = h.s_energyTime.size() / bins;
+    if (rows == 0) {
+        h.s_firstTimeBin = timeBin;
+        h.s_energyTime.resize(bins, 0);
+        return h.s_energyTime.data();
+    }
+    if (timeBin < h.s_firstTimeBin) {
+        std::uint64_t more = h.s_firstTimeBin - timeBin;
+        if (more > maxRows - rows) return nullptr;
+        reserveRows(h.s_energyTime, rows + more, bins, maxRows);
+        h.s_energyTime.insert(h.s_energyTime.begin(), more*bins, 0);
+        h.s_firstTimeBin = timeBin;
+    } else if (timeBin - h.s_firstTimeBin >= rows) {
+        std::uint64_t needed = timeBin - h.s_firstTimeBin + 1;
+        if (needed > maxRows) return nullptr;
+        reserveRows(h.s_energyTime, needed, bins, maxRows);
+        h.s_energyTime.resize(needed*bins, 0);
+    }
+    return h.s_energyTime.data() + (timeBin - h.s_firstTimeBin)*bins;
+}
+
+/**
+ * @class HistogramFiller
+ *    Hit visitor that fills one thread's histograms.  Hits mostly come in
+ *    runs from one module so the last module used is checked first.
+ */
+class HistogramFiller : public VX2750HitVisitor
+{
+public:
+    typedef VX2750EnergyHistogrammer::ModuleHistograms ModuleHistograms;
+
+    std::vector<ModuleHistograms> m_modules;
+private:
+    unsigned          m_energyBins;
+    unsigned          m_energyShift;
+    unsigned          m_timeEnergyBins;
+    unsigned          m_timeEnergyShift;
+    std::uint64_t     m_timeBin;
+    ModuleHistograms* m_pLast;
+public:
+    HistogramFiller(unsigned energyBins, unsigned timeEnergyBins, std::uint64_t timeBin) :
+        m_energyBins(energyBins), m_energyShift(energyShift(energyBins)),
+        m_timeEnergyBins(timeEnergyBins), m_timeEnergyShift(energyShift(timeEnergyBins)),
+        m_timeBin(timeBin), m_pLast(nullptr)
+    {
+        m_modules.reserve(16);
+    }
+    virtual void hit(const VX2750Hit& hit) {
+        ModuleHistograms& h(module(hit.s_moduleName));
+        h.s_hits++;
+        if (hit.s_channel >= VX2750EnergyHistogrammer::CHANNELS) {
+            h.s_badChannels++;
+            return;
+        }
+        h.s_energy[hit.s_channel*m_energyBins + (hit.s_energy >> m_energyShift)]++;
+
+        std::uint64_t timeBin = hit.s_timestamp / m_timeBin;
+        std::uint64_t rows    = h.s_energyTime.size() / m_timeEnergyBins;
+        std::uint64_t* pRow;
+        if (timeBin >= h.s_firstTimeBin && timeBin - h.s_firstTimeBin < rows) {
+            pRow = h.s_energyTime.data() + (timeBin - h.s_firstTimeBin)*m_timeEnergyBins;
+        } else {
+            pRow = timeRow(h, timeBin, m_timeEnergyBins);
+        }
+        if (pRow) {
+            pRow[hit.s_energy >> m_timeEnergyShift]++;
+        } else {
+            h.s_timeOverflows++;
+        }
+    }
+private:
+    ModuleHistograms& module(const char* name) {
+        if (m_pLast && m_pLast->s_module == name) return *m_pLast;
+        for (auto& m : m_modules) {
+            if (m.s_module == name) {
+                m_pLast = &m;
+                return m;
+            }
+        }
+        m_modules.emplace_back(name, m_energyBins);
+        m_pLast = &m_modules.back();
+        return *m_pLast;
+    }
+};
+
+/**
+ * ModuleHistograms constructor
+ *  @param module     - module name.
+ *  @param energyBins - bins in each channel's energy spectrum.
+ */
+VX2750EnergyHistogrammer::ModuleHistograms::ModuleHistograms(
+    const std::string& module, unsigned energyBins
+) :
+    s_module(module), s_energy(CHANNELS*energyBins, 0), s_firstTimeBin(0),
+    s_hits(0), s_badChannels(0), s_timeOverflows(0)
+{}
+
+/**
+ * constructor
+ *  @param energyBins     - bins in each channel's energy spectrum.
+ *  @param timeEnergyBins - energy bins of each energy vs. time row.
+ *  @param timeBin        - ns per energy vs. time row.
+ *  @throw std::invalid_argument - a bin count is not a power of 2 up to
+ *         65536 or the time bin is zero.
+ */
+VX2750EnergyHistogrammer::VX2750EnergyHistogrammer(
+    unsigned energyBins, unsigned timeEnergyBins, std::uint64_t timeBin
+) :
+    m_energyBins(energyBins), m_timeEnergyBins(timeEnergyBins), m_timeBin(timeBin)
+{
+    energyShift(energyBins);
+    energyShift(timeEnergyBins);
+    if (timeBin == 0) {
+        throw std::invalid_argument("The time bin must be at least 1 ns");
+    }
+}
+/**
+ * destructor
+ */
+VX2750EnergyHistogrammer::~VX2750EnergyHistogrammer()
+{}
+
+/**
+ * getMaxTimeBins
+ *  @return std::size_t - the most time bins an energy vs. time histogram
+ *          can have; it is limited to MAX_TIME_BYTES.
+ */
+std::size_t
+VX2750EnergyHistogrammer::getMaxTimeBins() const
+{
+    return maxTimeRows(m_timeEnergyBins);
+}
+/**
+ * findModule
+ *  @param module - module name.
+ *  @return const ModuleHistograms* - its histograms, nullptr if it had no hits.
+ */
+const VX2750EnergyHistogrammer::ModuleHistograms*
+VX2750EnergyHistogrammer::findModule(const char* module) const
+{
+    for (auto& m : m_modules) {
+        if (m.s_module == module) return &m;
+    }
+    return nullptr;
+}
+/**
+ * addFile
+ *    Histogram the hits in an event file.  Each thread fills its own
+ *    histograms which are then added to the totals.
+ *  @param file    - the file.
+ *  @param threads - number of decoding threads.
+ *  @return VX2750OfflineDecoder::Statistics - what was in the file.
+ */
+VX2750OfflineDecoder::Statistics
+VX2750EnergyHistogrammer::addFile(const VX2750EventFile& file, unsigned threads)
+{
+    auto chunks = file.chunks(threads);
+    std::vector<HistogramFiller> fillers(
+        chunks.size(), HistogramFiller(m_energyBins, m_timeEnergyBins, m_timeBin)
+    );
+    std::vector<VX2750HitVisitor*> visitors;
+    for (auto& f : fillers) visitors.push_back(&f);
+    VX2750OfflineDecoder decoder(file);
+    auto stats = decoder.decode(chunks, visitors);
+
+    for (auto& f : fillers) {
+        for (auto& from : f.m_modules) {
+            ModuleHistograms& to(module(from.s_module));
+            if (to.s_hits == 0) {                    // New; just take these.
+                std::swap(to, from);
+                continue;
+            }
+            to.s_hits          += from.s_hits;
+            to.s_badChannels   += from.s_badChannels;
+            to.s_timeOverflows += from.s_timeOverflows;
+            for (std::size_t i = 0; i < to.s_energy.size(); i++) {
+                to.s_energy[i] += from.s_energy[i];
+            }
+            std::size_t rows = from.s_energyTime.size() / m_timeEnergyBins;
+            for (std::size_t r = 0; r < rows; r++) {
+                const std::uint64_t* pFrom = from.s_energyTime.data() + r*m_timeEnergyBins;
+                std::uint64_t* pTo = timeRow(to, from.s_firstTimeBin + r, m_timeEnergyBins);
+                for (unsigned i = 0; i < m_timeEnergyBins; i++) {
+                    if (pTo) {
+                        pTo[i] += pFrom[i];
+                    } else {
+                        to.s_timeOverflows += pFrom[i];
+                    }
+                }
+            }
+        }
+    }
+    return stats;
+}
+/**
+ * writeBinary
+ *    Write the histograms in binary form (see the class comment).
+ *  @param filename - file to write.
+ *  @throw std::system_error - the file can't be written.
+ */
+void
+VX2750EnergyHistogrammer::writeBinary(const char* filename) const
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+    try {
+        FileHeader header;
+        memcpy(header.s_magic, MAGIC, sizeof(header.s_magic));
+        header.s_version    = VERSION;
+        header.s_histograms = 2*m_modules.size();
+        write(fd, &header, sizeof(header));
+
+        std::uint64_t energyWidth = (1U << ENERGY_BITS) / m_energyBins;
+        std::uint64_t timeEnergyWidth = (1U << ENERGY_BITS) / m_timeEnergyBins;
+        for (auto& m : m_modules) {
+            HistogramHeader h = {
+                ENERGY_BY_CHANNEL, std::uint32_t(m.s_module.size()), CHANNELS, m_energyBins,
+                0, 1, energyWidth
+            };
+            write(fd, &h, sizeof(h));
+            write(fd, m.s_module.data(), m.s_module.size());
+            write(fd, m.s_energy.data(), m.s_energy.size()*sizeof(std::uint64_t));
+
+            h.s_type    = ENERGY_VS_TIME;
+            h.s_xBins   = m.s_energyTime.size() / m_timeEnergyBins;
+            h.s_yBins   = m_timeEnergyBins;
+            h.s_xOrigin = m.s_firstTimeBin * m_timeBin;
+            h.s_xWidth  = m_timeBin;
+            h.s_yWidth  = timeEnergyWidth;
+            write(fd, &h, sizeof(h));
+            write(fd, m.s_module.data(), m.s_module.size());
+            write(fd, m.s_energyTime.data(), m.s_energyTime.size()*sizeof(std::uint64_t));
+        }
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    if (close(fd)) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+}
+/**
+ * writeAscii
+ *    Write the histograms as text (see the class comment).
+ *  @param filename - file to write.
+ *  @throw std::system_error - the file can't be written.
+ */
+void
+VX2750EnergyHistogrammer::writeAscii(const char* filename) const
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+    try {
+        std::uint64_t energyWidth = (1U << ENERGY_BITS) / m_energyBins;
+        std::uint64_t timeEnergyWidth = (1U << ENERGY_BITS) / m_timeEnergyBins;
+        for (auto& m : m_modules) {
+            std::stringstream text;
+            text << "# energy-by-channel " << m.s_module << " " << CHANNELS
+                << " 0 1 " << m_energyBins << " " << energyWidth << "\n";
+            for (unsigned c = 0; c < CHANNELS; c++) {
+                for (unsigned e = 0; e < m_energyBins; e++) {
+                    std::uint64_t n = m.s_energy[c*m_energyBins + e];
+                    if (n) text << c << " " << e*energyWidth << " " << n << "\n";
+                }
+            }
+            text << "\n";
+
+            std::size_t rows = m.s_energyTime.size() / m_timeEnergyBins;
+            text << "# energy-vs-time " << m.s_module << " " << rows << " "
+                << m.s_firstTimeBin*m_timeBin << " " << m_timeBin << " "
+                << m_timeEnergyBins << " " << timeEnergyWidth << "\n";
+            for (std::size_t r = 0; r < rows; r++) {
+                for (unsigned e = 0; e < m_timeEnergyBins; e++) {
+                    std::uint64_t n = m.s_energyTime[r*m_timeEnergyBins + e];
+                    if (n) {
+                        text << (m.s_firstTimeBin + r)*m_timeBin << " "
+                            << e*timeEnergyWidth << " " << n << "\n";
+                    }
+                }
+            }
+            text << "\n";
+            std::string s = text.str();
+            write(fd, s.data(), s.size());
+        }
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    if (close(fd)) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * module
+ *  @param name - a module name.
+ *  @return ModuleHistograms& - its histograms, created if need be.  Modules
+ *          are kept in name order.
+ */
+VX2750EnergyHistogrammer::ModuleHistograms&
+VX2750EnergyHistogrammer::module(const std::string& name)
+{
+    auto p = std::lower_bound(m_modules.begin(), m_modules.end(), name,
+        [](const ModuleHistograms& m, const std::string& n) { return m.s_module < n; }
+    );
+    if (p == m_modules.end() || p->s_module != name) {
+        p = m_modules.insert(p, ModuleHistograms(name, m_energyBins));
+    }
+    return *p;
+}
+/**
+ * write
+ *    Write data, retrying partial writes.
+ *  @param fd    - where.
+ *  @param pData - what.
+ *  @param bytes - how much.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750EnergyHistogrammer::write(int fd, const void* pData, std::size_t bytes)
+{
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(pData);
+    while (bytes) {
+        ssize_t n = ::write(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "Writing histograms");
+        }
+        p     += n;
+        bytes -= n;
+    }
+}
+}                                     // caen_offline namespace
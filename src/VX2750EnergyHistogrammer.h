@@ -0,0 +1,135 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750EnergyHistogrammer.h
+* @brief    Quick look energy spectra from event files.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750ENERGYHISTOGRAMMER_H
+#define VX2750ENERGYHISTOGRAMMER_H
+#include "VX2750OfflineDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caen_offline {
+/**
+ * @class VX2750EnergyHistogrammer
+ *    Histograms the hits in event files without SpecTcl.  For each module
+ *    two histograms are kept:
+ *
+ *    -  Energy by channel: CHANNELS rows of energy bins; row n is the
+ *       energy spectrum of channel n.
+ *    -  Energy vs. time: a row of (coarser) energy bins per time bin.  Rows
+ *       are added as hits at new times arrive.  A module's histogram is
+ *       limited to MAX_TIME_BYTES (and so is each thread's); hits that
+ *       would need more rows are counted but left out of this histogram.
+ *
+ *    Energies are 16 bits and bin counts are powers of two so binning is a
+ *    shift.  Each histogram is one contiguous array.  Each decoding
+ *    thread fills its own histograms so filling takes no locks.  The
+ *    threads' histograms are summed when each file is done.
+ *
+ *    Histograms are written in a binary or ASCII form.  The binary file
+ *    (all little endian) is a FileHeader then, for each histogram, a
+ *    HistogramHeader, the module name and s_xBins*s_yBins uint64_t counts:
+ *    count (x, y) is at x*s_yBins + y.  x is the channel or time bin; y
+ *    is the energy bin.  Bin i of an axis starts at s_origin + i*s_width.
+ *    The ASCII form has a '#' line like the header for each histogram,
+ *    then an "x y count" line, using the low edges of the bins, for each
+ *    nonzero bin.  A blank line ends each histogram.
+ */
+class VX2750EnergyHistogrammer {
+public:
+    static const unsigned      CHANNELS = 64;
+    static const unsigned      DEFAULT_ENERGY_BINS      = 4096;
+    static const unsigned      DEFAULT_TIME_ENERGY_BINS = 256;
+    static const std::uint64_t DEFAULT_TIME_BIN         = 1000000000;   // ns
+    static const std::size_t   MAX_TIME_BYTES           = 64*1024*1024;
+
+    static const char          MAGIC[8];
+    static const std::uint32_t VERSION = 1;
+    static const std::uint32_t ENERGY_BY_CHANNEL = 1;
+    static const std::uint32_t ENERGY_VS_TIME    = 2;
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        char          s_magic[8];
+        std::uint32_t s_version;
+        std::uint32_t s_histograms;
+    };
+    struct HistogramHeader {
+        std::uint32_t s_type;
+        std::uint32_t s_nameBytes;          // The name follows, no terminator.
+        std::uint32_t s_xBins;
+        std::uint32_t s_yBins;
+        std::uint64_t s_xOrigin;
+        std::uint64_t s_xWidth;
+        std::uint64_t s_yWidth;             // y starts at 0.
+    };
+#pragma pack(pop)
+
+    // A module's histograms:
+
+    struct ModuleHistograms {
+        std::string                s_module;
+        std::vector<std::uint64_t> s_energy;        // CHANNELS x energy bins.
+        std::uint64_t              s_firstTimeBin;  // Time of row 0 / time bin.
+        std::vector<std::uint64_t> s_energyTime;    // Time bins x energy bins.
+        std::uint64_t              s_hits;
+        std::uint64_t              s_badChannels;   // Channel >= CHANNELS.
+        std::uint64_t              s_timeOverflows; // Left out of s_energyTime.
+
+        ModuleHistograms(const std::string& module, unsigned energyBins);
+    };
+private:
+    unsigned                      m_energyBins;
+    unsigned                      m_timeEnergyBins;
+    std::uint64_t                 m_timeBin;
+    std::vector<ModuleHistograms> m_modules;        // By name.
+public:
+    VX2750EnergyHistogrammer(
+        unsigned energyBins = DEFAULT_ENERGY_BINS,
+        unsigned timeEnergyBins = DEFAULT_TIME_ENERGY_BINS,
+        std::uint64_t timeBin = DEFAULT_TIME_BIN
+    );
+    virtual ~VX2750EnergyHistogrammer();
+private:
+    VX2750EnergyHistogrammer(const VX2750EnergyHistogrammer&);
+    VX2750EnergyHistogrammer& operator=(const VX2750EnergyHistogrammer&);
+public:
+    unsigned      getEnergyBins() const { return m_energyBins; }
+    unsigned      getTimeEnergyBins() const { return m_timeEnergyBins; }
+    std::size_t   getMaxTimeBins() const;
+    std::uint64_t getTimeBin() const { return m_timeBin; }
+    const std::vector<ModuleHistograms>& getModules() const { return m_modules; }
+    const ModuleHistograms* findModule(const char* module) const;
+
+    VX2750OfflineDecoder::Statistics addFile(
+        const VX2750EventFile& file, unsigned threads = 1
+    );
+    void writeBinary(const char* filename) const;
+    void writeAscii(const char* filename) const;
+private:
+    ModuleHistograms& module(const std::string& name);
+    static void       write(int fd, const void* pData, std::size_t bytes);
+};
+}                                     // caen_offline namespace
+#endif
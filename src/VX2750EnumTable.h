@@ -0,0 +1,214 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750EnumTable.h
+* @brief    Case blind, bidirectional string <-> enum conversion table.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750ENUMTABLE_H
+#define VX2750ENUMTABLE_H
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+namespace caen_nscldaq {
+/**
+ * @class VX2750EnumTable
+ *    The digitizer's enumerated parameters are strings on the wire and
+ *    enums in the VX2750Pha API.  Each parameter has one of these tables
+ *    which converts in both directions:
+ *
+ *    -  find(string) is case blind and uses a perfect hash over the
+ *       case folded names; the hash seed is chosen when the table is
+ *       built so that no two names share a slot.  A lookup is therefore
+ *       a hash, one slot and one case blind compare with no allocation.
+ *    -  name(enum) indexes an array by the enumerated value.
+ *
+ *    The first name given for a value is the one name() returns.
+ *    Tables are built once, at static initialization time.
+ *
+ *    find() returns a pointer to a name/value pair (nullptr if there's
+ *    no match) so code written against the std::map tables that used
+ *    to be here, table.find(s)->second, still works.
+ */
+template<class T>
+class VX2750EnumTable {
+public:
+    typedef std::pair<std::string, T> Entry;
+private:
+    std::vector<Entry> m_entries;   // In definition order.
+    std::vector<int>   m_slots;     // Hash slot -> index in m_entries or -1.
+    std::uint32_t      m_seed;
+    std::vector<int>   m_names;     // Enum value -> index in m_entries or -1.
+public:
+    VX2750EnumTable(std::initializer_list<Entry> entries);
+
+    const Entry* find(const std::string& name) const;
+    const Entry* find(const char* name, size_t length) const;
+    const std::string* name(T value) const;
+    const std::vector<Entry>& entries() const { return m_entries; }
+    size_t size() const { return m_entries.size(); }
+private:
+    static std::uint32_t hash(const char* name, size_t length, std::uint32_t seed);
+    static char fold(char c) {
+        return ((c >= 'a') && (c <= 'z')) ? (c - 'a' + 'A') : c;
+    }
+    static bool sameName(const std::string& s, const char* name, size_t length);
+    bool placeAll();
+};
+
+/**
+ * constructor
+ *    Index the entries.  The hash table has at least twice as many slots
+ *    as entries; we try seeds until one places every name in its own
+ *    slot, doubling the table if a few hundred seeds don't work.
+ * @param entries - name/value pairs.
+ * @throw std::logic_error - Two names differ only in case or an
+ *        enumerated value is negative.
+ */
+template<class T>
+VX2750EnumTable<T>::VX2750EnumTable(std::initializer_list<Entry> entries) :
+    m_entries(entries), m_seed(0)
+{
+    // Enum -> name array, first name wins:
+
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        int value = static_cast<int>(m_entries[i].second);
+        if (value < 0) {
+            throw std::logic_error("VX2750EnumTable - negative enumerated value");
+        }
+        if (value >= static_cast<int>(m_names.size())) {
+            m_names.resize(value + 1, -1);
+        }
+        if (m_names[value] < 0) m_names[value] = i;
+    }
+    // Perfect hash of the names:
+
+    size_t nSlots = 1;
+    while (nSlots < 2*m_entries.size()) nSlots *= 2;
+    while(true) {
+        m_slots.assign(nSlots, -1);
+        for (m_seed = 1; m_seed < 512; m_seed++) {
+            if (placeAll()) return;
+        }
+        if (nSlots > 64*m_entries.size()) {
+            throw std::logic_error("VX2750EnumTable - names differ only in case");
+        }
+        nSlots *= 2;
+    }
+}
+/**
+ * find
+ *    Case blind lookup of a name.
+ * @param name - the name to look up.
+ * @return const Entry* - pointer to the matching name/value pair or
+ *         nullptr if there's no match.
+ */
+template<class T>
+const typename VX2750EnumTable<T>::Entry*
+VX2750EnumTable<T>::find(const std::string& name) const
+{
+    return find(name.c_str(), name.size());
+}
+template<class T>
+const typename VX2750EnumTable<T>::Entry*
+VX2750EnumTable<T>::find(const char* name, size_t length) const
+{
+    if (m_slots.empty()) return nullptr;
+
+    int index = m_slots[hash(name, length, m_seed) & (m_slots.size() - 1)];
+    if ((index >= 0) && sameName(m_entries[index].first, name, length)) {
+        return &(m_entries[index]);
+    }
+    return nullptr;
+}
+/**
+ * name
+ *    @param value - an enumerated value.
+ *    @return const std::string* - Its name or nullptr if it has none.
+ */
+template<class T>
+const std::string*
+VX2750EnumTable<T>::name(T value) const
+{
+    int v = static_cast<int>(value);
+    if ((v < 0) || (v >= static_cast<int>(m_names.size())) || (m_names[v] < 0)) {
+        return nullptr;
+    }
+    return &(m_entries[m_names[v]].first);
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * hash
+ *    FNV-1a over the case folded characters, perturbed by the seed.
+ */
+template<class T>
+std::uint32_t
+VX2750EnumTable<T>::hash(const char* name, size_t length, std::uint32_t seed)
+{
+    std::uint32_t h = 2166136261U ^ (seed * 0x9e3779b9U);
+    for (size_t i = 0; i < length; i++) {
+        h ^= static_cast<unsigned char>(fold(name[i]));
+        h *= 16777619U;
+    }
+    h ^= h >> 15;                 // FNV's low bits are weak for short keys.
+    return h;
+}
+/**
+ * sameName
+ *    @return bool - true if s and name are equal ignoring case.
+ */
+template<class T>
+bool
+VX2750EnumTable<T>::sameName(const std::string& s, const char* name, size_t length)
+{
+    if (s.size() != length) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (fold(s[i]) != fold(name[i])) return false;
+    }
+    return true;
+}
+/**
+ * placeAll
+ *    Try to put all of the entries into m_slots using m_seed.
+ * @return bool - false if there was a collision.
+ */
+template<class T>
+bool
+VX2750EnumTable<T>::placeAll()
+{
+    std::fill(m_slots.begin(), m_slots.end(), -1);
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const std::string& s(m_entries[i].first);
+        size_t slot = hash(s.c_str(), s.size(), m_seed) & mask;
+        if (m_slots[slot] >= 0) return false;
+        m_slots[slot] = i;
+    }
+    return true;
+}
+}                                        // caen_nscldaq namespace.
+#endif
@@ -24,6 +24,7 @@
 #include "VX2750EventBuiltEventProcessor.h"
 #include "VX2750ModuleUnpacker.h"
 #include "VX2750EventProcessor.h"
+#include <iostream>
 
 
 namespace caen_spectcl {
@@ -62,10 +63,16 @@ namespace caen_spectcl {
      *    - m_createdModuleUnpackersis a vector of event processors we created
      *                          as a result of calls to addEventProcessor.
      *                          these will be deleted in the destructor.
+     *    - m_dispatch        - event processors indexed by source id for
+     *                          direct dispatch (nullptr for unused ids).
+     *    - m_lastEvent, m_touched - which processors got data in the last
+     *                          event when dispatching directly so that only
+     *                          those need to be reset.
      */
     VX2750EventBuiltEventProcessor::VX2750EventBuiltEventProcessor(
         std::string baseName
-    )   : CEventBuilderEventProcessor(1000.0, baseName)
+    )   : CEventBuilderEventProcessor(1000.0, baseName),
+        m_directDispatch(false), m_eventNumber(0), m_touchedValid(false)
     {}
     /**
      * destructor
@@ -101,6 +108,13 @@ namespace caen_spectcl {
     {
         CEventBuilderEventProcessor::addEventProcessor(sourceId, processor);
         m_eventProcessors.push_back(&processor);
+        
+        if (sourceId >= m_dispatch.size()) {
+            m_dispatch.resize(sourceId + 1, nullptr);
+            m_lastEvent.resize(sourceId + 1, 0);
+        }
+        m_dispatch[sourceId] = &processor;
+        m_touchedValid = false;          // Replaced processor may have data.
     }
     /**
      * addEventProcessor
@@ -142,12 +156,39 @@ namespace caen_spectcl {
         addEventProcessor(sourceId, *pUnpacker);
     }
     
+    /**
+     * setDirectDispatch
+     *    Select how fragments get to the module unpackers.  Normally the
+     *    base class does this and, along the way, computes its diagnostic
+     *    parameters.  With direct dispatch on, we walk the fragments
+     *    ourselves, look up the event processor for each fragment's source
+     *    id in a table indexed by source id and have it unpack the fragment
+     *    directly.  The diagnostic parameters are then not computed.
+     *    Only the unpackers that got data in the previous event are reset.
+     *  @param enable - true to turn on direct dispatch.
+     */
+    void
+    VX2750EventBuiltEventProcessor::setDirectDispatch(bool enable)
+    {
+        m_directDispatch = enable;
+        m_touchedValid   = false;
+    }
+    /**
+     * isDirectDispatch
+     *   @return bool - true if direct dispatch is on.
+     */
+    bool
+    VX2750EventBuiltEventProcessor::isDirectDispatch() const
+    {
+        return m_directDispatch;
+    }
     /**
      * operator()
      *    This is called to process each event.
      *    What we need to do is iterate over the event processors we _have_
      *    and reset their module unpackers.  Once that's done, we can turn over
-     *    control to the base class's operator().
+     *    control to the base class's operator() or, if direct dispatch is
+     *    on, unpack the fragments ourselves.
      * @note we don't need to know the meaning of the parameters, however they
      *    are standard for CEventProcessor derived classes and, if you are
      *    curious look at the reference page for CEventProcessor at:
@@ -161,13 +202,101 @@ namespace caen_spectcl {
         CBufferDecoder& rDecoder
     )
     {
-        for (auto p : m_eventProcessors) {
-            p->resetUnpacker();
+        resetUnpackers();
+        if (m_directDispatch) {
+            return dispatchFragments(pEvent);
         }
         return CEventBuilderEventProcessor::operator()(
             pEvent, rEvent, rAnalyzer, rDecoder
         );
         
     }
+    ///////////////////////////////////////////////////////////////////////////
+    // Private utilities.
+    
+    /**
+     * resetUnpackers
+     *    Reset the module unpackers before an event.  If the last event was
+     *    dispatched directly, we know which unpackers got data and only
+     *    reset those.  Otherwise all of them are reset.
+     */
+    void
+    VX2750EventBuiltEventProcessor::resetUnpackers()
+    {
+        if (m_touchedValid) {
+            for (auto p : m_touched) {
+                p->resetUnpacker();
+            }
+        } else {
+            for (auto p : m_eventProcessors) {
+                p->resetUnpacker();
+            }
+        }
+        m_touched.clear();
+        m_touchedValid = m_directDispatch;
+        m_eventNumber++;
+    }
+    /**
+     * dispatchFragments
+     *    Walk the fragments of an event built event handing each one
+     *    to the processor for its source id.  Fragments from sources with no
+     *    processor are skipped.  The event body is:
+     *    -  uint32_t number of bytes in the body (including this).
+     *    -  Fragments, each of which is a fragment header (uint64_t timestamp,
+     *       uint32_t source id, uint32_t payload bytes, uint32_t barrier type)
+     *       followed by the payload: a ring item whose body is what the
+     *       module's event processor wants.
+     * @param pEvent - pointer to the event body.
+     * @return Bool_t - kfFALSE if the event is malformed or a fragment could
+     *        not be unpacked.
+     */
+    Bool_t
+    VX2750EventBuiltEventProcessor::dispatchFragments(const Address_t pEvent)
+    {
+        const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(pEvent);
+        std::uint32_t bodyBytes = *reinterpret_cast<const std::uint32_t*>(p);
+        const std::uint8_t* pEnd = p + bodyBytes;
+        p += sizeof(std::uint32_t);
+        
+        const size_t fragHeaderBytes = sizeof(std::uint64_t) + 3*sizeof(std::uint32_t);
+        while (p < pEnd) {
+            if (size_t(pEnd - p) < fragHeaderBytes) {
+                std::cerr << "VX2750EventBuiltEventProcessor: truncated fragment header\n";
+                return kfFALSE;
+            }
+            const std::uint32_t* pHeader =
+                reinterpret_cast<const std::uint32_t*>(p + sizeof(std::uint64_t));
+            std::uint32_t sourceId     = pHeader[0];
+            std::uint32_t payloadBytes = pHeader[1];
+            const std::uint8_t* pPayload = p + fragHeaderBytes;
+            p = pPayload + payloadBytes;
+            if (p > pEnd) {
+                std::cerr << "VX2750EventBuiltEventProcessor: fragment from source "
+                    << sourceId << " runs past the end of the event\n";
+                return kfFALSE;
+            }
+            if ((sourceId >= m_dispatch.size()) || !m_dispatch[sourceId]) {
+                continue;                           // Not ours.
+            }
+            VX2750EventProcessor* pProcessor = m_dispatch[sourceId];
+            if (m_lastEvent[sourceId] != m_eventNumber) {
+                m_lastEvent[sourceId] = m_eventNumber;
+                m_touched.push_back(pProcessor);
+            }
+            // The payload is a ring item: uint32_t size, uint32_t type then
+            // the body header size which is 0 (or sizeof(uint32_t)) if
+            // there's no body header else includes itself:
+            
+            const std::uint32_t* pItem = reinterpret_cast<const std::uint32_t*>(pPayload);
+            std::uint32_t bodyHeaderBytes = pItem[2];
+            if (bodyHeaderBytes < sizeof(std::uint32_t)) {
+                bodyHeaderBytes = sizeof(std::uint32_t);
+            }
+            if (!pProcessor->unpack(pPayload + 2*sizeof(std::uint32_t) + bodyHeaderBytes)) {
+                return kfFALSE;
+            }
+        }
+        return kfTRUE;
+    }
     
 }                              // caen_spectcl namespace.
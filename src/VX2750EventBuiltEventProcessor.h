@@ -27,6 +27,7 @@
 #include "CEventBuilderEventProcessor.h"
 #include <vector>
 #include <string>
+#include <cstdint>
 
 namespace caen_spectcl {
     class VX2750ModuleUnpacker;
@@ -48,6 +49,15 @@ namespace caen_spectcl {
         std::vector<VX2750EventProcessor*> m_createdEventProcessors;
         std::vector<VX2750ModuleUnpacker*> m_createdModuleUnpackers;
         
+        // Direct dispatch:
+        
+        bool                               m_directDispatch;
+        std::vector<VX2750EventProcessor*> m_dispatch;      // Indexed by source id.
+        std::vector<std::uint64_t>         m_lastEvent;     // Event a source was last seen.
+        std::vector<VX2750EventProcessor*> m_touched;       // Processors with data.
+        std::uint64_t                      m_eventNumber;
+        bool                               m_touchedValid;  // m_touched is complete.
+        
     public:
         VX2750EventBuiltEventProcessor(std::string baseName);
         virtual ~VX2750EventBuiltEventProcessor();
@@ -63,6 +73,12 @@ namespace caen_spectcl {
             const std::string& moduleName, const std::string paramBasename
         );
         
+        // Direct dispatch skips the base class (and its diagnostic
+        // parameters) and walks the fragments itself:
+        
+        void setDirectDispatch(bool enable);
+        bool isDirectDispatch() const;
+        
         //  Override the base class operator() so we can reset the
         // module unpackers:
         
@@ -70,7 +86,9 @@ namespace caen_spectcl {
                               CEvent& rEvent,
                               CAnalyzer& rAnalyzer,
                               CBufferDecoder& rDecoder);
-        
+    private:
+        Bool_t dispatchFragments(const Address_t pEvent);
+        void   resetUnpackers();
     };
 }                      // caen_spectcl namespace.
 
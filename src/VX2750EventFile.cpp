@@ -0,0 +1,205 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750EventFile.cpp
+* @brief    Implement the memory mapped event file.
+* @author   Ron Fox
+*
+*/
+#include "VX2750EventFile.h"
+#include <stdexcept>
+#include <system_error>
+#include <sstream>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace caen_offline {
+
+const std::uint32_t VX2750EventFile::BEGIN_RUN;
+const std::uint32_t VX2750EventFile::END_RUN;
+const std::uint32_t VX2750EventFile::PHYSICS_EVENT;
+const std::size_t   VX2750EventFile::ITEM_HEADER_SIZE;
+const std::size_t   VX2750EventFile::BODY_HEADER_SIZE;
+
+/**
+ * constructor
+ *    Map a file.
+ *  @param filename - path to the event file.
+ *  @throw std::system_error - the file can't be opened or mapped.
+ */
+VX2750EventFile::VX2750EventFile(const char* filename) :
+    m_filename(filename), m_pData(nullptr), m_size(0), m_mapped(false)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info)) {
+        int e = errno;
+        close(fd);
+        throw std::system_error(e, std::generic_category(), filename);
+    }
+    m_size = info.st_size;
+    if (m_size) {                              // Can't map an empty file.
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            int e = errno;
+            close(fd);
+            throw std::system_error(e, std::generic_category(), filename);
+        }
+        m_pData  = reinterpret_cast<const std::uint8_t*>(p);
+        m_mapped = true;
+    }
+    close(fd);                                // The mapping holds the file.
+}
+/**
+ * constructor
+ *    Wrap memory that's already been loaded.
+ *  @param pData - the data (ownership is not transferred).
+ *  @param size  - bytes of data.
+ */
+VX2750EventFile::VX2750EventFile(const void* pData, std::size_t size) :
+    m_filename("(memory)"),
+    m_pData(reinterpret_cast<const std::uint8_t*>(pData)), m_size(size),
+    m_mapped(false)
+{}
+/**
+ * destructor
+ */
+VX2750EventFile::~VX2750EventFile()
+{
+    if (m_mapped) {
+        munmap(const_cast<std::uint8_t*>(m_pData), m_size);
+    }
+}
+/**
+ * chunks
+ *    Cut the file into at most n ranges of roughly equal size.  Each range
+ *    begins on a ring item and holds only complete ring items.  Ranges
+ *    never split a ring item.  If the file ends in a partial ring item
+ *    (e.g. it's still being written) the partial item is not in any chunk.
+ *  @param n - the number of chunks desired (normally the thread count).
+ *  @param begin - offset of the ring item at which to start (e.g. the
+ *                 end of the part of the file that's already been processed).
+ *  @return std::vector<Chunk> - the chunks.  There may be fewer than n
+ *          e.g. if there are fewer than n items.  An empty file has none.
+ *  @throw std::runtime_error - a ring item has an impossible size.
+ */
+std::vector<VX2750EventFile::Chunk>
+VX2750EventFile::chunks(unsigned n, std::uint64_t begin) const
+{
+    std::vector<Chunk> result;
+    if (n == 0) n = 1;
+    if (begin > m_size) begin = m_size;
+    std::uint64_t target = (m_size - begin) / n;
+    if (target == 0) target = 1;
+
+    Chunk current = {begin, begin};
+    std::uint64_t offset = begin;
+    while (offset + sizeof(std::uint32_t) <= m_size) {
+        std::uint64_t next = nextItem(offset);
+        if (next > m_size) break;                  // Partial item.
+        offset = next;
+        if ((offset - current.s_begin) >= target && (result.size() < n - 1)) {
+            current.s_end = offset;
+            result.push_back(current);
+            current.s_begin = offset;
+        }
+    }
+    if (offset > current.s_begin) {
+        current.s_end = offset;
+        result.push_back(current);
+    }
+    return result;
+}
+/**
+ * nextItem
+ *    @param offset - offset to a ring item.
+ *    @return std::uint64_t - offset to the item following it.  This can be
+ *           past the end of the file if the item is truncated.
+ *    @throw std::runtime_error - the item's size is smaller than a ring item
+ *           header which means we've lost our place in the file.
+ */
+std::uint64_t
+VX2750EventFile::nextItem(std::uint64_t offset) const
+{
+    std::uint32_t size = *reinterpret_cast<const std::uint32_t*>(m_pData + offset);
+    if (size < 2*sizeof(std::uint32_t)) {
+        std::stringstream msg;
+        msg << m_filename << ": Invalid ring item size " << size
+            << " at offset " << offset;
+        throw std::runtime_error(msg.str());
+    }
+    return offset + size;
+}
+/**
+ * willNeed
+ *    Let the kernel know a chunk is about to be read sequentially so that
+ *    it can read ahead.  This is advice only; failures are ignored.
+ *  @param chunk - the chunk about to be read.
+ */
+void
+VX2750EventFile::willNeed(const Chunk& chunk) const
+{
+    if (!m_mapped) return;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    std::uint64_t begin = chunk.s_begin - (chunk.s_begin % pageSize);
+    madvise(
+        const_cast<std::uint8_t*>(m_pData) + begin, chunk.s_end - begin,
+        MADV_SEQUENTIAL
+    );
+    madvise(
+        const_cast<std::uint8_t*>(m_pData) + begin, chunk.s_end - begin,
+        MADV_WILLNEED
+    );
+}
+/**
+ * putPhysicsItem
+ *    Format a PHYSICS_EVENT ring item with a body header.
+ *  @param p         - where to put it; there must be room for
+ *                     ITEM_HEADER_SIZE + BODY_HEADER_SIZE + bodyBytes.
+ *  @param timestamp - body header timestamp.
+ *  @param sourceId  - body header source id.
+ *  @param pBody     - the body.
+ *  @param bodyBytes - its size.
+ *  @return std::uint8_t* - pointer just past the item.
+ */
+std::uint8_t*
+VX2750EventFile::putPhysicsItem(
+    std::uint8_t* p, std::uint64_t timestamp, std::uint32_t sourceId,
+    const void* pBody, std::uint32_t bodyBytes
+)
+{
+    std::uint32_t header[3] = {
+        std::uint32_t(ITEM_HEADER_SIZE + BODY_HEADER_SIZE + bodyBytes), PHYSICS_EVENT,
+        BODY_HEADER_SIZE
+    };
+    std::uint32_t trailer[2] = {sourceId, 0};             // sid, barrier type.
+    memcpy(p, header, sizeof(header));        p += sizeof(header);
+    memcpy(p, &timestamp, sizeof(timestamp)); p += sizeof(timestamp);
+    memcpy(p, trailer, sizeof(trailer));      p += sizeof(trailer);
+    memcpy(p, pBody, bodyBytes);
+    return p + bodyBytes;
+}
+}                                     // caen_offline namespace
@@ -0,0 +1,96 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750EventFile.h
+* @brief    Memory mapped NSCLDAQ event file.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750EVENTFILE_H
+#define VX2750EVENTFILE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caen_offline {
+/**
+ * @class VX2750EventFile
+ *    Maps an NSCLDAQ (11.x or 12.x) event file into memory read-only
+ *    so that ring items can be decoded in place.  The file can be cut into
+ *    chunks that each start on a ring item boundary so that the chunks can
+ *    be decoded in parallel.
+ *
+ *    Ring items have no synchronization marker so the only way to find item
+ *    boundaries is to hop from size to size from the start of the file.
+ *    That touches one word per item and is much cheaper than decoding.
+ *
+ *    The object can also wrap a block of memory that's already in the
+ *    process (e.g. for testing).  In that case the memory is not owned.
+ */
+class VX2750EventFile {
+public:
+    // Ring item types we care about:
+
+    static const std::uint32_t BEGIN_RUN     = 1;
+    static const std::uint32_t END_RUN       = 2;
+    static const std::uint32_t PHYSICS_EVENT = 30;
+
+    // Ring item header and 12.x body header (size, timestamp, sid, barrier):
+
+    static const std::size_t ITEM_HEADER_SIZE = 2*sizeof(std::uint32_t);
+    static const std::size_t BODY_HEADER_SIZE =
+        3*sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+    // A range of ring items: [s_begin, s_end) are file offsets.
+
+    struct Chunk {
+        std::uint64_t s_begin;
+        std::uint64_t s_end;
+    };
+private:
+    std::string         m_filename;
+    const std::uint8_t* m_pData;
+    std::size_t         m_size;
+    bool                m_mapped;          // m_pData is ours to unmap.
+public:
+    VX2750EventFile(const char* filename);
+    VX2750EventFile(const void* pData, std::size_t size);
+    virtual ~VX2750EventFile();
+private:
+    VX2750EventFile(const VX2750EventFile&);
+    VX2750EventFile& operator=(const VX2750EventFile&);
+public:
+
+    // Selectors:
+
+    const std::string&  getFilename() const { return m_filename; }
+    const std::uint8_t* data() const { return m_pData; }
+    std::size_t         size() const { return m_size; }
+
+    std::vector<Chunk> chunks(unsigned n, std::uint64_t begin = 0) const;
+    std::uint64_t      nextItem(std::uint64_t offset) const;
+    void               willNeed(const Chunk& chunk) const;
+
+    static std::uint8_t* putPhysicsItem(
+        std::uint8_t* p, std::uint64_t timestamp, std::uint32_t sourceId,
+        const void* pBody, std::uint32_t bodyBytes
+    );
+};
+}                                     // caen_offline namespace
+#endif
@@ -83,12 +83,7 @@ VX2750EventProcessor::resetUnpacker()
 /**
  *  operator()
  *     Called with a pointer to the ring item data body (that is past the
- *     body header if there is one) for our module.
- *     - Get the number of words that are supposed to be in the fragment body.
- *     - Invoke the unpacker to unpack the body.
- *     - If there's a match in the number of words it processed and the
- *       size of the event, return kfTRUE else output an error message and
- *       return kfFALSE, aborting event processing for this evenmt.
+ *     body header if there is one) for our module.  See unpack.
  *
  *   @param pEvent - pointer to the event.
  *   @note the remainder of the parameters are unused and therefore not documented here.
@@ -101,10 +96,29 @@ VX2750EventProcessor::operator()(
     CBufferDecoder& rDecoder
 )
 {
-    // Recasting pEvent as pointing to  uint32_t allows us to painlessly extract
+    return unpack(pEvent);
+}
+/**
+ * unpack
+ *     Unpack the body of a ring item for our module.
+ *     - Get the number of words that are supposed to be in the fragment body.
+ *     - Invoke the unpacker to unpack the body.
+ *     - If there's a match in the number of words it processed and the
+ *       size of the event, return kfTRUE else output an error message and
+ *       return kfFALSE, aborting event processing for this evenmt.
+ *     This is separate from operator() so VX2750EventBuiltEventProcessor
+ *     can call it directly.
+ *
+ *   @param pBody - pointer to the ring item body.
+ *   @return Bool_t - kfTRUE if event processing was successful else kfFALSE if not.
+ */
+Bool_t
+VX2750EventProcessor::unpack(const void* pBody)
+{
+    // Recasting pBody as pointing to  uint32_t allows us to painlessly extract
     // the fragment body size
     
-    const std::uint32_t* p = reinterpret_cast<std::uint32_t*>(pEvent);
+    const std::uint32_t* p = reinterpret_cast<const std::uint32_t*>(pBody);
     const std::uint8_t*   pEnd;
     std::uint32_t nWords = *p;
     
@@ -54,6 +54,7 @@ namespace caen_spectcl {
         
         VX2750ModuleUnpacker* getUnpacker();
         void                  resetUnpacker();
+        Bool_t                unpack(const void* pBody);
         
         // Interface to the CEventProcessor that we implement:
         
@@ -28,6 +28,8 @@
 #include "VX2750TclConfig.h"
 #include "VX2750PhaConfiguration.h"
 #include "VX2750Pha.h"
+#include "VX2750TracePrescaler.h"
+#include "VX2750ConnectionPool.h"
 #include <Exception.h>
 #include <stdexcept>
 #include <sstream>
@@ -52,16 +54,26 @@ namespace caen_nscldaq {
  *   @param pHostOrPid  - Host or USB PID of the module we're talking to.
  *   @param isUsb       - if true, the module is USB connected else Ethernet.
  *                        This parameter is optional and defaults to fals (ethernet).
+ *   @param pConnections - If not null, the module connection is gotten from
+ *                        this pool rather than made by us.  The connection
+ *                        then survives our destruction (e.g. when the
+ *                        configuration changes).  The caller retains ownership
+ *                        of the pool.
  */
 VX2750EventSegment::VX2750EventSegment(
         CExperiment* pExperiment, uint32_t sourceId,        
         const char* pModuleName, VX2750TclConfig* pConfig,
-        const char* pHostOrPid, bool fIsUsb
-    
+        const char* pHostOrPid, bool fIsUsb,
+        VX2750ConnectionPool* pConnections
 ) :
     m_pExperiment(pExperiment), m_sourceId(sourceId),
     m_pModule(nullptr), m_pConfiguration(pConfig), m_moduleName(pModuleName),
-    m_hostOrPid(pHostOrPid), m_isUsb(fIsUsb), m_traceSizes(nullptr)
+    m_hostOrPid(pHostOrPid), m_isUsb(fIsUsb), m_pConnections(pConnections),
+    m_traceSizes(nullptr),
+    m_pPrescaler(nullptr), m_headerSize(0), m_noTraceFragmentSize(0),
+    m_swStart(false), m_paused(false),
+    m_pStatistics(&(VX2750ReadoutStatistics::getInstance().getModule(pModuleName))),
+    m_readTimeouts(0)
 {}
 
 /**
@@ -69,29 +81,60 @@ VX2750EventSegment::VX2750EventSegment(
  *     In theory the module has already been disconnected however, just in case
  *     we have missed a use case we'll delete it here as well.
  *     The configuration is not owned by us so we leave it alone.
+ *     Neither is a pooled module.
  */
 VX2750EventSegment::~VX2750EventSegment()
 {
-    delete m_pModule;                // no-op if it's a nullptr.
+    if (!m_pConnections) {
+        delete m_pModule;                // no-op if it's a nullptr.
+    }
     delete m_traceSizes;
+    delete m_pPrescaler;
 }
 /**
  * hwInit
  *   Hardware initialize the module from the configuration.
  *   This is separated from the initialize method to support
  *   faster run starts once the module is actually initialized.
+ *   If we have a connection pool, an existing connection to the module
+ *   is re-used and only the parameters are pushed.  If that fails,
+ *   the connection is dropped from the pool so that the next attempt
+ *   reconnects in case the connection itself has gone bad.
+ *   Furthermore, if the digest of our configuration matches the digest
+ *   of the configuration last loaded into the pooled module, the module
+ *   is not reconfigured at all.
  */
 void
 VX2750EventSegment::hwInit()
 {
     try {
         auto pConfig = m_pConfiguration->getModule(m_moduleName.c_str());
-	if (m_pModule) {
-	  delete m_pModule;
-	  m_pModule = nullptr;   // in case new throws this time.
-	}
-        m_pModule = new VX2750Pha(m_hostOrPid.c_str(), m_isUsb);
-        pConfig->configureModule(*m_pModule);
+        if (m_pConnections) {
+            m_pModule = m_pConnections->get(m_hostOrPid.c_str(), m_isUsb);
+            std::string digest = pConfig->computeDigest();
+            if (digest == m_pConnections->getConfigDigest(m_hostOrPid.c_str(), m_isUsb)) {
+                std::cout << "Configuration of " << m_moduleName
+                    << " is unchanged - not reconfiguring\n";
+                return;
+            }
+            try {
+                m_pConnections->setConfigDigest(m_hostOrPid.c_str(), m_isUsb, "");
+                pConfig->configureModule(*m_pModule);
+                m_pConnections->setConfigDigest(m_hostOrPid.c_str(), m_isUsb, digest);
+            }
+            catch (...) {
+                m_pModule = nullptr;
+                m_pConnections->drop(m_hostOrPid.c_str(), m_isUsb);
+                throw;
+            }
+        } else {
+            if (m_pModule) {
+              delete m_pModule;
+              m_pModule = nullptr;   // in case new throws this time.
+            }
+            m_pModule = new VX2750Pha(m_hostOrPid.c_str(), m_isUsb);
+            pConfig->configureModule(*m_pModule);
+        }
     }
     catch (std::exception& e) {
         throw e.what();
@@ -100,6 +143,40 @@ VX2750EventSegment::hwInit()
         throw e.ReasonText();
     }
 }
+/**
+ * verify
+ *    If the module's configuration asks for it (verifyconfig), read the
+ *    configuration back from the module and compare it with what we
+ *    configured.  This is safe to call from a thread other than the one
+ *    that did the hwInit, and for several segments at once.
+ * @return VX2750PHAModuleConfiguration::Mismatches - the differences.
+ *         Empty if there are none or verification is not enabled.
+ */
+VX2750PHAModuleConfiguration::Mismatches
+VX2750EventSegment::verify()
+{
+    VX2750PHAModuleConfiguration::Mismatches result;
+    if (m_pModule) {
+        auto pConfig = m_pConfiguration->getModule(m_moduleName.c_str());
+        if (pConfig->getBoolParameter("verifyconfig")) {
+            result = pConfig->verifyModule(*m_pModule);
+        }
+    }
+    return result;
+}
+/**
+ * verifyAborts
+ *    @return bool - true if the module's configuration asks that differences
+ *            found by verify (or a failure to verify) fail the begin run
+ *            (verifyabort).
+ */
+bool
+VX2750EventSegment::verifyAborts()
+{
+    auto pConfig = m_pConfiguration->getModule(m_moduleName.c_str());
+    return pConfig->getBoolParameter("verifyconfig") &&
+        pConfig->getBoolParameter("verifyabort");
+}
 /**
  * initialize
  *    - locate our configuration in the Tcl configuration.  If we can't find it
@@ -133,8 +210,14 @@ VX2750EventSegment::initialize()
         // The configuration takes care of initializing the module:
         
         
+        // The probe buffers come from our pool which survives from run to
+        // run so this normally does not allocate:
+        
         m_pModule->initDecodedBuffer(m_Event);
-        m_pModule->setupDecodedBuffer(m_Event);
+        m_eventPool.setHugePages(pConfig->getBoolParameter("hugepagebuffers"));
+        m_pModule->setupDecodedBuffer(m_Event, m_eventPool);
+        buildFragmentTables();
+        setupPrescaler();
         
         // Set up the endpoint for PHA data based on our configuration
         // the module configuration includes enables for the things we can get
@@ -144,23 +227,25 @@ VX2750EventSegment::initialize()
         m_pModule->selectEndpoint(VX2750Pha::PHA);
         m_pModule->initializeDPPPHAReadout();
         
-        // prep the module for data taking and start it
-        // After this chunk of code the module should be able to generate triggers.
+        // If one of the start sources is SwCommand we need to start
+        // the module after arming it.  Remember that for resumes:
         
-        m_pModule->Clear();
-        m_pModule->Arm();
-        // If one of the start sources is SwCommand we need to do that:
-        //
+        m_swStart = false;
         auto startSources = pConfig->getList("startsource");
         for (auto s : startSources) {
             if (s == "SWcmd") {
                 std::cout << "SWcmd is enabled as a start source for "
                     << m_moduleName << " so invoking start\n";
-                m_pModule->Start();
+                m_swStart = true;
                 break;                     // in case there's duplication.
             }
         }
+        // prep the module for data taking and start it
+        // After this  the module should be able to generate triggers.
         
+        startAcquisition();
+        m_paused = false;
+        m_readTimeouts = m_pModule->getReadTimeouts();
         
     }
     catch (std::exception& e) {
@@ -180,6 +265,8 @@ VX2750EventSegment::disable()
 {
     delete []m_traceSizes;                 // Trace lengths might change
     m_traceSizes = nullptr;                // if config changes.
+    delete m_pPrescaler;
+    m_pPrescaler = nullptr;
     
     // Defensive programming this if an end of run in the paused state will
     // find us without a module.
@@ -187,32 +274,59 @@ VX2750EventSegment::disable()
     
     if (m_pModule) {
         m_pModule->freeDecodedBuffer(m_Event);
-        m_pModule->Stop();
-        m_pModule->Disarm();
+        stopAcquisition();
         //delete m_pModule;
         //m_pModule = nullptr;          // This disconnects.
     }
+    m_paused = false;
 }
 /**
  * onPause
- *   THe run is pausing - disable:
+ *   The run is pausing.  We only stop and disarm the module.  The
+ *   decoded buffer, trace lengths, fragment tables and the module's
+ *   endpoint setup are all kept so that resume can be fast.
  */
 void VX2750EventSegment::onPause()
 {
-    disable();
+    try {
+        if (m_pModule) {
+            stopAcquisition();
+            m_paused = true;
+        }
+    }
+    catch (std::exception& e) {
+        throw e.what();
+    }
+    catch (CException& e) {
+        throw e.ReasonText();
+    }
 }
 /**
  * onResume
- *    This is just enable again:
+ *    If we were paused via onPause, all of the readout state is intact so
+ *    we just need to re-arm and, if needed, start the module.
+ *    Otherwise (I don't know how this is possible but be defensive),
+ *    fall back to a full disable/initialize.
  */
 void VX2750EventSegment::onResume()
 {
-    // I don't know how this is possible but be defensive anyway:
-    
-    if (m_pModule) {
-        disable();                   // Get rid of the existing module.
+    if (m_paused && m_pModule && m_traceSizes) {
+        try {
+            startAcquisition();
+            m_paused = false;
+        }
+        catch (std::exception& e) {
+            throw e.what();
+        }
+        catch (CException& e) {
+            throw e.ReasonText();
+        }
+    } else {
+        if (m_pModule) {
+            disable();                   // Get rid of the existing state.
+        }
+        initialize();                    // reprocesses the configuration too.
     }
-    initialize();                        // reprocesses the configuration too.
 }
  
  /**
@@ -247,7 +361,7 @@ void VX2750EventSegment::onResume()
   *    +------------------------------------+
   *    | uint16_t t downsample selection(*) |
   *    +------------------------------------+
-  *    | uint16_t fail  flag                 |
+  *    | uint16_t fail  flags               |  See below.
   *    +------------------------------------+
   *    | uint16_t analog probe type 1  (*)  |
   *    +------------------------------------+
@@ -294,6 +408,16 @@ void VX2750EventSegment::onResume()
   *    
   *\endverbatim    
   *
+  *  The fail flags word has the digitizer's fail bit in bit 0.  If
+  *  trace bandwidth limiting is enabled for the module (tracebandwidth
+  *  configuration parameter), the bits VX2750TracePrescaler::TRACES_PRESCALED
+  *  and VX2750TracePrescaler::TRACES_SUPPRESSED mark hits from channels
+  *  that were being prescaled which, respectively, kept or dropped
+  *  their traces.  Dropped traces are written with zero samples.
+  *
+  *  The time taken to read the hit from the digitizer and to format it,
+  *  the bytes it produced and any read timeouts are added to the module's
+  *  readout statistics.
   *
   *  @param pBuffer - buffer into which we put the data.
   *  @param maxwords - maximum number of 16 bit words available in the buffer.
@@ -308,45 +432,42 @@ void VX2750EventSegment::onResume()
     // First we need to read the event into the decoded buffer:
     // FIgure out the trace sizes:
     
+    std::uint64_t readStart = VX2750ModuleStatistics::now();
     m_pModule->readDPPPHAEndpoint(m_Event);
+    std::uint64_t formatStart = VX2750ModuleStatistics::now();
     size_t traceLength = m_traceSizes[m_Event.s_channel];
     
-    // figure out if this will fit.
-    
-    
-    size_t bytesNeeded =
-        m_moduleName.size() + 1 + 7*sizeof(uint16_t) +
-        2*sizeof(uint64_t);                                      // Fixed junk:
-    if (m_moduleName.size() % 2 == 0) bytesNeeded++;          // Round to next uint16_t
-    bytesNeeded += 6*(sizeof(uint16_t) + sizeof(uint32_t));  // Always present probe stuff.
-    
-    // Fold in any present traces. Null pointers in the event indicate
-    // the trace is not enabled:
-    
-    if (m_Event.s_pAnalogProbe1) {
-        bytesNeeded += traceLength * sizeof(int32_t);
-    }
-    if (m_Event.s_pAnalogProbe2) {
-        bytesNeeded += traceLength * sizeof(int32_t);
-    }
-    size_t digitalProbeLength = traceLength;   // Byte per sample...
-    
-    if (m_Event.s_pDigitalProbe1) {
-        bytesNeeded += digitalProbeLength;
-    }
-    if (m_Event.s_pDigitalProbe2) {
-        bytesNeeded += digitalProbeLength;
-    }
-    if (m_Event.s_pDigitalProbe3) {
-        bytesNeeded += digitalProbeLength;
-    }
-    if (m_Event.s_pDigitalProbe4) {
-        bytesNeeded += digitalProbeLength;
+    // Ask the bandwidth policy what to do with the traces.  If they are
+    // suppressed we pretend the probes are disabled for this hit:
+    
+    uint16_t failFlags = m_Event.s_fail ? 1 : 0;
+    int32_t* pAnalogProbe1 = m_Event.s_pAnalogProbe1;
+    int32_t* pAnalogProbe2 = m_Event.s_pAnalogProbe2;
+    uint8_t* pDigitalProbe1 = m_Event.s_pDigitalProbe1;
+    uint8_t* pDigitalProbe2 = m_Event.s_pDigitalProbe2;
+    uint8_t* pDigitalProbe3 = m_Event.s_pDigitalProbe3;
+    uint8_t* pDigitalProbe4 = m_Event.s_pDigitalProbe4;
+    if (m_pPrescaler) {
+        switch (m_pPrescaler->decide(m_Event.s_channel, m_Event.s_nsTimestamp)) {
+        case VX2750TracePrescaler::Keep:
+            break;
+        case VX2750TracePrescaler::Prescaled:
+            failFlags |= VX2750TracePrescaler::TRACES_PRESCALED;
+            break;
+        case VX2750TracePrescaler::Suppressed:
+            failFlags |= VX2750TracePrescaler::TRACES_SUPPRESSED;
+            pAnalogProbe1 = pAnalogProbe2 = nullptr;
+            pDigitalProbe1 = pDigitalProbe2 = pDigitalProbe3 = pDigitalProbe4 = nullptr;
+            break;
+        }
     }
-    //Yeah could assume sizeof(int16_t) is 2 but...
     
-    while (bytesNeeded % sizeof(uint16_t) > 0) bytesNeeded++;
+    // figure out if this will fit.  The size only depends on the channel
+    // and was computed at initialization time:
     
+    size_t bytesNeeded = (failFlags & VX2750TracePrescaler::TRACES_SUPPRESSED) ?
+        m_noTraceFragmentSize : m_fragmentSizes[m_Event.s_channel];
+    size_t digitalProbeLength = traceLength;   // Byte per sample...
     
     // Get upset if our event won't fit in the ring item buffer:
     
@@ -373,16 +494,17 @@ void VX2750EventSegment::onResume()
     } p;
     p.p16 = reinterpret_cast<uint16_t*>(pBuffer);
     
-    // First the module name:
+    // First the module name and channel from the channel's header template:
     
-    strcpy(reinterpret_cast<char*>(p.p8), m_moduleName.c_str());
-    p.p8 += m_moduleName.size() + 1;
-    if (m_moduleName.size() % 2 == 0) *p.p8++ = 0;  // Pad to uint16_t
+    memcpy(
+        p.p8, m_headerTemplates.data() + m_Event.s_channel*m_headerSize,
+        m_headerSize
+    );
+    p.p8 += m_headerSize;
     
     // Now the fixed part... we need to do this field by field because
     // we adjust some sizes:
     
-    *p.p16++ = m_Event.s_channel;
     *p.p64++ = m_Event.s_nsTimestamp;
     m_pExperiment->setTimestamp(m_Event.s_nsTimestamp);
     *p.p64++ = m_Event.s_rawTimestamp;
@@ -391,13 +513,14 @@ void VX2750EventSegment::onResume()
     *p.p16++ = m_Event.s_lowPriorityFlags;
     *p.p16++ = m_Event.s_highPriorityFlags;
     *p.p16++ = m_Event.s_timeDownSampling;
+    *p.p16++ = failFlags;
     
     // Ok, now analog probe 1:
     
     *p.p16++ = m_Event.s_analogProbe1Type;
-    if(m_Event.s_pAnalogProbe1) {
+    if(pAnalogProbe1) {
         *p.p32++ = traceLength;
-        memcpy(p.p32, m_Event.s_pAnalogProbe1, traceLength*sizeof(uint32_t));
+        memcpy(p.p32, pAnalogProbe1, traceLength*sizeof(uint32_t));
         p.p32 += traceLength;
     } else {
       *p.p32++ = 0;        // no data.
@@ -406,9 +529,9 @@ void VX2750EventSegment::onResume()
     // Ok, now analog probe 2:
     
     *p.p16++ = m_Event.s_analogProbe2Type;
-    if(m_Event.s_pAnalogProbe2) {
+    if(pAnalogProbe2) {
         *p.p32++ = traceLength;
-        memcpy(p.p32, m_Event.s_pAnalogProbe2, traceLength*sizeof(uint32_t));
+        memcpy(p.p32, pAnalogProbe2, traceLength*sizeof(uint32_t));
         p.p32 += traceLength;
     } else {
       *p.p32++ = 0;        // no data.
@@ -418,36 +541,36 @@ void VX2750EventSegment::onResume()
     // per present probe.
     
     *p.p16++ = m_Event.s_digitalProbe1Type;
-    if (m_Event.s_pDigitalProbe1) {
+    if (pDigitalProbe1) {
         *p.p32++ = digitalProbeLength;
-        memcpy(p.p8, m_Event.s_pDigitalProbe1, digitalProbeLength);
+        memcpy(p.p8, pDigitalProbe1, digitalProbeLength);
         p.p8 += digitalProbeLength;
     } else {
         *p.p32++ = 0;
     }
     
     *p.p16++ = m_Event.s_digitalProbe2Type;
-    if (m_Event.s_pDigitalProbe2) {
+    if (pDigitalProbe2) {
         *p.p32++ = digitalProbeLength;
-        memcpy(p.p8, m_Event.s_pDigitalProbe2, digitalProbeLength);
+        memcpy(p.p8, pDigitalProbe2, digitalProbeLength);
         p.p8 += digitalProbeLength;
     } else {
         *p.p32++ = 0;
     }
     
     *p.p16++ = m_Event.s_digitalProbe2Type;
-    if (m_Event.s_pDigitalProbe3) {
+    if (pDigitalProbe3) {
         *p.p32++ = digitalProbeLength;
-        memcpy(p.p8, m_Event.s_pDigitalProbe3, digitalProbeLength);
+        memcpy(p.p8, pDigitalProbe3, digitalProbeLength);
         p.p8 += digitalProbeLength;
     } else {
         *p.p32++ = 0;
     }
     
     *p.p16++ = m_Event.s_digitalProbe4Type;
-    if (m_Event.s_pDigitalProbe4) {
+    if (pDigitalProbe4) {
         *p.p32++ = digitalProbeLength;
-        memcpy(p.p8, m_Event.s_pDigitalProbe4, digitalProbeLength);
+        memcpy(p.p8, pDigitalProbe4, digitalProbeLength);
         p.p8 += digitalProbeLength;
     } else {
         *p.p32++ = 0;
@@ -456,8 +579,120 @@ void VX2750EventSegment::onResume()
     // THe + 1 below adds an extra pad byte if bytesNeeded is odd.
     // (which I think is impossible since there are an even number
     // of digital probes).
+    
+    m_pStatistics->hit(
+        formatStart - readStart, VX2750ModuleStatistics::now() - formatStart,
+        bytesNeeded
+    );
+    std::uint64_t timeouts = m_pModule->getReadTimeouts();
+    m_pStatistics->timeouts(timeouts - m_readTimeouts);
+    m_readTimeouts = timeouts;
     return (bytesNeeded + 1) / sizeof(uint16_t);
  }
+ /**
+  * startAcquisition
+  *    Clear and arm the module and, if SWcmd is a start source,
+  *    start it.
+  */
+ void
+ VX2750EventSegment::startAcquisition()
+ {
+    m_pModule->Clear();
+    m_pModule->Arm();
+    if (m_swStart) {
+        m_pModule->Start();
+    }
+ }
+ /**
+  * stopAcquisition
+  *    Stop and disarm the module.
+  */
+ void
+ VX2750EventSegment::stopAcquisition()
+ {
+    m_pModule->Stop();
+    m_pModule->Disarm();
+ }
+ /**
+  * buildFragmentTables
+  *    Precompute what read needs to know about the fragment of each channel:
+  *    -  The header template: the module name, null terminated and padded
+  *       to a uint16_t followed by the channel number.  read just copies the
+  *       template for the hit's channel.
+  *    -  The number of bytes in a hit from each channel given its trace
+  *       length and the enabled probes.
+  *    -  The number of bytes in a hit whose traces were suppressed
+  *       (the same for all channels).
+  *    Must be called after the trace lengths are known and the decoded
+  *    buffer is set up (it's null pointers tell us which probes are disabled).
+  */
+ void
+ VX2750EventSegment::buildFragmentTables()
+ {
+    size_t nameBytes = m_moduleName.size() + 1;
+    if (nameBytes % sizeof(uint16_t)) nameBytes++;   // Pad to uint16_t.
+    m_headerSize = nameBytes + sizeof(uint16_t);     // + channel number.
+    
+    m_headerTemplates.assign(m_chans * m_headerSize, 0);
+    for (int i = 0; i < m_chans; i++) {
+        uint8_t* pTemplate = m_headerTemplates.data() + i*m_headerSize;
+        memcpy(pTemplate, m_moduleName.c_str(), m_moduleName.size());
+        uint16_t channel = i;
+        memcpy(pTemplate + nameBytes, &channel, sizeof(uint16_t));
+    }
+    // Fixed stuff: the header, two uint64_t timestamps, six uint16_t fields
+    // and the type/length of the six probes:
+    
+    m_noTraceFragmentSize = m_headerSize + 2*sizeof(uint64_t) +
+        6*sizeof(uint16_t) + 6*(sizeof(uint16_t) + sizeof(uint32_t));
+    
+    size_t bytesPerSample = 0;
+    if (m_Event.s_pAnalogProbe1) bytesPerSample += sizeof(int32_t);
+    if (m_Event.s_pAnalogProbe2) bytesPerSample += sizeof(int32_t);
+    if (m_Event.s_pDigitalProbe1) bytesPerSample++;   // Byte per sample.
+    if (m_Event.s_pDigitalProbe2) bytesPerSample++;
+    if (m_Event.s_pDigitalProbe3) bytesPerSample++;
+    if (m_Event.s_pDigitalProbe4) bytesPerSample++;
+    
+    m_fragmentSizes.resize(m_chans);
+    for (int i = 0; i < m_chans; i++) {
+        size_t bytes = m_noTraceFragmentSize + m_traceSizes[i]*bytesPerSample;
+        
+        //Yeah could assume sizeof(int16_t) is 2 but...
+        
+        while (bytes % sizeof(uint16_t) > 0) bytes++;
+        m_fragmentSizes[i] = bytes;
+    }
+ }
+ 
  
+/////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * setupPrescaler
+ *    Create the trace bandwidth policy object if the module configuration
+ *    asks for one (nonzero tracebandwidth).  Must be called after
+ *    buildFragmentTables as the difference between the fragment size with and
+ *    without traces is the number of bytes of trace each hit carries.
+ */
+void
+VX2750EventSegment::setupPrescaler()
+{
+    delete m_pPrescaler;
+    m_pPrescaler = nullptr;
+    
+    auto pConfig = m_pConfiguration->getModule(m_moduleName.c_str());
+    uint64_t budget = pConfig->getIntegerParameter("tracebandwidth");
+    if (budget == 0) return;                         // Disabled.
+    
+    m_pPrescaler = new VX2750TracePrescaler(
+        m_chans, budget, pConfig->getIntegerParameter("traceprescale"),
+        pConfig->getIntegerParameter("traceratewindow") * 1000000   // ms -> ns.
+    );
+    for (int i = 0; i < m_chans; i++) {
+        m_pPrescaler->setTraceBytes(i, m_fragmentSizes[i] - m_noTraceFragmentSize);
+    }
+}
  
 }                     // caen_nscldaq namespace. 
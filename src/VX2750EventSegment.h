@@ -26,12 +26,18 @@
 #define VX2750EVENTSEGMENT_H
 #include <CEventSegment.h>
 #include <string>
+#include <vector>
 #include "VX2750Pha.h"
+#include "VX2750PHAConfiguration.h"
+#include "VX2750DecodedEventPool.h"
+#include "VX2750ReadoutStatistics.h"
 
 class CExperiment;
 
 namespace caen_nscldaq {
 class VX2750TclConfig;                    // May become XML later....
+class VX2750TracePrescaler;
+class VX2750ConnectionPool;
 
 
 /**
@@ -59,33 +65,56 @@ private:
     std::string      m_moduleName;               // Cofiguration lookup key.
     std::string      m_hostOrPid;                // module connection - host/PID
     bool             m_isUsb;                    // module connection usb connection flg.
+    VX2750ConnectionPool* m_pConnections;        // If not null, owns m_pModule.
     VX2750Pha::DecodedEvent m_Event;
+    VX2750DecodedEventPool m_eventPool;          // Probe storage - kept across runs.
     size_t           m_chans;                    // Module channels.
     size_t           *m_traceSizes;              // Sizes of traces from each channel.
+    VX2750TracePrescaler* m_pPrescaler;          // Trace bandwidth policy.
+    
+    // Precomputed at initialize so read need not recompute them:
+    
+    std::vector<uint8_t> m_headerTemplates;     // Padded name + channel for each chan.
+    size_t           m_headerSize;               // Bytes in one header template.
+    std::vector<size_t> m_fragmentSizes;         // Bytes in a hit for each channel.
+    size_t           m_noTraceFragmentSize;      // Bytes in a hit with no traces.
+    bool             m_swStart;                  // SWcmd is a start source.
+    bool             m_paused;                   // Paused with readout state kept.
+    VX2750ModuleStatistics* m_pStatistics;       // Readout counters/latencies.
+    std::uint64_t    m_readTimeouts;             // Module's timeout count at last read.
 public:
     VX2750EventSegment(
         CExperiment *pExperiment, uint32_t sourceId,
         const char* pModuleName, VX2750TclConfig* pConfig,
-        const char* pHostOrPid, bool fIsUsb = false
+        const char* pHostOrPid, bool fIsUsb = false,
+        VX2750ConnectionPool* pConnections = nullptr
     );
     virtual ~VX2750EventSegment();
     
     // Getters:
     
     VX2750Pha* getModule() {return m_pModule;}
+    const std::string& getModuleName() const { return m_moduleName; }
+    VX2750ModuleStatistics& getStatistics() { return *m_pStatistics; }
     
     void hwInit();                            // Addition for faster init.
+    VX2750PHAModuleConfiguration::Mismatches verify();  // After hwInit.
+    bool verifyAborts();
     // Preparing and dropping modules:
     
     virtual void initialize();                  // at begin run.
     virtual void disable();                     // at end run.
-    virtual void onPause();                     //  Just will disable.
-    virtual void onResume();                    // just will initilialize.
+    virtual void onPause();                     // Stop/disarm, keep state.
+    virtual void onResume();                    // Re-arm/start.
     
     // Getting data from the module in response to a trigger.
     
     virtual size_t read(void* pBuffer, size_t maxwords);  // At trigger.
-    
+private:
+    void setupPrescaler();
+    void buildFragmentTables();
+    void startAcquisition();
+    void stopAcquisition();
 };
 
 }                               // CAEN Namespace.
@@ -0,0 +1,569 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ExternalSorter.cpp
+* @brief    Implement the out of core hit sorter.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ExternalSorter.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <queue>
+#include <stdexcept>
+#include <system_error>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace caen_offline {
+
+const std::size_t VX2750ExternalSorter::DEFAULT_MEMORY;
+const std::size_t VX2750ExternalSorter::SPARSE_INTERVAL;
+const std::size_t VX2750ExternalSorter::WRITE_BUFFER;
+
+// Size of a hit written as its own ring item:
+
+static const std::size_t HIT_ITEM_OVERHEAD =
+    VX2750EventFile::ITEM_HEADER_SIZE + VX2750EventFile::BODY_HEADER_SIZE;
+
+// Fewest hits in a run, however small the memory budget:
+
+static const std::size_t MIN_RUN_HITS = 1024;
+
+/**
+ * @class RunCollector
+ *    Hit visitor that collects references to the hits of one piece of the
+ *    input and writes a sorted run each time the collector's share of the
+ *    memory budget fills.
+ */
+class RunCollector : public VX2750HitVisitor
+{
+public:
+    const VX2750ExternalSorter&                   m_sorter;
+    std::vector<VX2750ExternalSorter::HitRef>     m_refs;
+    std::vector<VX2750ExternalSorter::Run>&       m_runs;
+    std::size_t                                   m_maxRefs;
+    std::uint64_t                                 m_hits;
+    std::uint64_t                                 m_unsorted;
+    std::uint64_t                                 m_first;
+    std::uint64_t                                 m_last;
+public:
+    RunCollector(
+        const VX2750ExternalSorter& sorter, std::vector<VX2750ExternalSorter::Run>& runs,
+        std::size_t maxRefs
+    ) :
+        m_sorter(sorter), m_runs(runs), m_maxRefs(maxRefs), m_hits(0),
+        m_unsorted(0), m_first(0), m_last(0)
+    {
+        m_refs.reserve(maxRefs);
+    }
+    virtual void hit(const VX2750Hit& hit) {
+        if (m_hits == 0) m_first = hit.s_timestamp;
+        if (m_hits && hit.s_timestamp < m_last) m_unsorted++;
+        m_last = hit.s_timestamp;
+        m_hits++;
+
+        VX2750ExternalSorter::HitRef ref = {
+            hit.s_timestamp, hit.s_pData, hit.s_bytes, hit.s_sourceId
+        };
+        m_refs.push_back(ref);
+        if (m_refs.size() >= m_maxRefs) flush();
+    }
+    void flush() {
+        if (!m_refs.empty()) {
+            m_sorter.writeRun(m_refs, m_runs);
+            m_refs.clear();
+        }
+    }
+};
+/**
+ * @struct SortHead
+ *    The next item of a run in the merge.  Ties in timestamp go to the
+ *    earlier run which keeps the sort stable.
+ */
+struct SortHead {
+    std::uint64_t s_timestamp;
+    std::uint32_t s_run;
+    std::uint64_t s_offset;
+    bool operator>(const SortHead& rhs) const {
+        return (s_timestamp > rhs.s_timestamp) ||
+            ((s_timestamp == rhs.s_timestamp) && (s_run > rhs.s_run));
+    }
+};
+typedef std::priority_queue<SortHead, std::vector<SortHead>, std::greater<SortHead>> SortQueue;
+
+static bool
+earlier(const VX2750ExternalSorter::HitRef& a, const VX2750ExternalSorter::HitRef& b)
+{
+    return a.s_timestamp < b.s_timestamp;
+}
+static bool
+markBefore(const VX2750ExternalSorter::RunMark& mark, std::uint64_t timestamp)
+{
+    return mark.s_timestamp < timestamp;
+}
+static std::uint32_t
+itemSize(const std::uint8_t* pItem)
+{
+    return *reinterpret_cast<const std::uint32_t*>(pItem);
+}
+
+/**
+ * Statistics constructor
+ */
+VX2750ExternalSorter::Statistics::Statistics() :
+    s_hits(0), s_unsorted(0), s_runs(0), s_partitions(0), s_bytes(0)
+{}
+
+/**
+ * constructor
+ *  @param tempDir - directory in which run files are written.
+ *  @param memory  - bytes of hit references held at once, over all threads.
+ */
+VX2750ExternalSorter::VX2750ExternalSorter(const char* tempDir, std::size_t memory) :
+    m_tempDir(tempDir), m_memory(memory)
+{}
+/**
+ * destructor
+ */
+VX2750ExternalSorter::~VX2750ExternalSorter()
+{}
+
+/**
+ * addFile
+ *    Add an event file to the sort.  Files should be added in time order
+ *    (e.g. the segments of a run in order) so that hits with equal
+ *    timestamps keep their order.
+ *  @param file - the file; must live until sort is done.
+ *  @throw std::runtime_error - a ring item has an invalid size.
+ */
+void
+VX2750ExternalSorter::addFile(const VX2750EventFile& file)
+{
+    auto chunks = file.chunks(1);
+    std::uint64_t end = chunks.empty() ? 0 : chunks.back().s_end;
+    m_files.push_back(&file);
+
+    // State changes:
+
+    for (std::uint64_t offset = 0; offset < end; offset = file.nextItem(offset)) {
+        const std::uint8_t* pItem = file.data() + offset;
+        std::uint32_t type = reinterpret_cast<const std::uint32_t*>(pItem)[1];
+        if (type == VX2750EventFile::BEGIN_RUN) m_beginRuns.push_back(pItem);
+        if (type == VX2750EventFile::END_RUN)   m_endRuns.push_back(pItem);
+    }
+}
+/**
+ * sort
+ *    Sort the hits of the files added so far and write them.
+ *  @param fd      - regular file to write; the output starts at offset 0
+ *                   and the file is truncated to the output size.
+ *  @param threads - number of threads for run generation and merging.
+ *  @return Statistics - what was sorted.
+ *  @throw std::invalid_argument - fd is not a regular file.
+ *  @throw std::system_error - a run file or the output can't be written.
+ *  @throw std::runtime_error - a ring item has an invalid size.
+ */
+VX2750ExternalSorter::Statistics
+VX2750ExternalSorter::sort(int fd, unsigned threads)
+{
+    if (threads == 0) threads = 1;
+    struct stat info;
+    if (fstat(fd, &info) || !S_ISREG(info.st_mode)) {
+        throw std::invalid_argument("Sorted hits must be written to a regular file");
+    }
+
+    Statistics stats;
+    std::vector<Run> runs;
+    try {
+        makeRuns(runs, threads, stats);
+        std::vector<Cut> cuts = partition(runs, threads);
+        stats.s_runs       = runs.size();
+        stats.s_partitions = cuts.size() - 1;
+
+        // Everything's size is known so lay out the output:
+
+        std::uint64_t offset = 0;
+        for (auto p : m_beginRuns) {
+            writeAt(fd, p, itemSize(p), offset);
+            offset += itemSize(p);
+        }
+        std::vector<std::uint64_t> offsets;
+        for (std::size_t i = 0; i + 1 < cuts.size(); i++) {
+            offsets.push_back(offset);
+            for (std::size_t r = 0; r < runs.size(); r++) {
+                offset += cuts[i+1][r] - cuts[i][r];
+            }
+        }
+        for (auto p : m_endRuns) {
+            writeAt(fd, p, itemSize(p), offset);
+            offset += itemSize(p);
+        }
+        if (ftruncate(fd, offset)) {
+            throw std::system_error(errno, std::generic_category(), "Sizing sorted output");
+        }
+        stats.s_bytes = offset;
+
+        // Merge the partitions, threads at a time:
+
+        std::atomic<std::size_t> next(0);
+        std::vector<std::future<void>> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.push_back(std::async(std::launch::async,
+                [this, &runs, &cuts, &offsets, &next, fd]() {
+                    for (std::size_t i = next++; i < offsets.size(); i = next++) {
+                        mergePartition(runs, cuts[i], cuts[i+1], fd, offsets[i]);
+                    }
+                }
+            ));
+        }
+        for (auto& w : workers) w.get();
+    }
+    catch (...) {
+        freeRuns(runs);
+        throw;
+    }
+    freeRuns(runs);
+    return stats;
+}
+/**
+ * segments
+ *    Find the segments of a run.  NSCLDAQ writes run NNNN to
+ *    run-NNNN-00.evt, run-NNNN-01.evt...
+ *  @param filename - an event file.  If it's the first segment of a run
+ *                    (ends in -00.evt) the segments that follow it are found.
+ *  @return std::vector<std::string> - the file and any following segments,
+ *          in order.
+ */
+std::vector<std::string>
+VX2750ExternalSorter::segments(const char* filename)
+{
+    std::vector<std::string> result = {filename};
+    std::string name(filename);
+    const std::string first = "-00.evt";
+    if (name.size() < first.size() ||
+        name.compare(name.size() - first.size(), first.size(), first) != 0) {
+        return result;
+    }
+    std::string base = name.substr(0, name.size() - first.size());
+    for (int i = 1; i < 100; i++) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "-%02d.evt", i);
+        std::string segment = base + suffix;
+        if (access(segment.c_str(), F_OK)) break;
+        result.push_back(segment);
+    }
+    return result;
+}
+/**
+ * itemTimestamp
+ *  @param pItem - a ring item with a body header.
+ *  @return std::uint64_t - the body header timestamp.
+ */
+std::uint64_t
+VX2750ExternalSorter::itemTimestamp(const std::uint8_t* pItem)
+{
+    std::uint64_t result;
+    memcpy(
+        &result, pItem + VX2750EventFile::ITEM_HEADER_SIZE + sizeof(std::uint32_t),
+        sizeof(result)
+    );
+    return result;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * makeRuns
+ *    Decode the files and write sorted runs.  Each file is cut into a
+ *    piece per thread and the pieces are handed out to the threads in
+ *    order.  The runs of each piece are kept in order so that, in the
+ *    merge, lower run numbers are earlier in the input.
+ *  @param[out] runs  - the runs.  Any made are here even on failure.
+ *  @param threads    - threads to use.
+ *  @param[out] stats - input, hit and unsorted counts are filled in.
+ *  @throw std::system_error - a run file can't be written.
+ */
+void
+VX2750ExternalSorter::makeRuns(std::vector<Run>& runs, unsigned threads, Statistics& stats)
+{
+    struct Piece {
+        const VX2750EventFile* s_pFile;
+        VX2750EventFile::Chunk s_chunk;
+    };
+    std::vector<Piece> pieces;
+    for (auto pFile : m_files) {
+        for (auto& c : pFile->chunks(threads)) {
+            Piece p = {pFile, c};
+            pieces.push_back(p);
+        }
+    }
+    std::size_t maxRefs = std::max(MIN_RUN_HITS, m_memory / threads / sizeof(HitRef));
+
+    std::vector<std::vector<Run>> pieceRuns(pieces.size());
+    std::vector<Statistics> threadStats(threads);
+    std::vector<RunCollector*> collectors(pieces.size(), nullptr);
+    std::atomic<std::size_t> next(0);
+    std::vector<std::future<void>> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.push_back(std::async(std::launch::async,
+            [this, &pieces, &pieceRuns, &threadStats, &collectors, &next, maxRefs, t]() {
+                Statistics& s(threadStats[t]);
+                for (std::size_t i = next++; i < pieces.size(); i = next++) {
+                    collectors[i] = new RunCollector(*this, pieceRuns[i], maxRefs);
+                    RunCollector& collector(*collectors[i]);
+                    pieces[i].s_pFile->willNeed(pieces[i].s_chunk);
+                    VX2750OfflineDecoder decoder(*pieces[i].s_pFile);
+                    s.s_input += decoder.decode(pieces[i].s_chunk, collector);
+                    collector.flush();
+                    collector.m_refs = std::vector<HitRef>();
+                    s.s_hits     += collector.m_hits;
+                    s.s_unsorted += collector.m_unsorted;
+                }
+            }
+        ));
+    }
+    std::exception_ptr failure;
+    for (auto& w : workers) {
+        try {
+            w.get();
+        }
+        catch (...) {
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    for (auto& p : pieceRuns) {
+        runs.insert(runs.end(), p.begin(), p.end());
+    }
+    // Hits out of order where one piece meets the next:
+
+    const RunCollector* pPrior = nullptr;
+    for (auto pCollector : collectors) {
+        if (pCollector && pCollector->m_hits) {
+            if (pPrior && pCollector->m_first < pPrior->m_last) stats.s_unsorted++;
+            pPrior = pCollector;
+        }
+    }
+    for (auto pCollector : collectors) delete pCollector;
+    if (failure) std::rethrow_exception(failure);
+
+    for (auto& s : threadStats) {
+        stats.s_input    += s.s_input;
+        stats.s_hits     += s.s_hits;
+        stats.s_unsorted += s.s_unsorted;
+    }
+}
+/**
+ * writeRun
+ *    Sort hit references and write the hits to a run file.
+ *  @param refs       - the references (sorted on return).
+ *  @param[out] runs  - the run is appended.
+ *  @throw std::system_error - the run file can't be written or mapped.
+ */
+void
+VX2750ExternalSorter::writeRun(std::vector<HitRef>& refs, std::vector<Run>& runs) const
+{
+    std::stable_sort(refs.begin(), refs.end(), earlier);
+
+    std::string name = m_tempDir + "/vx2750sortXXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), name);
+    }
+    Run run = {nullptr, {}};
+    try {
+        std::vector<std::uint8_t> buffer;
+        buffer.reserve(WRITE_BUFFER);
+        std::uint64_t offset = 0;
+        for (std::size_t i = 0; i < refs.size(); i++) {
+            std::size_t bytes = HIT_ITEM_OVERHEAD + refs[i].s_bytes;
+            if (!buffer.empty() && buffer.size() + bytes > WRITE_BUFFER) {
+                writeAt(fd, buffer.data(), buffer.size(), offset);
+                offset += buffer.size();
+                buffer.clear();
+            }
+            if ((i % SPARSE_INTERVAL) == 0) {
+                RunMark mark = {refs[i].s_timestamp, offset + buffer.size()};
+                run.s_marks.push_back(mark);
+            }
+            std::size_t at = buffer.size();
+            buffer.resize(at + bytes);
+            VX2750EventFile::putPhysicsItem(
+                buffer.data() + at, refs[i].s_timestamp, refs[i].s_sourceId,
+                refs[i].s_pData, refs[i].s_bytes
+            );
+        }
+        writeAt(fd, buffer.data(), buffer.size(), offset);
+        run.s_pFile = new VX2750EventFile(name.c_str());
+    }
+    catch (...) {
+        close(fd);
+        unlink(name.c_str());
+        throw;
+    }
+    close(fd);
+    unlink(name.c_str());                    // The mapping keeps the data.
+    runs.push_back(run);
+}
+/**
+ * partition
+ *    Cut the runs into time partitions for the merge.  Cut times are
+ *    quantiles of the run marks.  Every item earlier than a cut time is in
+ *    an earlier partition than every item at or after it.
+ *  @param runs    - the runs.
+ *  @param threads - threads merging; a few partitions are made per thread
+ *                   to even out the load.
+ *  @return std::vector<Cut> - partition i is [result[i], result[i+1]) in
+ *          each run.  There's always at least one partition.
+ */
+std::vector<VX2750ExternalSorter::Cut>
+VX2750ExternalSorter::partition(const std::vector<Run>& runs, unsigned threads) const
+{
+    Cut begin(runs.size(), 0), end;
+    std::vector<std::uint64_t> samples;
+    for (auto& r : runs) {
+        end.push_back(r.s_pFile->size());
+        for (auto& m : r.s_marks) samples.push_back(m.s_timestamp);
+    }
+    std::vector<Cut> result = {begin};
+    std::size_t nParts = (threads > 1) ? threads*4 : 1;
+
+    if (nParts > 1 && !samples.empty()) {
+        std::sort(samples.begin(), samples.end());
+        std::uint64_t last = samples.front();
+        for (std::size_t i = 1; i < nParts; i++) {
+            std::uint64_t t = samples[i * samples.size() / nParts];
+            if (t <= last) continue;
+            last = t;
+
+            Cut cut;
+            for (auto& r : runs) cut.push_back(seek(r, t));
+            result.push_back(cut);
+        }
+    }
+    result.push_back(end);
+    return result;
+}
+/**
+ * seek
+ *    Find where a time starts in a run.
+ *  @param run       - the run.
+ *  @param timestamp - the time.
+ *  @return std::uint64_t - offset of the first item at or after timestamp
+ *          (the run size if there is none).
+ */
+std::uint64_t
+VX2750ExternalSorter::seek(const Run& run, std::uint64_t timestamp) const
+{
+    auto p = std::lower_bound(run.s_marks.begin(), run.s_marks.end(), timestamp, markBefore);
+    std::uint64_t offset = (p == run.s_marks.begin()) ? 0 : (p - 1)->s_offset;
+
+    const VX2750EventFile& file(*run.s_pFile);
+    while (offset < file.size() && itemTimestamp(file.data() + offset) < timestamp) {
+        offset = file.nextItem(offset);
+    }
+    return offset;
+}
+/**
+ * mergePartition
+ *    Merge a partition of the runs into its place in the output.
+ *  @param runs       - the runs.
+ *  @param begin, end - the partition.
+ *  @param fd         - the output file.
+ *  @param offset     - where the partition goes in it.
+ *  @throw std::system_error - the output can't be written.
+ */
+void
+VX2750ExternalSorter::mergePartition(
+    const std::vector<Run>& runs, const Cut& begin, const Cut& end,
+    int fd, std::uint64_t offset
+) const
+{
+    SortQueue queue;
+    for (std::uint32_t r = 0; r < runs.size(); r++) {
+        if (begin[r] < end[r]) {
+            SortHead h = {itemTimestamp(runs[r].s_pFile->data() + begin[r]), r, begin[r]};
+            queue.push(h);
+        }
+    }
+    std::vector<std::uint8_t> buffer;
+    buffer.reserve(WRITE_BUFFER);
+    while (!queue.empty()) {
+        SortHead h = queue.top();
+        queue.pop();
+        const VX2750EventFile& file(*runs[h.s_run].s_pFile);
+        const std::uint8_t* pItem = file.data() + h.s_offset;
+        std::uint32_t bytes = itemSize(pItem);
+        if (!buffer.empty() && buffer.size() + bytes > WRITE_BUFFER) {
+            writeAt(fd, buffer.data(), buffer.size(), offset);
+            offset += buffer.size();
+            buffer.clear();
+        }
+        buffer.insert(buffer.end(), pItem, pItem + bytes);
+
+        h.s_offset += bytes;
+        if (h.s_offset < end[h.s_run]) {
+            h.s_timestamp = itemTimestamp(file.data() + h.s_offset);
+            queue.push(h);
+        }
+    }
+    writeAt(fd, buffer.data(), buffer.size(), offset);
+}
+/**
+ * writeAt
+ *    Write data at an offset, retrying partial writes.
+ *  @param fd     - where.
+ *  @param pData  - what.
+ *  @param bytes  - how much.
+ *  @param offset - file offset.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750ExternalSorter::writeAt(
+    int fd, const void* pData, std::size_t bytes, std::uint64_t offset
+)
+{
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(pData);
+    while (bytes) {
+        ssize_t n = pwrite(fd, p, bytes, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "Writing sorted hits");
+        }
+        p      += n;
+        bytes  -= n;
+        offset += n;
+    }
+}
+/**
+ * freeRuns
+ *    Unmap run files.  They've already been unlinked.
+ *  @param runs - the runs; emptied.
+ */
+void
+VX2750ExternalSorter::freeRuns(std::vector<Run>& runs)
+{
+    for (auto& r : runs) delete r.s_pFile;
+    runs.clear();
+}
+}                                     // caen_offline namespace
@@ -0,0 +1,131 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ExternalSorter.h
+* @brief    Out of core timestamp sort of the hits in event files.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750EXTERNALSORTER_H
+#define VX2750EXTERNALSORTER_H
+#include "VX2750OfflineDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caen_offline {
+/**
+ * @class VX2750ExternalSorter
+ *    Sorts all of the hits in a set of event files (e.g. the segments of a
+ *    run) into one stream in timestamp order without holding the hits in
+ *    memory.  The output is written as the readout writes hits: a
+ *    PHYSICS_EVENT per hit whose body header has the hit's timestamp and
+ *    source id (NO_SOURCE if the hit had none).  BEGIN_RUN items are copied
+ *    before the hits and END_RUN items after them.  Other items are dropped.
+ *
+ *    The sort is a classic two phase external sort:
+ *    -  Run generation: each thread decodes a part of the input, collecting
+ *       references to the hits until its share of the memory budget is
+ *       full.  The references are sorted and the hits they point to are
+ *       written, in output format, to a run file in the temporary directory.
+ *    -  Merge: the run files are mapped and merged.  While each run is
+ *       written, the timestamp of every SPARSE_INTERVAL'th item is kept.
+ *       Those marks are used to cut the merge into time partitions whose
+ *       output size and place in the output file are known in advance, so
+ *       partitions are merged in parallel and written in place.
+ *
+ *    The sort is stable: hits with equal timestamps stay in the order the
+ *    files were added and, within a file, the order they were recorded.
+ *    Memory use is the budget plus a write buffer per thread.  The temporary
+ *    directory needs about as much space as the output.  Run files are
+ *    unlinked as soon as they are mapped so nothing is left behind.
+ *
+ *    Files must live until sort is done.
+ */
+class VX2750ExternalSorter {
+public:
+    static const std::size_t DEFAULT_MEMORY  = 512*1024*1024;
+    static const std::size_t SPARSE_INTERVAL = 1024;       // Items per run mark.
+    static const std::size_t WRITE_BUFFER    = 1024*1024;
+
+    struct HitRef {
+        std::uint64_t       s_timestamp;
+        const std::uint8_t* s_pData;            // Hit with its word count.
+        std::uint32_t       s_bytes;
+        std::uint32_t       s_sourceId;
+    };
+    struct Statistics {
+        VX2750OfflineDecoder::Statistics s_input;
+        std::uint64_t s_hits;
+        std::uint64_t s_unsorted;               // Hits earlier than the one before.
+        std::uint64_t s_runs;
+        std::uint64_t s_partitions;             // Of the merge.
+        std::uint64_t s_bytes;                  // Written.
+
+        Statistics();
+    };
+    // A sorted run.  Marks are the timestamp and offset of every
+    // SPARSE_INTERVAL'th item.
+
+    struct RunMark {
+        std::uint64_t s_timestamp;
+        std::uint64_t s_offset;
+    };
+    struct Run {
+        VX2750EventFile*     s_pFile;
+        std::vector<RunMark> s_marks;
+    };
+private:
+    friend class RunCollector;
+    typedef std::vector<std::uint64_t> Cut;    // An offset into each run.
+
+    std::string                          m_tempDir;
+    std::size_t                          m_memory;
+    std::vector<const VX2750EventFile*>  m_files;
+    std::vector<const std::uint8_t*>     m_beginRuns;
+    std::vector<const std::uint8_t*>     m_endRuns;
+public:
+    VX2750ExternalSorter(const char* tempDir = "/tmp", std::size_t memory = DEFAULT_MEMORY);
+    virtual ~VX2750ExternalSorter();
+private:
+    VX2750ExternalSorter(const VX2750ExternalSorter&);
+    VX2750ExternalSorter& operator=(const VX2750ExternalSorter&);
+public:
+    const std::string& getTempDir() const { return m_tempDir; }
+    std::size_t        getMemory() const { return m_memory; }
+
+    void       addFile(const VX2750EventFile& file);
+    Statistics sort(int fd, unsigned threads = 1);
+
+    static std::vector<std::string> segments(const char* filename);
+    static std::uint64_t itemTimestamp(const std::uint8_t* pItem);
+private:
+    void          makeRuns(std::vector<Run>& runs, unsigned threads, Statistics& stats);
+    void          writeRun(std::vector<HitRef>& refs, std::vector<Run>& runs) const;
+    std::vector<Cut> partition(const std::vector<Run>& runs, unsigned threads) const;
+    std::uint64_t seek(const Run& run, std::uint64_t timestamp) const;
+    void          mergePartition(
+        const std::vector<Run>& runs, const Cut& begin, const Cut& end,
+        int fd, std::uint64_t offset
+    ) const;
+    static void   writeAt(int fd, const void* pData, std::size_t bytes, std::uint64_t offset);
+    static void   freeRuns(std::vector<Run>& runs);
+};
+}                                     // caen_offline namespace
+#endif
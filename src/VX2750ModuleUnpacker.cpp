@@ -47,10 +47,13 @@ VX2750ModuleUnpacker::VX2750ModuleUnpacker(
     const char* moduleName, const char* paramBaseName
 ) :
     m_moduleName(moduleName),
+    m_nameBytes(m_moduleName.size() + 1),
     m_channelMask(0),
     m_ns(nullptr), m_rawTimestamp(nullptr), m_fineTimestamp(nullptr),
-    m_energy(nullptr)
+    m_energy(nullptr), m_zeroCopy(false)
 {
+    if (m_nameBytes % 2) m_nameBytes++;          // Padded to uint16_t in the data.
+
     {
         std::stringstream ns;
         ns << paramBaseName << ".ns";
@@ -90,19 +93,56 @@ VX2750ModuleUnpacker::~VX2750ModuleUnpacker()
  *   Should be called before decoding the hits that make up an event built event.
  *   Just clears the m_channelMask field so that we can properly keep track of the
  *   channels in an event.  Clear's the probe arrays as well.
+ *   Only the channels with hits since the last reset (the ones in
+ *   m_channelMask) can have probe data so only those are cleared.  This
+ *   keeps the cost of a reset proportional to the hits in the event.
  */
 void
 VX2750ModuleUnpacker::reset()
 {
-    m_channelMask = 0;
-    for (int i = 0; i < VX2750_MAX_CHANNELS; i++) {
+    std::uint64_t dirty = m_channelMask;
+    while (dirty) {
+        unsigned i = __builtin_ctzll(dirty);     // Lowest hit channel.
+        dirty &= dirty - 1;                      // Remove it.
+        
         m_analogProbe1Samples[i].clear();
         m_analogProbe2Samples[i].clear();
         m_digitalProbe1Samples[i].clear();
         m_digitalProbe2Samples[i].clear();
         m_digitalProbe3Samples[i].clear();
         m_digitalProbe4Samples[i].clear();
+        
+        m_analogProbe1Views[i] = VX2750TraceView<std::uint32_t>();
+        m_analogProbe2Views[i] = VX2750TraceView<std::uint32_t>();
+        m_digitalProbe1Views[i] = VX2750TraceView<std::uint8_t>();
+        m_digitalProbe2Views[i] = VX2750TraceView<std::uint8_t>();
+        m_digitalProbe3Views[i] = VX2750TraceView<std::uint8_t>();
+        m_digitalProbe4Views[i] = VX2750TraceView<std::uint8_t>();
     }
+    m_channelMask = 0;
+}
+/**
+ * setZeroCopy
+ *    Select whether or not probe samples are copied out of the event.
+ *    In zero copy mode, the get*Samples methods return empty vectors and
+ *    the samples must be gotten with the get*View methods.  The views
+ *    point into the event and so are only valid until the next event
+ *    is analyzed.  Should be called between events.
+ * @param enable - true to turn on zero copy mode.
+ */
+void
+VX2750ModuleUnpacker::setZeroCopy(bool enable)
+{
+    m_zeroCopy = enable;
+}
+/**
+ * isZeroCopy
+ *    @return bool - true if zero copy mode is on.
+ */
+bool
+VX2750ModuleUnpacker::isZeroCopy() const
+{
+    return m_zeroCopy;
 }
 /**
  * unpackHit
@@ -128,14 +168,18 @@ VX2750ModuleUnpacker::unpackHit(const void* pData)
     
     p.l++;                          // Skip the size longword.
     
-    // Check the mdoule name:
+    // Check the mdoule name.  Comparing through the null terminator means
+    // we match the whole name; strncmp stops at the data's terminator so we
+    // never look past the name.  No std::string is made unless it's wrong:
     
-    std::string name(p.c);
-    if (name != m_moduleName) {
-        throw std::logic_error("Mismatch between data module name and unpacker module name!");
+    if (strncmp(p.c, m_moduleName.c_str(), m_moduleName.size() + 1) != 0) {
+        std::string msg("Mismatch between data module name and unpacker module name! data: ");
+        msg += p.c;
+        msg += " unpacker: ";
+        msg += m_moduleName;
+        throw std::logic_error(msg);
     }
-    p.b += name.size() + 1;                      // +1 for null term.
-    if (((name.size()+1) % 2) == 1 ) p.b++;        // Paded out to uint16_t.
+    p.b += m_nameBytes;                          // Null terminated, padded to uint16_t.
     
     std::uint16_t ch = *p.w;
     std::uint64_t m  = 1;
@@ -143,7 +187,7 @@ VX2750ModuleUnpacker::unpackHit(const void* pData)
     
     if (m & m_channelMask != 0) {
         std::cerr << "** Warning: duplicate channel " << ch <<
-            " in module: " << name << " Second hit overwrites first" <<  std::endl;
+            " in module: " << m_moduleName << " Second hit overwrites first" <<  std::endl;
     }
     m_channelMask |= m;
     
@@ -164,47 +208,41 @@ VX2750ModuleUnpacker::unpackHit(const void* pData)
     
     m_analogProbe1Types[ch] = *(p.w); p.w++;
     size_t nSamples = *(p.l); p.l++;
-    m_analogProbe1Samples[ch].resize(nSamples);
-    memcpy(m_analogProbe1Samples[ch].data(), p.l, nSamples*sizeof(std::uint32_t));
+    setProbe(p.l, nSamples, m_analogProbe1Samples[ch], m_analogProbe1Views[ch]);
     p.l += nSamples;
     
     // Analog probe 2
     
     m_analogProbe2Types[ch] = *(p.w); p.w++;
     nSamples = *(p.l); p.l++;
-    m_analogProbe2Samples[ch].resize(nSamples);
-    memcpy(m_analogProbe2Samples[ch].data(), p.l, nSamples*sizeof(std::uint32_t));
+    setProbe(p.l, nSamples, m_analogProbe2Samples[ch], m_analogProbe2Views[ch]);
     p.l += nSamples;
     
     // Digital Probe 1:
     
     m_digitalProbe1Types[ch] =  *(p.w) ; p.w++;
     size_t nBytes = *(p.l); p.l++;
-    m_digitalProbe1Samples[ch].resize(nBytes);
-    memcpy(m_digitalProbe1Samples[ch].data(), p.b, nBytes);
+    setProbe(p.b, nBytes, m_digitalProbe1Samples[ch], m_digitalProbe1Views[ch]);
     p.b += nBytes;
     
     // Digital Probe 2:
     
     m_digitalProbe2Types[ch] =  *(p.w) ; p.w++;
     nBytes = *(p.l); p.l++;
-    m_digitalProbe2Samples[ch].resize(nBytes);
-    memcpy(m_digitalProbe2Samples[ch].data(), p.b, nBytes);
+    setProbe(p.b, nBytes, m_digitalProbe2Samples[ch], m_digitalProbe2Views[ch]);
     p.b += nBytes;
     
     // Digital Probe 1:
     
     m_digitalProbe3Types[ch] =  *(p.w) ; p.w++;
     nBytes = *(p.l); p.l++;
-    m_digitalProbe3Samples[ch].resize(nBytes);
-    memcpy(m_digitalProbe3Samples[ch].data(), p.b, nBytes);
+    setProbe(p.b, nBytes, m_digitalProbe3Samples[ch], m_digitalProbe3Views[ch]);
     p.b += nBytes;
     // Digital Probe 1:
     
     m_digitalProbe4Types[ch] =  *(p.w) ; p.w++;
     nBytes = *(p.l); p.l++;
-    m_digitalProbe4Samples[ch].resize(nBytes);
-    memcpy(m_digitalProbe4Samples[ch].data(), p.b, nBytes);
+    setProbe(p.b, nBytes, m_digitalProbe4Samples[ch], m_digitalProbe4Views[ch]);
     p.b += nBytes;
     
     const uint8_t* pBegin = reinterpret_cast<const uint8_t*>(pData);
@@ -242,7 +280,7 @@ VX2750ModuleUnpacker::getChannelSet() const
 {
     std::set<unsigned> result;
     for (int i =0; i < 64; i++) {
-        if (m_channelMask & (1 << i)) {
+        if (m_channelMask & (std::uint64_t(1) << i)) {
             result.insert(i);
         }
     }
@@ -456,6 +494,78 @@ VX2750ModuleUnpacker::getDigitalProbe4Samples(unsigned channel) const
     checkChannel(channel);
     return m_digitalProbe4Samples[channel];
 }
+/**
+ * getAnalogProbe1View
+ *    @param channel - valid hit channel number.
+ *    @return VX2750TraceView<std::uint32_t> - view of the analog probe 1 samples.
+ *    @throw std::invalid_argument - invalid channel.
+ */
+VX2750TraceView<std::uint32_t>
+VX2750ModuleUnpacker::getAnalogProbe1View(unsigned channel) const
+{
+    checkChannel(channel);
+    return m_analogProbe1Views[channel];
+}
+/**
+ * getAnalogProbe2View
+ *    @param channel - valid hit channel number.
+ *    @return VX2750TraceView<std::uint32_t> - view of the analog probe 2 samples.
+ *    @throw std::invalid_argument - invalid channel.
+ */
+VX2750TraceView<std::uint32_t>
+VX2750ModuleUnpacker::getAnalogProbe2View(unsigned channel) const
+{
+    checkChannel(channel);
+    return m_analogProbe2Views[channel];
+}
+/**
+ * getDigitalProbe1View
+ *    @param channel - valid hit channel number.
+ *    @return VX2750TraceView<std::uint8_t> - view of the digital probe 1 samples.
+ *    @throw std::invalid_argument - invalid channel.
+ */
+VX2750TraceView<std::uint8_t>
+VX2750ModuleUnpacker::getDigitalProbe1View(unsigned channel) const
+{
+    checkChannel(channel);
+    return m_digitalProbe1Views[channel];
+}
+/**
+ * getDigitalProbe2View
+ *    @param channel - valid hit channel number.
+ *    @return VX2750TraceView<std::uint8_t> - view of the digital probe 2 samples.
+ *    @throw std::invalid_argument - invalid channel.
+ */
+VX2750TraceView<std::uint8_t>
+VX2750ModuleUnpacker::getDigitalProbe2View(unsigned channel) const
+{
+    checkChannel(channel);
+    return m_digitalProbe2Views[channel];
+}
+/**
+ * getDigitalProbe3View
+ *    @param channel - valid hit channel number.
+ *    @return VX2750TraceView<std::uint8_t> - view of the digital probe 3 samples.
+ *    @throw std::invalid_argument - invalid channel.
+ */
+VX2750TraceView<std::uint8_t>
+VX2750ModuleUnpacker::getDigitalProbe3View(unsigned channel) const
+{
+    checkChannel(channel);
+    return m_digitalProbe3Views[channel];
+}
+/**
+ * getDigitalProbe4View
+ *    @param channel - valid hit channel number.
+ *    @return VX2750TraceView<std::uint8_t> - view of the digital probe 4 samples.
+ *    @throw std::invalid_argument - invalid channel.
+ */
+VX2750TraceView<std::uint8_t>
+VX2750ModuleUnpacker::getDigitalProbe4View(unsigned channel) const
+{
+    checkChannel(channel);
+    return m_digitalProbe4Views[channel];
+}
 //////////////////////////////////////////////////////////////////////////////
 // Private utilities.
 
@@ -475,9 +585,35 @@ VX2750ModuleUnpacker::checkChannel(unsigned channel) const
         throw std::invalid_argument("Channel number is out of range");
     }
     
-    if ((m_channelMask & (1 << channel)) == 0) {
+    if ((m_channelMask & (std::uint64_t(1) << channel)) == 0) {
         throw std::invalid_argument("Channel was not hit");
     }
 }
 
+/**
+ * setProbe
+ *    Record the samples of a probe.  In zero copy mode, the view just
+ *    points at the samples in the event; otherwise they are copied into
+ *    the channel's vector and the view points at that.
+ * @param pSamples - the samples in the event.
+ * @param nSamples - how many there are.
+ * @param samples  - vector into which to copy them.
+ * @param view     - view to set.
+ */
+template<class T>
+void
+VX2750ModuleUnpacker::setProbe(
+    const void* pSamples, std::size_t nSamples,
+    std::vector<T>& samples, VX2750TraceView<T>& view
+)
+{
+    if (m_zeroCopy) {
+        view = VX2750TraceView<T>(reinterpret_cast<const T*>(pSamples), nSamples);
+    } else {
+        samples.resize(nSamples);
+        memcpy(samples.data(), pSamples, nSamples*sizeof(T));
+        view = VX2750TraceView<T>(samples.data(), nSamples);
+    }
+}
+
 }                                             // caen_spectcl namespace.
\ No newline at end of file
@@ -27,10 +27,42 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <cstddef>
 class CTreeParameterArray;
 
 namespace caen_spectcl {
     static const unsigned int VX2750_MAX_CHANNELS(64);
+    // Fail flag bits set by the readout's trace bandwidth limiting:
+    
+    static const std::uint16_t VX2750_FAIL_FLAG(1);
+    static const std::uint16_t VX2750_TRACES_PRESCALED(0x4000);
+    static const std::uint16_t VX2750_TRACES_SUPPRESSED(0x8000);
+
+/**
+ *  @class VX2750TraceView
+ *     Non owning, read only view of the samples of a probe: a pointer and
+ *     a sample count with the bits of the std::vector interface needed to
+ *     look at the samples (size, empty, [], data, begin/end).
+ *     Views returned by VX2750ModuleUnpacker in zero copy mode point
+ *     into the event being analyzed and are only valid while it is.
+ */
+template<class T>
+class VX2750TraceView {
+private:
+    const T*    m_pData;
+    std::size_t m_size;
+public:
+    VX2750TraceView() : m_pData(nullptr), m_size(0) {}
+    VX2750TraceView(const T* pData, std::size_t size) :
+        m_pData(pData), m_size(size) {}
+    
+    const T*    data() const  { return m_pData; }
+    std::size_t size() const  { return m_size; }
+    bool        empty() const { return m_size == 0; }
+    const T*    begin() const { return m_pData; }
+    const T*    end() const   { return m_pData + m_size; }
+    const T&    operator[](std::size_t i) const { return m_pData[i]; }
+};
 /**
  *   @class VX2750ModuleUpacker
  *     Unpacks data that comes from a single module of a VX2750
@@ -41,6 +73,7 @@ namespace caen_spectcl {
 class VX2750ModuleUnpacker {
 private:
     std::string                 m_moduleName;
+    std::size_t                 m_nameBytes;        // Bytes of name + padding in a hit.
     std::uint64_t               m_channelMask;
     CTreeParameterArray*        m_ns;               // Timestamp in nanoseconds.
     CTreeParameterArray*        m_rawTimestamp;     // Raw timestamps
@@ -62,6 +95,16 @@ private:
     std::vector<std::uint8_t>   m_digitalProbe3Samples[VX2750_MAX_CHANNELS];
     std::uint32_t               m_digitalProbe4Types[VX2750_MAX_CHANNELS];
     std::vector<std::uint8_t>   m_digitalProbe4Samples[VX2750_MAX_CHANNELS];
+    
+    // Views of the samples above or, in zero copy mode, of the event data:
+    
+    bool                              m_zeroCopy;
+    VX2750TraceView<std::uint32_t>    m_analogProbe1Views[VX2750_MAX_CHANNELS];
+    VX2750TraceView<std::uint32_t>    m_analogProbe2Views[VX2750_MAX_CHANNELS];
+    VX2750TraceView<std::uint8_t>     m_digitalProbe1Views[VX2750_MAX_CHANNELS];
+    VX2750TraceView<std::uint8_t>     m_digitalProbe2Views[VX2750_MAX_CHANNELS];
+    VX2750TraceView<std::uint8_t>     m_digitalProbe3Views[VX2750_MAX_CHANNELS];
+    VX2750TraceView<std::uint8_t>     m_digitalProbe4Views[VX2750_MAX_CHANNELS];
 
 public:
     VX2750ModuleUnpacker(const char* moduleName, const char* paramBaseName);
@@ -70,6 +113,12 @@ public:
     void reset();                   // Data reset method.
     const void* unpackHit(const void* pData);
     
+    // Zero copy mode: probe samples are not copied out of the event; only
+    // the views are valid, and only for the life of the event.
+    
+    void setZeroCopy(bool enable);
+    bool isZeroCopy() const;
+    
     // Selectors:
     
     std::uint64_t getChannelMask() const;
@@ -93,10 +142,24 @@ public:
     std::uint16_t getDigitalProbe4Type(unsigned channel) const;
     const std::vector<std::uint8_t>&  getDigitalProbe4Samples(unsigned channel) const;
     
+    // Views work in both modes:
+    
+    VX2750TraceView<std::uint32_t> getAnalogProbe1View(unsigned channel) const;
+    VX2750TraceView<std::uint32_t> getAnalogProbe2View(unsigned channel) const;
+    VX2750TraceView<std::uint8_t>  getDigitalProbe1View(unsigned channel) const;
+    VX2750TraceView<std::uint8_t>  getDigitalProbe2View(unsigned channel) const;
+    VX2750TraceView<std::uint8_t>  getDigitalProbe3View(unsigned channel) const;
+    VX2750TraceView<std::uint8_t>  getDigitalProbe4View(unsigned channel) const;
+    
     
     // Utilities:
 private:
     void checkChannel(unsigned channel) const;
+    template<class T>
+    void setProbe(
+        const void* pSamples, std::size_t nSamples,
+        std::vector<T>& samples, VX2750TraceView<T>& view
+    );
     
     
     
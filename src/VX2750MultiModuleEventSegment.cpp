@@ -25,10 +25,37 @@
 
 #include "VX2750MultiTrigger.h"
 #include "VX2750EventSegment.h"
+#include "NSCLDAQLog.h"
 #include <CExperiment.h>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <exception>
+#include <stdexcept>
 
 
 namespace caen_nscldaq {
+    /**
+     * logVerify
+     *    Log a verification message.  If no log file has been set up the
+     *    message goes to stderr instead so it's not lost.
+     *  @param level - daqlog::Warning or daqlog::Error.
+     *  @param msg   - the message.
+     */
+    static void
+    logVerify(daqlog::logLevel level, const std::string& msg)
+    {
+        try {
+            if (level == daqlog::Error) {
+                daqlog::error(msg);
+            } else {
+                daqlog::warning(msg);
+            }
+        }
+        catch (std::logic_error&) {                  // No log file.
+            std::cerr << msg << std::endl;
+        }
+    }
     /**
      * constructor
      * Our job is simple, just initialize the internal data from the
@@ -64,19 +91,100 @@ namespace caen_nscldaq {
      *    them and initialize each one.
      *      This implies, for a synchronized set, the order is important with
      *      the master module needing to be last in the list.
+     *    If the configuration changed, all modules are hardware initialized
+     *    first and then (for modules that ask for it) the configuration
+     *    is read back from all of them in parallel and any differences
+     *    reported.
+     *  @throw std::string - verification of a module with verifyabort set
+     *         found differences or failed.  This fails the begin run.
      */
     void
     VX2750MultiModuleEventSegment::initialize()
     {
         auto modules = m_pTrigger->getModules();
-        for (auto p : modules) {
-            if (m_configChanged) {
+        if (m_configChanged) {
+            for (auto p : modules) {
                 p->hwInit();
             }
+            verifyModules(modules);
+        }
+        for (auto p : modules) {
             p->initialize();
         }
         m_configChanged = false;
     }
+    /**
+     * verifyModules
+     *    Read back the configurations of a set of modules, one thread
+     *    per module, and log mismatches as warnings, one line each:
+     *
+     *    Configuration mismatch: module name parameter [index] expected: e read back: a
+     *
+     *    A module that can't be verified is logged as an error.
+     *    Mismatches are reported so that e.g. values the firmware quietly
+     *    clamped are noticed.  They only fail the begin run for modules
+     *    configured with verifyabort; all modules are reported first.
+     *
+     * @param modules - the modules to verify.
+     * @throw std::string - a module with verifyabort had mismatches or
+     *        could not be verified.
+     */
+    void
+    VX2750MultiModuleEventSegment::verifyModules(
+        const std::vector<VX2750EventSegment*>& modules
+    )
+    {
+        std::vector<std::future<VX2750PHAModuleConfiguration::Mismatches>> results;
+        for (auto p : modules) {
+            results.push_back(std::async(std::launch::async, [p]() {
+                return p->verify();
+            }));
+        }
+        std::string failed;                         // Modules that abort.
+        for (int i = 0; i < modules.size(); i++) {
+            const std::string& name(modules[i]->getModuleName());
+            bool ok = true;
+            try {
+                auto mismatches = results[i].get();
+                for (auto& m : mismatches) {
+                    std::stringstream msg;
+                    msg << "Configuration mismatch: module " << name
+                        << " " << m.s_parameter;
+                    if (m.s_index >= 0) {
+                        msg << " [" << m.s_index << "]";
+                    }
+                    msg << " expected: " << m.s_expected
+                        << " read back: " << m.s_actual;
+                    logVerify(daqlog::Warning, msg.str());
+                }
+                ok = mismatches.empty();
+            }
+            catch (std::exception& e) {
+                logVerify(
+                    daqlog::Error,
+                    "Unable to verify the configuration of " + name + ": " + e.what()
+                );
+                ok = false;
+            }
+            catch (std::string msg) {
+                logVerify(
+                    daqlog::Error,
+                    "Unable to verify the configuration of " + name + ": " + msg
+                );
+                ok = false;
+            }
+            if (!ok && modules[i]->verifyAborts()) {
+                failed += " ";
+                failed += name;
+            }
+        }
+        if (!failed.empty()) {
+            std::string msg = "Configuration verification failed for:";
+            msg += failed;
+            msg += " (verifyabort is set; see the log for the differences)";
+            throw msg;
+        }
+    }
     /**
      * disable
      *    As above but call disable for each item:
@@ -90,19 +198,27 @@ namespace caen_nscldaq {
     }
     /**
      * onPause
-     *    This is just disable:
+     *    Pause each module.  The modules only stop/disarm keeping
+     *    their readout state so the resume can be quick.
      */
     void VX2750MultiModuleEventSegment::onPause()
     {
-        disable();
+        auto modules = m_pTrigger->getModules();
+        for (auto p : modules) {
+            p->onPause();
+        }
     }
     /**
      * onResume:
-     *    Similarly, this is is just enable.
+     *    Resume each module (re-arm/start).  As with initialize, the order is
+     *    important for a synchronized set.
      */
     void  VX2750MultiModuleEventSegment::onResume()
     {
-        initialize();
+        auto modules = m_pTrigger->getModules();
+        for (auto p : modules) {
+            p->onResume();
+        }
     }
     /**
      * read:
@@ -25,12 +25,14 @@
 #define VX2750MULTIMODULEEVENTSEGMENT_H
 
 #include <CEventSegment.h>
+#include <vector>
 
 class CExperiment;
 namespace caen_nscldaq {
     // Forward class references:
     
     class VX2750MultiTrigger;
+    class VX2750EventSegment;
     
     /**
      * @class VX2750MultiModuleEventSegment
@@ -58,6 +60,8 @@ namespace caen_nscldaq {
         void onPause();
         void onResume();
         size_t read(void* pBuffer, size_t maxwords);
+    private:
+        void verifyModules(const std::vector<VX2750EventSegment*>& modules);
     };
 }                         // caen_nscldaq namespace.
 
@@ -0,0 +1,392 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750OfflineDecoder.cpp
+* @brief    Implement the offline hit decoder.
+* @author   Ron Fox
+*
+*/
+#include "VX2750OfflineDecoder.h"
+#include <stdexcept>
+#include <sstream>
+#include <future>
+#include <string.h>
+
+namespace caen_offline {
+
+const std::uint32_t VX2750Hit::NO_SOURCE;
+
+// Event building can nest but not without limit:
+
+static const unsigned MAX_DEPTH = 8;
+
+// Event builder fragment header: timestamp, source id, payload size, barrier.
+
+static const std::size_t FRAGMENT_HEADER_SIZE =
+    sizeof(std::uint64_t) + 3*sizeof(std::uint32_t);
+
+/**
+ * Statistics constructor
+ *    All zero.
+ */
+VX2750OfflineDecoder::Statistics::Statistics() :
+    s_bytes(0), s_items(0), s_physicsItems(0), s_hits(0), s_errors(0)
+{}
+/**
+ * Statistics::operator+=
+ *    Accumulate the statistics of another chunk.  The first error is the
+ *    first one seen in the order the statistics are summed.
+ */
+VX2750OfflineDecoder::Statistics&
+VX2750OfflineDecoder::Statistics::operator+=(const Statistics& rhs)
+{
+    s_bytes        += rhs.s_bytes;
+    s_items        += rhs.s_items;
+    s_physicsItems += rhs.s_physicsItems;
+    s_hits         += rhs.s_hits;
+    if (s_errors == 0) s_firstError = rhs.s_firstError;
+    s_errors       += rhs.s_errors;
+    return *this;
+}
+
+/**
+ * constructor
+ *  @param file - the file to decode; must live as long as we do.
+ */
+VX2750OfflineDecoder::VX2750OfflineDecoder(const VX2750EventFile& file) :
+    m_file(file)
+{}
+/**
+ * destructor
+ */
+VX2750OfflineDecoder::~VX2750OfflineDecoder()
+{}
+/**
+ * decode
+ *    Decode the hits in a chunk of the file.
+ *  @param chunk - the chunk (see VX2750EventFile::chunks).
+ *  @param visitor - called for each hit in file order.
+ *  @return Statistics - what was seen in the chunk.
+ *  @throw std::runtime_error - a ring item size is invalid so we can't
+ *         find the next item.
+ *  @note  anything else thrown (by the visitor or std::bad_alloc) ends the
+ *         decode and is passed on.
+ */
+VX2750OfflineDecoder::Statistics
+VX2750OfflineDecoder::decode(
+    const VX2750EventFile::Chunk& chunk, VX2750HitVisitor& visitor
+)
+{
+    Statistics stats;
+    VX2750Hit  hit;
+    const std::uint8_t* pData = m_file.data();
+
+    std::uint64_t offset = chunk.s_begin;
+    while (offset < chunk.s_end) {
+        std::uint64_t next = m_file.nextItem(offset);
+        if (next > chunk.s_end) {
+            std::stringstream msg;
+            msg << m_file.getFilename() << ": Ring item at offset " << offset
+                << " runs past the end of its chunk";
+            throw std::runtime_error(msg.str());
+        }
+        decodeItem(pData + offset, offset, hit, visitor, stats);
+        stats.s_bytes += next - offset;
+        offset = next;
+    }
+    return stats;
+}
+/**
+ * decode
+ *    Decode the whole file in parallel.  The file is cut into one chunk per
+ *    visitor and each chunk is decoded in its own thread.  Visitor i sees the
+ *    hits of chunk i, in file order, so concatenating the visitors' results
+ *    in order gives the file order.
+ *  @param visitors - one per thread.  If the file has fewer items than
+ *                    visitors, the last visitors see nothing.
+ *  @return Statistics - summed over the chunks.
+ *  @throw std::runtime_error - a ring item size is invalid.
+ */
+VX2750OfflineDecoder::Statistics
+VX2750OfflineDecoder::decode(std::vector<VX2750HitVisitor*>& visitors)
+{
+    return decode(m_file.chunks(visitors.size()), visitors);
+}
+/**
+ * decode
+ *    Decode a set of chunks in parallel, one thread per visitor.  Visitor
+ *    i decodes chunks i, i+n, i+2n... (n visitors) in that order, so with
+ *    one visitor all hits are seen in chunk order.
+ *  @param chunks   - the chunks e.g. from VX2750EventFile::chunks or
+ *                    VX2750TimeIndex::find.
+ *  @param visitors - one per thread.
+ *  @return Statistics - summed over the chunks.
+ *  @throw std::runtime_error - a ring item size is invalid.
+ */
+VX2750OfflineDecoder::Statistics
+VX2750OfflineDecoder::decode(
+    const std::vector<VX2750EventFile::Chunk>& chunks,
+    std::vector<VX2750HitVisitor*>& visitors
+)
+{
+    std::vector<std::future<Statistics>> results;
+    std::size_t n = visitors.size();
+    for (std::size_t i = 0; i < n && i < chunks.size(); i++) {
+        VX2750HitVisitor* pVisitor = visitors[i];
+        results.push_back(std::async(std::launch::async, [this, &chunks, i, n, pVisitor]() {
+            Statistics stats;
+            for (std::size_t c = i; c < chunks.size(); c += n) {
+                m_file.willNeed(chunks[c]);
+                stats += decode(chunks[c], *pVisitor);
+            }
+            return stats;
+        }));
+    }
+    Statistics result;
+    for (auto& r : results) {
+        result += r.get();
+    }
+    return result;
+}
+/**
+ * decodeHit
+ *    Decode one hit.  The layout is that of
+ *    caen_spectcl::VX2750ModuleUnpacker::unpackHit: a uint32_t count of
+ *    uint16_t words (including itself) followed by the hit.
+ *  @param p    - points to the hit's word count.
+ *  @param pEnd - end of the data the hit must fit in.
+ *  @param[out] hit - the decoded hit.  s_sourceId and s_itemOffset are not
+ *                modified.
+ *  @return const std::uint8_t* - pointer just past the hit.
+ *  @throw VX2750FormatError - the hit doesn't fit or its parts don't add up
+ *         to its word count.
+ */
+const std::uint8_t*
+VX2750OfflineDecoder::decodeHit(
+    const std::uint8_t* p, const std::uint8_t* pEnd, VX2750Hit& hit
+)
+{
+    if (std::size_t(pEnd - p) < sizeof(std::uint32_t)) {
+        throw VX2750FormatError("Hit size does not fit in its item");
+    }
+    const std::uint8_t* pBegin = p;
+    std::uint64_t nBytes = *reinterpret_cast<const std::uint32_t*>(p) * sizeof(std::uint16_t);
+    if (nBytes < sizeof(std::uint32_t) + sizeof(std::uint16_t)) {
+        throw VX2750FormatError("Hit word count is too small");
+    }
+    if (nBytes > std::uint64_t(pEnd - p)) {
+        throw VX2750FormatError("Hit runs past the end of its item");
+    }
+    const std::uint8_t* pHitEnd = p + nBytes;
+    hit.s_pData = p;
+    hit.s_bytes = nBytes;
+    p += sizeof(std::uint32_t);
+
+    // Module name; null terminated and padded to a uint16_t:
+
+    const void* pNull = memchr(p, 0, pHitEnd - p);
+    if (!pNull) {
+        throw VX2750FormatError("Hit module name is not terminated");
+    }
+    hit.s_moduleName = reinterpret_cast<const char*>(p);
+    std::size_t nameBytes = reinterpret_cast<const std::uint8_t*>(pNull) - p + 1;
+    p += (nameBytes + 1) & ~std::size_t(1);
+
+    // Fixed part:
+
+    const std::size_t fixedBytes =
+        sizeof(std::uint16_t) + 2*sizeof(std::uint64_t) + 6*sizeof(std::uint16_t);
+    if (std::size_t(pHitEnd - p) < fixedBytes) {
+        throw VX2750FormatError("Hit is too small for its fixed part");
+    }
+    memcpy(&hit.s_channel, p, sizeof(std::uint16_t));         p += sizeof(std::uint16_t);
+    memcpy(&hit.s_timestamp, p, sizeof(std::uint64_t));       p += sizeof(std::uint64_t);
+    memcpy(&hit.s_rawTimestamp, p, sizeof(std::uint64_t));    p += sizeof(std::uint64_t);
+    memcpy(&hit.s_fineTimestamp, p, sizeof(std::uint16_t));   p += sizeof(std::uint16_t);
+    memcpy(&hit.s_energy, p, sizeof(std::uint16_t));          p += sizeof(std::uint16_t);
+    memcpy(&hit.s_lowPriorityFlags, p, sizeof(std::uint16_t)); p += sizeof(std::uint16_t);
+    memcpy(&hit.s_highPriorityFlags, p, sizeof(std::uint16_t)); p += sizeof(std::uint16_t);
+    memcpy(&hit.s_downSampleSelection, p, sizeof(std::uint16_t)); p += sizeof(std::uint16_t);
+    memcpy(&hit.s_failFlags, p, sizeof(std::uint16_t));       p += sizeof(std::uint16_t);
+
+    // Probes: type, count then samples.  Analog samples are uint32_t,
+    // digital samples are bytes:
+
+    const std::size_t probeHeader = sizeof(std::uint16_t) + sizeof(std::uint32_t);
+    for (int i = 0; i < 6; i++) {
+        if (std::size_t(pHitEnd - p) < probeHeader) {
+            throw VX2750FormatError("Hit is too small for its probes");
+        }
+        std::uint16_t type;
+        std::uint32_t n;
+        memcpy(&type, p, sizeof(std::uint16_t));  p += sizeof(std::uint16_t);
+        memcpy(&n, p, sizeof(std::uint32_t));     p += sizeof(std::uint32_t);
+        std::uint64_t sampleBytes = (i < 2) ? std::uint64_t(n)*sizeof(std::uint32_t) : n;
+        if (sampleBytes > std::uint64_t(pHitEnd - p)) {
+            throw VX2750FormatError("Hit probe runs past the end of the hit");
+        }
+        if (i < 2) {
+            VX2750Probe<std::uint32_t>& probe(hit.s_analogProbes[i]);
+            probe.s_type = type;
+            probe.s_nSamples = n;
+            probe.s_pSamples = reinterpret_cast<const std::uint32_t*>(p);
+        } else {
+            VX2750Probe<std::uint8_t>& probe(hit.s_digitalProbes[i-2]);
+            probe.s_type = type;
+            probe.s_nSamples = n;
+            probe.s_pSamples = p;
+        }
+        p += sampleBytes;
+    }
+    if ((p - pBegin) % 2) p++;                // Skip any padding.
+    if (p != pHitEnd) {
+        std::stringstream msg;
+        msg << "Hit word count says " << nBytes << " bytes but the hit has "
+            << (p - pBegin);
+        throw VX2750FormatError(msg.str());
+    }
+    return p;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * decodeItem
+ *    Decode a ring item.  Only PHYSICS_EVENT items have hits.
+ *  @param pItem   - the ring item.
+ *  @param offset  - its file offset.
+ *  @param hit     - scratch hit.
+ *  @param visitor - called for each hit.
+ *  @param stats   - statistics to update.
+ */
+void
+VX2750OfflineDecoder::decodeItem(
+    const std::uint8_t* pItem, std::uint64_t offset,
+    VX2750Hit& hit, VX2750HitVisitor& visitor, Statistics& stats
+)
+{
+    const std::uint32_t* pHeader = reinterpret_cast<const std::uint32_t*>(pItem);
+    stats.s_items++;
+    if (pHeader[1] != VX2750EventFile::PHYSICS_EVENT) return;
+    stats.s_physicsItems++;
+
+    hit.s_itemOffset = offset;
+    try {
+        const std::uint8_t* pEnd = pItem + pHeader[0];
+        const std::uint8_t* pBody = pItem + 2*sizeof(std::uint32_t);
+        std::uint32_t sid = VX2750Hit::NO_SOURCE;
+        if (std::size_t(pEnd - pBody) < sizeof(std::uint32_t)) {
+            throw VX2750FormatError("Ring item is too small for its body header size");
+        }
+        // The body header size includes itself;  0 or sizeof(uint32_t)
+        // means there's no body header.  If there is one the source id
+        // follows the timestamp.
+
+        std::uint32_t bodyHeaderSize = pHeader[2];
+        if (bodyHeaderSize > sizeof(std::uint32_t)) {
+            if (bodyHeaderSize > std::uint64_t(pEnd - pBody) ||
+                bodyHeaderSize < 2*sizeof(std::uint32_t) + sizeof(std::uint64_t)) {
+                throw VX2750FormatError("Invalid body header size");
+            }
+            memcpy(&sid, pBody + sizeof(std::uint32_t) + sizeof(std::uint64_t), sizeof(sid));
+        } else {
+            bodyHeaderSize = sizeof(std::uint32_t);
+        }
+        decodeBody(pBody + bodyHeaderSize, pEnd, sid, 0, hit, visitor, stats);
+    }
+    catch (VX2750FormatError& e) {
+        if (stats.s_errors == 0) {
+            std::stringstream msg;
+            msg << m_file.getFilename() << ": Ring item at offset " << offset
+                << ": " << e.what();
+            stats.s_firstError = msg.str();
+        }
+        stats.s_errors++;
+    }
+}
+/**
+ * decodeBody
+ *    Decode the body of a physics item (or fragment payload).
+ *  @param p       - the body.
+ *  @param pEnd    - end of the body.
+ *  @param sid     - source id of the body (from its body header).
+ *  @param depth   - event building nesting depth.
+ *  @param hit     - scratch hit.
+ *  @param visitor - called for each hit.
+ *  @param stats   - statistics to update.
+ *  @throw VX2750FormatError - malformed body.
+ */
+void
+VX2750OfflineDecoder::decodeBody(
+    const std::uint8_t* p, const std::uint8_t* pEnd, std::uint32_t sid,
+    unsigned depth, VX2750Hit& hit, VX2750HitVisitor& visitor, Statistics& stats
+)
+{
+    if (p == pEnd) return;                             // Empty body.
+    if (std::size_t(pEnd - p) < sizeof(std::uint32_t)) {
+        throw VX2750FormatError("Body is too small for its size");
+    }
+    std::uint32_t size = *reinterpret_cast<const std::uint32_t*>(p);
+
+    if (size != std::size_t(pEnd - p)) {
+        // Hits:
+
+        while (p < pEnd) {
+            p = decodeHit(p, pEnd, hit);
+            hit.s_sourceId = sid;
+            stats.s_hits++;
+            visitor.hit(hit);
+        }
+        return;
+    }
+    // Event built: fragments each with a ring item payload:
+
+    if (depth >= MAX_DEPTH) {
+        throw VX2750FormatError("Event building is nested too deeply");
+    }
+    p += sizeof(std::uint32_t);
+    while (p < pEnd) {
+        if (std::size_t(pEnd - p) < FRAGMENT_HEADER_SIZE) {
+            throw VX2750FormatError("Truncated fragment header");
+        }
+        std::uint32_t fragSid, payloadSize;
+        memcpy(&fragSid, p + sizeof(std::uint64_t), sizeof(std::uint32_t));
+        memcpy(
+            &payloadSize, p + sizeof(std::uint64_t) + sizeof(std::uint32_t),
+            sizeof(std::uint32_t)
+        );
+        const std::uint8_t* pPayload = p + FRAGMENT_HEADER_SIZE;
+        if (payloadSize > std::size_t(pEnd - pPayload) ||
+            payloadSize < 3*sizeof(std::uint32_t)) {
+            throw VX2750FormatError("Fragment payload size is invalid");
+        }
+        const std::uint32_t* pItem = reinterpret_cast<const std::uint32_t*>(pPayload);
+        std::uint32_t bodyHeaderSize = pItem[2];
+        if (bodyHeaderSize < sizeof(std::uint32_t)) bodyHeaderSize = sizeof(std::uint32_t);
+        if (pItem[0] != payloadSize ||
+            bodyHeaderSize > payloadSize - 2*sizeof(std::uint32_t)) {
+            throw VX2750FormatError("Fragment payload ring item size is invalid");
+        }
+        decodeBody(
+            pPayload + 2*sizeof(std::uint32_t) + bodyHeaderSize,
+            pPayload + payloadSize, fragSid, depth + 1, hit, visitor, stats
+        );
+        p = pPayload + payloadSize;
+    }
+}
+}                                     // caen_offline namespace
@@ -0,0 +1,152 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750OfflineDecoder.h
+* @brief    Decode VX2750 hits from event files without SpecTcl.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750OFFLINEDECODER_H
+#define VX2750OFFLINEDECODER_H
+#include "VX2750EventFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace caen_offline {
+/**
+ * @class VX2750FormatError
+ *    Thrown by VX2750OfflineDecoder for data that isn't laid out as it
+ *    should be.  Only these mark a ring item as malformed; anything else
+ *    thrown while decoding (by a visitor, or std::bad_alloc) is passed on
+ *    to the caller.
+ */
+class VX2750FormatError : public std::runtime_error {
+public:
+    explicit VX2750FormatError(const std::string& what) :
+        std::runtime_error(what) {}
+};
+/**
+ * @struct VX2750Probe
+ *    A probe (trace) of a hit.  The samples are not copied; s_pSamples
+ *    points into the event file and is valid as long as the file is.
+ */
+template<class T>
+struct VX2750Probe {
+    std::uint16_t s_type;
+    std::uint32_t s_nSamples;
+    const T*      s_pSamples;
+};
+/**
+ * @struct VX2750Hit
+ *    One decoded hit.  The fields are those written by
+ *    caen_nscldaq::VX2750EventSegment::read and unpacked by
+ *    caen_spectcl::VX2750ModuleUnpacker::unpackHit.  Pointers point into the
+ *    event file.
+ */
+struct VX2750Hit {
+    static const std::uint32_t NO_SOURCE = 0xffffffff;
+
+    const char*   s_moduleName;
+    std::uint32_t s_sourceId;           // Fragment/body header sid or NO_SOURCE.
+    std::uint64_t s_itemOffset;         // File offset of the ring item.
+    const std::uint8_t* s_pData;        // The hit as read (word count first)
+    std::uint32_t s_bytes;              // and its size.
+    std::uint16_t s_channel;
+    std::uint64_t s_timestamp;          // ns.
+    std::uint64_t s_rawTimestamp;
+    std::uint16_t s_fineTimestamp;
+    std::uint16_t s_energy;
+    std::uint16_t s_lowPriorityFlags;
+    std::uint16_t s_highPriorityFlags;
+    std::uint16_t s_downSampleSelection;
+    std::uint16_t s_failFlags;
+    VX2750Probe<std::uint32_t> s_analogProbes[2];
+    VX2750Probe<std::uint8_t>  s_digitalProbes[4];
+};
+/**
+ * @class VX2750HitVisitor
+ *    Called by VX2750OfflineDecoder for each hit.  When decoding in parallel
+ *    each chunk has its own visitor so visitors need not be thread-safe.
+ */
+class VX2750HitVisitor {
+public:
+    virtual ~VX2750HitVisitor() {}
+    virtual void hit(const VX2750Hit& hit) = 0;
+};
+/**
+ * @class VX2750OfflineDecoder
+ *    Walks the ring items of a VX2750EventFile and decodes the hits in
+ *    the PHYSICS_EVENT items.  Both event built and unbuilt data are
+ *    understood and the two are told apart item by item:
+ *
+ *    -  Event built bodies start with a uint32_t byte count that is
+ *       the size of the body.  Each fragment's payload is a ring item whose
+ *       body is decoded in the same way so nested event building works.
+ *    -  Hit bodies start with a uint32_t count of uint16_t words, the
+ *       layout VX2750EventProcessor expects.
+ *
+ *    Malformed items are counted and skipped; the message for the first
+ *    one is kept.  Other item types are counted and otherwise ignored.
+ *    Exceptions thrown by visitors are not malformed items; they end the
+ *    decode and are rethrown from it.
+ */
+class VX2750OfflineDecoder {
+public:
+    struct Statistics {
+        std::uint64_t s_bytes;              // Bytes of ring items walked.
+        std::uint64_t s_items;
+        std::uint64_t s_physicsItems;
+        std::uint64_t s_hits;
+        std::uint64_t s_errors;             // Malformed items.
+        std::string   s_firstError;
+
+        Statistics();
+        Statistics& operator+=(const Statistics& rhs);
+    };
+private:
+    const VX2750EventFile& m_file;
+public:
+    VX2750OfflineDecoder(const VX2750EventFile& file);
+    virtual ~VX2750OfflineDecoder();
+
+    Statistics decode(const VX2750EventFile::Chunk& chunk, VX2750HitVisitor& visitor);
+    Statistics decode(std::vector<VX2750HitVisitor*>& visitors);
+    Statistics decode(
+        const std::vector<VX2750EventFile::Chunk>& chunks,
+        std::vector<VX2750HitVisitor*>& visitors
+    );
+
+    static const std::uint8_t* decodeHit(
+        const std::uint8_t* p, const std::uint8_t* pEnd, VX2750Hit& hit
+    );
+private:
+    void decodeItem(
+        const std::uint8_t* pItem, std::uint64_t offset,
+        VX2750Hit& hit, VX2750HitVisitor& visitor, Statistics& stats
+    );
+    void decodeBody(
+        const std::uint8_t* p, const std::uint8_t* pEnd, std::uint32_t sid,
+        unsigned depth, VX2750Hit& hit, VX2750HitVisitor& visitor,
+        Statistics& stats
+    );
+};
+}                                     // caen_offline namespace
+#endif
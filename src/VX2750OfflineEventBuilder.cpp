@@ -0,0 +1,473 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750OfflineEventBuilder.cpp
+* @brief    Implement the offline event builder.
+* @author   Ron Fox
+*
+*/
+#include "VX2750OfflineEventBuilder.h"
+#include <algorithm>
+#include <future>
+#include <queue>
+#include <stdexcept>
+#include <system_error>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+
+namespace caen_offline {
+
+const std::size_t VX2750OfflineEventBuilder::DEFAULT_PARTITION_HITS;
+
+// Hits examined looking for a gap before giving up on a partition cut:
+
+static const std::size_t MAX_GAP_SEARCH = 65536;
+
+// Sizes of the pieces of a built event:
+
+static const std::size_t ITEM_HEADER_SIZE = VX2750EventFile::ITEM_HEADER_SIZE;
+static const std::size_t BODY_HEADER_SIZE = VX2750EventFile::BODY_HEADER_SIZE;
+static const std::size_t FRAGMENT_HEADER_SIZE =
+    sizeof(std::uint64_t) + 3*sizeof(std::uint32_t);
+
+/**
+ * @class StreamCollector
+ *    Hit visitor that sorts the hits of a chunk into streams by source id.
+ *    Hits mostly come in runs from one source so the last stream used is
+ *    checked before the map is searched.
+ */
+class StreamCollector : public VX2750HitVisitor
+{
+public:
+    std::map<std::uint32_t, std::vector<VX2750OfflineEventBuilder::HitRef>> m_streams;
+    std::uint64_t m_noSource;
+private:
+    std::uint32_t m_lastSid;
+    std::vector<VX2750OfflineEventBuilder::HitRef>* m_pLast;
+public:
+    StreamCollector() : m_noSource(0), m_lastSid(0), m_pLast(nullptr) {}
+    virtual void hit(const VX2750Hit& hit) {
+        if (hit.s_sourceId == VX2750Hit::NO_SOURCE) {
+            m_noSource++;
+            return;
+        }
+        if (!m_pLast || hit.s_sourceId != m_lastSid) {
+            m_pLast = &m_streams[hit.s_sourceId];
+            m_lastSid = hit.s_sourceId;
+        }
+        VX2750OfflineEventBuilder::HitRef ref = {hit.s_timestamp, hit.s_pData, hit.s_bytes};
+        m_pLast->push_back(ref);
+    }
+};
+/**
+ * @struct MergeHead
+ *    The next hit of a stream in a k-way merge.  Ties in timestamp go to
+ *    the stream with the lower index (source id) so output is repeatable.
+ */
+struct MergeHead {
+    std::uint64_t s_timestamp;
+    std::uint32_t s_stream;
+    std::size_t   s_index;
+    bool operator>(const MergeHead& rhs) const {
+        return (s_timestamp > rhs.s_timestamp) ||
+            ((s_timestamp == rhs.s_timestamp) && (s_stream > rhs.s_stream));
+    }
+};
+typedef std::priority_queue<MergeHead, std::vector<MergeHead>, std::greater<MergeHead>> MergeQueue;
+
+template<class T> static void put(std::uint8_t*& p, T value)
+{
+    memcpy(p, &value, sizeof(T));
+    p += sizeof(T);
+}
+static bool
+earlier(const VX2750OfflineEventBuilder::HitRef& a, const VX2750OfflineEventBuilder::HitRef& b)
+{
+    return a.s_timestamp < b.s_timestamp;
+}
+
+/**
+ * Statistics constructor
+ */
+VX2750OfflineEventBuilder::Statistics::Statistics() :
+    s_hits(0), s_events(0), s_maxFragments(0), s_unsorted(0), s_noSource(0),
+    s_partitions(0), s_bytes(0)
+{}
+
+/**
+ * constructor
+ *  @param window   - coincidence window in ns.  Hits at most this long
+ *                    after the first hit of an event are in the event.
+ *  @param sourceId - source id put in the body headers of built events.
+ */
+VX2750OfflineEventBuilder::VX2750OfflineEventBuilder(
+    std::uint64_t window, std::uint32_t sourceId
+) :
+    m_window(window), m_sourceId(sourceId), m_noSource(0)
+{}
+/**
+ * destructor
+ */
+VX2750OfflineEventBuilder::~VX2750OfflineEventBuilder()
+{}
+/**
+ * addFile
+ *    Add the hits in an event file to the streams.  Files should be added
+ *    in time order (e.g. the segments of a run in order).
+ *  @param file    - the file; must live until build is done.
+ *  @param threads - number of decoding threads.
+ *  @return VX2750OfflineDecoder::Statistics - what was in the file.
+ *  @throw std::runtime_error - a ring item has an invalid size.
+ */
+VX2750OfflineDecoder::Statistics
+VX2750OfflineEventBuilder::addFile(const VX2750EventFile& file, unsigned threads)
+{
+    auto chunks = file.chunks(threads);
+    std::vector<StreamCollector> collectors(chunks.size());
+    std::vector<VX2750HitVisitor*> visitors;
+    for (auto& c : collectors) visitors.push_back(&c);
+    VX2750OfflineDecoder decoder(file);
+    auto stats = decoder.decode(chunks, visitors);
+
+    for (auto& c : collectors) {
+        for (auto& s : c.m_streams) {
+            auto& stream(m_streams[s.first]);
+            stream.insert(stream.end(), s.second.begin(), s.second.end());
+        }
+        m_noSource += c.m_noSource;
+    }
+    // State changes:
+
+    std::uint64_t offset = 0;
+    while (!chunks.empty() && offset < chunks.back().s_end) {
+        const std::uint8_t* pItem = file.data() + offset;
+        std::uint32_t type = reinterpret_cast<const std::uint32_t*>(pItem)[1];
+        if (type == VX2750EventFile::BEGIN_RUN) m_beginRuns.push_back(pItem);
+        if (type == VX2750EventFile::END_RUN)   m_endRuns.push_back(pItem);
+        offset = file.nextItem(offset);
+    }
+    return stats;
+}
+/**
+ * build
+ *    Build events from the hits added so far and write them.
+ *  @param fd            - file descriptor to write to.
+ *  @param threads       - number of partitions built at once.
+ *  @param partitionHits - target hits per partition.  The output of
+ *                         threads partitions is held in memory at a time.
+ *  @return Statistics - what was built.
+ *  @throw std::system_error - a write failed.
+ *  @throw std::runtime_error - an event is too big for a ring item.
+ */
+VX2750OfflineEventBuilder::Statistics
+VX2750OfflineEventBuilder::build(int fd, unsigned threads, std::size_t partitionHits)
+{
+    if (threads == 0) threads = 1;
+    if (partitionHits == 0) partitionHits = 1;
+
+    Statistics stats;
+    stats.s_noSource = m_noSource;
+    std::vector<std::vector<HitRef>*> streams;
+    std::vector<std::uint32_t> sids;
+    for (auto& s : m_streams) {
+        sids.push_back(s.first);
+        streams.push_back(&s.second);
+    }
+    stats.s_unsorted = sortStreams(streams);
+    std::vector<Cut> cuts = partition(streams, partitionHits);
+    stats.s_partitions = cuts.size() - 1;
+
+    for (auto p : m_beginRuns) {
+        write(fd, p, *reinterpret_cast<const std::uint32_t*>(p));
+        stats.s_bytes += *reinterpret_cast<const std::uint32_t*>(p);
+    }
+    // Build a batch of partitions in parallel then write them in order:
+
+    for (std::size_t first = 0; first < cuts.size() - 1; first += threads) {
+        std::size_t n = std::min<std::size_t>(threads, cuts.size() - 1 - first);
+        std::vector<std::vector<std::uint8_t>> outputs(n);
+        std::vector<Statistics> partStats(n);
+        std::vector<std::future<void>> results;
+        for (std::size_t i = 0; i < n; i++) {
+            results.push_back(std::async(std::launch::async,
+                [this, &streams, &sids, &cuts, &outputs, &partStats, first, i]() {
+                    buildPartition(
+                        streams, sids, cuts[first + i], cuts[first + i + 1],
+                        outputs[i], partStats[i]
+                    );
+                }
+            ));
+        }
+        for (auto& r : results) r.get();
+        for (std::size_t i = 0; i < n; i++) {
+            write(fd, outputs[i].data(), outputs[i].size());
+            stats.s_bytes  += outputs[i].size();
+            stats.s_hits   += partStats[i].s_hits;
+            stats.s_events += partStats[i].s_events;
+            stats.s_maxFragments = std::max(stats.s_maxFragments, partStats[i].s_maxFragments);
+        }
+    }
+    for (auto p : m_endRuns) {
+        write(fd, p, *reinterpret_cast<const std::uint32_t*>(p));
+        stats.s_bytes += *reinterpret_cast<const std::uint32_t*>(p);
+    }
+    return stats;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * sortStreams
+ *    Put any streams that aren't in timestamp order in order (in
+ *    parallel, a thread per stream that needs it).
+ *  @param streams - the streams.
+ *  @return std::uint64_t - number of hits that were earlier than the hit
+ *          before them in their stream.
+ */
+std::uint64_t
+VX2750OfflineEventBuilder::sortStreams(std::vector<std::vector<HitRef>*>& streams)
+{
+    std::vector<std::future<std::uint64_t>> results;
+    for (auto pStream : streams) {
+        results.push_back(std::async(std::launch::async, [pStream]() {
+            std::uint64_t unsorted = 0;
+            for (std::size_t i = 1; i < pStream->size(); i++) {
+                if ((*pStream)[i].s_timestamp < (*pStream)[i-1].s_timestamp) unsorted++;
+            }
+            if (unsorted) {
+                std::stable_sort(pStream->begin(), pStream->end(), earlier);
+            }
+            return unsorted;
+        }));
+    }
+    std::uint64_t result = 0;
+    for (auto& r : results) result += r.get();
+    return result;
+}
+/**
+ * partition
+ *    Cut the streams into partitions of about partitionHits hits.  Cut
+ *    times are chosen from a sample of the timestamps and each is moved
+ *    to the next gap in the merged hits that's longer than the window.  If
+ *    there's no such gap near a cut time the cut is dropped.
+ *  @param streams       - the (sorted) streams.
+ *  @param partitionHits - target partition size.
+ *  @return std::vector<Cut> - partition i is [result[i], result[i+1]) in
+ *          each stream.  There's always at least one partition.
+ */
+std::vector<VX2750OfflineEventBuilder::Cut>
+VX2750OfflineEventBuilder::partition(
+    const std::vector<std::vector<HitRef>*>& streams, std::size_t partitionHits
+) const
+{
+    std::size_t total = 0;
+    Cut begin, end;
+    for (auto pStream : streams) {
+        total += pStream->size();
+        begin.push_back(0);
+        end.push_back(pStream->size());
+    }
+    std::vector<Cut> result = {begin};
+    std::size_t nParts = total / partitionHits;
+
+    if (nParts > 1) {
+        std::size_t step = std::max<std::size_t>(1, total / (nParts * 16));
+        std::vector<std::uint64_t> samples;
+        for (auto pStream : streams) {
+            for (std::size_t i = 0; i < pStream->size(); i += step) {
+                samples.push_back((*pStream)[i].s_timestamp);
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+
+        std::uint64_t last = 0;
+        for (std::size_t i = 1; i < nParts; i++) {
+            std::uint64_t boundary;
+            if (!findGap(streams, samples[i * samples.size() / nParts], boundary)) {
+                continue;
+            }
+            if (boundary <= last) continue;
+            last = boundary;
+
+            Cut cut;
+            for (auto pStream : streams) {
+                HitRef key = {boundary, nullptr, 0};
+                cut.push_back(
+                    std::lower_bound(pStream->begin(), pStream->end(), key, earlier)
+                    - pStream->begin()
+                );
+            }
+            result.push_back(cut);
+        }
+    }
+    result.push_back(end);
+    return result;
+}
+/**
+ * findGap
+ *    Find the first hit at or after a time that is more than the window
+ *    after the hit before it in the merged streams.  That hit must start an
+ *    event.
+ *  @param streams - the (sorted) streams.
+ *  @param t       - where to start looking.
+ *  @param[out] boundary - the hit's timestamp.
+ *  @return bool - false if there's no such hit near t.
+ */
+bool
+VX2750OfflineEventBuilder::findGap(
+    const std::vector<std::vector<HitRef>*>& streams, std::uint64_t t,
+    std::uint64_t& boundary
+) const
+{
+    MergeQueue queue;
+    bool havePrevious = false;
+    std::uint64_t previous = 0;
+    for (std::uint32_t s = 0; s < streams.size(); s++) {
+        auto& stream(*streams[s]);
+        HitRef key = {t, nullptr, 0};
+        std::size_t i = std::lower_bound(stream.begin(), stream.end(), key, earlier) - stream.begin();
+        if (i > 0 && (!havePrevious || stream[i-1].s_timestamp > previous)) {
+            previous = stream[i-1].s_timestamp;
+            havePrevious = true;
+        }
+        if (i < stream.size()) {
+            MergeHead h = {stream[i].s_timestamp, s, i};
+            queue.push(h);
+        }
+    }
+    if (!havePrevious) return false;            // Nothing before t.
+
+    for (std::size_t n = 0; n < MAX_GAP_SEARCH && !queue.empty(); n++) {
+        MergeHead h = queue.top();
+        queue.pop();
+        if (h.s_timestamp - previous > m_window) {
+            boundary = h.s_timestamp;
+            return true;
+        }
+        previous = h.s_timestamp;
+        auto& stream(*streams[h.s_stream]);
+        if (++h.s_index < stream.size()) {
+            h.s_timestamp = stream[h.s_index].s_timestamp;
+            queue.push(h);
+        }
+    }
+    return false;
+}
+/**
+ * buildPartition
+ *    Merge a partition of the streams and build its events.
+ *  @param streams     - the streams.
+ *  @param sids        - the source id of each stream.
+ *  @param begin, end  - the partition.
+ *  @param[out] out    - the built ring items are appended here.
+ *  @param[out] stats  - hits, events and largest event of the partition.
+ *  @throw std::runtime_error - an event is too big for a ring item.
+ */
+void
+VX2750OfflineEventBuilder::buildPartition(
+    const std::vector<std::vector<HitRef>*>& streams,
+    const std::vector<std::uint32_t>& sids, const Cut& begin, const Cut& end,
+    std::vector<std::uint8_t>& out, Statistics& stats
+) const
+{
+    MergeQueue queue;
+    for (std::uint32_t s = 0; s < streams.size(); s++) {
+        if (begin[s] < end[s]) {
+            MergeHead h = {(*streams[s])[begin[s]].s_timestamp, s, begin[s]};
+            queue.push(h);
+        }
+    }
+    std::vector<MergeHead> event;
+    std::uint64_t     eventBytes = 0;
+    auto emit = [&]() {
+        std::uint64_t bodyBytes = sizeof(std::uint32_t) + eventBytes;
+        std::uint64_t itemBytes = ITEM_HEADER_SIZE + BODY_HEADER_SIZE + bodyBytes;
+        if (itemBytes > 0xffffffff) {
+            throw std::runtime_error("Built event is too big for a ring item");
+        }
+        std::size_t offset = out.size();
+        out.resize(offset + itemBytes);
+        std::uint8_t* p = out.data() + offset;
+
+        put<std::uint32_t>(p, itemBytes);
+        put<std::uint32_t>(p, VX2750EventFile::PHYSICS_EVENT);
+        put<std::uint32_t>(p, BODY_HEADER_SIZE);
+        put<std::uint64_t>(p, event[0].s_timestamp);
+        put<std::uint32_t>(p, m_sourceId);
+        put<std::uint32_t>(p, 0);                          // Barrier type.
+        put<std::uint32_t>(p, bodyBytes);
+        for (auto& h : event) {
+            const HitRef& hit((*streams[h.s_stream])[h.s_index]);
+            std::uint32_t sid = sids[h.s_stream];
+            std::uint32_t payloadBytes = ITEM_HEADER_SIZE + BODY_HEADER_SIZE + hit.s_bytes;
+            put<std::uint64_t>(p, hit.s_timestamp);
+            put<std::uint32_t>(p, sid);
+            put<std::uint32_t>(p, payloadBytes);
+            put<std::uint32_t>(p, 0);
+            p = VX2750EventFile::putPhysicsItem(
+                p, hit.s_timestamp, sid, hit.s_pData, hit.s_bytes
+            );
+        }
+        stats.s_events++;
+        stats.s_hits += event.size();
+        if (event.size() > stats.s_maxFragments) stats.s_maxFragments = event.size();
+        event.clear();
+        eventBytes = 0;
+    };
+
+    while (!queue.empty()) {
+        MergeHead h = queue.top();
+        queue.pop();
+        if (!event.empty() && (h.s_timestamp - event[0].s_timestamp > m_window)) {
+            emit();
+        }
+        event.push_back(h);
+        eventBytes += FRAGMENT_HEADER_SIZE + ITEM_HEADER_SIZE + BODY_HEADER_SIZE +
+            (*streams[h.s_stream])[h.s_index].s_bytes;
+
+        if (++h.s_index < end[h.s_stream]) {
+            h.s_timestamp = (*streams[h.s_stream])[h.s_index].s_timestamp;
+            queue.push(h);
+        }
+    }
+    if (!event.empty()) emit();
+}
+/**
+ * write
+ *    Write data, retrying partial writes.
+ *  @param fd    - where.
+ *  @param pData - what.
+ *  @param bytes - how much.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750OfflineEventBuilder::write(int fd, const void* pData, std::size_t bytes)
+{
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(pData);
+    while (bytes) {
+        ssize_t n = ::write(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "Writing built events");
+        }
+        p     += n;
+        bytes -= n;
+    }
+}
+}                                     // caen_offline namespace
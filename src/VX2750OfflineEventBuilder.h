@@ -0,0 +1,126 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750OfflineEventBuilder.h
+* @brief    Build events from recorded hits with any coincidence window.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750OFFLINEEVENTBUILDER_H
+#define VX2750OFFLINEEVENTBUILDER_H
+#include "VX2750OfflineDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <map>
+
+namespace caen_offline {
+/**
+ * @class VX2750OfflineEventBuilder
+ *    Rebuilds events from the hits in event files.  Hits are collected
+ *    into one stream per source id (the body header or fragment source id
+ *    of each hit) and the streams are merged by timestamp.  As with the
+ *    NSCLDAQ event builder, an event starts with the earliest hit not yet
+ *    in an event and holds every hit within the coincidence window of it.
+ *    Event built input is taken apart and rebuilt.
+ *
+ *    Events are written as the NSCLDAQ event builder writes them so
+ *    VX2750EventBuiltEventProcessor and VX2750OfflineDecoder can read them:
+ *    a PHYSICS_EVENT whose body header has the first hit's timestamp and
+ *    the builder's source id.  The body is a uint32_t byte count and a
+ *    fragment per hit.  Each fragment's payload is a PHYSICS_EVENT holding
+ *    the hit with a body header giving its timestamp and source id.
+ *    BEGIN_RUN items are copied before the events and END_RUN items after
+ *    them.  Other items are dropped.
+ *
+ *    The merge is parallel in time: the merged hits are cut into
+ *    partitions at gaps longer than the window.  No event can span such a
+ *    gap so partitions are built independently and the output is the same
+ *    as a serial merge's.
+ *
+ *    Hits point into the event files, which must live until build is done.
+ *    Each stream should be in timestamp order.  Streams that aren't are
+ *    sorted, and the hits out of order are counted.
+ */
+class VX2750OfflineEventBuilder {
+public:
+    static const std::size_t DEFAULT_PARTITION_HITS = 1024*1024;
+
+    struct HitRef {
+        std::uint64_t       s_timestamp;
+        const std::uint8_t* s_pData;            // Hit with its word count.
+        std::uint32_t       s_bytes;
+    };
+    struct Statistics {
+        std::uint64_t s_hits;
+        std::uint64_t s_events;
+        std::uint64_t s_maxFragments;           // Largest event.
+        std::uint64_t s_unsorted;               // Hits out of order in their stream.
+        std::uint64_t s_noSource;               // Hits without a source id (dropped).
+        std::uint64_t s_partitions;
+        std::uint64_t s_bytes;                  // Written.
+
+        Statistics();
+    };
+private:
+    typedef std::vector<std::size_t> Cut;       // An index into each stream.
+
+    std::uint64_t                            m_window;
+    std::uint32_t                            m_sourceId;
+    std::map<std::uint32_t, std::vector<HitRef>> m_streams;
+    std::vector<const std::uint8_t*>         m_beginRuns;
+    std::vector<const std::uint8_t*>         m_endRuns;
+    std::uint64_t                            m_noSource;
+public:
+    VX2750OfflineEventBuilder(std::uint64_t window, std::uint32_t sourceId = 0);
+    virtual ~VX2750OfflineEventBuilder();
+private:
+    VX2750OfflineEventBuilder(const VX2750OfflineEventBuilder&);
+    VX2750OfflineEventBuilder& operator=(const VX2750OfflineEventBuilder&);
+public:
+    std::uint64_t getWindow() const { return m_window; }
+    void          setWindow(std::uint64_t window) { m_window = window; }
+    const std::map<std::uint32_t, std::vector<HitRef>>& getStreams() const {
+        return m_streams;
+    }
+
+    VX2750OfflineDecoder::Statistics addFile(
+        const VX2750EventFile& file, unsigned threads = 1
+    );
+    Statistics build(
+        int fd, unsigned threads = 1,
+        std::size_t partitionHits = DEFAULT_PARTITION_HITS
+    );
+private:
+    std::uint64_t    sortStreams(std::vector<std::vector<HitRef>*>& streams);
+    std::vector<Cut> partition(
+        const std::vector<std::vector<HitRef>*>& streams, std::size_t partitionHits
+    ) const;
+    bool             findGap(
+        const std::vector<std::vector<HitRef>*>& streams, std::uint64_t t,
+        std::uint64_t& boundary
+    ) const;
+    void             buildPartition(
+        const std::vector<std::vector<HitRef>*>& streams,
+        const std::vector<std::uint32_t>& sids, const Cut& begin, const Cut& end,
+        std::vector<std::uint8_t>& out, Statistics& stats
+    ) const;
+    void             write(int fd, const void* pData, std::size_t bytes);
+};
+}                                     // caen_offline namespace
+#endif
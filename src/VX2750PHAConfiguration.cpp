@@ -27,6 +27,11 @@
 #include <string>
 #include <stdlib.h>
 #include <map>
+#include <set>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <openssl/md5.h>
 namespace caen_nscldaq {
 // Local lookup tables:
 
@@ -48,6 +53,15 @@ static const std::map<unsigned, VX2750Pha::EnergyFilterBaselineAverage> blaverag
    {16384, VX2750Pha::Average16K}
 };
 
+// Times set in ns are rounded to the FPGA clock by the module so a readback
+// is allowed to differ by this much:
+
+static const std::int64_t NS_TOLERANCE = 8;
+
+// Serializes configuration reads by the verify threads (see verifyModule):
+
+static std::mutex verifyLock;
+
     
 /**
  *  constructor (default)
@@ -123,6 +137,34 @@ VX2750PHAModuleConfiguration::operator!=(const VX2750PHAModuleConfiguration& rhs
 {
    return !operator==(rhs);
 }
+/**
+ * computeDigest
+ *    Compute the MD5 digest of the configuration.  Two configurations
+ *    with the same parameter values have the same digest regardless of the
+ *    name of the configuration.  This allows the readout to know if a
+ *    module's configuration has actually changed and only reconfigure
+ *    modules whose configurations did.
+ * @return std::string - the MD5_DIGEST_LENGTH byte (binary) digest.
+ */
+std::string
+VX2750PHAModuleConfiguration::computeDigest()
+{
+  MD5_CTX c;
+  MD5_Init(&c);
+  
+  // cget gives us the parameters sorted by name.  The null terminators
+  // keep e.g. "ab"="c" from hashing the same as "a"="bc".
+  
+  auto config = cget();
+  for (auto& item : config) {
+    MD5_Update(&c, item.first.c_str(), item.first.size() + 1);
+    MD5_Update(&c, item.second.c_str(), item.second.size() + 1);
+  }
+  unsigned char digest[MD5_DIGEST_LENGTH];
+  MD5_Final(digest, &c);
+  
+  return std::string(reinterpret_cast<char*>(digest), MD5_DIGEST_LENGTH);
+}
 
 /**
  * configureModule
@@ -147,6 +189,50 @@ VX2750PHAModuleConfiguration::configureModule(VX2750Pha& module)
   configureEventSelection(module);
   configureFilter(module);
 }
+/**
+ * verifyModule
+ *    Read the module's settings back and compare them with the configuration.
+ *    Parameters that are only used by the readout (e.g. the readout format
+ *    and trace bandwidth policy) are not checked.  Several modules can be
+ *    verified at once from separate threads; only the reads of the
+ *    configuration itself are serialized.
+ * @param module - the module to verify.  It must be connected.
+ * @return Mismatches - the parameters whose values differ.  Empty if the
+ *         module matches the configuration.
+ * @note A section whose readback fails gets a single mismatch with the
+ *       failure reason in s_actual and the rest of the sections are still
+ *       checked.
+ */
+VX2750PHAModuleConfiguration::Mismatches
+VX2750PHAModuleConfiguration::verifyModule(VX2750Pha& module)
+{
+  typedef void (VX2750PHAModuleConfiguration::*Verifier)(VX2750Pha&, Mismatches&);
+  static const std::pair<const char*, Verifier> sections[] = {
+    {"general", &VX2750PHAModuleConfiguration::verifyGeneralOptions},
+    {"acquisition/trigger", &VX2750PHAModuleConfiguration::verifyAcquisitionTriggerOptions},
+    {"waveform inspection", &VX2750PHAModuleConfiguration::verifyWfInspectionOptions},
+    {"service", &VX2750PHAModuleConfiguration::verifyServiceOptions},
+    {"ITL", &VX2750PHAModuleConfiguration::verifyITLOptions},
+    {"LVDS", &VX2750PHAModuleConfiguration::verifyLVDSOptions},
+    {"DAC", &VX2750PHAModuleConfiguration::verifyDACOptions},
+    {"input conditioning", &VX2750PHAModuleConfiguration::verifyInputConditioning},
+    {"event selection", &VX2750PHAModuleConfiguration::verifyEventSelection},
+    {"filter", &VX2750PHAModuleConfiguration::verifyFilter}
+  };
+  Mismatches result;
+  for (auto& section : sections) {
+    try {
+      (this->*(section.second))(module, result);
+    }
+    catch (std::exception& e) {
+      result.push_back({section.first, -1, "", std::string("readback failed: ") + e.what()});
+    }
+    catch (std::string msg) {
+      result.push_back({section.first, -1, "", std::string("readback failed: ") + msg});
+    }
+  }
+  return result;
+}
 
  
 ////////////////////////////////////////////////////////////////////////////////
@@ -169,6 +255,15 @@ VX2750PHAModuleConfiguration::defineReadoutOptions()
     addBoolListParameter("readdigitalprobes", 4,4, false);
     addBooleanParameter("readsamplecount", false);
     addBooleanParameter("readeventsize", false);
+    
+    // Trace bandwidth policy - these are used by the readout, not the module:
+    
+    addIntegerParameter("tracebandwidth", 0, 0x7fffffffffffffff, 0);
+    addIntegerParameter("traceprescale", 0, 65535, 10);
+    addIntegerParameter("traceratewindow", 1, 60000, 1000);
+    addBooleanParameter("hugepagebuffers", false);
+    addBooleanParameter("verifyconfig", false);
+    addBooleanParameter("verifyabort", false);
 }
 /**
  * configureReadoutOptions
@@ -180,8 +275,8 @@ VX2750PHAModuleConfiguration::configureReadoutOptions(VX2750Pha& module)
 {
     // start from the default format:
 
-    auto aprobeEnables = getBoolList("readanalogprobes");
-    auto dprobeEnables = getBoolList("readdigitalprobes");
+    const auto& aprobeEnables = getBoolList("readanalogprobes");
+    const auto& dprobeEnables = getBoolList("readdigitalprobes");
     module.setDefaultFormat();
     module.enableRawTimestamp(getBoolParameter("readrawtimes"));
     module.enableFineTimestamp(getBoolParameter("readfinetimestamps"));
@@ -333,25 +428,25 @@ VX2750PHAModuleConfiguration::configureAcquisitionTriggerOptions(VX2750Pha& modu
 {
   int nch = module.channelCount();
   
-  auto startSources = getList("startsource");
+  const auto& startSources = getList("startsource");
   std::vector<VX2750Pha::StartSource>  startSourceVec;
   for (auto src :startSources) {
     startSourceVec.push_back(VX2750Pha::stringToStartSource.find(src)->second);
   }
   module.setStartSource(startSourceVec);
-  auto globalTriggers = getList("gbltriggersrc");
+  const auto& globalTriggers = getList("gbltriggersrc");
   std::vector<VX2750Pha::GlobalTriggerSource> srcs;
   for (auto src: globalTriggers) {
     srcs.push_back(VX2750Pha::stringToGlobalTriggerSource.find(src)->second);
   }
   module.setGlobalTriggerSource(srcs);
   
-  auto waveTriggers = getListOfLists("wavetriggersrc");
-  auto evtTriggers  = getListOfLists("eventtriggersrc");
-  auto triggerMasks = getUnsignedList("channeltriggermasks");   // since they're uint64_ts.
-  auto saveTraces   = getList("savetraces");
-  auto chanVetoSrcs = getList("chanvetosrc");
-  auto chanVetoWidths = getIntegerList("chanvetowidth");
+  const auto& waveTriggers = getListOfLists("wavetriggersrc");
+  const auto& evtTriggers  = getListOfLists("eventtriggersrc");
+  const auto& triggerMasks = getUnsignedList("channeltriggermasks");   // since they're uint64_ts.
+  const auto& saveTraces   = getList("savetraces");
+  const auto& chanVetoSrcs = getList("chanvetosrc");
+  const auto& chanVetoWidths = getIntegerList("chanvetowidth");
   
   for (int i =0; i < nch; i++) {
     if (waveTriggers.size() > i) {
@@ -450,9 +545,9 @@ VX2750PHAModuleConfiguration::defineWfInspectionOptions()
  VX2750PHAModuleConfiguration::configureWfInspectionOptions(VX2750Pha& module)
  {
     int nch = module.channelCount();            // # of channels in the module.
-    auto wfsources = getList("wavesource");
-    auto samples   = getIntegerList("recordsamples");
-    auto resolutions = getList("waveresolutions");
+    const auto& wfsources = getList("wavesource");
+    const auto& samples   = getIntegerList("recordsamples");
+    const auto& resolutions = getList("waveresolutions");
     std::vector<std::string> analogProbes[2];
     analogProbes[0] = getList("analogprobe1");
     analogProbes[1] = getList("analogprobe2");
@@ -461,7 +556,7 @@ VX2750PHAModuleConfiguration::defineWfInspectionOptions()
     digitalProbes[1] = getList("digitalprobe2");
     digitalProbes[2] = getList("digitalprobe3");
     digitalProbes[3] = getList("digitalprobe4");
-    auto pretrigger = getIntegerList("pretriggersamples");
+    const auto& pretrigger = getIntegerList("pretriggersamples");
     
     // Now loop over the channels setting the parameters:
     
@@ -625,9 +720,9 @@ VX2750PHAModuleConfiguration::defineLVDSOptions()
 void
 VX2750PHAModuleConfiguration::configureLVDSOptions(VX2750Pha& module)
 {
-  auto modes = getList("lvdsmode");
-  auto direction = getList("lvdsdirection");
-  auto masks   = getUnsignedList("lvdstrgmask");
+  const auto& modes = getList("lvdsmode");
+  const auto& direction = getList("lvdsdirection");
+  const auto& masks   = getUnsignedList("lvdstrgmask");
   
   // First set the direction and mode of each quartet.
   
@@ -704,7 +799,7 @@ VX2750PHAModuleConfiguration::configureInputConditioning(VX2750Pha& module)
   // Sinc eonly 2745 digitizers have a variable gain amp:
   
   if (module.getFamilyCode() == 2745) {
-    auto vgaGains = getIntegerList("vgagain");
+    const auto& vgaGains = getIntegerList("vgagain");
     for (int i =0; i < 4; i++) {
          module.setVGAGain(i, vgaGains[i]); 
     }
@@ -712,10 +807,10 @@ VX2750PHAModuleConfiguration::configureInputConditioning(VX2750Pha& module)
   // The remainder are all per channel parameters:
   
   auto enableOffsetCalibration = getBoolParameter("offsetcalibrationenable");
-  auto channelEnables  = getBoolList("channelenables");
-  auto dcOffsets  = getFloatList("dcoffsets");
-  auto thresholds = getIntegerList("triggerthresholds");
-  auto inputPolarities = getList("inputpolarities");
+  const auto& channelEnables  = getBoolList("channelenables");
+  const auto& dcOffsets  = getFloatList("dcoffsets");
+  const auto& thresholds = getIntegerList("triggerthresholds");
+  const auto& inputPolarities = getList("inputpolarities");
   
   module.enableOffsetCalibration(enableOffsetCalibration);
   
@@ -768,13 +863,13 @@ VX2750PHAModuleConfiguration::defineEventSelectionOptions()
 void
 VX2750PHAModuleConfiguration::configureEventSelection(VX2750Pha& module)
 {
-  auto lowskims = getIntegerList("energyskimlow");
-  auto hiskims  = getIntegerList("energyskimhigh");
-  auto eventselectors = getList("eventselector");
-  auto waveselectors = getList("waveselector");
-  auto coincMasks = getList("coincidencemask");
-  auto anticoincMasks = getList("anticoincidencemask");
-  auto coincidencewindow = getIntegerList("coincidencelength");
+  const auto& lowskims = getIntegerList("energyskimlow");
+  const auto& hiskims  = getIntegerList("energyskimhigh");
+  const auto& eventselectors = getList("eventselector");
+  const auto& waveselectors = getList("waveselector");
+  const auto& coincMasks = getList("coincidencemask");
+  const auto& anticoincMasks = getList("anticoincidencemask");
+  const auto& coincidencewindow = getIntegerList("coincidencelength");
   
   int nch = module.channelCount();
   for(int i =0; i < nch; i++) {
@@ -833,18 +928,18 @@ VX2750PHAModuleConfiguration::defineFilterOptions()
 void
 VX2750PHAModuleConfiguration::configureFilter(VX2750Pha& module)
 {
-    auto triggerRiseTimes = getIntegerList("tfrisetime");
-    auto triggerRetriggerGuards = getIntegerList("tfretriggerguard");
-    auto energyRiseTimes = getIntegerList("efrisetime");
-    auto energyFlatTopTimes = getIntegerList("efflattoptime");
-    auto energyPeakingPos = getIntegerList("efpeakingpos");
-    auto peakingAverages  = getIntegerList("efpeakingavg");  // The enums all translate as integers.
-    auto poleZeros       = getIntegerList("efpolezero");
-    auto fineGains      =getFloatList("effinegain");
-    auto lfEliminations = getBoolList("eflflimitation");
-    auto blAveraging    = getIntegerList("efbaselineavg"); // again they're all integers
-    auto blGuardTimes   = getIntegerList("efbaselineguardt");
-    auto pupGuardTimes  = getIntegerList("efpileupguardt");
+    const auto& triggerRiseTimes = getIntegerList("tfrisetime");
+    const auto& triggerRetriggerGuards = getIntegerList("tfretriggerguard");
+    const auto& energyRiseTimes = getIntegerList("efrisetime");
+    const auto& energyFlatTopTimes = getIntegerList("efflattoptime");
+    const auto& energyPeakingPos = getIntegerList("efpeakingpos");
+    const auto& peakingAverages  = getIntegerList("efpeakingavg");  // The enums all translate as integers.
+    const auto& poleZeros       = getIntegerList("efpolezero");
+    const auto& fineGains      = getFloatList("effinegain");
+    const auto& lfEliminations = getBoolList("eflflimitation");
+    const auto& blAveraging    = getIntegerList("efbaselineavg"); // again they're all integers
+    const auto& blGuardTimes   = getIntegerList("efbaselineguardt");
+    const auto& pupGuardTimes  = getIntegerList("efpileupguardt");
     
     int nch = module.channelCount();
     for (int i = 0; i < nch; i++) {
@@ -875,6 +970,577 @@ VX2750PHAModuleConfiguration::configureFilter(VX2750Pha& module)
     }
 }
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Verification - reading the configuration back from the module.
+// Each verifyXXX method copies what it needs from the configuration while
+// holding verifyLock (configurations may share parsed values with copies
+// being verified in other threads) and then reads the module.
+
+/**
+ * addMismatch
+ *    Record a mismatch if the expected and actual strings differ.
+ */
+static void
+addMismatch(
+  VX2750PHAModuleConfiguration::Mismatches& result, const char* param, int index,
+  const std::string& expected, const std::string& actual
+)
+{
+  if (expected != actual) {
+    result.push_back({param, index, expected, actual});
+  }
+}
+/**
+ * checkInteger
+ *    Compare an integer setting.
+ * @param tolerance - how far the readback may be from the expected value.
+ */
+static void
+checkInteger(
+  VX2750PHAModuleConfiguration::Mismatches& result, const char* param, int index,
+  std::int64_t expected, std::int64_t actual, std::int64_t tolerance = 0
+)
+{
+  std::int64_t diff = expected - actual;
+  if ((diff > tolerance) || (diff < -tolerance)) {
+    result.push_back({param, index, std::to_string(expected), std::to_string(actual)});
+  }
+}
+/**
+ * checkUnsigned
+ *    Compare an unsigned (mask) setting.
+ */
+static void
+checkUnsigned(
+  VX2750PHAModuleConfiguration::Mismatches& result, const char* param, int index,
+  std::uint64_t expected, std::uint64_t actual
+)
+{
+  if (expected != actual) {
+    result.push_back({param, index, std::to_string(expected), std::to_string(actual)});
+  }
+}
+/**
+ * checkFloat
+ *    Compare a floating point setting.
+ * @param tolerance - absolute difference allowed (the module quantizes these).
+ */
+static void
+checkFloat(
+  VX2750PHAModuleConfiguration::Mismatches& result, const char* param, int index,
+  double expected, double actual, double tolerance
+)
+{
+  if (std::fabs(expected - actual) > tolerance) {
+    result.push_back({param, index, std::to_string(expected), std::to_string(actual)});
+  }
+}
+/**
+ * checkBool
+ */
+static void
+checkBool(
+  VX2750PHAModuleConfiguration::Mismatches& result, const char* param, int index,
+  bool expected, bool actual
+)
+{
+  addMismatch(result, param, index, expected ? "true" : "false", actual ? "true": "false");
+}
+/**
+ * checkEnum
+ *    Compare an enumerated setting.  The expected value is the configuration
+ *    string which is looked up in the module's conversion table.
+ */
+template<class T>
+static void
+checkEnum(
+  VX2750PHAModuleConfiguration::Mismatches& result, const char* param, int index,
+  const VX2750EnumTable<T>& table, const std::string& expected, T actual
+)
+{
+  auto p = table.find(expected);
+  if (!p || (p->second != actual)) {
+    auto pName = table.name(actual);
+    result.push_back(
+      {param, index, expected, pName ? *pName : std::to_string(actual)}
+    );
+  }
+}
+/**
+ * checkEnumSet
+ *    Compare a multi-valued enumerated setting.  The module need not
+ *    return the values in the order they were set.
+ */
+template<class T>
+static void
+checkEnumSet(
+  VX2750PHAModuleConfiguration::Mismatches& result, const char* param, int index,
+  const VX2750EnumTable<T>& table, const std::vector<std::string>& expected,
+  const std::vector<T>& actual
+)
+{
+  std::set<int> want;
+  std::string wantString;
+  for (auto& s : expected) {
+    auto p = table.find(s);
+    want.insert(p ? static_cast<int>(p->second) : -1);
+    if (!wantString.empty()) wantString += " ";
+    wantString += s;
+  }
+  std::set<int> got;
+  std::string gotString;
+  for (auto v : actual) {
+    got.insert(static_cast<int>(v));
+    auto pName = table.name(v);
+    if (!gotString.empty()) gotString += " ";
+    gotString += pName ? *pName : std::to_string(v);
+  }
+  if (want != got) {
+    result.push_back({param, index, wantString, gotString});
+  }
+}
+
+/**
+ * verifyGeneralOptions
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyGeneralOptions(VX2750Pha& module, Mismatches& result)
+{
+  std::string clockSource;
+  bool fpClock;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    clockSource = cget("clocksource");
+    fpClock     = getBoolParameter("outputfpclock");
+  }
+  checkEnum(result, "clocksource", -1, VX2750Pha::stringToClockSource, clockSource, module.getClockSource());
+  checkBool(result, "outputfpclock", -1, fpClock, module.isClockOutOnFP());
+}
+/**
+ * verifyAcquisitionTriggerOptions
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyAcquisitionTriggerOptions(VX2750Pha& module, Mismatches& result)
+{
+  std::vector<std::string> startSources, globalTriggers, saveTraces, chanVetoSrcs;
+  std::vector<std::vector<std::string>> waveTriggers, evtTriggers;
+  std::vector<std::uint64_t> triggerMasks;
+  std::vector<std::int64_t>  chanVetoWidths;
+  std::string trgoutMode, gpioMode, busyIn, syncOut, vetoSrc, vetoPolarity;
+  std::int64_t vetoWidth, runDelay;
+  bool autoDisarm;
+  double permDelay, volDelay;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    startSources   = getList("startsource");
+    globalTriggers = getList("gbltriggersrc");
+    waveTriggers   = getListOfLists("wavetriggersrc");
+    evtTriggers    = getListOfLists("eventtriggersrc");
+    triggerMasks   = getUnsignedList("channeltriggermasks");
+    saveTraces     = getList("savetraces");
+    chanVetoSrcs   = getList("chanvetosrc");
+    chanVetoWidths = getIntegerList("chanvetowidth");
+    trgoutMode     = cget("triggeroutmode");
+    gpioMode       = cget("gpiomode");
+    busyIn         = cget("busyinsrc");
+    syncOut        = cget("syncoutmode");
+    vetoSrc        = cget("boardvetosrc");
+    vetoWidth      = getIntegerParameter("boardvetowidth");
+    vetoPolarity   = cget("boardvetopolarity");
+    runDelay       = getIntegerParameter("rundelay");
+    autoDisarm     = getBoolParameter("autodisarm");
+    permDelay      = getFloatParameter("permclkoutdelay");
+    volDelay       = getFloatParameter("volclkoutdelay");
+  }
+  checkEnumSet(result, "startsource", -1, VX2750Pha::stringToStartSource, startSources, module.getStartSource());
+  checkEnumSet(
+    result, "gbltriggersrc", -1, VX2750Pha::stringToGlobalTriggerSource,
+    globalTriggers, module.getGlobalTriggerSource()
+  );
+  int nch = module.channelCount();
+  for (int i = 0; i < nch; i++) {
+    if (waveTriggers.size() > i)
+      checkEnumSet(
+        result, "wavetriggersrc", i, VX2750Pha::stringToWaveTrigger,
+        waveTriggers[i], module.getWaveTriggerSource(i)
+      );
+    if (evtTriggers.size() > i)
+      checkEnumSet(
+        result, "eventtriggersrc", i, VX2750Pha::stringToEventTrigger,
+        evtTriggers[i], module.getEventTriggerSource(i)
+      );
+    if (triggerMasks.size() > i)
+      checkUnsigned(result, "channeltriggermasks", i, triggerMasks[i], module.getChannelTriggerMask(i));
+    if (saveTraces.size() > i)
+      addMismatch(
+        result, "savetraces", i, saveTraces[i],
+        module.getTraceRecordMode(i) == VX2750Pha::Always ? "Always" : "OnRequest"
+      );
+    if (chanVetoSrcs.size() > i)
+      checkEnum(
+        result, "chanvetosrc", i, VX2750Pha::stringToChannelVeto,
+        chanVetoSrcs[i], module.getChannelVetoSource(i)
+      );
+    if (chanVetoWidths.size() > i)
+      checkInteger(result, "chanvetowidth", i, chanVetoWidths[i], module.getChannelVetoWidth(i), NS_TOLERANCE);
+  }
+  checkEnum(result, "triggeroutmode", -1, VX2750Pha::stringToTRGOUT, trgoutMode, module.getTRGOUTMode());
+  checkEnum(result, "gpiomode", -1, VX2750Pha::stringToGPIO, gpioMode, module.getGPIOMode());
+  checkEnum(result, "busyinsrc", -1, VX2750Pha::stringToBusyIn, busyIn, module.getBusyInputSource());
+  checkEnum(result, "syncoutmode", -1, VX2750Pha::stringToSyncOut, syncOut, module.getSyncOutMode());
+  checkEnum(result, "boardvetosrc", -1, VX2750Pha::stringToVeto, vetoSrc, module.getBoardVetoSource());
+  checkInteger(result, "boardvetowidth", -1, vetoWidth, module.getBoardVetoWidth(), NS_TOLERANCE);
+  checkEnum(
+    result, "boardvetopolarity", -1, VX2750Pha::stringToVetoPolarity,
+    vetoPolarity, module.getBoardVetoPolarity()
+  );
+  checkInteger(result, "rundelay", -1, runDelay, module.getRunDelay(), NS_TOLERANCE);
+  checkBool(result, "autodisarm", -1, autoDisarm, module.isAutoDisarmEnabled());
+  checkFloat(result, "permclkoutdelay", -1, permDelay, module.getPermanentClockDelay(), 1.0);
+  checkFloat(result, "volclkoutdelay", -1, volDelay, module.getVolatileClockDelay(), 1.0);
+}
+/**
+ * verifyWfInspectionOptions
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyWfInspectionOptions(VX2750Pha& module, Mismatches& result)
+{
+  static const char* analogNames[2] = {"analogprobe1", "analogprobe2"};
+  static const char* digitalNames[4] = {
+    "digitalprobe1", "digitalprobe2", "digitalprobe3", "digitalprobe4"
+  };
+  std::vector<std::string> wfsources, resolutions;
+  std::vector<std::int64_t> samples, pretrigger;
+  std::vector<std::string> analogProbes[2];
+  std::vector<std::string> digitalProbes[4];
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    wfsources   = getList("wavesource");
+    samples     = getIntegerList("recordsamples");
+    resolutions = getList("waveresolutions");
+    for (int p = 0; p < 2; p++) analogProbes[p] = getList(analogNames[p]);
+    for (int p = 0; p < 4; p++) digitalProbes[p] = getList(digitalNames[p]);
+    pretrigger  = getIntegerList("pretriggersamples");
+  }
+  int nch = module.channelCount();
+  for (int i = 0; i < nch; i++) {
+    if (wfsources.size() > i)
+      checkEnum(
+        result, "wavesource", i, VX2750Pha::stringToWaveDataSource,
+        wfsources[i], module.getWaveDataSource(i)
+      );
+    if (samples.size() > i)
+      checkInteger(result, "recordsamples", i, samples[i], module.getRecordSamples(i));
+    if (resolutions.size() > i)
+      checkEnum(
+        result, "waveresolutions", i, VX2750Pha::stringToWaveResolution,
+        resolutions[i], module.getWaveResolution(i)
+      );
+    for (int p = 0; p < 2; p++) {
+      if (analogProbes[p].size() > i)
+        checkEnum(
+          result, analogNames[p], i, VX2750Pha::stringToAnalogProbe,
+          analogProbes[p][i], module.getAnalogProbe(i, p)
+        );
+    }
+    for (int p = 0; p < 4; p++) {
+      if (digitalProbes[p].size() > i)
+        checkEnum(
+          result, digitalNames[p], i, VX2750Pha::stringToDigitalProbe,
+          digitalProbes[p][i], module.getDigitalProbe(i, p)
+        );
+    }
+    if (pretrigger.size() > i)
+      checkInteger(result, "pretriggersamples", i, pretrigger[i], module.getPreTriggerSamples(i));
+  }
+}
+/**
+ * verifyServiceOptions
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyServiceOptions(VX2750Pha& module, Mismatches& result)
+{
+  std::int64_t period, width, low, high, errorMask, errorDataMask;
+  std::string ioLevel;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    period        = getIntegerParameter("testpulseperiod");
+    width         = getIntegerParameter("testpulsewidth");
+    low           = getIntegerParameter("testpulselowlevel");
+    high          = getIntegerParameter("testpulsehighlevel");
+    ioLevel       = cget("iolevel");
+    errorMask     = getIntegerParameter("errorflagmask");
+    errorDataMask = getIntegerParameter("errorflagdatamask");
+  }
+  checkInteger(result, "testpulseperiod", -1, period, module.getTestPulsePeriod(), NS_TOLERANCE);
+  checkInteger(result, "testpulsewidth", -1, width, module.getTestPulseWidth(), NS_TOLERANCE);
+  checkInteger(result, "testpulselowlevel", -1, low, module.getTestPulseLowLevel());
+  checkInteger(result, "testpulsehighlevel", -1, high, module.getTestPulseHighLevel());
+  addMismatch(
+    result, "iolevel", -1, ioLevel,
+    module.getIOLevel() == VX2750Pha::NIM ? "NIM" : "TTL"
+  );
+  checkInteger(result, "errorflagmask", -1, errorMask, module.getErrorFlagMask());
+  checkInteger(result, "errorflagdatamask", -1, errorDataMask, module.getErrorFlagDataMask());
+}
+/**
+ * verifyITLOptions
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyITLOptions(VX2750Pha& module, Mismatches& result)
+{
+  std::string aLogic, bLogic, aPair, bPair, aPolarity, bPolarity;
+  std::int64_t aMajority, bMajority;
+  std::uint64_t aMask, bMask, aGate, bGate;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    aLogic    = cget("itlalogic");
+    bLogic    = cget("itlblogic");
+    aMajority = getIntegerParameter("itlamajoritylevel");
+    bMajority = getIntegerParameter("itlbmajoritylevel");
+    aPair     = cget("itlapairlogic");
+    bPair     = cget("itlbpairlogic");
+    aPolarity = cget("itlapolarity");
+    bPolarity = cget("itlbpolarity");
+    aMask     = getUnsignedParameter("itlamask");
+    bMask     = getUnsignedParameter("itlbmask");
+    aGate     = getUnsignedParameter("itlagatewidth");
+    bGate     = getUnsignedParameter("itlbgatewidth");
+  }
+  checkEnum(result, "itlalogic", -1, VX2750Pha::stringToIndividualTriggerLogic, aLogic, module.getITLAMainLogic());
+  checkEnum(result, "itlblogic", -1, VX2750Pha::stringToIndividualTriggerLogic, bLogic, module.getITLBMainLogic());
+  checkInteger(result, "itlamajoritylevel", -1, aMajority, module.getITLAMajorityLevel());
+  checkInteger(result, "itlbmajoritylevel", -1, bMajority, module.getITLBMajorityLevel());
+  checkEnum(result, "itlapairlogic", -1, VX2750Pha::stringToPairLogic, aPair, module.getITLAPairLogic());
+  checkEnum(result, "itlbpairlogic", -1, VX2750Pha::stringToPairLogic, bPair, module.getITLBPairLogic());
+  addMismatch(result, "itlapolarity", -1, aPolarity, module.isITLAInverted() ? "Inverted" : "Direct");
+  addMismatch(result, "itlbpolarity", -1, bPolarity, module.isITLBInverted() ? "Inverted" : "Direct");
+  checkUnsigned(result, "itlamask", -1, aMask, module.getITLAMask());
+  checkUnsigned(result, "itlbmask", -1, bMask, module.getITLBMask());
+  checkInteger(result, "itlagatewidth", -1, aGate, module.getITLAGateWidth(), NS_TOLERANCE);
+  checkInteger(result, "itlbgatewidth", -1, bGate, module.getITLBGateWidth(), NS_TOLERANCE);
+}
+/**
+ * verifyLVDSOptions
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyLVDSOptions(VX2750Pha& module, Mismatches& result)
+{
+  std::vector<std::string> modes, directions;
+  std::vector<std::uint64_t> masks;
+  std::uint64_t ioReg;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    modes      = getList("lvdsmode");
+    directions = getList("lvdsdirection");
+    masks      = getUnsignedList("lvdstrgmask");
+    ioReg      = getUnsignedParameter("lvdsoutput");
+  }
+  for (int i = 0; i < modes.size(); i++) {
+    checkEnum(result, "lvdsmode", i, VX2750Pha::stringToLVDSMode, modes[i], module.getLVDSMode(i));
+    addMismatch(
+      result, "lvdsdirection", i, directions[i],
+      module.getLVDSDirection(i) == VX2750Pha::Input ? "Input" : "Output"
+    );
+  }
+  for (int i = 0; i < masks.size(); i++) {
+    checkUnsigned(result, "lvdstrgmask", i, masks[i], module.getLVDSTriggerMask(i));
+  }
+  checkUnsigned(result, "lvdsoutput", -1, ioReg, module.getLVDSIOReg());
+}
+/**
+ * verifyDACOptions
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyDACOptions(VX2750Pha& module, Mismatches& result)
+{
+  std::string mode;
+  std::int64_t level, channel;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    mode    = cget("dacoutmode");
+    level   = getIntegerParameter("dacoutputlevel");
+    channel = getIntegerParameter("dacoutchannel");
+  }
+  checkEnum(result, "dacoutmode", -1, VX2750Pha::stringToDACOutMode, mode, module.getDACOutMode());
+  checkInteger(result, "dacoutputlevel", -1, level, module.getDACOutValue());
+  checkInteger(result, "dacoutchannel", -1, channel, module.getDACChannel());
+}
+/**
+ * verifyInputConditioning
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyInputConditioning(VX2750Pha& module, Mismatches& result)
+{
+  std::vector<std::int64_t> vgaGains, thresholds;
+  bool offsetCalibration;
+  std::vector<bool> channelEnables;
+  std::vector<double> dcOffsets;
+  std::vector<std::string> polarities;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    vgaGains          = getIntegerList("vgagain");
+    offsetCalibration = getBoolParameter("offsetcalibrationenable");
+    channelEnables    = getBoolList("channelenables");
+    dcOffsets         = getFloatList("dcoffsets");
+    thresholds        = getIntegerList("triggerthresholds");
+    polarities        = getList("inputpolarities");
+  }
+  if (module.getFamilyCode() == 2745) {
+    for (int i = 0; i < 4; i++) {
+      checkFloat(result, "vgagain", i, vgaGains[i], module.getVGAGain(i), 0.5);
+    }
+  }
+  checkBool(result, "offsetcalibrationenable", -1, offsetCalibration, module.isOffsetCalibrationEnabled());
+  int nch = module.channelCount();
+  for (int i = 0; i < nch; i++) {
+    if (polarities.size() > i)
+      addMismatch(
+        result, "inputpolarities", i, polarities[i],
+        module.getPulsePolarity(i) == VX2750Pha::Positive ? "Positive" : "Negative"
+      );
+    if (channelEnables.size() > i)
+      checkBool(result, "channelenables", i, channelEnables[i], module.isChannelEnabled(i));
+    if (dcOffsets.size() > i)
+      checkFloat(result, "dcoffsets", i, dcOffsets[i], module.getDCOffset(i), 0.01);
+    if (thresholds.size() > i)
+      checkInteger(result, "triggerthresholds", i, thresholds[i], module.getTriggerThreshold(i));
+  }
+}
+/**
+ * verifyEventSelection
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyEventSelection(VX2750Pha& module, Mismatches& result)
+{
+  std::vector<std::int64_t> lowSkims, highSkims, windows;
+  std::vector<std::string> eventSelectors, waveSelectors, coincMasks, anticoincMasks;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    lowSkims       = getIntegerList("energyskimlow");
+    highSkims      = getIntegerList("energyskimhigh");
+    eventSelectors = getList("eventselector");
+    waveSelectors  = getList("waveselector");
+    coincMasks     = getList("coincidencemask");
+    anticoincMasks = getList("anticoincidencemask");
+    windows        = getIntegerList("coincidencelength");
+  }
+  int nch = module.channelCount();
+  for (int i = 0; i < nch; i++) {
+    if (lowSkims.size() > i)
+      checkInteger(result, "energyskimlow", i, lowSkims[i], module.getEnergySkimLowDiscriminator(i));
+    if (highSkims.size() > i)
+      checkInteger(result, "energyskimhigh", i, highSkims[i], module.getEnergySkimHighDiscriminator(i));
+    if (eventSelectors.size() > i)
+      checkEnum(
+        result, "eventselector", i, VX2750Pha::stringToEventSelection,
+        eventSelectors[i], module.getEventSelector(i)
+      );
+    if (waveSelectors.size() > i)
+      checkEnum(
+        result, "waveselector", i, VX2750Pha::stringToEventSelection,
+        waveSelectors[i], module.getWaveformSelector(i)
+      );
+    if (windows.size() > i)
+      checkInteger(result, "coincidencelength", i, windows[i], module.getCoincidenceNs(i), NS_TOLERANCE);
+    if (coincMasks.size() > i)
+      checkEnum(
+        result, "coincidencemask", i, VX2750Pha::stringToCoincidenceMask,
+        coincMasks[i], module.getCoincidenceMask(i)
+      );
+    if (anticoincMasks.size() > i)
+      checkEnum(
+        result, "anticoincidencemask", i, VX2750Pha::stringToCoincidenceMask,
+        anticoincMasks[i], module.getAntiCoincidenceMask(i)
+      );
+  }
+}
+/**
+ * verifyFilter
+ * @param module - module being verified.
+ * @param result - mismatches are appended here.
+ */
+void
+VX2750PHAModuleConfiguration::verifyFilter(VX2750Pha& module, Mismatches& result)
+{
+  std::vector<std::int64_t> tfRise, tfGuard, efRise, efFlatTop, efPeakPos, peakAvgs;
+  std::vector<std::int64_t> poleZeros, blAverages, blGuards, pupGuards;
+  std::vector<double> fineGains;
+  std::vector<bool>   lfLimitations;
+  {
+    std::lock_guard<std::mutex> lock(verifyLock);
+    tfRise        = getIntegerList("tfrisetime");
+    tfGuard       = getIntegerList("tfretriggerguard");
+    efRise        = getIntegerList("efrisetime");
+    efFlatTop     = getIntegerList("efflattoptime");
+    efPeakPos     = getIntegerList("efpeakingpos");
+    peakAvgs      = getIntegerList("efpeakingavg");
+    poleZeros     = getIntegerList("efpolezero");
+    fineGains     = getFloatList("effinegain");
+    lfLimitations = getBoolList("eflflimitation");
+    blAverages    = getIntegerList("efbaselineavg");
+    blGuards      = getIntegerList("efbaselineguardt");
+    pupGuards     = getIntegerList("efpileupguardt");
+  }
+  int nch = module.channelCount();
+  for (int i = 0; i < nch; i++) {
+    if (tfRise.size() > i)
+      checkInteger(result, "tfrisetime", i, tfRise[i], module.getTimeFilterRiseSamples(i));
+    if (tfGuard.size() > i)
+      checkInteger(result, "tfretriggerguard", i, tfGuard[i], module.getTimeFilterRetriggerGuardSamples(i));
+    if (efRise.size() > i)
+      checkInteger(result, "efrisetime", i, efRise[i], module.getEnergyFilterRiseSamples(i));
+    if (efFlatTop.size() > i)
+      checkInteger(result, "efflattoptime", i, efFlatTop[i], module.getEnergyFilterFlatTopSamples(i));
+    if (efPeakPos.size() > i)
+      checkInteger(result, "efpeakingpos", i, efPeakPos[i], module.getEnergyFilterPeakingPosition(i));
+    if (peakAvgs.size() > i) {
+      auto actual = module.getEnergyFilterPeakingAverage(i);
+      std::string actualString = std::to_string(actual);
+      for (auto& e : peakingAvgs) {
+        if (e.second == actual) actualString = std::to_string(e.first);
+      }
+      addMismatch(result, "efpeakingavg", i, std::to_string(peakAvgs[i]), actualString);
+    }
+    if (poleZeros.size() > i)
+      checkInteger(result, "efpolezero", i, poleZeros[i], module.getEnergyFilterPoleZeroSamples(i));
+    if (fineGains.size() > i)
+      checkFloat(result, "effinegain", i, fineGains[i], module.getEnergyFilterFineGain(i), 0.001);
+    if (lfLimitations.size() > i)
+      checkBool(result, "eflflimitation", i, lfLimitations[i], module.isEnergyFilterFLimitationEnabled(i));
+    if (blAverages.size() > i) {
+      auto actual = module.getEnergyFilterBaselineAverage(i);
+      std::string actualString = std::to_string(actual);
+      for (auto& e : blaverage) {
+        if (e.second == actual) actualString = std::to_string(e.first);
+      }
+      addMismatch(result, "efbaselineavg", i, std::to_string(blAverages[i]), actualString);
+    }
+    if (blGuards.size() > i)
+      checkInteger(result, "efbaselineguardt", i, blGuards[i], module.getEnergyFilterBaselineGuardTime(i), NS_TOLERANCE);
+    if (pupGuards.size() > i)
+      checkInteger(result, "efpileupguardt", i, pupGuards[i], module.getEnergyFilterPileupGuardTime(i), NS_TOLERANCE);
+  }
+}
 }                                   // caen_nscldaq namespace.
 
 
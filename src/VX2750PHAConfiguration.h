@@ -27,6 +27,8 @@
 
 
 #include "XXUSBConfigurableObject.h"      // nice base class from NSCLDAQ.
+#include <string>
+#include <vector>
 
 
 namespace caen_nscldaq {
@@ -49,6 +51,17 @@ class VX2750Pha;
  *     -  readdigitalprobes   - list of four bools {probe1 probe2 probe3 probe4}
  *     -  readsamplecount     - bool -enable read of number of samples in fragment.
  *     -  readeventsize        - bool enable read of event size.
+ *     -  tracebandwidth      - integer bytes/sec of trace data allowed before
+ *                              traces are prescaled (0 - the default, no limit).
+ *     -  traceprescale       - integer when over budget keep traces for 1 in this
+ *                              many hits from the busiest channels (0 drops them).
+ *     -  traceratewindow     - integer ms of hit time over which rates are measured.
+ *     -  hugepagebuffers     - bool put the readout's trace buffers on
+ *                              transparent huge pages.
+ *     -  verifyconfig        - bool after the module is configured, read the
+ *                              configuration back and report differences.
+ *     -  verifyabort         - bool a difference (or failure to read back) found
+ *                              by verifyconfig fails the begin run.
  *  ### General Parameters:
  *     -  clocksource - enumerated "Internal", "FPClkIn", "P0ClkIn", "Link", "DIPswitchSel"
  *     -  outputp0clock - bool  Output clock on backplane.
@@ -190,6 +203,23 @@ public:
     int operator!=(const VX2750PHAModuleConfiguration& rhs);
     
     void configureModule(VX2750Pha& module);
+    std::string computeDigest();
+    
+    // Reading the configuration back from a module:
+    
+    /**
+     * A parameter whose value in the module differs from the configuration.
+     * If the module could not be read, s_actual describes the failure.
+     */
+    struct Mismatch {
+        std::string s_parameter;       // Configuration parameter name.
+        int         s_index;           // Channel/list index, -1 for scalars.
+        std::string s_expected;        // Value from the configuration.
+        std::string s_actual;          // Value read from the module.
+    };
+    typedef std::vector<Mismatch> Mismatches;
+    
+    Mismatches verifyModule(VX2750Pha& module);
     
     // Everything else public is done by the base class.
 private:
@@ -215,6 +245,17 @@ private:
     void configureEventSelection(VX2750Pha& module);
     void defineFilterOptions();
     void configureFilter(VX2750Pha& module);
+    
+    void verifyGeneralOptions(VX2750Pha& module, Mismatches& result);
+    void verifyAcquisitionTriggerOptions(VX2750Pha& module, Mismatches& result);
+    void verifyWfInspectionOptions(VX2750Pha& module, Mismatches& result);
+    void verifyServiceOptions(VX2750Pha& module, Mismatches& result);
+    void verifyITLOptions(VX2750Pha& module, Mismatches& result);
+    void verifyLVDSOptions(VX2750Pha& module, Mismatches& result);
+    void verifyDACOptions(VX2750Pha& module, Mismatches& result);
+    void verifyInputConditioning(VX2750Pha& module, Mismatches& result);
+    void verifyEventSelection(VX2750Pha& module, Mismatches& result);
+    void verifyFilter(VX2750Pha& module, Mismatches& result);
 };
     
 }                                             // caen_nscldaq namespace
@@ -22,6 +22,7 @@
 * @todo     ITLConnect can support multiple connections.
 */
 #include "VX2750Pha.h"
+#include "VX2750DecodedEventPool.h"
 #include <stdexcept>
 #include <sstream>
 #include <stdlib.h>
@@ -35,10 +36,11 @@ namespace caen_nscldaq {
 static const std::uint64_t FPGA_NS_PER_CLOCK = 8;
 static const unsigned DPP_MAX_PARAMS=30;    // sizes argv for DPP-PHA endpoint.
 
-// Enumerator mappings.  Readonly have string->enum maps.  R/W have
-// both a string to enum and enum to string map.  
+// Enumerator mappings.  Each table converts in both directions (see
+// VX2750EnumTable.h).  The first name listed for a value is the one
+// written to the digitizer.
 
-static const std::map<std::string, VX2750Pha::FwType> stringToFwType = {
+static const VX2750EnumTable<VX2750Pha::FwType> stringToFwType = {
     { "DPP_PHA", VX2750Pha::DPP_PHA},
     { "DPP_ZLE", VX2750Pha::DPP_ZLE},
     { "DPP_PSD", VX2750Pha::DPP_PSD},
@@ -47,28 +49,21 @@ static const std::map<std::string, VX2750Pha::FwType> stringToFwType = {
     {"Scope", VX2750Pha::Scope}
 };
 
-static const std::map<std::string, VX2750Pha::FormFactor> stringToFormFactor = {
+static const VX2750EnumTable<VX2750Pha::FormFactor> stringToFormFactor = {
     {"0", VX2750Pha::VME},
     {"1", VX2750Pha::VME64X},
     {"2", VX2750Pha::DT}
 };
 
-const std::map<std::string, VX2750Pha::ClockSource> VX2750Pha::stringToClockSource = {
+const VX2750EnumTable<VX2750Pha::ClockSource> VX2750Pha::stringToClockSource = {
     {"Internal", VX2750Pha::Internal},
     {"FPClkIn", VX2750Pha::FrontPanel},
     {"P0ClkIn",   VX2750Pha::Clock_P0},
     {"Link",   VX2750Pha::Link},
     {"DIPswitchSel", VX2750Pha::DIPSelected}
 };
-static const std::map<VX2750Pha::ClockSource, std::string> clockSourceToString = {
-    {VX2750Pha::Internal, "Internal"},
-    {VX2750Pha::FrontPanel, "FPClkIn"},
-    {VX2750Pha::Clock_P0, "P0ClkIn"},
-    {VX2750Pha::Link, "Link"},
-    {VX2750Pha::DIPSelected, "DIPswitchSel"}
-};
 
-const std::map<std::string, VX2750Pha::StartSource> VX2750Pha::stringToStartSource = {
+const VX2750EnumTable<VX2750Pha::StartSource> VX2750Pha::stringToStartSource = {
     {"EncodedClkIn", VX2750Pha::Start_EncodedClockIn},
     {"SINlevel", VX2750Pha::SINLevel},
     {"SINedge", VX2750Pha::SINEdge},
@@ -77,16 +72,8 @@ const std::map<std::string, VX2750Pha::StartSource> VX2750Pha::stringToStartSour
     {"P0",   VX2750Pha::Start_P0}
 };
 
-static const std::map<VX2750Pha::StartSource, std::string> startSourceToString = {
-    {VX2750Pha::Start_EncodedClockIn, "EncodedClkIn"},
-    {VX2750Pha::SINLevel, "SINlevel"},
-    {VX2750Pha::SINEdge, "SINedge"},
-    {VX2750Pha::SWCommand, "SWcmd"},
-    {VX2750Pha::Start_LVDS, "LVDS"},
-    {VX2750Pha::Start_P0, "P0"}
-};
 
-const std::map<std::string, VX2750Pha::GlobalTriggerSource> VX2750Pha::stringToGlobalTriggerSource = {
+const VX2750EnumTable<VX2750Pha::GlobalTriggerSource> VX2750Pha::stringToGlobalTriggerSource = {
     {"TrgIn", VX2750Pha::GlobalTrigger_TriggerIn},
     {"P0", VX2750Pha::GlobalTrigger_P0},
     {"SwTrg", VX2750Pha::GlobalTrigger_Software},
@@ -99,21 +86,8 @@ const std::map<std::string, VX2750Pha::GlobalTriggerSource> VX2750Pha::stringToG
     {"GPIO", VX2750Pha::GlobalTrigger_GPIO},
     {"TestPulse", VX2750Pha::GlobalTrigger_TestPulse}
 };
-static const std::map<VX2750Pha::GlobalTriggerSource, std::string> globalTriggerSourceToString = {
-    {VX2750Pha::GlobalTrigger_TriggerIn, "TrgIn"},
-    {VX2750Pha::GlobalTrigger_P0, "P0"},
-    {VX2750Pha::GlobalTrigger_Software, "SwTrg"},
-    {VX2750Pha::GlobalTrigger_LVDS, "LVDS"},
-    {VX2750Pha::GlobalTrigger_InternalA, "ITLA"},
-    {VX2750Pha::GlobalTrigger_InternalB, "ITLB"},
-    {VX2750Pha::GlobalTrigger_InternalAandB, "ITLA_AND_ITLB"},
-    {VX2750Pha::GlobalTrigger_InternalAorB, "ITLA_OR_ITLB"},
-    {VX2750Pha::GlobalTrigger_EncodedClockIn, "EncodedClkIn"},
-    {VX2750Pha::GlobalTrigger_GPIO, "GPIO"},
-    {VX2750Pha::GlobalTrigger_TestPulse, "TestPulse"}    
-};
 
-const std::map<std::string, VX2750Pha::WaveTriggerSource> VX2750Pha::stringToWaveTrigger= {
+const VX2750EnumTable<VX2750Pha::WaveTriggerSource> VX2750Pha::stringToWaveTrigger= {
      {"ITLA", VX2750Pha::WaveTrigger_InternalA},
      {"ITLB", VX2750Pha::WaveTrigger_InternalB},
      {"GlobalTriggerSource", VX2750Pha::WaveTrigger_GlobalTriggerSource},
@@ -126,21 +100,8 @@ const std::map<std::string, VX2750Pha::WaveTriggerSource> VX2750Pha::stringToWav
      {"Ch64Trigger", VX2750Pha::WaveTrigger_AnyChannelSelfTrigger},
      {"Disabled", VX2750Pha::WaveTrigger_Disabled}
 };
-static const std::map<VX2750Pha::WaveTriggerSource, std::string> waveTriggerToString= {
-     {VX2750Pha::WaveTrigger_InternalA, "ITLA"},
-     {VX2750Pha::WaveTrigger_InternalB, "ITLB"},
-     {VX2750Pha::WaveTrigger_GlobalTriggerSource, "GlobalTriggerSource"},
-     {VX2750Pha::WaveTrigger_TRGIN, "TRGIN"},
-     {VX2750Pha::ExternalInhibit, "ExternalInhibit"},
-     {VX2750Pha::ADCUnderSaturation, "ADCUnderSaturation"},
-     {VX2750Pha::ADCOverSaturation, "ADCOverSaturation"},
-     {VX2750Pha::WaveTrigger_Software, "SWTrg"},
-     {VX2750Pha::WaveTrigger_ChannelSelfTrigger, "ChSelfTrigger"},
-     {VX2750Pha::WaveTrigger_AnyChannelSelfTrigger, "Ch64Trigger"},
-     {VX2750Pha::WaveTrigger_Disabled, "Disabled"}
-};
 
-const std::map<std::string, VX2750Pha::EventTriggerSource> VX2750Pha::stringToEventTrigger = {
+const VX2750EnumTable<VX2750Pha::EventTriggerSource> VX2750Pha::stringToEventTrigger = {
     {"ITLB", VX2750Pha::EventTrigger_InternalB},
     {"ITLA", VX2750Pha::EventTrigger_InternalA},
     {"GlobalTriggerSource", VX2750Pha::EventTrigger_GlobalTriggerSource},
@@ -150,29 +111,15 @@ const std::map<std::string, VX2750Pha::EventTriggerSource> VX2750Pha::stringToEv
     {"Ch64Trigger", VX2750Pha::EventTrigger_AnyChannelSelfTrigger},
     {"Disabled", VX2750Pha::EventTrigger_Disabled}
 };
-static const std::map<VX2750Pha::EventTriggerSource, std::string> eventTriggerToString = {
-    {VX2750Pha::EventTrigger_InternalB, "ITLB"},
-    {VX2750Pha::EventTrigger_InternalA, "ITLA"},
-    {VX2750Pha::EventTrigger_GlobalTriggerSource, "GlobalTriggerSource"},
-    {VX2750Pha::EventTrigger_TRGIN, "TRGIN"},
-    {VX2750Pha::EventTrigger_Software, "SWTrg"},
-    {VX2750Pha::EventTrigger_ChannelSelfTrigger, "ChSelfTrigger"},
-    {VX2750Pha::EventTrigger_AnyChannelSelfTrigger, "Ch64Trigger"},
-    {VX2750Pha::EventTrigger_Disabled, "Disabled"}    
-};
 
 
 
-static const std::map<std::string, VX2750Pha::TraceRecordMode> stringToTraceRecord = {
+static const VX2750EnumTable<VX2750Pha::TraceRecordMode> stringToTraceRecord = {
     {"Always", VX2750Pha::Always},
     {"OnRequest", VX2750Pha::OnRequest}
 };
-static const std::map<VX2750Pha::TraceRecordMode, std::string> traceRecordToString = {
-    {VX2750Pha::Always, "Always"},
-    {VX2750Pha::OnRequest, "OnRequest"}
-};
 
-const std::map<std::string, VX2750Pha::TRGOUTMode> VX2750Pha::stringToTRGOUT = {
+const VX2750EnumTable<VX2750Pha::TRGOUTMode> VX2750Pha::stringToTRGOUT = {
     {"TrgIn", VX2750Pha::TriggerOut_TRGIN},
     {"P0", VX2750Pha::TriggerOut_P0},
     {"SwTrg", VX2750Pha::TriggerOut_Software},
@@ -195,30 +142,8 @@ const std::map<std::string, VX2750Pha::TRGOUTMode> VX2750Pha::stringToTRGOUT = {
     {"TrgClk", VX2750Pha::TriggerClock}
 };
 
-static const std::map<VX2750Pha::TRGOUTMode, std::string> TRGOUTToString = {
-    {VX2750Pha::TriggerOut_TRGIN, "TrgIn"},
-    {VX2750Pha::TriggerOut_P0, "P0"},
-    {VX2750Pha::TriggerOut_Software, "SwTrg"},
-    {VX2750Pha::TriggerOut_LVDS, "LVDS"},
-    {VX2750Pha::TriggerOut_InternalA, "ITLA"},
-    {VX2750Pha::TriggerOut_InternalB, "ITLB"},
-    {VX2750Pha::TriggerOut_InternalAandInternalB, "ITLA_AND_ITLB"},
-    {VX2750Pha::TriggerOut_InternalAorInternalB, "ITLA_OR_ITLB"},
-    {VX2750Pha::TriggerOut_EncodedClockIn, "EncodedClkIn"},
-    {VX2750Pha::TriggerOut_Run, "Run"},
-    {VX2750Pha::TriggerOut_ReferenceClock, "RefClk"},
-    {VX2750Pha::TriggerOut_TestPulse, "TestPulse"},
-    {VX2750Pha::TriggerOut_Busy, "Busy"},
-    {VX2750Pha::TriggerOut_Zero, "Fixed0"},
-    {VX2750Pha::TriggerOut_One, "Fixed1"},
-    {VX2750Pha::TriggerOut_SynchIn, "SyncIn"},
-    {VX2750Pha::TriggerOut_SIN, "SIN"},
-    {VX2750Pha::TriggerOut_GPIO, "GPIO"},
-    {VX2750Pha::AcceptedTrigger, "AcceptTrg"},
-    {VX2750Pha::TriggerClock, "TrgClk"}
-};
 
-const std::map<std::string, VX2750Pha::GPIOMode>  VX2750Pha::stringToGPIO = {
+const VX2750EnumTable<VX2750Pha::GPIOMode>  VX2750Pha::stringToGPIO = {
     {"Disabled", VX2750Pha::GPIOMode_Disabled},
     {"TrgIn", VX2750Pha::GPIOMode_TriggerIn},
     {"P0", VX2750Pha::GPIOMode_P0},
@@ -237,55 +162,23 @@ const std::map<std::string, VX2750Pha::GPIOMode>  VX2750Pha::stringToGPIO = {
     {"Fixed0", VX2750Pha::GPIOMode_Zero},
     {"Fixed1", VX2750Pha::GPIOMode_One}
 };
-static const std::map<VX2750Pha::GPIOMode,std::string> GPIOToString = {
-    {VX2750Pha::GPIOMode_Disabled, "Disabled"},
-    {VX2750Pha::GPIOMode_TriggerIn, "TrgIn"},
-    {VX2750Pha::GPIOMode_P0, "P0"},
-    {VX2750Pha::GPIOMode_SIN, "SIN"},
-    {VX2750Pha::GPIOMode_LVDS, "LVDS"},
-    {VX2750Pha::GPIOMode_InternalA, "ITLA"},
-    {VX2750Pha::GPIOMode_InternalB, "ITLB"},
-    {VX2750Pha::GPIOMode_InternalAandInternalB, "ITLA_AND_ITLB"},
-    {VX2750Pha::GPIOMode_InternalAorInternalB, "ITLA_OR_ITLB"},
-    {VX2750Pha::GPIOMode_EncodedClockIn, "EncodedClkIn"},
-    {VX2750Pha::GPIOMode_SoftwareTrigger, "SwTrg"},
-    {VX2750Pha::GPIOMode_Run, "Run"},
-    {VX2750Pha::GPIOMode_ReferenceClock, "RefClk"},
-    {VX2750Pha::GPIOMode_TestPulse, "TestPulse"},
-    {VX2750Pha::GPIOMode_Busy, "Busy"},
-    {VX2750Pha::GPIOMode_Zero, "Fixed0"},
-    {VX2750Pha::GPIOMode_One, "Fixed1"}
-};
 
-const std::map<std::string, VX2750Pha::BusyInSource> VX2750Pha::stringToBusyIn = {
+const VX2750EnumTable<VX2750Pha::BusyInSource> VX2750Pha::stringToBusyIn = {
     {"SIN", VX2750Pha::BusyIn_SIN},
     {"GPIO", VX2750Pha::BusyIn_GPIO},
     {"LVDS", VX2750Pha::BusyIn_LVDS},
     {"Disabled", VX2750Pha::BusyIn_Disabled }
 };
-static const std::map<VX2750Pha::BusyInSource, std::string> busyInToString = {
-    {VX2750Pha::BusyIn_SIN, "SIN"},
-    {VX2750Pha::BusyIn_GPIO, "GPIO"},
-    {VX2750Pha::BusyIn_LVDS, "LVDS"},
-    {VX2750Pha::BusyIn_Disabled, "Disabled"}
-};
 
-const std::map<std::string, VX2750Pha::SyncOutMode> VX2750Pha::stringToSyncOut = {
+const VX2750EnumTable<VX2750Pha::SyncOutMode> VX2750Pha::stringToSyncOut = {
     {"Disabled", VX2750Pha::SyncOut_Disabled},
     {"SyncIn", VX2750Pha::SyncOut_SynchIn},
     {"TestPulse", VX2750Pha::SyncOut_TestPulse},
     {"IntClk", VX2750Pha::InternalClock},
     {"Run", VX2750Pha::SyncOut_Run}
 };
-static const std::map<VX2750Pha::SyncOutMode, std::string> syncOutToString = {
-    {VX2750Pha::SyncOut_Disabled, "Disabled"},
-    {VX2750Pha::SyncOut_SynchIn, "SyncIn"},
-    {VX2750Pha::SyncOut_TestPulse, "TestPulse"},
-    {VX2750Pha::InternalClock, "IntClk"},
-    {VX2750Pha::SyncOut_Run, "Run"}
-};
 
-const std::map<std::string , VX2750Pha::VetoSource>  VX2750Pha::stringToVeto = {
+const VX2750EnumTable<VX2750Pha::VetoSource>  VX2750Pha::stringToVeto = {
     {"SIN", VX2750Pha::Veto_SIN},
     {"LVDS", VX2750Pha::Veto_LVDS},
     {"GPIO", VX2750Pha::Veto_GPIO},
@@ -293,38 +186,20 @@ const std::map<std::string , VX2750Pha::VetoSource>  VX2750Pha::stringToVeto = {
     {"EncodedClkIn", VX2750Pha::Veto_EncodedClock},
     {"Disabled", VX2750Pha::Veto_Disabled}
 };
-static const std::map<VX2750Pha::VetoSource, std::string>  vetoToString = {
-    {VX2750Pha::Veto_SIN, "SIN"},
-    {VX2750Pha::Veto_LVDS, "LVDS"},
-    {VX2750Pha::Veto_GPIO, "GPIO"},
-    {VX2750Pha::Veto_P0, "P0"},
-    {VX2750Pha::Veto_EncodedClock, "EncodedClkIn"},
-    {VX2750Pha::Veto_Disabled, "Disabled"}
-};
 
-const std::map<std::string, VX2750Pha::VetoPolarity> VX2750Pha::stringToVetoPolarity = {
+const VX2750EnumTable<VX2750Pha::VetoPolarity> VX2750Pha::stringToVetoPolarity = {
     {"ActiveHigh", VX2750Pha::ActiveHigh},
     {"ActiveLow", VX2750Pha::ActiveLow}
 };
-static const std::map<VX2750Pha::VetoPolarity, std::string> vetoPolarityToString = {
-    {VX2750Pha::ActiveHigh, "ActiveHigh"},
-    {VX2750Pha::ActiveLow, "ActiveLow"}
-};
 
-const std::map<std::string, VX2750Pha::ChannelVetoSource> VX2750Pha::stringToChannelVeto = {
+const VX2750EnumTable<VX2750Pha::ChannelVetoSource> VX2750Pha::stringToChannelVeto = {
     {"BoardVeto", VX2750Pha::BoardVeto},
     {"ADCOverSaturation", VX2750Pha::OverSaturation},
     {"ADCUnderSaturation", VX2750Pha::UnderSaturation},
     {"Disabled", VX2750Pha::ChanVeto_Disabled}
 };
-static const std::map<VX2750Pha::ChannelVetoSource, std::string> channelVetoToString = {
-    {VX2750Pha::BoardVeto, "BoardVeto"},
-    {VX2750Pha::OverSaturation, "ADCOverSaturation"},
-    {VX2750Pha::UnderSaturation, "ADCUnderSaturation"},
-    {VX2750Pha::ChanVeto_Disabled, "Disabled"}
-};
 
-const std::map<std::string, VX2750Pha::WaveDataSource> VX2750Pha::stringToWaveDataSource = {
+const VX2750EnumTable<VX2750Pha::WaveDataSource> VX2750Pha::stringToWaveDataSource = {
     {"ADC_DATA", VX2750Pha::ADC_DATA},
     {"ADC_TEST_TOGGLE", VX2750Pha::ADC_TEST_TOGGLE},
     {"ADC_TEST_RAMP", VX2750Pha::ADC_TEST_RAMP},
@@ -334,46 +209,23 @@ const std::map<std::string, VX2750Pha::WaveDataSource> VX2750Pha::stringToWaveDa
     {"SquareWave", VX2750Pha::SquareWave},
     {"ADC_TEST_PRBS", VX2750Pha::ADC_TEST_PRBS}
 };
-static const std::map<VX2750Pha::WaveDataSource, std::string> waveDataSourceToString = {
-    {VX2750Pha::ADC_DATA, "ADC_DATA"},
-    {VX2750Pha::ADC_TEST_TOGGLE, "ADC_TEST_TOGGLE"},
-    {VX2750Pha::ADC_TEST_RAMP, "ADC_TEST_RAMP"},
-    {VX2750Pha::ADC_SIN, "ADC_TEST_SIN"},
-    {VX2750Pha::WaveSource_IPE, "IPE"},
-    {VX2750Pha::WaveSource_Ramp, "Ramp"},
-    {VX2750Pha::SquareWave, "SquareWave"},
-    {VX2750Pha::ADC_TEST_PRBS, "ADC_TEST_PRBS"}
-};
 
-const std::map<std::string, VX2750Pha::WaveResolution> VX2750Pha::stringToWaveResolution = {
+const VX2750EnumTable<VX2750Pha::WaveResolution> VX2750Pha::stringToWaveResolution = {
     {"Res8", VX2750Pha::Res8},
     {"Res16", VX2750Pha::Res16},
     {"Res32", VX2750Pha::Res32},
     {"Res64", VX2750Pha::Res64} 
 };
-static const std::map<VX2750Pha::WaveResolution, std::string> waveResolutionToString = {
-    {VX2750Pha::Res8, "Res8",},
-    {VX2750Pha::Res16, "Res16"},
-    {VX2750Pha::Res32, "Res32"},
-    {VX2750Pha::Res64, "Res64"} 
-};
 
-const std::map<std::string, VX2750Pha::AnalogProbe> VX2750Pha::stringToAnalogProbe = {
+const VX2750EnumTable<VX2750Pha::AnalogProbe> VX2750Pha::stringToAnalogProbe = {
     {"ADCInput", VX2750Pha::ADCInput},
     {"TimeFilter", VX2750Pha::TimeFilter},
     { "EnergyFilter", VX2750Pha::EnergyFilter},
     {"EnergyFilterBaseline", VX2750Pha::EnergyFilterBaseline},
     {"EnergyFilterMinusBaseline", VX2750Pha::EnergyFilterMinusBaseline}
 };
-static const std::map<VX2750Pha::AnalogProbe, std::string> analogProbeToString = {
-    {VX2750Pha::ADCInput, "ADCInput"},
-    {VX2750Pha::TimeFilter,"TimeFilter"},
-    {VX2750Pha::EnergyFilter, "EnergyFilter"},
-    {VX2750Pha::EnergyFilterBaseline, "EnergyFilterBaseline"},
-    {VX2750Pha::EnergyFilterMinusBaseline, "EnergyFilterMinusBaseline"} 
-};
 
-const std::map<std::string, VX2750Pha::DigitalProbe> VX2750Pha::stringToDigitalProbe = {
+const VX2750EnumTable<VX2750Pha::DigitalProbe> VX2750Pha::stringToDigitalProbe = {
     {"Trigger", VX2750Pha::DProbe_Trigger},
     {"TimeFilterArmed", VX2750Pha::TimeFilterArmed},
     {"ReTriggerGuard", VX2750Pha::ReTriggerGuard},
@@ -388,85 +240,42 @@ const std::map<std::string, VX2750Pha::DigitalProbe> VX2750Pha::stringToDigitalP
     {"EnergyFilterSaturation", VX2750Pha::EnergyFilterSaturation},
     {"AcquisitionInhibit", VX2750Pha::AcquisitionInhibit}
 };
-static const std::map<VX2750Pha::DigitalProbe, std::string> digitalProbeToString = {
-    {VX2750Pha::DProbe_Trigger, "Trigger"},
-    {VX2750Pha::TimeFilterArmed, "TimeFilterArmed"},
-    {VX2750Pha::ReTriggerGuard, "ReTriggerGuard"},
-    {VX2750Pha::EneryFilterBaselineFreeze, "EnergyFilterBaselineFreeze"},
-    {VX2750Pha::EnergyFilterPeaking, "EnergyFilterPeaking" },
-    {VX2750Pha::EnergyFilterPeakReady, "EnergyFilterPeakReady"},
-    {VX2750Pha::EnergyFilterPileupGuard, "EnergyFilterPileUpGuard"},
-    {VX2750Pha::EventPileup, "EventPileup"},
-    {VX2750Pha::ADCSaturation, "ADCSaturation"},
-    {VX2750Pha::ADCSaturationProtection, "ADCSaturationProtection"},
-    {VX2750Pha::PostSaturationEvent, "PostSaturationEvent"},
-    {VX2750Pha::EnergyFilterSaturation, "EnergyFilterSaturation" },
-    {VX2750Pha::AcquisitionInhibit, "AcquisitionInhibit"}
-};
 
-static const std::map<std::string, VX2750Pha::IOLevel> stringToIOLevel = {
+static const VX2750EnumTable<VX2750Pha::IOLevel> stringToIOLevel = {
     {"TTL", VX2750Pha::TTL},
     {"NIM", VX2750Pha::NIM}
 };
-static const std::map<VX2750Pha::IOLevel, std::string> ioLevelToString = {
-    {VX2750Pha::NIM, "NIM"},
-    {VX2750Pha::TTL, "TTL"}
-};
 
-const std::map<std::string, VX2750Pha::IndividualTriggerLogic> VX2750Pha::stringToIndividualTriggerLogic = {
+const VX2750EnumTable<VX2750Pha::IndividualTriggerLogic> VX2750Pha::stringToIndividualTriggerLogic = {
     {"OR", VX2750Pha::ITL_OR},
     {"AND", VX2750Pha::ITL_AND},
     {"Majority", VX2750Pha::Majority}
 };
-static const std::map<VX2750Pha::IndividualTriggerLogic, std::string> individualTriggerLogicToString = {
-    {VX2750Pha::ITL_OR, "OR"},
-    {VX2750Pha::ITL_AND, "AND"},
-    {VX2750Pha::Majority, "Majority"}
-};
 
-const std::map<std::string, VX2750Pha::PairTriggerLogic> VX2750Pha::stringToPairLogic = {
+const VX2750EnumTable<VX2750Pha::PairTriggerLogic> VX2750Pha::stringToPairLogic = {
     {"AND", VX2750Pha::PTL_AND},
     {"OR", VX2750Pha::PTL_OR},
     {"NONE", VX2750Pha::NONE}
 };
-static const std::map<VX2750Pha::PairTriggerLogic, std::string> pairLogicToString = {
-    {VX2750Pha::PTL_AND, "AND"},
-    {VX2750Pha::PTL_OR, "OR"},
-    {VX2750Pha::NONE, "NONE"}
-};
 
-const std::map<std::string, VX2750Pha::ITLConnect> VX2750Pha::stringToITLConnect = {
+const VX2750EnumTable<VX2750Pha::ITLConnect> VX2750Pha::stringToITLConnect = {
     {"Disabled", VX2750Pha::ITL_Disabled},
     {"ITLA", VX2750Pha::ITL_ITLA},
     {"ITLB", VX2750Pha::ITL_ITLB}
 };
-static const std::map<VX2750Pha::ITLConnect, std::string> ITLConnectToString = {
-    {VX2750Pha::ITL_Disabled, "Disabled"},
-    {VX2750Pha::ITL_ITLA, "ITLA"},
-    {VX2750Pha::ITL_ITLB, "ITLB"}
-};
 
-const std::map<std::string, VX2750Pha::LVDSMode> VX2750Pha::stringToLVDSMode = {
+const VX2750EnumTable<VX2750Pha::LVDSMode> VX2750Pha::stringToLVDSMode = {
      {"SelfTriggers", VX2750Pha::SelfTriggers},
      {"Sync", VX2750Pha::Sync},
      {"IORegister", VX2750Pha::IORegister}
 };
-static const std::map<VX2750Pha::LVDSMode, std::string> LVDSModeToString = {
-     {VX2750Pha::SelfTriggers, "SelfTriggers"},
-     {VX2750Pha::Sync, "Sync"},
-     {VX2750Pha::IORegister, "IORegister"}    
-};
 
-static const std::map<std::string, VX2750Pha::LVDSDirection> stringToLVDSDirection = {
+static const VX2750EnumTable<VX2750Pha::LVDSDirection> stringToLVDSDirection = {
     {"Input", VX2750Pha::Input},
     {"Output", VX2750Pha::Output}
 };
-static const std::map<VX2750Pha::LVDSDirection, std::string> LVDSDirectionToString = {
-    {VX2750Pha::Input, "Input"},
-    {VX2750Pha::Output, "Output"}    
-};
 
-const std::map<std::string, VX2750Pha::DACOutputMode> VX2750Pha::stringToDACOutMode = {
+const VX2750EnumTable<VX2750Pha::DACOutputMode> VX2750Pha::stringToDACOutMode = {
     {"Static", VX2750Pha::Static},
     {"IPE", VX2750Pha::DACOut_IPE},
     {"ChInput", VX2750Pha::DACOut_ChInput},
@@ -477,39 +286,19 @@ const std::map<std::string, VX2750Pha::DACOutputMode> VX2750Pha::stringToDACOutM
     {"Sin5MHz", VX2750Pha::Sine5MHz},
     {"Square", VX2750Pha::Square}
 };
-static const std::map<VX2750Pha::DACOutputMode, std::string> DACOutModeToString = {
-    {VX2750Pha::Static, "Static"},
-    {VX2750Pha::DACOut_IPE, "IPE"},
-    {VX2750Pha::DACOut_ChInput, "ChInput"},
-    {VX2750Pha::MemOccupancy, "MemOccupancy"},
-    {VX2750Pha::ChSum, "ChSum"},
-    {VX2750Pha::OverThrSum, "OverThrSum"},
-    {VX2750Pha::DACOut_Ramp, "Ramp"},
-    {VX2750Pha::Sine5MHz, "Sin5MHz"},
-    {VX2750Pha::Square, "Square"}
-};
 
-static const std::map<std::string, VX2750Pha::Polarity> stringToPolarity = {
+static const VX2750EnumTable<VX2750Pha::Polarity> stringToPolarity = {
     {"Positive", VX2750Pha::Positive},
     {"Negative", VX2750Pha::Negative}
 };
-static const std::map<VX2750Pha::Polarity, std::string> polarityToString = {
-    {VX2750Pha::Positive, "Positive"},
-    {VX2750Pha::Negative, "Negative"}
-};
 
-const std::map<std::string, VX2750Pha::EventSelection> VX2750Pha::stringToEventSelection = {
+const VX2750EnumTable<VX2750Pha::EventSelection> VX2750Pha::stringToEventSelection = {
     {"All", VX2750Pha::All},
     {"Pileup", VX2750Pha::Pileup},
     {"EnergySkim", VX2750Pha::EnergySkim}
 };
-static const std::map<VX2750Pha::EventSelection, std::string> eventSelectionToString = {
-    {VX2750Pha::All, "All"},
-    {VX2750Pha::Pileup, "Pileup"},
-    {VX2750Pha::EnergySkim, "EnergySkim"}
-};
 
-const std::map<std::string, VX2750Pha::CoincidenceMask> VX2750Pha::stringToCoincidenceMask = {
+const VX2750EnumTable<VX2750Pha::CoincidenceMask> VX2750Pha::stringToCoincidenceMask = {
     {"Disabled", VX2750Pha::Coincidence_Disabled},
     {"Ch64Trigger", VX2750Pha::Ch64Trigger},
     {"TRGIN", VX2750Pha::Coincidence_TRGIN},
@@ -517,29 +306,15 @@ const std::map<std::string, VX2750Pha::CoincidenceMask> VX2750Pha::stringToCoinc
     {"ITLA", VX2750Pha::Coincidence_ITLA},
     {"ITLB", VX2750Pha::Coincidence_ITLB}
 };
-static const std::map<VX2750Pha::CoincidenceMask, std::string> coincidenceMaskToString = {
-    {VX2750Pha::Coincidence_Disabled, "Disabled"},
-    {VX2750Pha::Ch64Trigger, "Ch64Trigger"},
-    {VX2750Pha::Coincidence_TRGIN, "TRGIN"},
-    {VX2750Pha::Coincidence_GlobalTriggerSource, "GlobalTriggerSource"},
-    {VX2750Pha::Coincidence_ITLA, "ITLA"},
-    {VX2750Pha::Coincidence_ITLB, "ITLB"}
-};
 
-static const std::map<std::string, VX2750Pha::EnergyPeakingAverage> stringToPeakingAverage = {
+static const VX2750EnumTable<VX2750Pha::EnergyPeakingAverage> stringToPeakingAverage = {
     {"OneShot", VX2750Pha::Average1},
     {"LowAVG", VX2750Pha::Average4},
     {"MediumAVG", VX2750Pha::EPeakAvg_Average16},
     {"HighAVG", VX2750Pha::EPeakAvg_Average64}
 };
-static const std::map<VX2750Pha::EnergyPeakingAverage, std::string> peakingAverageToString = {
-    {VX2750Pha::Average1, "OneShot"},
-    {VX2750Pha::Average4, "LowAVG"},
-    {VX2750Pha::EPeakAvg_Average16, "MediumAVG"},
-    {VX2750Pha::EPeakAvg_Average64, "HighAVG"}
-};
 
-static const std::map<std::string, VX2750Pha::EnergyFilterBaselineAverage> stringToBLAverage = {
+static const VX2750EnumTable<VX2750Pha::EnergyFilterBaselineAverage> stringToBLAverage = {
     {"Fixed", VX2750Pha::Fixed},
     {"VeryLow", VX2750Pha::EFilterBlineAvg_Average16},
     {"Low", VX2750Pha::EFilterBlineAvg_Average64},
@@ -548,24 +323,11 @@ static const std::map<std::string, VX2750Pha::EnergyFilterBaselineAverage> strin
     {"MediumHigh", VX2750Pha::Average4K},
     {"High", VX2750Pha::Average16K}
 };
-static const std::map<VX2750Pha::EnergyFilterBaselineAverage, std::string> BLAverageToString = {
-    {VX2750Pha::Fixed, "Fixed"},
-    {VX2750Pha::EFilterBlineAvg_Average16, "VeryLow"},
-    {VX2750Pha::EFilterBlineAvg_Average64, "Low"},
-    {VX2750Pha::Average256, "MediumLow"},
-    {VX2750Pha::Average1024, "Medium"},
-    {VX2750Pha::Average4K, "MediumHigh"},
-    {VX2750Pha::Average16K, "High"}
-};
 
-static const std::map<std::string, VX2750Pha::Endpoint> stringToEndpoint = {
+static const VX2750EnumTable<VX2750Pha::Endpoint> stringToEndpoint = {
     {"raw", VX2750Pha::Raw},
     {"dpppha", VX2750Pha::PHA}
 };
-static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
-    {VX2750Pha::Raw, "raw"},
-    {VX2750Pha::PHA, "dpppha"}
-};
 ////////////////////////////////////////////////////////////////////////////////
 // Public methods
 
@@ -848,7 +610,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setClockSource(ClockSource selection) const
     {
-        std::string src = enumToString(clockSourceToString, selection);
+        std::string src = enumToString(stringToClockSource, selection);
         SetDeviceValue("ClockSource", src.c_str());
     }
     /**
@@ -925,7 +687,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
         }
         std::vector<std::string> sources;
         for (auto s : src) {
-            sources.push_back(enumToString(startSourceToString, s));
+            sources.push_back(enumToString(stringToStartSource, s));
         }        
         std::string strValue = stringListToOrList(sources);
 
@@ -971,7 +733,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
         
         std::vector<std::string> sources;
         for (auto s : sel) {
-            sources.push_back(enumToString(globalTriggerSourceToString, s));
+            sources.push_back(enumToString(stringToGlobalTriggerSource, s));
         }
         
         
@@ -1015,7 +777,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
         
         std::vector<std::string> stringList;
         for (auto s : selection) {
-            stringList.push_back(enumToString(waveTriggerToString, s));
+            stringList.push_back(enumToString(stringToWaveTrigger, s));
         }
         
         std::string value = stringListToOrList(stringList);
@@ -1051,7 +813,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
         
         std::vector<std::string> stringList;
         for (auto s : selection) {
-            stringList.push_back(enumToString(eventTriggerToString, s));
+            stringList.push_back(enumToString(stringToEventTrigger, s));
         }
         
         
@@ -1104,7 +866,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setTraceRecordMode(unsigned ch, TraceRecordMode mode) const
     {
-        std::string value =  enumToString(traceRecordToString, mode);
+        std::string value =  enumToString(stringToTraceRecord, mode);
         SetChanValue(ch, "WaveSaving", value.c_str());
     }
     /**
@@ -1126,7 +888,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setTRGOUTMode(TRGOUTMode select) const
     {
-        std::string strMode = enumToString(TRGOUTToString, select);
+        std::string strMode = enumToString(stringToTRGOUT, select);
         SetDeviceValue("TrgOutMode", strMode.c_str());
     }
     /**
@@ -1146,7 +908,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setGPIOMode(GPIOMode mode) const
     {
-        std::string value = enumToString(GPIOToString, mode);
+        std::string value = enumToString(stringToGPIO, mode);
         SetDeviceValue("GPIOMode", value.c_str());
     }
     /**
@@ -1165,7 +927,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setBusyInputSource(VX2750Pha::BusyInSource src) const
     {
-        std::string value = enumToString(busyInToString, src);
+        std::string value = enumToString(stringToBusyIn, src);
         SetDeviceValue("BusyInSource", value.c_str());
     }
     /**
@@ -1185,7 +947,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setSyncOutMode(SyncOutMode mode) const
     {
-        std::string value =  enumToString(syncOutToString, mode);
+        std::string value =  enumToString(stringToSyncOut, mode);
         SetDeviceValue("SyncOutMode", value.c_str());
         
     }
@@ -1206,7 +968,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setBoardVetoSource(VetoSource src) const
     {
-        std::string value = enumToString(vetoToString, src);
+        std::string value = enumToString(stringToVeto, src);
         SetDeviceValue("BoardVetoSource", value.c_str());
     }
     /**
@@ -1258,7 +1020,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setBoardVetoPolarity(VetoPolarity pol) const
     {
-        std::string strValue = enumToString(vetoPolarityToString, pol);
+        std::string strValue = enumToString(stringToVetoPolarity, pol);
         SetDeviceValue("BoardVetoPolarity", strValue.c_str());
     }
     /**
@@ -1282,7 +1044,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setChannelVetoSource(unsigned ch, ChannelVetoSource src) const
     {
-        std::string strValue = enumToString(channelVetoToString, src);
+        std::string strValue = enumToString(stringToChannelVeto, src);
         SetChanValue(ch,  "ChannelVetoSource", strValue.c_str());
     }
     /**
@@ -1506,7 +1268,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setWaveDataSource(unsigned chan, WaveDataSource selection) const
     {
-        std::string value = enumToString(waveDataSourceToString, selection);
+        std::string value = enumToString(stringToWaveDataSource, selection);
         SetChanValue(chan, "WaveDataSource", value.c_str());
     }
     /**
@@ -1571,7 +1333,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setWaveResolution(unsigned ch, WaveResolution sel) const
     {
-        std::string value = enumToString(waveResolutionToString, sel);
+        std::string value = enumToString(stringToWaveResolution, sel);
         SetChanValue(ch, "WaveResolution", value.c_str());
     }
     /**
@@ -1601,7 +1363,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
         checkInclusiveRange(0, 1, probeNum);
         std::string param = appendNumber("WaveAnalogProbe", probeNum);
         
-        std::string value = enumToString(analogProbeToString, selection);
+        std::string value = enumToString(stringToAnalogProbe, selection);
         SetChanValue(ch, param.c_str(), value.c_str());
     }
     /**
@@ -1629,7 +1391,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     {
         checkInclusiveRange(0, 3, probe);
         std::string param = appendNumber("WaveDigitalProbe", probe);
-        std::string value = enumToString(digitalProbeToString, selection);
+        std::string value = enumToString(stringToDigitalProbe, selection);
         SetChanValue(ch, param.c_str(), value.c_str());
     }
     /**
@@ -1764,7 +1526,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setIOLevel(IOLevel level) const
     {
-        std::string value = enumToString(ioLevelToString, level);
+        std::string value = enumToString(stringToIOLevel, level);
         SetDeviceValue("IOLevel", value.c_str());
     }
     /**
@@ -1995,7 +1757,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setITLAMainLogic(IndividualTriggerLogic selection) const
     {
-        std::string value = enumToString(individualTriggerLogicToString, selection);
+        std::string value = enumToString(stringToIndividualTriggerLogic, selection);
         SetDeviceValue("ITLAMainLogic", value.c_str());
     }
     /**
@@ -2006,7 +1768,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setITLBMainLogic(IndividualTriggerLogic selection) const
     {
-        std::string value = enumToString(individualTriggerLogicToString, selection);
+        std::string value = enumToString(stringToIndividualTriggerLogic, selection);
         SetDeviceValue("ITLBMainLogic", value.c_str());
     }
     /**
@@ -2078,7 +1840,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setITLAPairLogic(PairTriggerLogic sel) const
     {
-        std::string value = enumToString(pairLogicToString, sel);
+        std::string value = enumToString(stringToPairLogic, sel);
         SetDeviceValue("ITLAPairLogic", value.c_str());
     }
     /**
@@ -2088,7 +1850,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setITLBPairLogic(PairTriggerLogic sel) const
     {
-        std::string value = enumToString(pairLogicToString, sel);
+        std::string value = enumToString(stringToPairLogic, sel);
         SetDeviceValue("ITLBPairLogic", value.c_str());
     }
     /**
@@ -2157,7 +1919,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setITLConnect(unsigned ch, ITLConnect selection) const
     {
-        std::string value = enumToString(ITLConnectToString, selection);
+        std::string value = enumToString(stringToITLConnect, selection);
         SetChanValue(ch, "ITLConnect", value.c_str());
     }
     /**
@@ -2252,7 +2014,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setLVDSMode(unsigned quartet, LVDSMode mode) const
     {
-        std::string value = enumToString(LVDSModeToString, mode);
+        std::string value = enumToString(stringToLVDSMode, mode);
         SetLVDSValue(quartet, "LVDSMode", value.c_str());
     }
     /**
@@ -2273,7 +2035,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setLVDSDirection(unsigned quartet, LVDSDirection direction) const
     {
-        std::string value = enumToString(LVDSDirectionToString, direction);
+        std::string value = enumToString(stringToLVDSDirection, direction);
         SetLVDSValue(quartet, "LVDSDirection", value.c_str());
     }
     /**
@@ -2350,7 +2112,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setDACOutMode(DACOutputMode mode) const
     {
-        std::string value = enumToString(DACOutModeToString, mode);
+        std::string value = enumToString(stringToDACOutMode, mode);
         SetDeviceValue("DACoutMode", value.c_str());
     }
     /**
@@ -2559,7 +2321,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setPulsePolarity(unsigned chan, Polarity pol) const
     {
-        std::string value = enumToString(polarityToString, pol);
+        std::string value = enumToString(stringToPolarity, pol);
         SetChanValue(chan, "PulsePolarity", value.c_str());
     }
     /**
@@ -2620,7 +2382,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setEventSelector(unsigned chan, EventSelection sel) const
     {
-        std::string value = enumToString(eventSelectionToString, sel);
+        std::string value = enumToString(stringToEventSelection, sel);
         SetChanValue(chan, "EventSelector", value.c_str());
     }
     /**
@@ -2642,7 +2404,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setWaveformSelector(unsigned chan, EventSelection sel) const
     {
-        std::string value = enumToString(eventSelectionToString, sel);
+        std::string value = enumToString(stringToEventSelection, sel);
         SetChanValue(chan, "WaveSelector", value.c_str());
     }
     /**
@@ -2662,7 +2424,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setCoincidenceMask(unsigned chan, CoincidenceMask sel) const
     {
-        std::string value = enumToString(coincidenceMaskToString, sel);
+        std::string value = enumToString(stringToCoincidenceMask, sel);
         SetChanValue(chan, "CoincidenceMask", value.c_str());
     }
     /**
@@ -2683,7 +2445,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setAntiCoincidenceMask(unsigned chan, CoincidenceMask sel) const
     {
-        std::string value = enumToString(coincidenceMaskToString, sel);
+        std::string value = enumToString(stringToCoincidenceMask, sel);
         SetChanValue(chan, "AntiCoincidenceMask", value.c_str());
     }
     /**
@@ -2924,7 +2686,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::setEnergyFilterPeakingAverage(unsigned ch, EnergyPeakingAverage selection) const
     {
-        std::string value = enumToString(peakingAverageToString, selection);
+        std::string value = enumToString(stringToPeakingAverage, selection);
         SetChanValue(ch, "EnergyFilterPeakingAvg", value.c_str());
     }
     /**
@@ -3031,7 +2793,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
         unsigned chan, EnergyFilterBaselineAverage sel
     ) const
     {
-        std::string value = enumToString(BLAverageToString, sel);
+        std::string value = enumToString(stringToBLAverage, sel);
         SetChanValue(chan, "EnergyFilterBaselineAvg", value.c_str());
     }
     /**
@@ -3258,7 +3020,7 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::selectEndpoint(Endpoint selection)
     {
-        std::string value = enumToString(endpointToString, selection);
+        std::string value = enumToString(stringToEndpoint, selection);
         SetActiveEndpoint(value.c_str());
     }
     /**
@@ -3645,12 +3407,8 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     {
         // Regardless we figure out the length of the longest trace:
         
-        int nChans = channelCount();
-        std::uint32_t samples = 0;
-        for (int i=0; i < nChans; i++) {
-            auto n = getRecordSamples(i);
-            if (n > samples) samples = n;
-        }
+        std::uint32_t samples = maxRecordSamples();
+        
         // samples is the number of analog samples and there's one byte per
         // digital probe sample so:
         
@@ -3716,18 +3474,150 @@ static const std::map<VX2750Pha::Endpoint, std::string> endpointToString = {
     void
     VX2750Pha::freeDecodedBuffer(DecodedEvent& event)
     {
-        delete []event.s_pAnalogProbe1;
-        delete []event.s_pAnalogProbe2;
-        delete []event.s_pDigitalProbe1;
-        delete []event.s_pDigitalProbe2;
-        delete []event.s_pDigitalProbe3;
-        delete []event.s_pDigitalProbe4;
+        // Pooled storage belongs to the pool, not the event:
+        
+        if (!event.s_pooled) {
+            delete []event.s_pAnalogProbe1;
+            delete []event.s_pAnalogProbe2;
+            delete []event.s_pDigitalProbe1;
+            delete []event.s_pDigitalProbe2;
+            delete []event.s_pDigitalProbe3;
+            delete []event.s_pDigitalProbe4;
+        }
         
         initDecodedBuffer(event);
     }
+    /**
+     * setupDecodedBuffer
+     *    Same as above, however the probe buffers are carved out of
+     *    a VX2750DecodedEventPool rather than new'd.  The pool only allocates
+     *    if it's not already big enough, so re-setting up an event from run
+     *    to run does no allocation once the pool has grown to size.
+     *    freeDecodedBuffer can (and should) still be called; it
+     *    won't free the pooled storage.
+     * @param[out] event - the event to setup; must have been initialized with
+     *                     initDecodedBuffer.
+     * @param pool       - pool from which storage is carved.
+     * @note growing the pool invalidates events previously set up in it.
+     */
+    void
+    VX2750Pha::setupDecodedBuffer(
+        DecodedEvent& event, VX2750DecodedEventPool& pool
+    )
+    {
+        setupDecodedBuffers(&event, 1, pool);
+    }
+    /**
+     * setupDecodedBuffers
+     *    Multi-hit variant of the above.  A batch of events is set up
+     *    so that their probe buffers are contiguous in the pool; event i's
+     *    probes start at i times the per event stride.  Each probe buffer
+     *    begins on a cache line.
+     * @param[out] pEvents - pointer to nEvents decoded events each
+     *                     of which must have been initialized via initDecodedBuffer.
+     * @param nEvents      - number of events in the batch.
+     * @param pool         - pool from which the storage is carved.
+     */
+    void
+    VX2750Pha::setupDecodedBuffers(
+        DecodedEvent* pEvents, size_t nEvents, VX2750DecodedEventPool& pool
+    )
+    {
+        std::uint32_t samples = maxRecordSamples();
+        size_t stride = decodedEventStride(samples);
+        std::uint8_t* pStorage = pool.reserve(stride * nEvents);
+        
+        for (int i = 0; i < nEvents; i++) {
+            carveDecodedBuffer(pEvents[i], pStorage, samples);
+            pStorage += stride;
+        }
+    }
     ////////////////////////////////////////////////////////////////////////////
     // Implementation of private (utility) functions.
     
+    /**
+     * maxRecordSamples
+     *    @return std::uint32_t - the longest trace any channel is
+     *                   configured to record.
+     */
+    std::uint32_t
+    VX2750Pha::maxRecordSamples() const
+    {
+        int nChans = channelCount();
+        std::uint32_t samples = 0;
+        for (int i=0; i < nChans; i++) {
+            auto n = getRecordSamples(i);
+            if (n > samples) samples = n;
+        }
+        return samples;
+    }
+    /**
+     * decodedEventStride
+     *    Compute the number of bytes of pool storage needed by the probes
+     *    of one decoded event given the current read options.  Each enabled
+     *    probe is rounded up to a cache line.
+     * @param samples - maximum number of samples in a trace.
+     * @return size_t - bytes of storage per event.
+     */
+    size_t
+    VX2750Pha::decodedEventStride(std::uint32_t samples) const
+    {
+        size_t aProbe = VX2750DecodedEventPool::roundUp(samples*sizeof(std::int32_t));
+        size_t dProbe = VX2750DecodedEventPool::roundUp(samples);
+        size_t result = 0;
+        
+        if (m_dppPhaOptions.s_enableAnalogProbe1) result += aProbe;
+        if (m_dppPhaOptions.s_enableAnalogProbe2) result += aProbe;
+        if (m_dppPhaOptions.s_enableDigitalProbe1) result += dProbe;
+        if (m_dppPhaOptions.s_enableDigitalProbe2) result += dProbe;
+        if (m_dppPhaOptions.s_enableDigitalProbe3) result += dProbe;
+        if (m_dppPhaOptions.s_enableDigitalProbe4) result += dProbe;
+        
+        return result;
+    }
+    /**
+     * carveDecodedBuffer
+     *    Point the enabled probe buffers of a decoded event into
+     *    pool storage.  The layout must match decodedEventStride.
+     * @param[out] event - event to set up.
+     * @param pStorage   - Where the event's probe storage starts.
+     * @param samples    - Maximum trace length.
+     */
+    void
+    VX2750Pha::carveDecodedBuffer(
+        DecodedEvent& event, std::uint8_t* pStorage, std::uint32_t samples
+    ) const
+    {
+        size_t aProbe = VX2750DecodedEventPool::roundUp(samples*sizeof(std::int32_t));
+        size_t dProbe = VX2750DecodedEventPool::roundUp(samples);
+        
+        if (m_dppPhaOptions.s_enableAnalogProbe1) {
+            event.s_pAnalogProbe1 = reinterpret_cast<std::int32_t*>(pStorage);
+            pStorage += aProbe;
+        }
+        if (m_dppPhaOptions.s_enableAnalogProbe2) {
+            event.s_pAnalogProbe2 = reinterpret_cast<std::int32_t*>(pStorage);
+            pStorage += aProbe;
+        }
+        if (m_dppPhaOptions.s_enableDigitalProbe1) {
+            event.s_pDigitalProbe1 = pStorage;
+            pStorage += dProbe;
+        }
+        if (m_dppPhaOptions.s_enableDigitalProbe2) {
+            event.s_pDigitalProbe2 = pStorage;
+            pStorage += dProbe;
+        }
+        if (m_dppPhaOptions.s_enableDigitalProbe3) {
+            event.s_pDigitalProbe3 = pStorage;
+            pStorage += dProbe;
+        }
+        if (m_dppPhaOptions.s_enableDigitalProbe4) {
+            event.s_pDigitalProbe4 = pStorage;
+            pStorage += dProbe;
+        }
+        event.s_pooled = true;
+    }
+    
     /**
      * dottedToInt
      *    Convert a dotted ip address to an integer.
@@ -24,6 +24,7 @@
 #ifndef VX2750PHA_H
 #define VX2750PHA_H
 #include "Dig2Device.h"
+#include "VX2750EnumTable.h"
 #include <string>
 #include <map>
 #include <vector>
@@ -31,6 +32,7 @@
 #include <json/json.h>
 
 namespace caen_nscldaq {
+class VX2750DecodedEventPool;
 /**
  * VX2750PHA - support for parameters in the VX2750.
  *             Since this derives from the Dig2Device class low level
@@ -297,6 +299,7 @@ public:
         bool           s_fail;                  // Always present.
         uint32_t       s_pad;                   // Maybe bool sizes differ?
         size_t         s_eventSize;             // s_enableEventSize
+        bool           s_pooled;                // Probes carved from a pool.
         
     } DecodedEvent, *pDecodedEvent;
     
@@ -342,29 +345,29 @@ public:
     };
     // These are useful for string based configuration modules.
     
-    static const  std::map<std::string, VX2750Pha::ClockSource> stringToClockSource;
-    static const  std::map<std::string, VX2750Pha::StartSource> stringToStartSource;
-    static const  std::map<std::string, VX2750Pha::GlobalTriggerSource> stringToGlobalTriggerSource;
-    static const  std::map<std::string, VX2750Pha::WaveTriggerSource> stringToWaveTrigger;
-    static const  std::map<std::string, VX2750Pha::EventTriggerSource> stringToEventTrigger;
-    static const  std::map<std::string, VX2750Pha::TRGOUTMode> stringToTRGOUT;
-    static const  std::map<std::string, VX2750Pha::GPIOMode>  stringToGPIO;
-    static const  std::map<std::string, VX2750Pha::BusyInSource> stringToBusyIn;
-    static const  std::map<std::string, VX2750Pha::SyncOutMode> stringToSyncOut;
-    static const  std::map<std::string , VX2750Pha::VetoSource>  stringToVeto;
-    static const  std::map<std::string, VX2750Pha::VetoPolarity> stringToVetoPolarity;
-    static const  std::map<std::string, VX2750Pha::ChannelVetoSource> stringToChannelVeto;
-    static const  std::map<std::string, VX2750Pha::WaveDataSource> stringToWaveDataSource;
-    static const  std::map<std::string, VX2750Pha::WaveResolution> stringToWaveResolution;
-    static const  std::map<std::string, VX2750Pha::AnalogProbe> stringToAnalogProbe;
-    static const  std::map<std::string, VX2750Pha::DigitalProbe> stringToDigitalProbe;
-    static const  std::map<std::string, VX2750Pha::IndividualTriggerLogic> stringToIndividualTriggerLogic;
-    static const  std::map<std::string, VX2750Pha::PairTriggerLogic> stringToPairLogic;
-    static const  std::map<std::string, VX2750Pha::ITLConnect> stringToITLConnect;
-    static const  std::map<std::string, VX2750Pha::LVDSMode> stringToLVDSMode;
-    static const  std::map<std::string, VX2750Pha::DACOutputMode> stringToDACOutMode;
-    static const  std::map<std::string, VX2750Pha::EventSelection> stringToEventSelection;
-    static const std::map<std::string, VX2750Pha::CoincidenceMask> stringToCoincidenceMask;
+    static const VX2750EnumTable<VX2750Pha::ClockSource> stringToClockSource;
+    static const VX2750EnumTable<VX2750Pha::StartSource> stringToStartSource;
+    static const VX2750EnumTable<VX2750Pha::GlobalTriggerSource> stringToGlobalTriggerSource;
+    static const VX2750EnumTable<VX2750Pha::WaveTriggerSource> stringToWaveTrigger;
+    static const VX2750EnumTable<VX2750Pha::EventTriggerSource> stringToEventTrigger;
+    static const VX2750EnumTable<VX2750Pha::TRGOUTMode> stringToTRGOUT;
+    static const VX2750EnumTable<VX2750Pha::GPIOMode> stringToGPIO;
+    static const VX2750EnumTable<VX2750Pha::BusyInSource> stringToBusyIn;
+    static const VX2750EnumTable<VX2750Pha::SyncOutMode> stringToSyncOut;
+    static const VX2750EnumTable<VX2750Pha::VetoSource> stringToVeto;
+    static const VX2750EnumTable<VX2750Pha::VetoPolarity> stringToVetoPolarity;
+    static const VX2750EnumTable<VX2750Pha::ChannelVetoSource> stringToChannelVeto;
+    static const VX2750EnumTable<VX2750Pha::WaveDataSource> stringToWaveDataSource;
+    static const VX2750EnumTable<VX2750Pha::WaveResolution> stringToWaveResolution;
+    static const VX2750EnumTable<VX2750Pha::AnalogProbe> stringToAnalogProbe;
+    static const VX2750EnumTable<VX2750Pha::DigitalProbe> stringToDigitalProbe;
+    static const VX2750EnumTable<VX2750Pha::IndividualTriggerLogic> stringToIndividualTriggerLogic;
+    static const VX2750EnumTable<VX2750Pha::PairTriggerLogic> stringToPairLogic;
+    static const VX2750EnumTable<VX2750Pha::ITLConnect> stringToITLConnect;
+    static const VX2750EnumTable<VX2750Pha::LVDSMode> stringToLVDSMode;
+    static const VX2750EnumTable<VX2750Pha::DACOutputMode> stringToDACOutMode;
+    static const VX2750EnumTable<VX2750Pha::EventSelection> stringToEventSelection;
+    static const VX2750EnumTable<VX2750Pha::CoincidenceMask> stringToCoincidenceMask;
     
     // InternalData.
 private:
@@ -696,13 +699,22 @@ public:
     
     void initDecodedBuffer(DecodedEvent& event);
     void setupDecodedBuffer(DecodedEvent& event);
+    void setupDecodedBuffer(DecodedEvent& event, VX2750DecodedEventPool& pool);
+    void setupDecodedBuffers(
+        DecodedEvent* pEvents, size_t nEvents, VX2750DecodedEventPool& pool
+    );
     void freeDecodedBuffer(DecodedEvent& event);
     
     
 private:
+    std::uint32_t maxRecordSamples() const;
+    size_t      decodedEventStride(std::uint32_t samples) const;
+    void        carveDecodedBuffer(
+        DecodedEvent& event, std::uint8_t* pStorage, std::uint32_t samples
+    ) const;
     uint32_t    dottedToInt(const std::string& dotted) const; 
-    template<class T> std::string enumToString(const std::map<T, std::string>& map, T value) const;
-    template<class T> T stringToEnum(const std::map<std::string, T>& map, const std::string& value) const;
+    template<class T> std::string enumToString(const VX2750EnumTable<T>& table, T value) const;
+    template<class T> T stringToEnum(const VX2750EnumTable<T>& table, const std::string& value) const;
     bool textToBool(const std::string& str) const;
     void checkInclusiveRange(int low, int high, int value) const;
     std::string appendNumber(const char* base, unsigned number) const;
@@ -722,9 +734,9 @@ private:
 /**
  * enumToString
  *    Given an enumerated value return the associated string.
- *    This is templated on the key of the conversion mapping.
- * @param map  - Map of enumerated value -> strings.
- * @param value - Value in the key type of the map
+ *    This is templated on the enumerated type of the table.
+ * @param table  - Conversion table for the enum.
+ * @param value - Enumerated value to convert.
  * @return std::string  - mapped string value.
  * @throw std::invalid_argument - lookup failure
  * @note it is possible for a lookup failure to occur given C/C++'s ability to
@@ -733,15 +745,15 @@ private:
  */
 template<class T>
 std::string
-VX2750Pha::enumToString(const std::map<T, std::string>&map, T value) const
+VX2750Pha::enumToString(const VX2750EnumTable<T>& table, T value) const
 {
-    auto p = map.find(value);
-    if (p == map.end()) {
+    auto p = table.name(value);
+    if (!p) {
         std::string msg = "Invalid lookup key passed to enumToString: ";
         msg += std::to_string(value);
-        throw std::invalid_argument("Invalid lookup key passed to enumToString");
+        throw std::invalid_argument(msg);
     }
-    return p->second;
+    return *p;
 }
 /**
  * stringToEnum
@@ -750,30 +762,20 @@ VX2750Pha::enumToString(const std::map<T, std::string>&map, T value) const
  *    but I'm too stupid to do that, and this provides
  *    a meaningful pair of method names which that would not
  *
- * @param map - mapping from string->enum.
- * @param value - String value to look up.
+ * @param table - conversion table for the enum.
+ * @param value - String value to look up (case blind).
  * @return T.
  * @throw std::invalid_argument if there's no mapping for the string
- * @note If the map has been constructed properly, there's less chance of throw
+ * @note If the table has been constructed properly, there's less chance of throw
  *       than in the previous method because the 'hardware's returning the
  *       strings that are getting tossed into this.
  */
 template<class T>
 T
-VX2750Pha::stringToEnum(const std::map<std::string, T>& map, const std::string& value) const
+VX2750Pha::stringToEnum(const VX2750EnumTable<T>& table, const std::string& value) const
 {
-    // Case blind fine of value in the string keys of the map:
-    
-    auto p = map.begin();
-    std::string needle = toUpper(value);
-    while (p != map.end()) {
-        if (toUpper(p->first) == needle) {
-            break;
-        }
-        ++p;
-    }
-    
-    if (p == map.end()) {
+    auto p = table.find(value);
+    if (!p) {
         // We can also be a bit more detailed in our message:
         
         std::string msg("Invalid lookup key passed to stringtoenum : ");
@@ -0,0 +1,410 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ReadoutStatistics.cpp
+* @brief    Implement the readout statistics classes.
+* @author   Ron Fox
+*
+*/
+#include "VX2750ReadoutStatistics.h"
+#include <limits>
+
+namespace caen_nscldaq {
+
+VX2750ReadoutStatistics* VX2750ReadoutStatistics::m_pInstance(nullptr);
+
+/**
+ * since
+ *    @param later   - a count.
+ *    @param earlier - the same count at an earlier time.
+ *    @return std::uint64_t - the increase in the count.  If the count went
+ *            down it was reset in between and later is the increase since
+ *            the reset.
+ */
+static inline std::uint64_t
+since(std::uint64_t later, std::uint64_t earlier)
+{
+    return later >= earlier ? later - earlier : later;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VX2750LatencyHistogram implementation.
+
+/**
+ * constructor
+ *    Start with an empty histogram.
+ */
+VX2750LatencyHistogram::VX2750LatencyHistogram()
+{
+    reset();
+}
+/**
+ * snapshot
+ *    @return Snapshot - a copy of the current histogram.  Since the recording
+ *            thread may be running, the total count and sum may be a hit or
+ *            so off from the channel counts.
+ */
+VX2750LatencyHistogram::Snapshot
+VX2750LatencyHistogram::snapshot() const
+{
+    Snapshot result;
+    for (int i = 0; i < CHANNELS; i++) {
+        result.s_counts[i] = m_counts[i].load(std::memory_order_relaxed);
+    }
+    result.s_count = m_count.load(std::memory_order_relaxed);
+    result.s_sum   = m_sum.load(std::memory_order_relaxed);
+    return result;
+}
+/**
+ * reset
+ *    Clear the histogram.  Counts recorded while the reset is in progress
+ *    may or may not survive it but none are lost or double counted.
+ */
+void
+VX2750LatencyHistogram::reset()
+{
+    for (int i = 0; i < CHANNELS; i++) {
+        m_counts[i].exchange(0, std::memory_order_relaxed);
+    }
+    m_count.exchange(0, std::memory_order_relaxed);
+    m_sum.exchange(0, std::memory_order_relaxed);
+}
+/**
+ * channel
+ *    @param ns - a latency.
+ *    @return unsigned - the channel it's counted in.
+ */
+unsigned
+VX2750LatencyHistogram::channel(std::uint64_t ns)
+{
+    if (ns < SUB_COUNT) return ns;
+
+    unsigned magnitude = 63 - __builtin_clzll(ns);    // Index of the top bit.
+    if (magnitude > MAX_BITS) return CHANNELS - 1;
+
+    unsigned sub = (ns >> (magnitude - SUB_BITS)) & (SUB_COUNT - 1);
+    return (magnitude - SUB_BITS + 1)*SUB_COUNT + sub;
+}
+/**
+ * lowEdge
+ *    @param channel - a histogram channel.
+ *    @return std::uint64_t - the smallest latency counted in that channel.
+ */
+std::uint64_t
+VX2750LatencyHistogram::lowEdge(unsigned channel)
+{
+    unsigned block = channel / SUB_COUNT;
+    std::uint64_t sub = channel % SUB_COUNT;
+    if (block == 0) return channel;
+
+    unsigned magnitude = block + SUB_BITS - 1;
+    return (SUB_COUNT + sub) << (magnitude - SUB_BITS);
+}
+/**
+ * highEdge
+ *    @param channel - a histogram channel.
+ *    @return std::uint64_t - the largest latency counted in that channel.
+ *            The top channel is open ended so we give its low edge.
+ */
+std::uint64_t
+VX2750LatencyHistogram::highEdge(unsigned channel)
+{
+    if (channel >= CHANNELS - 1) return lowEdge(CHANNELS - 1);
+    return lowEdge(channel + 1) - 1;
+}
+
+/**
+ * Snapshot constructor
+ *    Empty histogram.
+ */
+VX2750LatencyHistogram::Snapshot::Snapshot() :
+    s_counts(CHANNELS, 0), s_count(0), s_sum(0)
+{}
+/**
+ * Snapshot::operator-
+ *    @param rhs - an earlier snapshot of the same histogram.
+ *    @return Snapshot - the histogram of what was recorded between rhs and
+ *            this snapshot (see since for counts that were reset).
+ */
+VX2750LatencyHistogram::Snapshot
+VX2750LatencyHistogram::Snapshot::operator-(const Snapshot& rhs) const
+{
+    Snapshot result;
+    for (int i = 0; i < CHANNELS; i++) {
+        result.s_counts[i] = since(s_counts[i], rhs.s_counts[i]);
+    }
+    result.s_count = since(s_count, rhs.s_count);
+    result.s_sum   = since(s_sum, rhs.s_sum);
+    return result;
+}
+/**
+ * Snapshot::percentile
+ *    @param p - percentile in the range [0, 100].
+ *    @return std::uint64_t - latency at or below which p percent of the
+ *            counts lie.  This is the high edge of the channel so it may
+ *            overestimate by up to 1/16.  0 if the histogram is empty.
+ */
+std::uint64_t
+VX2750LatencyHistogram::Snapshot::percentile(double p) const
+{
+    std::uint64_t total = 0;
+    for (auto n : s_counts) total += n;
+    if (total == 0) return 0;
+
+    std::uint64_t needed = static_cast<std::uint64_t>(total * p / 100.0 + 0.5);
+    if (needed == 0) needed = 1;
+    if (needed > total) needed = total;
+
+    std::uint64_t sum = 0;
+    for (int i = 0; i < CHANNELS; i++) {
+        sum += s_counts[i];
+        if (sum >= needed) return highEdge(i);
+    }
+    return highEdge(CHANNELS - 1);                 // Can't get here.
+}
+/**
+ * Snapshot::max
+ *    @return std::uint64_t - high edge of the highest nonempty channel.
+ */
+std::uint64_t
+VX2750LatencyHistogram::Snapshot::max() const
+{
+    for (int i = CHANNELS - 1; i >= 0; i--) {
+        if (s_counts[i]) return highEdge(i);
+    }
+    return 0;
+}
+/**
+ * Snapshot::mean
+ *    @return std::uint64_t - mean latency (exact, not binned).
+ */
+std::uint64_t
+VX2750LatencyHistogram::Snapshot::mean() const
+{
+    return s_count ? s_sum / s_count : 0;
+}
+///////////////////////////////////////////////////////////////////////////////
+// VX2750ModuleStatistics implementation.
+
+/**
+ * constructor
+ */
+VX2750ModuleStatistics::VX2750ModuleStatistics() :
+    m_generation(0)
+{
+    reset();
+}
+/**
+ * poll
+ *    Record a check of the module for data.
+ * @param ns - time taken by the check.
+ * @param triggered - true if the module had data.
+ */
+void
+VX2750ModuleStatistics::poll(std::uint64_t ns, bool triggered)
+{
+    bump(m_polls, 1);
+    if (triggered) bump(m_triggers, 1);
+    m_latencies[Poll].record(ns);
+}
+/**
+ * hit
+ *    Record the read of a hit.
+ * @param readNs - time to read the hit from the digitizer.
+ * @param formatNs - time to format it into the event buffer.
+ * @param bytes    - bytes of event data the hit produced.
+ */
+void
+VX2750ModuleStatistics::hit(std::uint64_t readNs, std::uint64_t formatNs, std::size_t bytes)
+{
+    bump(m_hits, 1);
+    bump(m_bytes, bytes);
+    m_latencies[Read].record(readNs);
+    m_latencies[Format].record(formatNs);
+}
+/**
+ * timeouts
+ *    @param n - number of read timeouts to add to the count.
+ */
+void
+VX2750ModuleStatistics::timeouts(std::uint64_t n)
+{
+    if (n) bump(m_timeouts, n);
+}
+/**
+ * snapshot
+ *    @return Snapshot - copy of the current statistics.
+ */
+VX2750ModuleStatistics::Snapshot
+VX2750ModuleStatistics::snapshot() const
+{
+    Snapshot result;
+    result.s_generation = m_generation.load(std::memory_order_acquire);
+    result.s_polls    = m_polls.load(std::memory_order_relaxed);
+    result.s_triggers = m_triggers.load(std::memory_order_relaxed);
+    result.s_hits     = m_hits.load(std::memory_order_relaxed);
+    result.s_bytes    = m_bytes.load(std::memory_order_relaxed);
+    result.s_timeouts = m_timeouts.load(std::memory_order_relaxed);
+    for (int i = 0; i < STAGES; i++) {
+        result.s_latencies[i] = m_latencies[i].snapshot();
+    }
+    return result;
+}
+/**
+ * interval
+ *    The statistics since an earlier snapshot, which becomes the current
+ *    one.  If the statistics were reset since prior, the interval starts
+ *    at the reset.
+ * @param prior - snapshot taken at the start of the interval.  On return it
+ *                is the snapshot taken at the end of the interval.
+ * @return Snapshot - what happened in the interval.
+ */
+VX2750ModuleStatistics::Snapshot
+VX2750ModuleStatistics::interval(Snapshot& prior) const
+{
+    Snapshot now = snapshot();
+    Snapshot result = now.s_generation == prior.s_generation ? now - prior : now;
+    prior = now;
+    return result;
+}
+/**
+ * reset
+ *    Zero the counters and histograms and start a new generation.
+ */
+void
+VX2750ModuleStatistics::reset()
+{
+    m_polls.exchange(0, std::memory_order_relaxed);
+    m_triggers.exchange(0, std::memory_order_relaxed);
+    m_hits.exchange(0, std::memory_order_relaxed);
+    m_bytes.exchange(0, std::memory_order_relaxed);
+    m_timeouts.exchange(0, std::memory_order_relaxed);
+    for (int i = 0; i < STAGES; i++) {
+        m_latencies[i].reset();
+    }
+    m_generation.fetch_add(1, std::memory_order_release);
+}
+/**
+ * stageName
+ *    @param stage - a readout stage.
+ *    @return const char* - its name as used by the vx2750stats command.
+ */
+const char*
+VX2750ModuleStatistics::stageName(Stage stage)
+{
+    switch (stage) {
+    case Poll:
+        return "poll";
+    case Read:
+        return "read";
+    case Format:
+        return "format";
+    default:
+        return "unknown";
+    }
+}
+/**
+ * Snapshot::operator-
+ *    @param rhs - an earlier snapshot.
+ *    @return Snapshot - what happened between rhs and this (see since for
+ *            counts that were reset).
+ */
+VX2750ModuleStatistics::Snapshot
+VX2750ModuleStatistics::Snapshot::operator-(const Snapshot& rhs) const
+{
+    Snapshot result;
+    result.s_generation = s_generation;
+    result.s_polls    = since(s_polls, rhs.s_polls);
+    result.s_triggers = since(s_triggers, rhs.s_triggers);
+    result.s_hits     = since(s_hits, rhs.s_hits);
+    result.s_bytes    = since(s_bytes, rhs.s_bytes);
+    result.s_timeouts = since(s_timeouts, rhs.s_timeouts);
+    for (int i = 0; i < STAGES; i++) {
+        result.s_latencies[i] = s_latencies[i] - rhs.s_latencies[i];
+    }
+    return result;
+}
+///////////////////////////////////////////////////////////////////////////////
+// VX2750ReadoutStatistics implementation.
+
+/**
+ * getInstance
+ *    @return VX2750ReadoutStatistics& - the one and only instance.
+ */
+VX2750ReadoutStatistics&
+VX2750ReadoutStatistics::getInstance()
+{
+    static std::once_flag created;
+    std::call_once(created, []() { m_pInstance = new VX2750ReadoutStatistics; });
+    return *m_pInstance;
+}
+/**
+ * getModule
+ *    @param name - module name.
+ *    @return VX2750ModuleStatistics& - that module's statistics, created
+ *            if need be.  The reference remains valid for the life of the
+ *            program.
+ */
+VX2750ModuleStatistics&
+VX2750ReadoutStatistics::getModule(const std::string& name)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto& p = m_modules[name];
+    if (!p) p.reset(new VX2750ModuleStatistics);
+    return *p;
+}
+/**
+ * findModule
+ *    @param name - module name.
+ *    @return VX2750ModuleStatistics* - the module's statistics or nullptr if
+ *            it has none.
+ */
+VX2750ModuleStatistics*
+VX2750ReadoutStatistics::findModule(const std::string& name)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto p = m_modules.find(name);
+    return p == m_modules.end() ? nullptr : p->second.get();
+}
+/**
+ * listModules
+ *    @return std::vector<std::string> - names of modules with statistics.
+ */
+std::vector<std::string>
+VX2750ReadoutStatistics::listModules()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    std::vector<std::string> result;
+    for (auto& m : m_modules) {
+        result.push_back(m.first);
+    }
+    return result;
+}
+/**
+ * reset
+ *    Reset the statistics of all modules.
+ */
+void
+VX2750ReadoutStatistics::reset()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    for (auto& m : m_modules) {
+        m.second->reset();
+    }
+}
+}                                     // caen_nscldaq namespace
@@ -0,0 +1,195 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750ReadoutStatistics.h
+* @brief    Per module, per stage readout counters and latency histograms.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750READOUTSTATISTICS_H
+#define VX2750READOUTSTATISTICS_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace caen_nscldaq {
+/**
+ * @class VX2750LatencyHistogram
+ *    A log-linear (HDR style) histogram of nanosecond latencies.  Values
+ *    below 2^SUB_BITS have a channel each.  Above that, each power of two
+ *    is split into 2^SUB_BITS channels so the channel width is never
+ *    more than 1/16 of the value.  Values past the top channel land in it.
+ *
+ *    There must be only one thread that records into a histogram (the
+ *    readout thread).  Since the counts are atomic, other threads can
+ *    take snapshots of it at any time without locking.
+ */
+class VX2750LatencyHistogram {
+public:
+    static const unsigned SUB_BITS  = 4;
+    static const unsigned SUB_COUNT = 1 << SUB_BITS;
+    static const unsigned MAX_BITS  = 40;            // 2^40ns is about 18 minutes.
+    static const unsigned CHANNELS  = (MAX_BITS - SUB_BITS + 2) * SUB_COUNT;
+
+    /**
+     * Snapshot
+     *    A copy of the histogram at some point in time.  Subtracting an
+     *    earlier snapshot from a later one gives the histogram for the
+     *    interval between them.  A count that went down was reset in the
+     *    interval; its later value is what was recorded since the reset.
+     */
+    struct Snapshot {
+        std::vector<std::uint64_t> s_counts;
+        std::uint64_t              s_count;
+        std::uint64_t              s_sum;
+
+        Snapshot();
+        Snapshot operator-(const Snapshot& rhs) const;
+        std::uint64_t percentile(double p) const;
+        std::uint64_t max() const;
+        std::uint64_t mean() const;
+    };
+private:
+    std::atomic<std::uint64_t> m_counts[CHANNELS];
+    std::atomic<std::uint64_t> m_count;
+    std::atomic<std::uint64_t> m_sum;
+public:
+    VX2750LatencyHistogram();
+
+    /**
+     * record
+     *    Count a latency.  The counts are incremented atomically so a
+     *    reset from another thread is never undone by a recording in
+     *    progress.
+     * @param ns - the latency.
+     */
+    void record(std::uint64_t ns) {
+        bump(m_counts[channel(ns)], 1);
+        bump(m_count, 1);
+        bump(m_sum, ns);
+    }
+    Snapshot snapshot() const;
+    void reset();
+
+    static unsigned channel(std::uint64_t ns);
+    static std::uint64_t lowEdge(unsigned channel);
+    static std::uint64_t highEdge(unsigned channel);
+private:
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @class VX2750ModuleStatistics
+ *    The statistics kept for one module:
+ *    -  Counters: polls of the module for data, polls that found data,
+ *       hits read, bytes of event data produced and read timeouts.
+ *    -  Latency histograms for each stage of the readout: the poll
+ *       (CAEN_FELib_HasData), the read of a hit from the digitizer and
+ *       formatting that hit into the event buffer.
+ *
+ *    As with the histograms, only the readout thread records.  Each reset
+ *    increments the generation so that the difference of snapshots taken
+ *    on either side of a reset can be recognized.
+ */
+class VX2750ModuleStatistics {
+public:
+    typedef enum _Stage {
+        Poll, Read, Format,
+        STAGES                            // Must be last.
+    } Stage;
+
+    struct Snapshot {
+        std::uint64_t s_generation;       // Resets before the snapshot.
+        std::uint64_t s_polls;
+        std::uint64_t s_triggers;
+        std::uint64_t s_hits;
+        std::uint64_t s_bytes;
+        std::uint64_t s_timeouts;
+        VX2750LatencyHistogram::Snapshot s_latencies[STAGES];
+
+        Snapshot operator-(const Snapshot& rhs) const;
+    };
+private:
+    std::atomic<std::uint64_t> m_generation;
+    std::atomic<std::uint64_t> m_polls;
+    std::atomic<std::uint64_t> m_triggers;
+    std::atomic<std::uint64_t> m_hits;
+    std::atomic<std::uint64_t> m_bytes;
+    std::atomic<std::uint64_t> m_timeouts;
+    VX2750LatencyHistogram     m_latencies[STAGES];
+public:
+    VX2750ModuleStatistics();
+
+    void poll(std::uint64_t ns, bool triggered);
+    void hit(std::uint64_t readNs, std::uint64_t formatNs, std::size_t bytes);
+    void timeouts(std::uint64_t n);
+
+    Snapshot snapshot() const;
+    Snapshot interval(Snapshot& prior) const;
+    void reset();
+
+    static const char* stageName(Stage stage);
+
+    /**
+     * now
+     *    @return std::uint64_t - monotonic clock in ns; only differences
+     *           are meaningful.
+     */
+    static std::uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+private:
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @class VX2750ReadoutStatistics
+ *    The set of module statistics, indexed by module name.  The
+ *    statistics for a module are created the first time they're asked for
+ *    and live as long as the program so they accumulate across runs and
+ *    configuration changes (which re-create the event segments).
+ */
+class VX2750ReadoutStatistics {
+private:
+    static VX2750ReadoutStatistics* m_pInstance;
+    std::mutex m_lock;
+    std::map<std::string, std::unique_ptr<VX2750ModuleStatistics>> m_modules;
+public:
+    static VX2750ReadoutStatistics& getInstance();
+
+    VX2750ModuleStatistics& getModule(const std::string& name);
+    VX2750ModuleStatistics* findModule(const std::string& name);
+    std::vector<std::string> listModules();
+    void reset();
+private:
+    VX2750ReadoutStatistics() {}
+};
+}                                     // caen_nscldaq namespace
+#endif
@@ -0,0 +1,206 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750StatisticsCommand.cpp
+* @brief    Implement the vx2750stats command.
+* @author   Ron Fox
+*
+*/
+#include "VX2750StatisticsCommand.h"
+#include <TCLObject.h>
+#include <TCLInterpreter.h>
+#include <tcl.h>
+#include <stdexcept>
+#include <sstream>
+
+namespace caen_nscldaq {
+/**
+ * constructor
+ *    Register the command with the interpreter:
+ *  @param interp - interpreter on which the command will be registered.
+ *  @param pName  - Name of the command.
+ */
+VX2750StatisticsCommand::VX2750StatisticsCommand(
+    CTCLInterpreter& interp, const char* pName
+) :
+    CTCLObjectProcessor(interp, pName, TCLPLUS::kfTRUE)
+{}
+/**
+ * destructor
+ *    The statistics aren't ours so there's nothing to do.
+ */
+VX2750StatisticsCommand::~VX2750StatisticsCommand()
+{}
+
+/**
+ * operator()
+ *    Called when the command is executed.
+ *  @param interp -interpreter running the command.
+ *  @param objv  - command words.
+ *  @return int TCL_OK - successs, TCL_ERROR failure.
+ */
+int
+VX2750StatisticsCommand::operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv)
+{
+    bindAll(interp, objv);
+    try {
+        requireAtLeast(objv, 2, "Insufficient command parameters");
+        std::string subcommand = objv[1];
+
+        if (subcommand == "list") {
+            list(interp, objv);
+        } else if (subcommand == "get") {
+            get(interp, objv);
+        } else if (subcommand == "reset") {
+            reset(interp, objv);
+        } else {
+            std::string msg = "Unrecognized subcommand: ";
+            msg += subcommand;
+            throw msg;
+        }
+    }
+    catch (std::string msg) {
+        interp.setResult(msg);
+        return TCL_ERROR;
+    }
+    catch (std::exception& e) {
+        interp.setResult(e.what());
+        return TCL_ERROR;
+    }
+    return TCL_OK;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Subcommands.
+
+/**
+ * list
+ *    Result is the list of modules that have statistics.
+ * @param interp - references the interpreter running the command.
+ * @param obvj   - the encapsulated command words.
+ */
+void
+VX2750StatisticsCommand::list(CTCLInterpreter& interp, std::vector<CTCLObject>& objv)
+{
+    requireExactly(objv, 2, "Incorrect number of command parameters");
+
+    CTCLObject result;
+    result.Bind(interp);
+    for (auto& name : VX2750ReadoutStatistics::getInstance().listModules()) {
+        result += name;
+    }
+    interp.setResult(result);
+}
+/**
+ * get
+ *    Result is the statistics of one module (see the header for the format).
+ * @param interp - references the interpreter running the command.
+ * @param obvj   - the encapsulated command words.
+ */
+void
+VX2750StatisticsCommand::get(CTCLInterpreter& interp, std::vector<CTCLObject>& objv)
+{
+    requireExactly(objv, 3, "Incorrect number of command parameters");
+    std::string name = objv[2];
+    auto stats = getStatisticsOrThrow(name)->snapshot();
+
+    CTCLObject result;
+    result.Bind(interp);
+    addItem(interp, result, "polls", stats.s_polls);
+    addItem(interp, result, "triggers", stats.s_triggers);
+    addItem(interp, result, "hits", stats.s_hits);
+    addItem(interp, result, "bytes", stats.s_bytes);
+    addItem(interp, result, "timeouts", stats.s_timeouts);
+
+    for (int i = 0; i < VX2750ModuleStatistics::STAGES; i++) {
+        auto& h(stats.s_latencies[i]);
+        CTCLObject latencies;
+        latencies.Bind(interp);
+        addItem(interp, latencies, "count", h.s_count);
+        addItem(interp, latencies, "mean", h.mean());
+        addItem(interp, latencies, "p50", h.percentile(50.0));
+        addItem(interp, latencies, "p90", h.percentile(90.0));
+        addItem(interp, latencies, "p99", h.percentile(99.0));
+        addItem(interp, latencies, "max", h.max());
+
+        result += VX2750ModuleStatistics::stageName(
+            static_cast<VX2750ModuleStatistics::Stage>(i)
+        );
+        result += latencies;
+    }
+    interp.setResult(result);
+}
+/**
+ * reset
+ *    Zero the statistics of one module or, if no module is given, all of them.
+ * @param interp - references the interpreter running the command.
+ * @param obvj   - the encapsulated command words.
+ */
+void
+VX2750StatisticsCommand::reset(CTCLInterpreter& interp, std::vector<CTCLObject>& objv)
+{
+    if (objv.size() != 2 && objv.size() != 3) {
+        throw std::string("Incorrect number of command parameters");
+    }
+    if (objv.size() == 3) {
+        std::string name = objv[2];
+        getStatisticsOrThrow(name)->reset();
+    } else {
+        VX2750ReadoutStatistics::getInstance().reset();
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utils.
+
+/**
+ * addItem
+ *    Append a name and a value to a dict-like list.  The values can be
+ *    bigger than a Tcl int so they're added as strings.
+ * @param interp - interpreter.
+ * @param list   - list to append to.
+ * @param name   - item name.
+ * @param value  - item value.
+ */
+void
+VX2750StatisticsCommand::addItem(
+    CTCLInterpreter& interp, CTCLObject& list, const char* name,
+    std::uint64_t value
+)
+{
+    std::stringstream strValue;
+    strValue << value;
+    list += name;
+    list += strValue.str();
+}
+/**
+ * getStatisticsOrThrow
+ *    @param name - module name.
+ *    @return VX2750ModuleStatistics* - its statistics.
+ *    @throw std::string - the module has no statistics.
+ */
+VX2750ModuleStatistics*
+VX2750StatisticsCommand::getStatisticsOrThrow(const std::string& name)
+{
+    auto pStats = VX2750ReadoutStatistics::getInstance().findModule(name);
+    if (!pStats) {
+        std::string message = "No statistics for module: ";
+        message += name;
+        throw message;
+    }
+    return pStats;
+}
+}                                     // caen_nscldaq namespace
@@ -0,0 +1,67 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750StatisticsCommand.h
+* @brief    Tcl command to inspect the readout statistics.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750STATISTICSCOMMAND_H
+#define VX2750STATISTICSCOMMAND_H
+#include <TCLObjectProcessor.h>
+#include <vector>
+#include "VX2750ReadoutStatistics.h"
+
+class CTCLInterpreter;
+class CTCLObject;
+
+namespace caen_nscldaq {
+/**
+ * @class VX2750StatisticsCommand
+ *    Tcl command that gives access to the readout statistics kept in
+ *    VX2750ReadoutStatistics.  Normally registered in the Readout
+ *    program's interpreter as vx2750stats:
+ *
+ *  vx2750stats list          - Names of modules that have statistics.
+ *  vx2750stats get name      - Statistics of a module.
+ *  vx2750stats reset ?name?  - Zero the statistics of one or all modules.
+ *
+ *  get returns a dict-like list: polls, triggers, hits, bytes and timeouts
+ *  counters followed by poll, read and format each of which is a dict-like
+ *  list of the latency distribution: count mean p50 p90 p99 max (ns).
+ */
+class VX2750StatisticsCommand : public ::CTCLObjectProcessor
+{
+public:
+    VX2750StatisticsCommand(CTCLInterpreter& interp, const char* pName);
+    virtual ~VX2750StatisticsCommand();
+
+    int operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
+private:
+    void list(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
+    void get(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
+    void reset(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
+
+    static void addItem(
+        CTCLInterpreter& interp, CTCLObject& list, const char* name,
+        std::uint64_t value
+    );
+    static VX2750ModuleStatistics* getStatisticsOrThrow(const std::string& name);
+};
+}                                     // caen_nscldaq namespace
+#endif
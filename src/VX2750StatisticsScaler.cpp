@@ -0,0 +1,116 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750StatisticsScaler.cpp
+* @brief    Implement the statistics scaler.
+* @author   Ron Fox
+*
+*/
+#include "VX2750StatisticsScaler.h"
+
+namespace caen_nscldaq {
+/**
+ * constructor
+ *    No modules yet.
+ */
+VX2750StatisticsScaler::VX2750StatisticsScaler()
+{}
+/**
+ * destructor
+ *    The statistics belong to VX2750ReadoutStatistics.
+ */
+VX2750StatisticsScaler::~VX2750StatisticsScaler()
+{}
+/**
+ * addModule
+ *    Add a module to the set whose statistics are read.
+ *  @param name - module name (as given to TclConfiguredReadout::addModule).
+ */
+void
+VX2750StatisticsScaler::addModule(const char* name)
+{
+    Module m;
+    m.s_pStatistics = &(VX2750ReadoutStatistics::getInstance().getModule(name));
+    m.s_prior       = m.s_pStatistics->snapshot();
+    m_modules.push_back(m);
+}
+/**
+ * initialize
+ *    Called at the beginning of a run.  Nothing to do since clear
+ *    sets the interval start.
+ */
+void
+VX2750StatisticsScaler::initialize()
+{}
+/**
+ * clear
+ *    Start a new interval.
+ */
+void
+VX2750StatisticsScaler::clear()
+{
+    for (auto& m : m_modules) {
+        m.s_prior = m.s_pStatistics->snapshot();
+    }
+}
+/**
+ * disable
+ *    Nothing to turn off.
+ */
+void
+VX2750StatisticsScaler::disable()
+{}
+/**
+ * read
+ *    @return std::vector<uint32_t> - the statistics for the interval since
+ *            the last read/clear (see the header for the layout).
+ */
+std::vector<uint32_t>
+VX2750StatisticsScaler::read()
+{
+    std::vector<uint32_t> result;
+    result.reserve(m_modules.size() * VALUES_PER_MODULE);
+
+    for (auto& m : m_modules) {
+        auto interval = m.s_pStatistics->interval(m.s_prior);
+
+        result.push_back(clamp(interval.s_polls));
+        result.push_back(clamp(interval.s_triggers));
+        result.push_back(clamp(interval.s_hits));
+        result.push_back(clamp(interval.s_bytes));
+        result.push_back(clamp(interval.s_timeouts));
+        for (int i = 0; i < VX2750ModuleStatistics::STAGES; i++) {
+            auto& h(interval.s_latencies[i]);
+            result.push_back(clamp(h.percentile(50.0)));
+            result.push_back(clamp(h.percentile(99.0)));
+            result.push_back(clamp(h.max()));
+        }
+    }
+    return result;
+}
+/**
+ * clamp
+ *    @param value - a 64 bit value.
+ *    @return uint32_t - value or 0xffffffff if it won't fit.
+ */
+uint32_t
+VX2750StatisticsScaler::clamp(std::uint64_t value)
+{
+    return value > 0xffffffff ? 0xffffffff : value;
+}
+}                                     // caen_nscldaq namespace
@@ -0,0 +1,76 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750StatisticsScaler.h
+* @brief    Periodically emit the readout statistics as scalers.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750STATISTICSSCALER_H
+#define VX2750STATISTICSSCALER_H
+#include <CScaler.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "VX2750ReadoutStatistics.h"
+
+namespace caen_nscldaq {
+/**
+ * @class VX2750StatisticsScaler
+ *    A scaler 'module' that reads the readout statistics of a set of
+ *    digitizers.  Registered with the experiment's scaler bank, the
+ *    statistics are written to the data stream with each periodic
+ *    scaler ring item.  Scalers are increments since the previous read
+ *    (or since a vx2750stats reset if there was one after that read).
+ *    For each module, in the order they were added, there are
+ *    VALUES_PER_MODULE values:
+ *
+ *    -  polls, triggers, hits, bytes, timeouts in the interval.
+ *    -  For each of the poll, read and format stages, the median,
+ *       99'th percentile and maximum latency in the interval in ns.
+ *
+ *    Values that don't fit in 32 bits are written as 0xffffffff.
+ */
+class VX2750StatisticsScaler : public ::CScaler
+{
+public:
+    static const unsigned COUNTERS = 5;
+    static const unsigned LATENCIES_PER_STAGE = 3;
+    static const unsigned VALUES_PER_MODULE =
+        COUNTERS + VX2750ModuleStatistics::STAGES * LATENCIES_PER_STAGE;
+private:
+    struct Module {
+        VX2750ModuleStatistics*          s_pStatistics;
+        VX2750ModuleStatistics::Snapshot s_prior;
+    };
+    std::vector<Module> m_modules;
+public:
+    VX2750StatisticsScaler();
+    virtual ~VX2750StatisticsScaler();
+
+    void addModule(const char* name);
+
+    virtual void initialize();
+    virtual void clear();
+    virtual void disable();
+    virtual std::vector<uint32_t> read();
+private:
+    static uint32_t clamp(std::uint64_t value);
+};
+}                                     // caen_nscldaq namespace
+#endif
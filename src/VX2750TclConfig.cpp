@@ -124,6 +124,23 @@ VX2750TclConfig::listModules()
     );
     return result;
 }
+/**
+ * addModule
+ *    Add an already built configuration (e.g. one restored from a
+ *    configuration snapshot).
+ * @param name - name of the module.
+ * @param pConfig - configuration, which we now own.
+ * @throw std::string - duplicate configuration name (pConfig is deleted).
+ */
+void
+VX2750TclConfig::addModule(const std::string& name, VX2750PHAModuleConfiguration* pConfig)
+{
+    if (m_modules.count(name) > 0) {
+        delete pConfig;
+        throw std::string("Duplicate configuration name");
+    }
+    m_modules[name] = pConfig;
+}
 //////////////////////////////////////////////////////////////////////////////
 /**
  * create
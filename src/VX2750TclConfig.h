@@ -57,6 +57,7 @@ public:
     int operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
     VX2750PHAModuleConfiguration* getModule(const char* pName);
     std::vector<std::string> listModules();
+    void addModule(const std::string& name, VX2750PHAModuleConfiguration* pConfig);
     
 private:
     void create(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
@@ -0,0 +1,327 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750TimeIndex.cpp
+* @brief    Implement the event file index reader.
+* @author   Ron Fox
+*
+*/
+#include "VX2750TimeIndex.h"
+#include <stdexcept>
+#include <system_error>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace caen_offline {
+
+const char          VX2750TimeIndex::MAGIC[8] = {'V', 'X', '2', '7', '5', '0', 'T', '1'};
+const std::uint32_t VX2750TimeIndex::VERSION;
+const std::uint32_t VX2750TimeIndex::MODULE_RECORD;
+const std::uint32_t VX2750TimeIndex::BLOCK_RECORD;
+
+static const unsigned ANY_CHANNEL = ~0U;
+
+/**
+ * constructor
+ *    Read an index.
+ *  @param filename - the index file.
+ *  @throw std::system_error - the file can't be opened or read.
+ *  @throw std::runtime_error - the file isn't an index or is corrupt.
+ */
+VX2750TimeIndex::VX2750TimeIndex(const char* filename) :
+    m_filename(filename), m_blockBytes(0), m_validBytes(0)
+{
+    refresh();
+    if (m_validBytes == 0) {
+        invalid("too small");
+    }
+}
+/**
+ * destructor
+ */
+VX2750TimeIndex::~VX2750TimeIndex()
+{}
+/**
+ * indexedBytes
+ *    @return std::uint64_t - how much of the event file is indexed; the
+ *            end of the last block.
+ */
+std::uint64_t
+VX2750TimeIndex::indexedBytes() const
+{
+    return m_blocks.empty() ? 0 : m_blocks.back().s_end;
+}
+/**
+ * refresh
+ *    Read the records appended to the file since it was last read.
+ *  @return std::size_t - number of new blocks.
+ *  @throw std::system_error - the file can't be read.
+ *  @throw std::runtime_error - the file is corrupt or shrank.
+ */
+std::size_t
+VX2750TimeIndex::refresh()
+{
+    int fd = open(m_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), m_filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info)) {
+        int e = errno;
+        close(fd);
+        throw std::system_error(e, std::generic_category(), m_filename);
+    }
+    std::uint64_t size = info.st_size;
+    if (size < m_validBytes) {
+        close(fd);
+        invalid("the file shrank");
+    }
+    std::vector<std::uint8_t> data(size - m_validBytes);
+    std::size_t n = 0;
+    while (n < data.size()) {
+        ssize_t nRead = pread(fd, data.data() + n, data.size() - n, m_validBytes + n);
+        if (nRead < 0 && errno == EINTR) continue;
+        if (nRead < 0) {
+            int e = errno;
+            close(fd);
+            throw std::system_error(e, std::generic_category(), m_filename);
+        }
+        if (nRead == 0) break;                  // Truncated under us.
+        n += nRead;
+    }
+    close(fd);
+
+    std::size_t blocks = m_blocks.size();
+    m_validBytes += parse(data.data(), n);
+    return m_blocks.size() - blocks;
+}
+/**
+ * findModule
+ *   @param name - a module name.
+ *   @return int - its id or -1 if it has no hits in the indexed data.
+ */
+int
+VX2750TimeIndex::findModule(const std::string& name) const
+{
+    for (std::size_t i = 0; i < m_modules.size(); i++) {
+        if (m_modules[i] == name) return i;
+    }
+    return -1;
+}
+/**
+ * findTime
+ *    Find the parts of the event file that may have hits in a time window.
+ *  @param from, to - the window in ns (inclusive).
+ *  @return std::vector<VX2750EventFile::Chunk> - the ranges of ring items
+ *          whose hits overlap the window, in file order.  Adjacent blocks
+ *          are merged.
+ */
+std::vector<VX2750EventFile::Chunk>
+VX2750TimeIndex::findTime(std::uint64_t from, std::uint64_t to) const
+{
+    return select(from, to, -1, ANY_CHANNEL);
+}
+/**
+ * findChannel
+ *    Find the parts of the event file that have hits from a channel.
+ *  @param module  - module name.
+ *  @param channel - channel number.
+ *  @return std::vector<VX2750EventFile::Chunk> - the ranges, in file order.
+ */
+std::vector<VX2750EventFile::Chunk>
+VX2750TimeIndex::findChannel(const std::string& module, unsigned channel) const
+{
+    return find(0, ~std::uint64_t(0), module, channel);
+}
+/**
+ * find
+ *    Find the parts of the event file that may have hits from a channel
+ *    within a time window.  Block time ranges are for all of a block's hits
+ *    so a block is returned if it has hits from the channel and any hits in
+ *    the window.
+ *  @param from, to - the window in ns (inclusive).
+ *  @param module   - module name.
+ *  @param channel  - channel number.
+ *  @return std::vector<VX2750EventFile::Chunk> - the ranges, in file order.
+ */
+std::vector<VX2750EventFile::Chunk>
+VX2750TimeIndex::find(
+    std::uint64_t from, std::uint64_t to, const std::string& module, unsigned channel
+) const
+{
+    int id = findModule(module);
+    if (id < 0) {
+        return std::vector<VX2750EventFile::Chunk>();
+    }
+    return select(from, to, id, channel);
+}
+/**
+ * indexName
+ *    @param eventFile - path to an event file.
+ *    @return std::string - the default path of its index.
+ */
+std::string
+VX2750TimeIndex::indexName(const std::string& eventFile)
+{
+    return eventFile + ".tidx";
+}
+/**
+ * channelBit
+ *    @param channel - a channel number.
+ *    @return std::uint64_t - its bit in ModulePresence::s_channels.  The
+ *           VX2750 has 64 channels; any higher channel numbers share the
+ *           last bit so lookups of them can return extra blocks but never
+ *           miss one.
+ */
+std::uint64_t
+VX2750TimeIndex::channelBit(unsigned channel)
+{
+    return std::uint64_t(1) << (channel < 63 ? channel : 63);
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * select
+ *    Find blocks by time and, optionally, channel.
+ *  @param from, to - time window (inclusive).
+ *  @param module   - module id or -1 for any.
+ *  @param channel  - channel or ANY_CHANNEL.
+ *  @return std::vector<VX2750EventFile::Chunk> - merged ranges of the blocks.
+ */
+std::vector<VX2750EventFile::Chunk>
+VX2750TimeIndex::select(
+    std::uint64_t from, std::uint64_t to, int module, unsigned channel
+) const
+{
+    std::uint64_t mask = (channel == ANY_CHANNEL) ? ~std::uint64_t(0) : channelBit(channel);
+    std::vector<VX2750EventFile::Chunk> result;
+    for (auto& b : m_blocks) {
+        if (b.s_hits == 0 || b.s_minTimestamp > to || b.s_maxTimestamp < from) {
+            continue;
+        }
+        if (module >= 0) {
+            bool present = false;
+            for (auto& m : b.s_modules) {
+                if (m.s_module == std::uint32_t(module) && (m.s_channels & mask)) {
+                    present = true;
+                    break;
+                }
+            }
+            if (!present) continue;
+        }
+        if (!result.empty() && result.back().s_end == b.s_begin) {
+            result.back().s_end = b.s_end;
+        } else {
+            VX2750EventFile::Chunk c = {b.s_begin, b.s_end};
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+/**
+ * parse
+ *    Parse the complete records in a block of the file.
+ *  @param p     - data read from the file at m_validBytes.  If that's 0
+ *                 the data starts with the header.
+ *  @param bytes - bytes of data.
+ *  @return std::size_t - bytes that were complete records (and header).
+ *  @throw std::runtime_error - the data are corrupt.
+ */
+std::size_t
+VX2750TimeIndex::parse(const std::uint8_t* p, std::size_t bytes)
+{
+    const std::uint8_t* pBegin = p;
+    const std::uint8_t* pEnd = p + bytes;
+
+    if (m_validBytes == 0) {
+        if (bytes < sizeof(Header)) return 0;    // Still being created.
+        Header h;
+        memcpy(&h, p, sizeof(h));
+        if (memcmp(h.s_magic, MAGIC, sizeof(MAGIC))) invalid("bad magic number");
+        if (h.s_version != VERSION) invalid("unsupported version");
+        m_blockBytes = h.s_blockBytes;
+        p += sizeof(h);
+    }
+    while (std::size_t(pEnd - p) >= sizeof(RecordHeader)) {
+        RecordHeader r;
+        memcpy(&r, p, sizeof(r));
+        if (r.s_bytes < sizeof(r) || r.s_bytes % 8) invalid("bad record size");
+        if (r.s_bytes > std::size_t(pEnd - p)) break;     // Partial record.
+        const std::uint8_t* pBody = p + sizeof(r);
+        std::size_t bodyBytes = r.s_bytes - sizeof(r);
+
+        if (r.s_type == MODULE_RECORD) {
+            std::uint32_t info[2];                         // id, name length.
+            if (bodyBytes < sizeof(info)) invalid("truncated module record");
+            memcpy(info, pBody, sizeof(info));
+            if (info[1] > bodyBytes - sizeof(info)) invalid("truncated module record");
+            if (info[0] != m_modules.size()) invalid("module ids out of order");
+            m_modules.push_back(
+                std::string(reinterpret_cast<const char*>(pBody + sizeof(info)), info[1])
+            );
+        } else if (r.s_type == BLOCK_RECORD) {
+            BlockRecord br;
+            if (bodyBytes < sizeof(br)) invalid("truncated block record");
+            memcpy(&br, pBody, sizeof(br));
+            if (br.s_nModules > (bodyBytes - sizeof(br))/sizeof(ModulePresence)) {
+                invalid("truncated block record");
+            }
+            if (br.s_begin != indexedBytes() || br.s_end < br.s_begin) {
+                invalid("blocks are not contiguous");
+            }
+            Block b;
+            b.s_begin        = br.s_begin;
+            b.s_end          = br.s_end;
+            b.s_minTimestamp = br.s_minTimestamp;
+            b.s_maxTimestamp = br.s_maxTimestamp;
+            b.s_hits         = br.s_hits;
+            b.s_modules.resize(br.s_nModules);
+            memcpy(
+                b.s_modules.data(), pBody + sizeof(br),
+                br.s_nModules * sizeof(ModulePresence)
+            );
+            for (auto& m : b.s_modules) {
+                if (m.s_module >= m_modules.size()) invalid("unknown module id");
+            }
+            m_blocks.push_back(b);
+        } else {
+            invalid("unknown record type");
+        }
+        p += r.s_bytes;
+    }
+    return p - pBegin;
+}
+/**
+ * invalid
+ *    Report an invalid index.
+ *  @param why - what's wrong with it.
+ *  @throw std::runtime_error - always.
+ */
+void
+VX2750TimeIndex::invalid(const char* why) const
+{
+    std::string msg = m_filename;
+    msg += ": not a valid event file index: ";
+    msg += why;
+    throw std::runtime_error(msg);
+}
+}                                     // caen_offline namespace
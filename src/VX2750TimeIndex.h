@@ -0,0 +1,147 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750TimeIndex.h
+* @brief    Time/channel index sidecar files for event files.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750TIMEINDEX_H
+#define VX2750TIMEINDEX_H
+#include "VX2750EventFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caen_offline {
+/**
+ * @class VX2750TimeIndex
+ *    Reads the index that VX2750TimeIndexer writes next to an event file.
+ *    The index cuts the event file into blocks of whole ring items of
+ *    roughly the same size.  For each block it records the range of hit
+ *    timestamps and which channels of which modules have hits in it.
+ *    Queries return the blocks that may hold the hits wanted as
+ *    VX2750EventFile::Chunk's that can be given to VX2750OfflineDecoder.
+ *    Blocks are not time ordered so a query can return several ranges
+ *    and the hits in them must still be filtered.
+ *
+ *    The file is a header followed by records appended as the event file
+ *    is indexed (all little endian):
+ *
+ *    -  Header: MAGIC, uint32_t VERSION, uint32_t target block bytes.
+ *    -  Records: a RecordHeader then:
+ *       -  MODULE_RECORD: uint32_t module id, uint32_t name length, the
+ *          name.  Module ids count up from 0 and a module's record
+ *          precedes the first block that refers to it.
+ *       -  BLOCK_RECORD: a BlockRecord then s_nModules ModulePresence's.
+ *          Blocks are in file order and each begins where the previous
+ *          one ended.
+ *       Records are padded to 8 bytes.
+ *
+ *    A record that runs past the end of the file is one being written (or
+ *    whose write was interrupted); it's ignored.  refresh picks up records
+ *    appended since the index was read so an index can be followed while
+ *    the event file is being written and indexed.
+ */
+class VX2750TimeIndex {
+public:
+    static const char          MAGIC[8];
+    static const std::uint32_t VERSION = 1;
+    static const std::uint32_t MODULE_RECORD = 1;
+    static const std::uint32_t BLOCK_RECORD  = 2;
+
+#pragma pack(push, 1)
+    struct Header {
+        char          s_magic[8];
+        std::uint32_t s_version;
+        std::uint32_t s_blockBytes;
+    };
+    struct RecordHeader {
+        std::uint32_t s_type;
+        std::uint32_t s_bytes;            // Includes this header and padding.
+    };
+    struct BlockRecord {
+        std::uint64_t s_begin;            // Event file offsets [begin, end)
+        std::uint64_t s_end;
+        std::uint64_t s_minTimestamp;     // ns; no hits: min > max.
+        std::uint64_t s_maxTimestamp;
+        std::uint64_t s_hits;
+        std::uint32_t s_nModules;
+        std::uint32_t s_unused;
+    };
+    struct ModulePresence {
+        std::uint64_t s_channels;         // Bit n: channel n has hits.
+        std::uint32_t s_module;
+        std::uint32_t s_hits;
+    };
+#pragma pack(pop)
+
+    struct Block {
+        std::uint64_t s_begin;
+        std::uint64_t s_end;
+        std::uint64_t s_minTimestamp;
+        std::uint64_t s_maxTimestamp;
+        std::uint64_t s_hits;
+        std::vector<ModulePresence> s_modules;
+    };
+private:
+    std::string              m_filename;
+    std::uint32_t            m_blockBytes;
+    std::vector<std::string> m_modules;
+    std::vector<Block>       m_blocks;
+    std::uint64_t            m_validBytes;     // Bytes of complete records.
+public:
+    VX2750TimeIndex(const char* filename);
+    virtual ~VX2750TimeIndex();
+private:
+    VX2750TimeIndex(const VX2750TimeIndex&);
+    VX2750TimeIndex& operator=(const VX2750TimeIndex&);
+public:
+    const std::string&              getFilename() const { return m_filename; }
+    std::uint32_t                   getBlockBytes() const { return m_blockBytes; }
+    const std::vector<std::string>& getModules() const { return m_modules; }
+    const std::vector<Block>&       getBlocks() const { return m_blocks; }
+    std::uint64_t                   validBytes() const { return m_validBytes; }
+    std::uint64_t                   indexedBytes() const;
+
+    std::size_t refresh();
+    int         findModule(const std::string& name) const;
+
+    std::vector<VX2750EventFile::Chunk> findTime(
+        std::uint64_t from, std::uint64_t to
+    ) const;
+    std::vector<VX2750EventFile::Chunk> findChannel(
+        const std::string& module, unsigned channel
+    ) const;
+    std::vector<VX2750EventFile::Chunk> find(
+        std::uint64_t from, std::uint64_t to,
+        const std::string& module, unsigned channel
+    ) const;
+
+    static std::string   indexName(const std::string& eventFile);
+    static std::uint64_t channelBit(unsigned channel);
+private:
+    std::vector<VX2750EventFile::Chunk> select(
+        std::uint64_t from, std::uint64_t to, int module, unsigned channel
+    ) const;
+    std::size_t parse(const std::uint8_t* p, std::size_t bytes);
+    [[noreturn]] void invalid(const char* why) const;
+};
+}                                     // caen_offline namespace
+#endif
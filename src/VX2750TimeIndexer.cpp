@@ -0,0 +1,347 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750TimeIndexer.cpp
+* @brief    Implement the event file indexer.
+* @author   Ron Fox
+*
+*/
+#include "VX2750TimeIndexer.h"
+#include <stdexcept>
+#include <system_error>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+namespace caen_offline {
+
+const std::uint32_t VX2750TimeIndexer::DEFAULT_BLOCK_BYTES;
+
+/**
+ * @class BlockBuilder
+ *    A hit visitor that cuts a chunk of the event file into blocks and
+ *    accumulates each block's time range and channel presence.  A block
+ *    ends at the first item with hits at least the block size past its
+ *    start so blocks only end on ring item boundaries.
+ */
+class BlockBuilder : public VX2750HitVisitor
+{
+public:
+    struct Module {
+        std::string   s_name;
+        std::uint64_t s_channels;
+        std::uint32_t s_hits;
+    };
+    struct Block {
+        std::uint64_t       s_begin;
+        std::uint64_t       s_end;
+        std::uint64_t       s_minTimestamp;
+        std::uint64_t       s_maxTimestamp;
+        std::uint64_t       s_hits;
+        std::vector<Module> s_modules;
+    };
+    std::vector<Block> m_blocks;
+private:
+    VX2750EventFile::Chunk m_chunk;
+    std::uint32_t          m_blockBytes;
+    Block                  m_current;
+    std::uint64_t          m_lastItem;
+    unsigned               m_lastModule;
+public:
+    BlockBuilder(const VX2750EventFile::Chunk& chunk, std::uint32_t blockBytes) :
+        m_chunk(chunk), m_blockBytes(blockBytes), m_lastItem(~std::uint64_t(0)),
+        m_lastModule(0)
+    {
+        start(chunk.s_begin);
+    }
+    virtual void hit(const VX2750Hit& hit) {
+        if (hit.s_itemOffset != m_lastItem) {
+            m_lastItem = hit.s_itemOffset;
+            if (hit.s_itemOffset - m_current.s_begin >= m_blockBytes) {
+                m_current.s_end = hit.s_itemOffset;
+                m_blocks.push_back(m_current);
+                start(hit.s_itemOffset);
+            }
+        }
+        if (hit.s_timestamp < m_current.s_minTimestamp) {
+            m_current.s_minTimestamp = hit.s_timestamp;
+        }
+        if (hit.s_timestamp > m_current.s_maxTimestamp) {
+            m_current.s_maxTimestamp = hit.s_timestamp;
+        }
+        m_current.s_hits++;
+
+        std::vector<Module>& modules(m_current.s_modules);
+        if (m_lastModule >= modules.size() || modules[m_lastModule].s_name != hit.s_moduleName) {
+            for (m_lastModule = 0; m_lastModule < modules.size(); m_lastModule++) {
+                if (modules[m_lastModule].s_name == hit.s_moduleName) break;
+            }
+            if (m_lastModule == modules.size()) {
+                Module m = {hit.s_moduleName, 0, 0};
+                modules.push_back(m);
+            }
+        }
+        modules[m_lastModule].s_channels |= VX2750TimeIndex::channelBit(hit.s_channel);
+        modules[m_lastModule].s_hits++;
+    }
+    // Close the last block; it ends where the chunk does.
+
+    void finish() {
+        m_current.s_end = m_chunk.s_end;
+        m_blocks.push_back(m_current);
+    }
+private:
+    void start(std::uint64_t offset) {
+        m_current.s_begin = offset;
+        m_current.s_end = offset;
+        m_current.s_minTimestamp = ~std::uint64_t(0);
+        m_current.s_maxTimestamp = 0;
+        m_current.s_hits = 0;
+        m_current.s_modules.clear();
+    }
+};
+
+/**
+ * addRecord
+ *    Append a record to a buffer of records.
+ *  @param records - the buffer.
+ *  @param type    - record type.
+ *  @param pBody   - the record body.
+ *  @param bytes   - size of the body; the record is padded to 8 bytes.
+ */
+static void
+addRecord(
+    std::vector<std::uint8_t>& records, std::uint32_t type,
+    const void* pBody, std::size_t bytes
+)
+{
+    VX2750TimeIndex::RecordHeader header;
+    header.s_type  = type;
+    header.s_bytes = (sizeof(header) + bytes + 7) & ~std::size_t(7);
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&header);
+    records.insert(records.end(), p, p + sizeof(header));
+    p = reinterpret_cast<const std::uint8_t*>(pBody);
+    records.insert(records.end(), p, p + bytes);
+    records.resize(records.size() + header.s_bytes - sizeof(header) - bytes, 0);
+}
+
+/**
+ * constructor
+ *    Open an index, creating it if it doesn't exist, and lock it.
+ *  @param filename   - the index file (see VX2750TimeIndex::indexName).
+ *  @param blockBytes - target size of the blocks.  If the index exists,
+ *                      the size it was created with is used.
+ *  @throw std::invalid_argument - blockBytes is zero.
+ *  @throw std::system_error - the file can't be opened, created or read.
+ *  @throw std::runtime_error - another indexer has the file locked or it
+ *         isn't an index.
+ */
+VX2750TimeIndexer::VX2750TimeIndexer(const char* filename, std::uint32_t blockBytes) :
+    m_filename(filename), m_fd(-1), m_pIndex(nullptr)
+{
+    if (blockBytes == 0) {
+        throw std::invalid_argument("Index block size must be positive");
+    }
+    m_fd = open(filename, O_RDWR | O_CREAT, 0664);
+    if (m_fd < 0) {
+        throw std::system_error(errno, std::generic_category(), filename);
+    }
+    try {
+        if (flock(m_fd, LOCK_EX | LOCK_NB)) {
+            if (errno == EWOULDBLOCK) {
+                throw std::runtime_error(
+                    m_filename + ": is being updated by another indexer"
+                );
+            }
+            throw std::system_error(errno, std::generic_category(), filename);
+        }
+        struct stat info;
+        if (fstat(m_fd, &info)) {
+            throw std::system_error(errno, std::generic_category(), filename);
+        }
+        if (info.st_size == 0) {
+            VX2750TimeIndex::Header header;
+            memcpy(header.s_magic, VX2750TimeIndex::MAGIC, sizeof(header.s_magic));
+            header.s_version    = VX2750TimeIndex::VERSION;
+            header.s_blockBytes = blockBytes;
+            if (pwrite(m_fd, &header, sizeof(header), 0) != sizeof(header)) {
+                throw std::system_error(errno, std::generic_category(), filename);
+            }
+        }
+        m_pIndex = new VX2750TimeIndex(filename);
+    }
+    catch (...) {
+        close(m_fd);
+        throw;
+    }
+    auto& modules(m_pIndex->getModules());
+    for (std::size_t i = 0; i < modules.size(); i++) {
+        m_moduleIds[modules[i]] = i;
+    }
+}
+/**
+ * destructor
+ *    Closing the file releases the lock.
+ */
+VX2750TimeIndexer::~VX2750TimeIndexer()
+{
+    delete m_pIndex;
+    close(m_fd);
+}
+/**
+ * update
+ *    Index the part of an event file that's not yet indexed.  The complete
+ *    ring items past the end of the index are cut into one chunk per
+ *    thread and decoded in parallel.  Their blocks are appended to the
+ *    index in file order.
+ *  @param file    - the event file.
+ *  @param threads - number of decoding threads.
+ *  @return VX2750OfflineDecoder::Statistics - what was seen in the newly
+ *          indexed part of the file.
+ *  @throw std::runtime_error - the event file is shorter than the index
+ *         (so it's not the file that was indexed) or a ring item size is
+ *         invalid.
+ *  @throw std::system_error - the index can't be written.
+ */
+VX2750OfflineDecoder::Statistics
+VX2750TimeIndexer::update(const VX2750EventFile& file, unsigned threads)
+{
+    std::uint64_t indexed = m_pIndex->indexedBytes();
+    if (file.size() < indexed) {
+        throw std::runtime_error(
+            file.getFilename() + ": is shorter than its index " + m_filename
+        );
+    }
+    auto chunks = file.chunks(threads, indexed);
+    if (chunks.empty()) {
+        return VX2750OfflineDecoder::Statistics();
+    }
+    std::vector<BlockBuilder> builders;
+    for (auto& c : chunks) {
+        builders.push_back(BlockBuilder(c, m_pIndex->getBlockBytes()));
+    }
+    std::vector<VX2750HitVisitor*> visitors;
+    for (auto& b : builders) visitors.push_back(&b);
+    VX2750OfflineDecoder decoder(file);
+    auto stats = decoder.decode(chunks, visitors);
+
+    // Build the new records then append them in one write:
+
+    std::vector<std::uint8_t> records;
+    try {
+        for (auto& builder : builders) {
+            builder.finish();
+            for (auto& b : builder.m_blocks) {
+                std::vector<VX2750TimeIndex::ModulePresence> presence;
+                for (auto& m : b.s_modules) {
+                    VX2750TimeIndex::ModulePresence p;
+                    p.s_channels = m.s_channels;
+                    p.s_module   = moduleId(m.s_name, records);
+                    p.s_hits     = m.s_hits;
+                    presence.push_back(p);
+                }
+                VX2750TimeIndex::BlockRecord br;
+                br.s_begin        = b.s_begin;
+                br.s_end          = b.s_end;
+                br.s_minTimestamp = b.s_minTimestamp;
+                br.s_maxTimestamp = b.s_maxTimestamp;
+                br.s_hits         = b.s_hits;
+                br.s_nModules     = presence.size();
+                br.s_unused       = 0;
+
+                std::vector<std::uint8_t> body(
+                    reinterpret_cast<std::uint8_t*>(&br),
+                    reinterpret_cast<std::uint8_t*>(&br + 1)
+                );
+                const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(presence.data());
+                body.insert(body.end(), p, p + presence.size()*sizeof(presence[0]));
+                addRecord(records, VX2750TimeIndex::BLOCK_RECORD, body.data(), body.size());
+            }
+        }
+        write(records);
+    }
+    catch (...) {
+        // New module ids may not have made it to the file:
+
+        m_moduleIds.clear();
+        auto& modules(m_pIndex->getModules());
+        for (std::size_t i = 0; i < modules.size(); i++) {
+            m_moduleIds[modules[i]] = i;
+        }
+        throw;
+    }
+    m_pIndex->refresh();
+    return stats;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * moduleId
+ *    @param name    - a module name.
+ *    @param records - records being built.  If the module is new, its
+ *                     record is appended.
+ *    @return std::uint32_t - the module's id.
+ */
+std::uint32_t
+VX2750TimeIndexer::moduleId(const std::string& name, std::vector<std::uint8_t>& records)
+{
+    auto p = m_moduleIds.find(name);
+    if (p != m_moduleIds.end()) return p->second;
+
+    std::uint32_t id = m_moduleIds.size();
+    m_moduleIds[name] = id;
+    std::uint32_t info[2] = {id, std::uint32_t(name.size())};
+    std::vector<std::uint8_t> body(
+        reinterpret_cast<std::uint8_t*>(info), reinterpret_cast<std::uint8_t*>(info + 2)
+    );
+    body.insert(body.end(), name.begin(), name.end());
+    addRecord(records, VX2750TimeIndex::MODULE_RECORD, body.data(), body.size());
+    return id;
+}
+/**
+ * write
+ *    Append records to the index.  Anything past the last complete record
+ *    (left by an interrupted update) is removed first.
+ *  @param records - the records.
+ *  @throw std::system_error - the write failed.
+ */
+void
+VX2750TimeIndexer::write(const std::vector<std::uint8_t>& records)
+{
+    std::uint64_t offset = m_pIndex->validBytes();
+    if (ftruncate(m_fd, offset)) {
+        throw std::system_error(errno, std::generic_category(), m_filename);
+    }
+    const std::uint8_t* p = records.data();
+    std::size_t bytes = records.size();
+    while (bytes) {
+        ssize_t n = pwrite(m_fd, p, bytes, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), m_filename);
+        }
+        p      += n;
+        bytes  -= n;
+        offset += n;
+    }
+}
+}                                     // caen_offline namespace
@@ -0,0 +1,73 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750TimeIndexer.h
+* @brief    Build and extend event file indices.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750TIMEINDEXER_H
+#define VX2750TIMEINDEXER_H
+#include "VX2750TimeIndex.h"
+#include "VX2750OfflineDecoder.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace caen_offline {
+/**
+ * @class VX2750TimeIndexer
+ *    Writes the index (see VX2750TimeIndex) of an event file.  Indexing is
+ *    incremental: each update indexes the complete ring items past the end
+ *    of the last block already indexed and appends their blocks.  Updating
+ *    as the event file grows keeps the index current while a run is being
+ *    recorded.  The new part of the file is decoded in parallel.
+ *
+ *    An indexer holds an exclusive lock on its index file so only one
+ *    process can extend an index at a time.  Readers don't lock; they
+ *    ignore a record that's still being written.
+ */
+class VX2750TimeIndexer {
+public:
+    static const std::uint32_t DEFAULT_BLOCK_BYTES = 1024*1024;
+private:
+    std::string                          m_filename;
+    int                                  m_fd;
+    VX2750TimeIndex*                     m_pIndex;
+    std::map<std::string, std::uint32_t> m_moduleIds;
+public:
+    VX2750TimeIndexer(
+        const char* filename, std::uint32_t blockBytes = DEFAULT_BLOCK_BYTES
+    );
+    virtual ~VX2750TimeIndexer();
+private:
+    VX2750TimeIndexer(const VX2750TimeIndexer&);
+    VX2750TimeIndexer& operator=(const VX2750TimeIndexer&);
+public:
+    const VX2750TimeIndex& getIndex() const { return *m_pIndex; }
+
+    VX2750OfflineDecoder::Statistics update(
+        const VX2750EventFile& file, unsigned threads = 1
+    );
+private:
+    std::uint32_t moduleId(const std::string& name, std::vector<std::uint8_t>& records);
+    void write(const std::vector<std::uint8_t>& records);
+};
+}                                     // caen_offline namespace
+#endif
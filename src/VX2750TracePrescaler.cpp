@@ -0,0 +1,195 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750TracePrescaler.cpp
+* @brief    Implement the rate adaptive trace prescaling policy.
+* @author   Ron Fox
+*
+*/
+#include "VX2750TracePrescaler.h"
+#include <stdexcept>
+
+namespace caen_nscldaq {
+
+const std::uint16_t VX2750TracePrescaler::TRACES_PRESCALED;
+const std::uint16_t VX2750TracePrescaler::TRACES_SUPPRESSED;
+
+/**
+ * constructor
+ *   @param nChannels - number of channels in the module.
+ *   @param budget    - Trace bandwidth budget in bytes/second.  0 disables
+ *                      prescaling entirely.
+ *   @param prescale  - When a channel is throttled, keep traces for one hit in
+ *                      this many.  0 means drop all traces from throttled
+ *                      channels.
+ *   @param windowNs  - Length of the rate measurement window in ns of
+ *                      hit timestamp.
+ *   @throw std::invalid_argument - the window length is zero.
+ */
+VX2750TracePrescaler::VX2750TracePrescaler(
+    unsigned nChannels, std::uint64_t budget, unsigned prescale,
+    std::uint64_t windowNs
+) :
+    m_channels(nChannels), m_budget(budget), m_prescale(prescale),
+    m_windowNs(windowNs), m_windowStart(0), m_windowStarted(false),
+    m_throttledHits(0), m_suppressedHits(0)
+{
+    if (m_windowNs == 0) {
+        throw std::invalid_argument("Trace prescaler rate window must be nonzero");
+    }
+    for (auto& c : m_channels) {
+        c.s_traceBytes = 0;
+    }
+    reset();
+}
+/**
+ * setTraceBytes
+ *    Set the number of bytes of trace data a hit in a channel carries when
+ *    its traces are kept.  This is what we use to compute bandwidth.
+ * @param channel - channel number.
+ * @param bytes   - trace bytes per hit.
+ * @throw std::out_of_range - bad channel number.
+ */
+void
+VX2750TracePrescaler::setTraceBytes(unsigned channel, std::size_t bytes)
+{
+    m_channels.at(channel).s_traceBytes = bytes;
+}
+/**
+ * decide
+ *    Count a hit and decide what to do with its traces.
+ * @param channel - channel the hit came from.
+ * @param nsTimestamp - The hit's timestamp in ns.
+ * @return Decision - what to do with the traces.
+ * @note out of range channels are just kept... that's the safe thing to do.
+ */
+VX2750TracePrescaler::Decision
+VX2750TracePrescaler::decide(unsigned channel, std::uint64_t nsTimestamp)
+{
+    if (!m_budget || (channel >= m_channels.size())) return Keep;
+
+    // Timestamps going backwards (e.g. a timestamp reset) just start a new
+    // window:
+
+    if (!m_windowStarted || (nsTimestamp < m_windowStart)) {
+        m_windowStart   = nsTimestamp;
+        m_windowStarted = true;
+    } else if ((nsTimestamp - m_windowStart) >= m_windowNs) {
+        endWindow(nsTimestamp);
+    }
+
+    auto& c = m_channels[channel];
+    c.s_windowHits++;
+    if (!c.s_throttled) return Keep;
+
+    m_throttledHits++;
+    if (m_prescale) {
+        c.s_counter++;
+        if (c.s_counter >= m_prescale) {
+            c.s_counter = 0;
+            return Prescaled;
+        }
+    }
+    m_suppressedHits++;
+    return Suppressed;
+}
+/**
+ * reset
+ *    Forget all rate information - e.g. at the start of a run.
+ *    The trace sizes are retained.
+ */
+void
+VX2750TracePrescaler::reset()
+{
+    for (auto& c : m_channels) {
+        c.s_windowHits = 0;
+        c.s_rate       = 0.0;
+        c.s_counter    = 0;
+        c.s_throttled  = false;
+    }
+    m_windowStart   = 0;
+    m_windowStarted = false;
+    m_throttledHits = 0;
+    m_suppressedHits = 0;
+}
+/**
+ * isThrottled
+ *   @param channel - channel number.
+ *   @return bool - true if the channel is currently being prescaled.
+ *   @throw std::out_of_range - bad channel.
+ */
+bool
+VX2750TracePrescaler::isThrottled(unsigned channel) const
+{
+    return m_channels.at(channel).s_throttled;
+}
+/**
+ * getRate
+ *   @param channel - channel number.
+ *   @return double - hit rate (Hz) measured in the last complete window.
+ *   @throw std::out_of_range - bad channel.
+ */
+double
+VX2750TracePrescaler::getRate(unsigned channel) const
+{
+    return m_channels.at(channel).s_rate;
+}
+////////////////////////////////////////////////////////////////////////////////
+// Private utilities:
+
+/**
+ * endWindow
+ *    Close off the current rate window and decide which channels get throttled
+ *    in the next one.  Channels are throttled only if the total trace
+ *    bandwidth exceeds the budget and, in that case, only those using more
+ *    than an equal share of the budget among the active channels.
+ *  @param nsTimestamp - the timestamp of the hit that closed the window;
+ *                       this starts the next window.
+ */
+void
+VX2750TracePrescaler::endWindow(std::uint64_t nsTimestamp)
+{
+    double seconds = static_cast<double>(nsTimestamp - m_windowStart)/1.0e9;
+    double total   = 0.0;
+    unsigned active = 0;
+    std::vector<double> bandwidth(m_channels.size(), 0.0);
+
+    for (int i = 0; i < m_channels.size(); i++) {
+        auto& c = m_channels[i];
+        c.s_rate     = static_cast<double>(c.s_windowHits)/seconds;
+        c.s_windowHits = 0;
+        bandwidth[i] = c.s_rate * c.s_traceBytes;
+        total       += bandwidth[i];
+        if (bandwidth[i] > 0.0) active++;
+    }
+    if (total <= static_cast<double>(m_budget)) {
+        for (auto& c : m_channels) {
+            c.s_throttled = false;
+        }
+    } else {
+        double share = static_cast<double>(m_budget)/active;
+        for (int i = 0; i < m_channels.size(); i++) {
+            auto& c = m_channels[i];
+            bool throttle = bandwidth[i] > share;
+            if (throttle && !c.s_throttled) c.s_counter = 0;
+            c.s_throttled = throttle;
+        }
+    }
+    m_windowStart = nsTimestamp;
+}
+}                                      // caen_nscldaq namespace
@@ -0,0 +1,105 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     VX2750TracePrescaler.h
+* @brief    Rate adaptive trace prescaling policy for the readout.
+* @author   Ron Fox
+*
+*/
+#ifndef VX2750TRACEPRESCALER_H
+#define VX2750TRACEPRESCALER_H
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace caen_nscldaq {
+/**
+ * @class VX2750TracePrescaler
+ *    At high rates, the traces in hits can swamp the link from the digitizer
+ *    (and the ring buffers downstream) where the energies/timestamps alone
+ *    would fit just fine.  This class implements a policy that lets
+ *    the readout degrade gracefully rather than allowing the digitizer to go
+ *    busy:
+ *
+ *    -  Hit rates are tracked per channel over a window that is measured
+ *       in hit timestamps (so we don't need to consult the clock for each hit).
+ *    -  At the end of each window, the trace bandwidth each channel would need
+ *       (hit rate * bytes of traces per hit) is computed.  If the sum exceeds
+ *       the budget, the channels using more than their fair share
+ *       of the budget are throttled for the next window.
+ *    -  Throttled channels keep their traces for only one hit in N
+ *       (N is the prescale factor).  A prescale of 0 drops the traces of
+ *       throttled channels entirely.
+ *
+ *    The readout marks hits whose traces were affected in the fail flags word
+ *    of the hit using the TRACES_PRESCALED and TRACES_SUPPRESSED bits below.
+ *    Since the throttle is based on hit rate rather than the rate of traces
+ *    actually written, a channel stays throttled until its hit rate falls.
+ */
+class VX2750TracePrescaler {
+public:
+    typedef enum _Decision {
+        Keep,                         // Traces are output normally.
+        Prescaled,                    // Channel throttled but this hit's traces kept.
+        Suppressed                    // Channel throttled and traces dropped.
+    } Decision;
+
+    // Bits in the hit fail flags word that mark affected hits:
+
+    static const std::uint16_t TRACES_PRESCALED  = 0x4000;
+    static const std::uint16_t TRACES_SUPPRESSED = 0x8000;
+private:
+    struct ChannelState {
+        std::uint64_t s_windowHits;     // Hits in the current window.
+        std::size_t   s_traceBytes;     // Bytes of trace data per hit.
+        double        s_rate;           // Hits/sec in the last completed window.
+        unsigned      s_counter;        // Prescale counter.
+        bool          s_throttled;      // Prescaling in effect.
+    };
+
+    std::vector<ChannelState> m_channels;
+    std::uint64_t             m_budget;         // Bytes/sec 0 means no limit.
+    unsigned                  m_prescale;       // Keep 1 in this many (0 drop all).
+    std::uint64_t             m_windowNs;       // Rate window length.
+    std::uint64_t             m_windowStart;    // Timestamp at window start.
+    bool                      m_windowStarted;  // False until first hit.
+    std::uint64_t             m_throttledHits;  // Statistics
+    std::uint64_t             m_suppressedHits;
+public:
+    VX2750TracePrescaler(
+        unsigned nChannels, std::uint64_t budget, unsigned prescale,
+        std::uint64_t windowNs = 1000000000
+    );
+
+    void setTraceBytes(unsigned channel, std::size_t bytes);
+    Decision decide(unsigned channel, std::uint64_t nsTimestamp);
+    void reset();
+
+    // Selectors
+
+    bool   enabled() const { return m_budget != 0; }
+    bool   isThrottled(unsigned channel) const;
+    double getRate(unsigned channel) const;
+    std::uint64_t throttledHits() const {return m_throttledHits; }
+    std::uint64_t suppressedHits() const { return m_suppressedHits; }
+
+private:
+    void endWindow(std::uint64_t nsTimestamp);
+};
+}                                     // caen_nscldaq namespace
+#endif
@@ -23,6 +23,7 @@
 */
 #include "VX2750XMLConfig.h"
 #include "VX2750PHAConfiguration.h"
+#include "VX2750ConfigSnapshot.h"
 #include <pugixml.hpp>
 #include <memory>
 #include <stdexcept>
@@ -174,6 +175,20 @@ namespace caen_nscldaq {
         emptyMap();
     }
     
+    /**
+     * setSnapshotFile
+     *    Keep a binary snapshot of the configurations produced from the XML
+     *    file.  If the snapshot is current (the XML file has not changed
+     *    since it was written), configure loads the configurations from it
+     *    rather than processing the XML.
+     * @param pFilename - snapshot file path.  Empty disables snapshots
+     *                  (the default).
+     */
+    void
+    VX2750XMLConfig::setSnapshotFile(const char* pFilename)
+    {
+        m_snapshotFile = pFilename;
+    }
     /**
      * configure
      *    Process the XML configuration file, which produces the m_modules conten
@@ -183,6 +198,8 @@ namespace caen_nscldaq {
      */
     void VX2750XMLConfig::configure()
     {
+        if (loadSnapshot()) return;
+        
         pugi::xml_document doc;
         pugi::xml_parse_result result = doc.load_file(m_xmlFile.c_str());
         
@@ -191,6 +208,7 @@ namespace caen_nscldaq {
                 computeDefaultConfiguration(doc));
             emptyMap();
             createConfigurations(doc, *defaultConfiguration);
+            writeSnapshot();
             
         } else {
             std::stringstream error;
@@ -259,6 +277,47 @@ namespace caen_nscldaq {
         
         m_modules.clear();
     }
+    /**
+     * loadSnapshot
+     *    If there's a current snapshot, replace the configurations with
+     *    those in the snapshot.
+     * @return bool - true if the configurations were loaded from the snapshot.
+     */
+    bool
+    VX2750XMLConfig::loadSnapshot()
+    {
+        if (m_snapshotFile.empty()) return false;
+        try {
+            VX2750ConfigSnapshot snapshot(m_snapshotFile);
+            if (snapshot.isCurrent()) {
+                VX2750ConfigSnapshot::Modules modules;
+                snapshot.createModules(modules);
+                emptyMap();
+                m_modules = modules;
+                return true;
+            }
+        }
+        catch (...) {}           // No usable snapshot, process the XML.
+        return false;
+    }
+    /**
+     * writeSnapshot
+     *    Write the snapshot of the configurations (if snapshots are enabled).
+     *    Failure is reported but not an error.
+     */
+    void
+    VX2750XMLConfig::writeSnapshot()
+    {
+        if (m_snapshotFile.empty()) return;
+        try {
+            std::vector<std::string> sources = {m_xmlFile};
+            VX2750ConfigSnapshot::write(m_snapshotFile, sources, m_modules);
+        }
+        catch (std::exception& e) {
+            std::cerr << "Unable to write configuration snapshot " << m_snapshotFile
+                << ": " << e.what() << std::endl;
+        }
+    }
     /**
      * computeDefaultConfiguration
      *    Iterate over all of the <parameterDescription> tags
@@ -562,6 +621,17 @@ namespace caen_nscldaq {
         mask = ~mask;                     // turn it into a removal mask.
         std::uint64_t ivalue = std::strtoul(value.c_str(), nullptr, 0);
         ivalue = ivalue << shift;
+        
+        // A single channel only needs that element modified:
+        
+        if (channel != -1) {
+            std::uint64_t old = configuration.getUnsignedList("channeltriggermasks").at(channel);
+            setListItem(
+                configuration, "channeltriggermasks", channel,
+                std::to_string((old & mask) | ivalue)
+            );
+            return;
+        }
         std::vector<std::uint64_t> masks = configuration.getUnsignedList("channeltriggermasks");
         
         // Fold the new value into the mask:
@@ -656,26 +726,20 @@ namespace caen_nscldaq {
         const std::string& newValue
     )
     {
-        std::vector<std::string> configList = config.getList(name);
-        if (element >= configList.size()) {
+        size_t listSize = config.getList(name).size();
+        if ((element < 0) || (element >= listSize)) {
             std::stringstream errorMessage;
             errorMessage << "Attempting to configure " << config.getName()
             << " parameter: " << name << " with a list index of "
             << element << ". But the existing configuration list has only "
-            << configList.size() << " elements.";
+            << listSize << " elements.";
             std::string msg = errorMessage.str();
             throw std::logic_error(msg);
         }
-        configList[element] = newValue;
-        
-        // Build the list value:
+        // Only the new element is validated and the rest of the list is
+        // not re-parsed:
         
-        std::string configValue = "";
-        for (auto v : configList) {
-            configValue += v;
-            configValue += " ";
-        }
-        config.configure(name, configValue);
+        config.configureListElement(name, element, newValue);
     }
     /**
      * setSpecialChannelValue
@@ -46,16 +46,20 @@ class VX2750XMLConfig
 private:
     std::map<std::string, VX2750PHAModuleConfiguration*> m_modules;
     std::string m_xmlFile;
+    std::string m_snapshotFile;
 public:
     VX2750XMLConfig(const char* pFilename);
     virtual ~VX2750XMLConfig();
     
+    void setSnapshotFile(const char* pFilename);
     void configure();
     VX2750PHAModuleConfiguration* getModule(const char* name);
     std::vector<std::string> listModules();
     
 private:
     void emptyMap();
+    bool loadSnapshot();
+    void writeSnapshot();
     VX2750PHAModuleConfiguration* computeDefaultConfiguration(pugi::xml_document& doc);
     void createConfigurations(
         pugi::xml_document& doc,
@@ -84,14 +84,19 @@ CConfigurableObject::~CConfigurableObject()
 }
 
 /*!
-   Copy construction.  We can just copy the name and map.
-   Copy construction should be rare as normally names are unique.
+   Copy construction.  The parameters are copy-on-write: rhs's parameters
+   are moved into a shared set that both objects reference.  Each object
+   only gets its own copy of a parameter when it is configured.
+   This makes copies of a configuration (e.g. one per board from a default
+   configuration) cheap in both time and memory.
 */
 CConfigurableObject::CConfigurableObject(const CConfigurableObject& rhs) :
-  m_name(rhs.m_name),
-  m_parameters(rhs.m_parameters)
+  m_name(rhs.m_name)
 {
+  // Sharing does not change rhs's logical value:
 
+  const_cast<CConfigurableObject&>(rhs).shareParameters();
+  m_pShared = rhs.m_pShared;
 }
 /*!
    Assignement is similar to copy construction:
@@ -100,8 +105,12 @@ CConfigurableObject&
 CConfigurableObject::operator=(const CConfigurableObject& rhs)
 {
   if (this != &rhs) {
+    const_cast<CConfigurableObject&>(rhs).shareParameters();
     m_name       = rhs.m_name;
-    m_parameters = rhs.m_parameters; 
+    m_parameters.clear();
+    m_parsedValues.clear();
+    releaseConstraintCheckers();    // Only our local parameters used these.
+    m_pShared    = rhs.m_pShared;
   }
   return *this;
 }
@@ -113,7 +122,7 @@ int
 CConfigurableObject::operator==(const CConfigurableObject& rhs) const
 {
   return ((m_name == rhs.m_name)   &&
-	  (m_parameters == rhs.m_parameters));
+	  (allParameters() == rhs.allParameters()));
 }
 /*!
   Inequality is the logical inverse of equality:
@@ -153,15 +162,21 @@ CConfigurableObject::getName() const
 string
 CConfigurableObject::cget(string name) 
 {
-  ConfigIterator found = m_parameters.find(name);
-  if (found == m_parameters.end()) {
+  const ConfigData* pData = findParameter(name);
+  if (!pData) {
     string msg("CConfigurableObject::cget was asked for parameter: ");
     msg += name;
     msg += " which is not defined";
     throw msg;
   }
-  ConfigData data = found->second;
-  return data.first;
+  // Elements configured one at a time are only joined when asked for:
+
+  auto p = m_parsedValues.find(name);
+  if ((p != m_parsedValues.end()) && p->second->s_joinPending) {
+    m_parameters[name].first = joinElements(p->second->s_elements);
+    p->second->s_joinPending = false;
+  }
+  return pData->first;
 }
 /*!
    Get the values of all the configuration parameters.
@@ -177,8 +192,9 @@ CConfigurableObject::ConfigurationArray
 CConfigurableObject::cget() 
 {
   ConfigurationArray result;
-  ConfigIterator p = m_parameters.begin();
-  while(p != m_parameters.end()) {
+  Configuration parameters = allParameters();
+  ConfigIterator p = parameters.begin();
+  while(p != parameters.end()) {
     
     string name = p->first;
     ConfigData data = p->second;
@@ -218,6 +234,7 @@ CConfigurableObject::addParameter(string      name,
   TypeCheckInfo checkInfo(checker, arg);
   ConfigData    data(defaultValue, checkInfo);
   m_parameters[name] = data;	// This overwrites any prior.
+  m_parsedValues.erase(name);
 }
 
 /*!
@@ -230,21 +247,24 @@ CConfigurableObject::addParameter(string      name,
    \throw std::string("No such parameter") if the parameter 'name' is not defined.
    \throw std::string("Validation failed for 'name' <- 'value'") if the value
            does not pass the validator for the parameter.
+
+   \note Values of list parameters are split and converted to their
+         element type here so that the list getters need not re-parse them.
 */
 void
 CConfigurableObject::configure(string name, string value)
 {
   // Locate the parameter and complain if it isn't in the map:
 
-  ConfigIterator item = m_parameters.find(name);
-  if(item == m_parameters.end()) {
+  const ConfigData* pItem = findParameter(name);
+  if(!pItem) {
     string msg("No such parameter: ");
     msg  += name;
     throw msg;
   }
   // If the parameter has a validator get it and validate:
 
-  TypeCheckInfo checker = item->second.second;
+  TypeCheckInfo checker = pItem->second;
   typeChecker   pCheck  = checker.first;
   if (pCheck) {			// No checker means no checkig.
     if (! (*pCheck)(name, value, checker.second)) {
@@ -255,10 +275,127 @@ CConfigurableObject::configure(string name, string value)
       throw msg;
     }
   }
-  // Now set the new validated value:
+  // Now set the new validated value (this is now a local parameter):
+
+  m_parameters[name] = ConfigData(value, checker);
+
+  // Cache the parsed form of list values:
+
+  m_parsedValues.erase(name);
+  if (isListChecker(pCheck)) {
+    std::shared_ptr<ParsedValue> pParsed(new ParsedValue);
+    ParsedValue& parsed(*pParsed);
+    parseValue(parsed, name, value);
+    m_parsedValues[name] = pParsed;
+
+    typeChecker pElement = elementChecker(checker).first;
+    if (pElement == isInteger) {
+      convertIntegers(parsed);
+    } else if (pElement == isBool) {
+      convertBools(parsed);
+    } else if (pElement == isFloat) {
+      convertFloats(parsed);
+    } else if (pElement == isEnumList) {
+      convertListOfLists(parsed);
+    }
+  }
 
-  m_parameters[name].first = value;
+}
+/*!
+   Configure a single element of a list parameter.  Only the new element
+   is validated (by the checker the list applies to each of its elements),
+   and the parsed forms of the list are updated in place, so setting
+   each element of a long list one at a time does not re-split and
+   re-validate the entire list each time.  The string form of the list is
+   not rebuilt until it is asked for (cget), so setting all n elements
+   takes time proportional to n, not n squared.
+
+   \param name : std::string
+      Name of the list parameter.
+   \param index : unsigned
+      Index of the element to set.
+   \param value : std::string
+      New value of the element.
+
+   \throw std::string - No such parameter, the parameter is not a list,
+          the index is out of range or the value does not validate.
+*/
+void
+CConfigurableObject::configureListElement(string name, unsigned index, string value)
+{
+  const ConfigData* pItem = findParameter(name);
+  if(!pItem) {
+    string msg("No such parameter: ");
+    msg  += name;
+    throw msg;
+  }
+  TypeCheckInfo checker = pItem->second;
+  if (!isListChecker(checker.first)) {
+    string msg("Element configuration of non-list parameter: ");
+    msg += name;
+    throw msg;
+  }
+  ParsedValue& parsed(parsedValue(name));
+  if (index >= parsed.s_elements.size()) {
+    string msg("Validation failed for ");
+    msg += name;
+    msg += "[";
+    msg += itos(index);
+    msg += "] - the list only has ";
+    msg += itos(parsed.s_elements.size());
+    msg += " elements";
+    throw msg;
+  }
+  TypeCheckInfo element = elementChecker(checker);
+  if (element.first) {
+    if (!(*element.first)(name, value, element.second)) {
+      string msg("Validation failed for ");
+      msg += name;
+      msg += "[";
+      msg += itos(index);
+      msg += "] <- ";
+      msg += value;
+      throw msg;
+    }
+  }
+  // The parameter and its parsed value become local (copied from the
+  // shared parameters if need be) before modifying them:
 
+  auto pLocal = m_parsedValues.find(name);
+  if ((pLocal == m_parsedValues.end()) || (pLocal->second.use_count() > 1)) {
+    m_parsedValues[name] = std::make_shared<ParsedValue>(parsed);
+  }
+  if (m_parameters.count(name) == 0) {
+    m_parameters[name] = *pItem;
+  }
+  ParsedValue& local(*m_parsedValues[name]);
+  local.s_joinPending = true;
+  setParsedElement(local, index, value);
+}
+/*!
+   Set the value of a parameter without validating it.  This is intended
+   for restoring values that were validated when they were saved (e.g.
+   from a configuration snapshot).  List values are parsed when first
+   fetched.
+
+   \param name : std::string
+      Name of the parameter to configure.
+   \param value : std::string
+      New, previously validated, value of the parameter.
+
+   \throw std::string("No such parameter") if the parameter 'name' is not defined.
+*/
+void
+CConfigurableObject::configureUnchecked(string name, string value)
+{
+  const ConfigData* pItem = findParameter(name);
+  if(!pItem) {
+    string msg("No such parameter: ");
+    msg  += name;
+    throw msg;
+  }
+  m_parameters[name] = ConfigData(value, pItem->second);
+  m_parsedValues.erase(name);
 }
 /*!
   clear the current configuration.  The configuration map m_parameters
@@ -268,6 +405,8 @@ void
 CConfigurableObject::clearConfiguration()
 {
   m_parameters.clear();
+  m_parsedValues.clear();
+  m_pShared.reset();
   releaseConstraintCheckers();
 }
 
@@ -368,90 +507,46 @@ CConfigurableObject::getFloatParameter(string name)
 /*!
   Return a parameter that is a list of integers.
   \param name - name of the parameter.
-  \return vector<int>
+  \return const vector<int64_t>&
   \retval Vector containing the integers in the list.
 
 */
-vector<int64_t>
+const vector<int64_t>&
 CConfigurableObject::getIntegerList(string name)
 {
-  string value = cget(name);
-  int argc;
-  const char** argv;
-  vector<int64_t> result;
-
-  Tcl_SplitList(NULL, value.c_str(), &argc, &argv);
-
-  for (int i =0; i < argc; i++) {
-    result.push_back(static_cast<int64_t>(strtol(argv[i], NULL, 0)));
-  }
-  Tcl_Free((char*)argv);
-  return result;
-
+  ParsedValue& parsed(parsedValue(name));
+  if (!parsed.s_haveIntegers) convertIntegers(parsed);
+  return parsed.s_integers;
 }
 
-vector<uint64_t>
+const vector<uint64_t>&
 CConfigurableObject::getUnsignedList(string name)
 {
-  string value = cget(name);
-  int argc;
-  const char** argv;
-  vector<uint64_t> result;
-
-  Tcl_SplitList(NULL, value.c_str(), &argc, &argv);
-
-  for (int i =0; i < argc; i++) {
-    result.push_back(static_cast<uint64_t>(strtoul(argv[i], NULL, 0)));
-  }
-  Tcl_Free((char*)argv);
-  return result;
+  ParsedValue& parsed(parsedValue(name));
+  if (!parsed.s_haveUnsigneds) convertUnsigneds(parsed);
+  return parsed.s_unsigneds;
 }
 
-vector<bool>
+const vector<bool>&
 CConfigurableObject::getBoolList(string name)
 {
-  string value = cget(name);
-  int argc;
-  const char** argv;
-  vector<bool> result;
-
-  Tcl_SplitList(NULL, value.c_str(), &argc, &argv);
-
-  for (int i =0; i < argc; i++) {
-    result.push_back(strToBool(argv[i]));
-  }
-  Tcl_Free((char*)argv);
-  return result;
+  ParsedValue& parsed(parsedValue(name));
+  if (!parsed.s_haveBools) convertBools(parsed);
+  return parsed.s_bools;
 }
 
 /**
  * getFloatList
  *    Get a list of values that are doubles.
  *  @param name - name of the parameter.
- *  @return std::vector<double> - list values.
+ *  @return const std::vector<double>& - list values.
  */
-vector<double>
+const vector<double>&
 CConfigurableObject::getFloatList(string name)
 {
-  string value = cget(name);
-  
-  // bust it up into a  list:
-  
-  int argc;
-  const char** argv;
-  Tcl_SplitList(NULL, value.c_str(), &argc, &argv);
-  
-  // Parse the values intothe result.
-  
-  vector<double> result;
-  for (int i = 0; i < argc; i++) {
-      result.push_back(strtod(argv[i], nullptr));
-  }
-  // Free the parsed list elements:
-  
-  Tcl_Free(reinterpret_cast<char*>(argv));
-  
-  return result;
+  ParsedValue& parsed(parsedValue(name));
+  if (!parsed.s_haveFloats) convertFloats(parsed);
+  return parsed.s_floats;
 }
 
 /**
@@ -459,23 +554,13 @@ CConfigurableObject::getFloatList(string name)
  *
  * @param name - name of configuration parameter.
  *
- * @return std::vector<std::string>
+ * @return const std::vector<std::string>&
  * @retval vector whose elements are the list elements.
  */
-vector<string>
+const vector<string>&
 CConfigurableObject::getList(string name)
 {
-    string value = cget(name);
-    int argc;
-    const char** argv;
-    vector<string> result;
-    Tcl_SplitList(NULL, value.c_str(), &argc, &argv);
-    
-    for (int i = 0; i < argc; i++) {
-        result.push_back(argv[i]);
-    }
-    Tcl_Free((char*)argv);
-    return result;
+  return parsedValue(name).s_elements;
 }
 
 /**
@@ -520,55 +605,15 @@ CConfigurableObject::getEnumParameter(std::string name, const char** pValues)
  * getListOfLists
  *     Return the value of a paramter that is a list of lists.
  *  @param name -name of the parameter
- *  @return std::vector<std::vector<std::string>>
+ *  @return const std::vector<std::vector<std::string>>&
+ *  @throw std::string - the value or one of its sublists is not a valid list.
  */
-std::vector<std::vector<std::string>>
+const std::vector<std::vector<std::string>>&
 CConfigurableObject::getListOfLists(std::string name)
 {
-  // Get the raw value:
-  
-  auto rawValue = cget(name);          // Throws if nosuch.
-  std::vector<std::vector<std::string>> result;
-  // Break up the outer list and marshall that into a vector of strings
-  // so we can immediately free the result:
-  
-  int argc;
-  const char** argv;
-  if (Tcl_SplitList(nullptr, rawValue.c_str(), &argc, &argv) != TCL_OK) {
-    std::string msg = rawValue;
-    msg += " is not a valid Tcl list";
-    throw msg;
-  
-  }
-  std::vector<std::string> outerList;
-  for (int i =0; i < argc; i++) {
-    outerList.push_back(argv[i]);
-  }
-  Tcl_Free((char*)(argv));
-  
-  // Now split each sublist:
-  
-  for (auto l : outerList) {
-    if (Tcl_SplitList(nullptr, l.c_str(), &argc, &argv) != TCL_OK) {
-      std::string msg = "sublist: " ;
-      msg += l;
-      msg += " is not a valid Tcl list";
-      throw msg;
-      
-    }
-    // Now marshall the sublist into its vector and push it into the result:
-    
-    std::vector<std::string> sublist;
-    for (int i =0; i < argc; i++) {
-      sublist.push_back(argv[i]);
-    }
-    Tcl_Free((char*)(argv));
-    result.push_back(sublist);
-  }
-  
-  return result;
-  
-  
+  ParsedValue& parsed(parsedValue(name));     // Throws if nosuch.
+  if (!parsed.s_haveListOfLists) convertListOfLists(parsed);
+  return parsed.s_listOfLists;
 }
 /** 
  * Add an integer parameter to the configuration that has no limits.
@@ -1667,12 +1712,364 @@ CConfigurableObject::releaseLimitsConstraint(void* pConstraint)
 void
 CConfigurableObject::releaseConstraintCheckers()
 {
-  while (!m_constraints.empty()) {
-    DynamicConstraint Item = m_constraints.front();
+  releaseConstraints(m_constraints);
+}
+/**
+ * Release the constraints in a constraint list:
+ */
+void
+CConfigurableObject::releaseConstraints(ConstraintReleaseList& constraints)
+{
+  while (!constraints.empty()) {
+    DynamicConstraint Item = constraints.front();
     (Item.s_Releaser)(Item.s_pObject); // Release the constraint.
-    m_constraints.pop_front();
+    constraints.pop_front();
+  }
+  constraints.clear();
+}
+/**
+ * SharedParameters destructor
+ *    The last object sharing the parameters is gone so the constraints
+ *    their checkers use can be released.
+ */
+CConfigurableObject::SharedParameters::~SharedParameters()
+{
+  releaseConstraints(s_constraints);
+}
+/**
+ * shareParameters
+ *    Move our local parameters, parsed values and constraints into a new
+ *    shared parameter set so that copies can share them.  The new set is
+ *    layered over any set we were already sharing.  If we have no local
+ *    state, our current shared set is already sufficient.
+ */
+void
+CConfigurableObject::shareParameters()
+{
+  if (m_pShared && m_parameters.empty() && m_parsedValues.empty() &&
+      m_constraints.empty()) {
+    return;
   }
-  m_constraints.clear();
+  joinPendingLists();                  // Shared values are always current.
+  std::shared_ptr<SharedParameters> pShared(new SharedParameters);
+  if (m_pShared) {
+    pShared->s_parameters = m_pShared->s_parameters;
+    for (auto& p : m_pShared->s_parsedValues) {
+      if (m_parameters.count(p.first) == 0) {        // Not overridden.
+        pShared->s_parsedValues.insert(p);
+      }
+    }
+    pShared->s_pParent = m_pShared;                   // Keeps its constraints.
+  }
+  for (auto& p : m_parameters) {
+    pShared->s_parameters[p.first] = p.second;
+  }
+  for (auto& p : m_parsedValues) {
+    pShared->s_parsedValues[p.first] = p.second;
+  }
+  pShared->s_constraints.splice(pShared->s_constraints.end(), m_constraints);
+
+  m_parameters.clear();
+  m_parsedValues.clear();
+  m_pShared = pShared;
+}
+/**
+ * joinPendingLists
+ *    Bring the string values of lists whose elements were configured one
+ *    at a time up to date.
+ */
+void
+CConfigurableObject::joinPendingLists()
+{
+  for (auto& p : m_parsedValues) {
+    if (p.second->s_joinPending) {
+      m_parameters[p.first].first = joinElements(p.second->s_elements);
+      p.second->s_joinPending = false;
+    }
+  }
+}
+/**
+ * findParameter
+ *    Locate a parameter; local parameters take precedence over shared ones.
+ * @param name - name of the parameter.
+ * @return const ConfigData* - the parameter value and checker, nullptr if
+ *                there's no such parameter.
+ */
+const CConfigurableObject::ConfigData*
+CConfigurableObject::findParameter(const std::string& name) const
+{
+  auto p = m_parameters.find(name);
+  if (p != m_parameters.end()) {
+    return &(p->second);
+  }
+  if (m_pShared) {
+    auto s = m_pShared->s_parameters.find(name);
+    if (s != m_pShared->s_parameters.end()) {
+      return &(s->second);
+    }
+  }
+  return nullptr;
+}
+/**
+ * allParameters
+ *   @return Configuration - the shared parameters overlaid with the local ones.
+ *           Lists with pending element changes have their current value.
+ */
+CConfigurableObject::Configuration
+CConfigurableObject::allParameters() const
+{
+  Configuration result;
+  if (m_pShared) {
+    result = m_pShared->s_parameters;
+    for (auto& p : m_parameters) {
+      result[p.first] = p.second;
+    }
+  } else {
+    result = m_parameters;
+  }
+  for (auto& p : m_parsedValues) {
+    if (p.second->s_joinPending) {
+      result[p.first].first = joinElements(p.second->s_elements);
+    }
+  }
+  return result;
+}
+/**
+ * parsedValue
+ *    Return the parsed form of a list parameter's value.  If it's not yet
+ *    been parsed (e.g. it still has its default value), it is split now
+ *    and cached.
+ * @param name - name of the parameter.
+ * @return ParsedValue& - the cache entry.
+ * @throw std::string - no such parameter or the value is not a valid list.
+ */
+CConfigurableObject::ParsedValue&
+CConfigurableObject::parsedValue(const std::string& name)
+{
+  auto p = m_parsedValues.find(name);
+  if (p != m_parsedValues.end()) {
+    return *(p->second);
+  }
+  // Shared parsed values are good only if we've not overridden the parameter:
+  
+  if (m_pShared && (m_parameters.count(name) == 0)) {
+    auto s = m_pShared->s_parsedValues.find(name);
+    if (s != m_pShared->s_parsedValues.end()) {
+      return *(s->second);
+    }
+  }
+  std::shared_ptr<ParsedValue> pParsed(new ParsedValue);
+  parseValue(*pParsed, name, cget(name));
+  m_parsedValues[name] = pParsed;
+  return *pParsed;
+}
+/**
+ * parseValue
+ *    Split a list value into its elements.  Any typed forms are discarded.
+ * @param parsed - the cache entry to fill in.
+ * @param name   - name of the parameter (for error messages).
+ * @param value  - the value to split.
+ * @throw std::string - the value is not a valid Tcl list.
+ */
+void
+CConfigurableObject::parseValue(
+  ParsedValue& parsed, const std::string& name, const std::string& value
+)
+{
+  int argc;
+  const char** argv;
+  if (Tcl_SplitList(nullptr, value.c_str(), &argc, &argv) != TCL_OK) {
+    std::string msg = value;
+    msg += " is not a valid Tcl list (parameter ";
+    msg += name;
+    msg += ")";
+    throw msg;
+  }
+  parsed = ParsedValue();
+  parsed.s_elements.reserve(argc);
+  for (int i = 0; i < argc; i++) {
+    parsed.s_elements.push_back(argv[i]);
+  }
+  Tcl_Free((char*)argv);
+}
+/**
+ * convertIntegers
+ *    Convert the elements of a parsed list to signed integers.
+ * @param parsed - the cache entry.
+ */
+void
+CConfigurableObject::convertIntegers(ParsedValue& parsed)
+{
+  parsed.s_integers.clear();
+  parsed.s_integers.reserve(parsed.s_elements.size());
+  for (auto& e : parsed.s_elements) {
+    parsed.s_integers.push_back(static_cast<int64_t>(strtol(e.c_str(), NULL, 0)));
+  }
+  parsed.s_haveIntegers = true;
+}
+/**
+ * convertUnsigneds
+ *    Convert the elements of a parsed list to unsigned integers.
+ * @param parsed - the cache entry.
+ */
+void
+CConfigurableObject::convertUnsigneds(ParsedValue& parsed)
+{
+  parsed.s_unsigneds.clear();
+  parsed.s_unsigneds.reserve(parsed.s_elements.size());
+  for (auto& e : parsed.s_elements) {
+    parsed.s_unsigneds.push_back(static_cast<uint64_t>(strtoul(e.c_str(), NULL, 0)));
+  }
+  parsed.s_haveUnsigneds = true;
+}
+/**
+ * convertFloats
+ *    Convert the elements of a parsed list to doubles.
+ * @param parsed - the cache entry.
+ */
+void
+CConfigurableObject::convertFloats(ParsedValue& parsed)
+{
+  parsed.s_floats.clear();
+  parsed.s_floats.reserve(parsed.s_elements.size());
+  for (auto& e : parsed.s_elements) {
+    parsed.s_floats.push_back(strtod(e.c_str(), nullptr));
+  }
+  parsed.s_haveFloats = true;
+}
+/**
+ * convertBools
+ *    Convert the elements of a parsed list to bools.
+ * @param parsed - the cache entry.
+ */
+void
+CConfigurableObject::convertBools(ParsedValue& parsed)
+{
+  parsed.s_bools.clear();
+  parsed.s_bools.reserve(parsed.s_elements.size());
+  for (auto& e : parsed.s_elements) {
+    parsed.s_bools.push_back(strToBool(e));
+  }
+  parsed.s_haveBools = true;
+}
+/**
+ * convertListOfLists
+ *    Split each element of a parsed list into a sublist.
+ * @param parsed - the cache entry.
+ * @throw std::string - a sublist is not a valid Tcl list.
+ */
+void
+CConfigurableObject::convertListOfLists(ParsedValue& parsed)
+{
+  std::vector<std::vector<std::string>> result;
+  result.reserve(parsed.s_elements.size());
+  for (auto& l : parsed.s_elements) {
+    int argc;
+    const char** argv;
+    if (Tcl_SplitList(nullptr, l.c_str(), &argc, &argv) != TCL_OK) {
+      std::string msg = "sublist: " ;
+      msg += l;
+      msg += " is not a valid Tcl list";
+      throw msg;
+    }
+    std::vector<std::string> sublist(argv, argv + argc);
+    Tcl_Free((char*)(argv));
+    result.push_back(sublist);
+  }
+  parsed.s_listOfLists.swap(result);
+  parsed.s_haveListOfLists = true;
+}
+/**
+ * isListChecker
+ *  @param checker - a parameter's type checker.
+ *  @return bool - true if the checker is one of the list checkers.
+ */
+bool
+CConfigurableObject::isListChecker(typeChecker checker)
+{
+  return (checker == isList)    || (checker == isBoolList)  ||
+         (checker == isIntList) || (checker == isFloatList) ||
+         (checker == isStringList);
+}
+/**
+ * elementChecker
+ *    Figure out the checker the list checkers apply to each element of a
+ *    list parameter.  This tells us what typed form the list getters will
+ *    want and how to validate a single element.
+ * @param checker - the parameter's type checker information.
+ * @return TypeCheckInfo - the element checker and its argument.  The checker
+ *                 is nullptr if elements are not checked.
+ */
+CConfigurableObject::TypeCheckInfo
+CConfigurableObject::elementChecker(const TypeCheckInfo& checker)
+{
+  if (checker.first == isBoolList)  return TypeCheckInfo(isBool, nullptr);
+  if (checker.first == isIntList)   return TypeCheckInfo(isInteger, nullptr);
+  if (checker.first == isFloatList) return TypeCheckInfo(isFloat, nullptr);
+  if ((checker.first == isList) && checker.second) {
+    return static_cast<isListParameter*>(checker.second)->s_checker;
+  }
+  return TypeCheckInfo(static_cast<typeChecker>(nullptr), nullptr);
+}
+/**
+ * setParsedElement
+ *    Set one element of a parsed value, updating any typed forms
+ *    that have already been computed.
+ * @param parsed - the cache entry.
+ * @param index  - element index (already range checked).
+ * @param value  - new element value.
+ * @throw std::string - a list of lists element is not a valid list.
+ */
+void
+CConfigurableObject::setParsedElement(
+  ParsedValue& parsed, unsigned index, const std::string& value
+)
+{
+  parsed.s_elements[index] = value;
+  const char* pValue = value.c_str();
+  if (parsed.s_haveIntegers) {
+    parsed.s_integers[index] = static_cast<int64_t>(strtol(pValue, NULL, 0));
+  }
+  if (parsed.s_haveUnsigneds) {
+    parsed.s_unsigneds[index] = static_cast<uint64_t>(strtoul(pValue, NULL, 0));
+  }
+  if (parsed.s_haveFloats) {
+    parsed.s_floats[index] = strtod(pValue, nullptr);
+  }
+  if (parsed.s_haveBools) {
+    parsed.s_bools[index] = strToBool(value);
+  }
+  if (parsed.s_haveListOfLists) {
+    int argc;
+    const char** argv;
+    if (Tcl_SplitList(nullptr, pValue, &argc, &argv) != TCL_OK) {
+      std::string msg = "sublist: " ;
+      msg += value;
+      msg += " is not a valid Tcl list";
+      throw msg;
+    }
+    parsed.s_listOfLists[index] = std::vector<std::string>(argv, argv + argc);
+    Tcl_Free((char*)(argv));
+  }
+}
+/**
+ * joinElements
+ *    Produce the string (Tcl list) representation of a list value.
+ * @param elements - the list elements.
+ * @return std::string - properly quoted Tcl list.
+ */
+std::string
+CConfigurableObject::joinElements(const std::vector<std::string>& elements)
+{
+  std::vector<const char*> argv;
+  argv.reserve(elements.size());
+  for (auto& e : elements) {
+    argv.push_back(e.c_str());
+  }
+  char* pList = Tcl_Merge(argv.size(), argv.data());
+  std::string result(pList);
+  Tcl_Free(pList);
+  return result;
 }
 
 
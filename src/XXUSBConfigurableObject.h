@@ -25,6 +25,7 @@
 #include <set>
 #include <list>
 #include <cstdint>
+#include <memory>
 
 // Typedefs for the parameter checker are in the global namespace:
 
@@ -62,6 +63,11 @@ namespace XXUSB {
    configuration is complete.  The subclass then would call cget to get and
    react to its configuration.
 
+   Copies of a configurable object share their parameters (copy-on-write).
+   A copy only holds its own copy of the parameters it configures, so
+   many copies of a large configuration are cheap.  Copies that share
+   parameters should be used from a single thread.
+
    This class does not implement any policy about how the configuration is gotten.
    This can be  done by manual parsing of data files, by internal data structures,
    by a Tcl interpreter reading scripts or any other practical means.
@@ -135,11 +141,51 @@ private:
 
   typedef std::list<DynamicConstraint>         ConstraintReleaseList;
 
+  // Parsed forms of a parameter's value.  List values are split once
+  // and the typed vectors built when the parameter is configured (or
+  // on first use for defaults), rather than on each get.  When elements
+  // are configured one at a time, s_joinPending says the string value is
+  // out of date; it's rebuilt from s_elements when it is next needed.
+
+  struct ParsedValue {
+    bool                                  s_haveIntegers;
+    bool                                  s_haveUnsigneds;
+    bool                                  s_haveFloats;
+    bool                                  s_haveBools;
+    bool                                  s_haveListOfLists;
+    bool                                  s_joinPending;
+    std::vector<std::string>              s_elements;
+    std::vector<int64_t>                  s_integers;
+    std::vector<uint64_t>                 s_unsigneds;
+    std::vector<double>                   s_floats;
+    std::vector<bool>                     s_bools;
+    std::vector<std::vector<std::string>> s_listOfLists;
+    ParsedValue() :
+      s_haveIntegers(false), s_haveUnsigneds(false), s_haveFloats(false),
+      s_haveBools(false), s_haveListOfLists(false), s_joinPending(false) {}
+  };
+  typedef std::map<std::string, std::shared_ptr<ParsedValue> > ParsedValues;
+
+  // Parameters shared by copies of an object.  Copies only hold the
+  // parameters they change (copy-on-write).  The dynamic constraints used
+  // by the shared checkers are owned here so that they live as long as
+  // any object that might use them.
+
+  struct SharedParameters {
+    Configuration                       s_parameters;
+    ParsedValues                        s_parsedValues;
+    ConstraintReleaseList               s_constraints;
+    std::shared_ptr<SharedParameters>   s_pParent;     // Owns older constraints.
+    ~SharedParameters();
+  };
+
 private:
   std::string               m_name;	        //!< Name of this object.
-  Configuration             m_parameters;	//!< Contains the configuration parameters.
+  Configuration             m_parameters;	//!< Parameters local to this object.
+  std::shared_ptr<SharedParameters> m_pShared;  //!< Parameters shared with copies.
   ConstraintReleaseList     m_constraints;      //!< Dynamically created constraints.
   EnumCheckers    m_EnumCheckers;
+  ParsedValues              m_parsedValues;     //!< Cache of parsed list values.
 
 public:
   // Canonicals..
@@ -166,13 +212,16 @@ public:
   std::uint64_t     getUnsignedParameter(std::string name);
   bool             getBoolParameter    (std::string name);
   double           getFloatParameter   (std::string name);
-  std::vector<int64_t> getIntegerList      (std::string name);
-	std::vector<uint64_t> getUnsignedList (std::string name);
-  std::vector<std::string> getList     (std::string name);
-	std::vector<double> getFloatList     (std::string name);    //
-	std::vector<bool>  getBoolList(std::string name);
+  // List getters return references to cached, already parsed, values.
+  // These remain valid until the parameter is next configured.
+
+  const std::vector<int64_t>& getIntegerList      (std::string name);
+	const std::vector<uint64_t>& getUnsignedList (std::string name);
+  const std::vector<std::string>& getList     (std::string name);
+	const std::vector<double>& getFloatList     (std::string name);    //
+	const std::vector<bool>&  getBoolList(std::string name);
   int              getEnumParameter(std::string name, const char**pValues);
-	std::vector<std::vector<std::string>> getListOfLists(std::string name);
+	const std::vector<std::vector<std::string>>& getListOfLists(std::string name);
 	
     
   // Operations:
@@ -188,6 +237,8 @@ public:
   // Manipulating and querying the configuration:
 
   void configure(std::string name, std::string value);
+  void configureListElement(std::string name, unsigned index, std::string value);
+  void configureUnchecked(std::string name, std::string value);
 
 
   // Convenience methods for creating typical parameter typse:
@@ -273,12 +324,28 @@ private:
   void        deleteEnumCheckers();
   void        addEnumCheckers(const EnumCheckers& rhs);
   void        releaseConstraintCheckers();
+  void        shareParameters();
+  void        joinPendingLists();
+  const ConfigData* findParameter(const std::string& name) const;
+  Configuration allParameters() const;
+  ParsedValue& parsedValue(const std::string& name);
+  void        parseValue(ParsedValue& parsed, const std::string& name, const std::string& value);
+  static void convertIntegers(ParsedValue& parsed);
+  static void convertUnsigneds(ParsedValue& parsed);
+  static void convertFloats(ParsedValue& parsed);
+  static void convertBools(ParsedValue& parsed);
+  static void convertListOfLists(ParsedValue& parsed);
+  static bool        isListChecker(typeChecker checker);
+  static TypeCheckInfo elementChecker(const TypeCheckInfo& checker);
+  static void        setParsedElement(ParsedValue& parsed, unsigned index, const std::string& value);
+  static std::string joinElements(const std::vector<std::string>& elements);
 
 
   // Constraint releasers.
 private:
   static void releaseEnumConstraint(void* pConstraint);
   static void releaseLimitsConstraint(void* pConstraint);
+  static void releaseConstraints(ConstraintReleaseList& constraints);
 };
 
 };
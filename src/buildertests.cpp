@@ -0,0 +1,296 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  buildertests.cpp
+ *  @brief: Tests of the offline event builder (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "OfflineTestData.h"
+#include "VX2750OfflineDecoder.h"
+#include "VX2750OfflineEventBuilder.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace caen_offline;
+using namespace offline_test;
+
+// What the decoder sees in built output; events are told apart by item:
+
+class EventList : public VX2750HitVisitor {
+public:
+    struct Hit {
+        std::uint64_t s_item;
+        std::uint64_t s_timestamp;
+        std::uint32_t s_sid;
+        std::uint16_t s_energy;
+    };
+    std::vector<Hit> m_hits;
+    virtual void hit(const VX2750Hit& hit) {
+        Hit h = {hit.s_itemOffset, hit.s_timestamp, hit.s_sourceId, hit.s_energy};
+        m_hits.push_back(h);
+    }
+    std::size_t events() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < m_hits.size(); i++) {
+            if (i == 0 || m_hits[i].s_item != m_hits[i-1].s_item) n++;
+        }
+        return n;
+    }
+};
+
+class buildertest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(buildertest);
+    CPPUNIT_TEST(merge);
+    CPPUNIT_TEST(windows);
+    CPPUNIT_TEST(partitions);
+    CPPUNIT_TEST(unsorted);
+    CPPUNIT_TEST(statechanges);
+    CPPUNIT_TEST(rebuild);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_filename;
+public:
+    void setUp() {
+        char name[] = "/tmp/buildertestXXXXXX";
+        close(mkstemp(name));
+        m_filename = name;
+    }
+    void tearDown() {
+        unlink(m_filename.c_str());
+    }
+protected:
+    void merge();
+    void windows();
+    void partitions();
+    void unsorted();
+    void statechanges();
+    void rebuild();
+private:
+    Bytes unbuilt(std::uint32_t sid, const std::vector<std::uint64_t>& times);
+    Bytes build(
+        VX2750OfflineEventBuilder& builder, unsigned threads = 1,
+        std::size_t partitionHits = VX2750OfflineEventBuilder::DEFAULT_PARTITION_HITS,
+        VX2750OfflineEventBuilder::Statistics* pStats = nullptr
+    );
+    void  decode(const Bytes& data, EventList& events);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(buildertest);
+
+// Unbuilt data from a source: one hit per item, energy is the hit's index.
+
+Bytes buildertest::unbuilt(std::uint32_t sid, const std::vector<std::uint64_t>& times)
+{
+    Bytes data;
+    for (std::size_t i = 0; i < times.size(); i++) {
+        append(data, item(30, hit("adc", sid, times[i], i), sid, times[i]));
+    }
+    return data;
+}
+// Build into the temp file and read it back:
+
+Bytes buildertest::build(
+    VX2750OfflineEventBuilder& builder, unsigned threads, std::size_t partitionHits,
+    VX2750OfflineEventBuilder::Statistics* pStats
+)
+{
+    int fd = open(m_filename.c_str(), O_WRONLY | O_TRUNC);
+    auto stats = builder.build(fd, threads, partitionHits);
+    close(fd);
+    if (pStats) *pStats = stats;
+
+    struct stat info;
+    stat(m_filename.c_str(), &info);
+    EQ(std::uint64_t(info.st_size), stats.s_bytes);
+    Bytes result(info.st_size);
+    fd = open(m_filename.c_str(), O_RDONLY);
+    ASSERT(read(fd, result.data(), result.size()) == ssize_t(result.size()));
+    close(fd);
+    return result;
+}
+void buildertest::decode(const Bytes& data, EventList& events)
+{
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    auto stats = decoder.decode(file.chunks(1)[0], events);
+    EQ(std::uint64_t(0), stats.s_errors);
+}
+
+// Two sources are merged by time into built events:
+
+void buildertest::merge()
+{
+    Bytes a = unbuilt(1, {100, 200, 300, 1000});
+    Bytes b = unbuilt(2, {105, 250, 1000, 2000});
+    VX2750EventFile fa(a.data(), a.size());
+    VX2750EventFile fb(b.data(), b.size());
+    VX2750OfflineEventBuilder builder(10, 99);
+    builder.addFile(fa);
+    builder.addFile(fb);
+    EQ(size_t(2), builder.getStreams().size());
+
+    VX2750OfflineEventBuilder::Statistics stats;
+    Bytes data = build(builder, 1, 1000, &stats);
+    EQ(std::uint64_t(8), stats.s_hits);
+    EQ(std::uint64_t(6), stats.s_events);     // 100+105, 200, 250, 300, 1000+1000, 2000
+    EQ(std::uint64_t(2), stats.s_maxFragments);
+
+    EventList events;
+    decode(data, events);
+    EQ(size_t(6), events.events());
+    std::uint64_t times[] = {100, 105, 200, 250, 300, 1000, 1000, 2000};
+    std::uint32_t sids[]  = {1, 2, 1, 2, 1, 1, 2, 2};
+    for (int i = 0; i < 8; i++) {
+        EQ(times[i], events.m_hits[i].s_timestamp);
+        EQ(sids[i], events.m_hits[i].s_sid);
+    }
+    EQ(events.m_hits[0].s_item, events.m_hits[1].s_item);
+    EQ(events.m_hits[5].s_item, events.m_hits[6].s_item);
+
+    // The built item's body header has the first timestamp and our sid:
+
+    const std::uint32_t* pItem = reinterpret_cast<const std::uint32_t*>(data.data());
+    EQ(std::uint32_t(30), pItem[1]);
+    EQ(std::uint32_t(20), pItem[2]);
+    EQ(std::uint64_t(100), *reinterpret_cast<const std::uint64_t*>(pItem + 3));
+    EQ(std::uint32_t(99), pItem[5]);
+}
+// The window is measured from the first hit of the event:
+
+void buildertest::windows()
+{
+    Bytes a = unbuilt(1, {0, 10, 20, 30, 40, 100});
+    VX2750EventFile fa(a.data(), a.size());
+    std::uint64_t windows[] = {0, 10, 25, 100};
+    std::uint64_t events[]  = {6, 4, 3, 1};      // w=10: {0,10} {20,30} {40} {100}
+    for (int i = 0; i < 4; i++) {
+        VX2750OfflineEventBuilder builder(windows[i]);
+        builder.addFile(fa);
+        VX2750OfflineEventBuilder::Statistics stats;
+        build(builder, 1, 1000, &stats);
+        EQ(events[i], stats.s_events);
+    }
+}
+// Time partitions built in parallel give the same output as one partition:
+
+void buildertest::partitions()
+{
+    std::vector<Bytes> sources;
+    for (std::uint32_t s = 0; s < 4; s++) {
+        std::vector<std::uint64_t> times;
+        std::uint64_t t = s;
+        for (int i = 0; i < 2000; i++) {
+            t += 1 + (i*7919 + s*104729) % 97;
+            times.push_back(t);
+        }
+        sources.push_back(unbuilt(s, times));
+    }
+    std::vector<VX2750EventFile*> files;
+    for (auto& s : sources) files.push_back(new VX2750EventFile(s.data(), s.size()));
+
+    VX2750OfflineEventBuilder builder(20);
+    for (auto f : files) builder.addFile(*f, 3);
+
+    VX2750OfflineEventBuilder::Statistics serial, parallel;
+    Bytes one = build(builder, 1, 1000000, &serial);
+    Bytes many = build(builder, 4, 500, &parallel);
+    EQ(std::uint64_t(1), serial.s_partitions);
+    ASSERT(parallel.s_partitions > 4);
+    EQ(std::uint64_t(8000), parallel.s_hits);
+    EQ(serial.s_events, parallel.s_events);
+    ASSERT(one == many);
+
+    for (auto f : files) delete f;
+}
+// Out of order hits are sorted and counted:
+
+void buildertest::unsorted()
+{
+    Bytes a = unbuilt(1, {100, 300, 200, 400});
+    VX2750EventFile fa(a.data(), a.size());
+    VX2750OfflineEventBuilder builder(0);
+    builder.addFile(fa);
+    VX2750OfflineEventBuilder::Statistics stats;
+    Bytes data = build(builder, 1, 1000, &stats);
+    EQ(std::uint64_t(1), stats.s_unsorted);
+
+    EventList events;
+    decode(data, events);
+    EQ(std::uint64_t(200), events.m_hits[1].s_timestamp);
+    EQ(std::uint16_t(2), events.m_hits[1].s_energy);
+}
+// Begin runs lead, end runs trail, hits without a source id are dropped:
+
+void buildertest::statechanges()
+{
+    Bytes data = item(1, Bytes(16, 1));
+    append(data, unbuilt(1, {100, 200}));
+    append(data, item(30, hit("adc", 0, 150, 0)));      // No body header.
+    append(data, item(2, Bytes(16, 2)));
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineEventBuilder builder(0);
+    builder.addFile(file);
+
+    VX2750OfflineEventBuilder::Statistics stats;
+    Bytes out = build(builder, 1, 1000, &stats);
+    EQ(std::uint64_t(1), stats.s_noSource);
+    EQ(std::uint64_t(2), stats.s_events);
+
+    VX2750EventFile built(out.data(), out.size());
+    std::vector<std::uint32_t> types;
+    for (std::uint64_t offset = 0; offset < out.size(); offset = built.nextItem(offset)) {
+        types.push_back(reinterpret_cast<const std::uint32_t*>(out.data() + offset)[1]);
+    }
+    std::vector<std::uint32_t> expected = {1, 30, 30, 2};
+    ASSERT(expected == types);
+}
+// Event built input can be rebuilt with another window:
+
+void buildertest::rebuild()
+{
+    Bytes data;
+    for (std::uint64_t i = 0; i < 10; i++) {
+        std::vector<Bytes> frags = {
+            fragment(1, i*1000, hit("adc1", 0, i*1000, i)),
+            fragment(2, i*1000 + 60, hit("adc2", 0, i*1000 + 60, i))
+        };
+        append(data, item(30, built(frags), 0, i*1000));
+    }
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineEventBuilder builder(50);
+    builder.addFile(file, 2);
+    VX2750OfflineEventBuilder::Statistics stats;
+    Bytes out = build(builder, 1, 1000, &stats);
+    EQ(std::uint64_t(20), stats.s_events);            // Split.
+
+    builder.setWindow(60);
+    build(builder, 1, 1000, &stats);
+    EQ(std::uint64_t(10), stats.s_events);            // As recorded.
+
+    EventList events;
+    decode(out, events);
+    EQ(size_t(20), events.events());
+    EQ(std::uint32_t(2), events.m_hits[1].s_sid);
+}
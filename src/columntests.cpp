@@ -0,0 +1,300 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  columntests.cpp
+ *  @brief: Tests of the columnar hit files (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "OfflineTestData.h"
+#include "VX2750OfflineDecoder.h"
+#include "VX2750ColumnFormat.h"
+#include "VX2750ColumnWriter.h"
+#include "VX2750ColumnReader.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+using namespace offline_test;
+
+class columntest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(columntest);
+    CPPUNIT_TEST(codecs);
+    CPPUNIT_TEST(rle);
+    CPPUNIT_TEST(notraces);
+    CPPUNIT_TEST(traces);
+    CPPUNIT_TEST(groups);
+    CPPUNIT_TEST(parallel);
+    CPPUNIT_TEST(notclosed);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_filename;
+public:
+    void setUp() {
+        char name[] = "/tmp/columntestXXXXXX";
+        int fd = mkstemp(name);
+        close(fd);
+        m_filename = name;
+    }
+    void tearDown() {
+        unlink(m_filename.c_str());
+    }
+protected:
+    void codecs();
+    void rle();
+    void notraces();
+    void traces();
+    void groups();
+    void parallel();
+    void notclosed();
+private:
+    Bytes events(unsigned n, std::uint32_t nSamples = 0);
+    void  exportEvents(const Bytes& data, bool traces, unsigned threads, std::size_t rows);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(columntest);
+
+// n event built events, two modules each.  Energies are i and i+1:
+
+Bytes columntest::events(unsigned n, std::uint32_t nSamples)
+{
+    Bytes data;
+    for (unsigned i = 0; i < n; i++) {
+        std::vector<Bytes> frags = {
+            fragment(1, i*100, hit("adc1", i % 64, i*100, i, nSamples)),
+            fragment(2, i*100 + 1, hit("adc2", 3, i*100 + 1, i + 1, nSamples))
+        };
+        append(data, item(30, built(frags), 0, i*100));
+    }
+    return data;
+}
+void columntest::exportEvents(
+    const Bytes& data, bool traces, unsigned threads, std::size_t rows
+)
+{
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    VX2750ColumnWriter writer(m_filename.c_str(), traces);
+    std::vector<VX2750ColumnExporter*> exporters;
+    std::vector<VX2750HitVisitor*> visitors;
+    for (unsigned i = 0; i < threads; i++) {
+        exporters.push_back(new VX2750ColumnExporter(writer, rows));
+        visitors.push_back(exporters.back());
+    }
+    decoder.decode(visitors);
+    for (auto e : exporters) {
+        e->flush();
+        delete e;
+    }
+    writer.close();
+}
+
+// Each codec decodes what it encodes, including big and decreasing values:
+
+void columntest::codecs()
+{
+    std::vector<std::uint64_t> values = {
+        0, 1, 127, 128, 300, 5, 0xffffffffffffffffULL, 0, 1ULL << 40, 12
+    };
+    VX2750ColumnFormat::Codec codecs[] = {
+        VX2750ColumnFormat::PLAIN, VX2750ColumnFormat::VARINT,
+        VX2750ColumnFormat::DELTA, VX2750ColumnFormat::RLE
+    };
+    for (auto codec : codecs) {
+        std::vector<std::uint8_t> encoded;
+        std::uint64_t min, max;
+        VX2750ColumnFormat::encode(
+            codec, VX2750ColumnFormat::U64, values.data(), values.size(),
+            encoded, min, max
+        );
+        EQ(std::uint64_t(0), min);
+        EQ(std::uint64_t(0xffffffffffffffffULL), max);
+
+        std::vector<std::uint64_t> decoded(values.size());
+        VX2750ColumnFormat::decode(
+            codec, VX2750ColumnFormat::U64, encoded.data(), encoded.size(),
+            decoded.size(), decoded.data()
+        );
+        ASSERT(values == decoded);
+
+        // Truncated data is detected:
+
+        if (codec != VX2750ColumnFormat::RLE) {
+            EXCEPTION(
+                VX2750ColumnFormat::decode(
+                    codec, VX2750ColumnFormat::U64, encoded.data(), encoded.size() - 1,
+                    decoded.size(), decoded.data()
+                ),
+                std::runtime_error
+            );
+        }
+    }
+}
+// Runs are run length encoded, varied values aren't:
+
+void columntest::rle()
+{
+    std::vector<std::uint16_t> runs(1000, 7);
+    runs[500] = 8;
+    EQ(VX2750ColumnFormat::RLE, VX2750ColumnFormat::chooseCodec(
+        VX2750ColumnFormat::VARINT, runs.data(), runs.size()
+    ));
+    std::vector<std::uint8_t> encoded;
+    std::uint64_t min, max;
+    VX2750ColumnFormat::encode(
+        VX2750ColumnFormat::RLE, VX2750ColumnFormat::U16, runs.data(), runs.size(),
+        encoded, min, max
+    );
+    ASSERT(encoded.size() < 16);
+    EQ(std::uint64_t(7), min);
+    EQ(std::uint64_t(8), max);
+
+    std::vector<std::uint16_t> varied;
+    for (int i = 0; i < 1000; i++) varied.push_back(i);
+    EQ(VX2750ColumnFormat::DELTA, VX2750ColumnFormat::chooseCodec(
+        VX2750ColumnFormat::DELTA, varied.data(), varied.size()
+    ));
+}
+// Without traces the scalar columns hold the hits:
+
+void columntest::notraces()
+{
+    exportEvents(events(100, 4), false, 1, 1000);
+    VX2750ColumnReader reader(m_filename.c_str());
+
+    EQ(std::uint64_t(200), reader.rows());
+    EQ(size_t(1), reader.groups());
+    EQ(-1, reader.findColumn("analog1"));
+    EQ(size_t(2), reader.getModules().size());
+    EQ(std::string("adc1"), reader.getModules()[0]);
+    EQ(std::string("adc2"), reader.getModules()[1]);
+
+    std::vector<std::uint64_t> modules, energies, timestamps, sids;
+    reader.read(0, reader.findColumn("module"), modules);
+    reader.read(0, reader.findColumn("energy"), energies);
+    reader.read(0, reader.findColumn("timestamp"), timestamps);
+    reader.read(0, reader.findColumn("sourceid"), sids);
+    EQ(size_t(200), energies.size());
+    for (unsigned i = 0; i < 100; i++) {
+        EQ(std::uint64_t(0), modules[2*i]);
+        EQ(std::uint64_t(1), modules[2*i + 1]);
+        EQ(std::uint64_t(i), energies[2*i]);
+        EQ(std::uint64_t(i + 1), energies[2*i + 1]);
+        EQ(std::uint64_t(i*100 + 1), timestamps[2*i + 1]);
+        EQ(std::uint64_t(2), sids[2*i + 1]);
+    }
+    auto& chunk(reader.columnChunk(0, reader.findColumn("energy")));
+    EQ(std::uint64_t(0), chunk.s_min);
+    EQ(std::uint64_t(100), chunk.s_max);
+}
+// Trace columns are list columns:
+
+void columntest::traces()
+{
+    exportEvents(events(10, 5), true, 1, 1000);
+    VX2750ColumnReader reader(m_filename.c_str());
+
+    int lengthColumn = reader.findColumn("analog1.n");
+    int samplesColumn = reader.findColumn("analog1");
+    int digitalColumn = reader.findColumn("digital3");
+    ASSERT(lengthColumn >= 0 && samplesColumn >= 0 && digitalColumn >= 0);
+
+    std::vector<std::uint32_t> lengths, samples;
+    std::vector<std::uint8_t>  digital;
+    reader.read(0, lengthColumn, lengths);
+    reader.read(0, samplesColumn, samples);
+    reader.read(0, digitalColumn, digital);
+    EQ(size_t(20), lengths.size());
+    EQ(size_t(100), samples.size());
+    EQ(size_t(100), digital.size());
+    for (unsigned i = 0; i < samples.size(); i++) {
+        EQ(std::uint32_t((i % 5)*10), samples[i]);
+        EQ(std::uint8_t(2 + i % 5), digital[i]);
+    }
+}
+// Groups split the rows and carry their own statistics:
+
+void columntest::groups()
+{
+    exportEvents(events(100), false, 1, 64);
+    VX2750ColumnReader reader(m_filename.c_str());
+    EQ(size_t(4), reader.groups());                    // 64+64+64+8
+
+    int energy = reader.findColumn("energy");
+    std::uint64_t rows = 0;
+    for (size_t g = 0; g < reader.groups(); g++) {
+        std::vector<std::uint16_t> values;
+        reader.read(g, energy, values);
+        EQ(size_t(reader.groupHeader(g).s_rows), values.size());
+        rows += values.size();
+
+        auto& chunk(reader.columnChunk(g, energy));
+        EQ(std::uint64_t(g*32), chunk.s_min);
+        EQ(std::uint64_t(values.back()), chunk.s_max);
+    }
+    EQ(reader.rows(), rows);
+    EQ(std::uint64_t(0), reader.groupHeader(0).s_firstItemOffset);
+    ASSERT(reader.groupHeader(1).s_firstItemOffset > 0);
+}
+// Several exporters writing one file lose nothing:
+
+void columntest::parallel()
+{
+    exportEvents(events(1000), false, 4, 100);
+    VX2750ColumnReader reader(m_filename.c_str());
+    EQ(std::uint64_t(2000), reader.rows());
+
+    std::vector<bool> seen(1001, false);
+    int energy = reader.findColumn("energy");
+    int module = reader.findColumn("module");
+    std::uint64_t rows = 0;
+    for (size_t g = 0; g < reader.groups(); g++) {
+        std::vector<std::uint64_t> energies, modules;
+        reader.read(g, energy, energies);
+        reader.read(g, module, modules);
+        for (size_t i = 0; i < energies.size(); i++) {
+            if (reader.getModules()[modules[i]] == "adc1") {
+                ASSERT(!seen[energies[i]]);
+                seen[energies[i]] = true;
+            }
+        }
+        rows += energies.size();
+    }
+    EQ(std::uint64_t(2000), rows);
+    for (int i = 0; i < 1000; i++) ASSERT(seen[i]);
+}
+// A file that was never closed is rejected:
+
+void columntest::notclosed()
+{
+    {
+        VX2750ColumnWriter writer(m_filename.c_str(), false);
+        VX2750ColumnExporter exporter(writer);
+        Bytes data = events(3);
+        VX2750EventFile file(data.data(), data.size());
+        VX2750OfflineDecoder decoder(file);
+        decoder.decode(file.chunks(1)[0], exporter);
+        exporter.flush();
+    }
+    EXCEPTION(VX2750ColumnReader reader(m_filename.c_str()), std::runtime_error);
+}
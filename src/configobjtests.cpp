@@ -0,0 +1,286 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  configobjtests.cpp
+ *  @brief: Tests of the parsed value cache, list element configuration and
+ *          copy-on-write parameters of XXUSB::CConfigurableObject.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "XXUSBConfigurableObject.h"
+#include <string>
+#include <vector>
+
+using namespace XXUSB;
+
+class configobjtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(configobjtest);
+    CPPUNIT_TEST(defaults);
+    CPPUNIT_TEST(configured);
+    CPPUNIT_TEST(reconfigured);
+    CPPUNIT_TEST(badvalue);
+    CPPUNIT_TEST(listoflists);
+    CPPUNIT_TEST(copy);
+    CPPUNIT_TEST(element);
+    CPPUNIT_TEST(elementbad);
+    CPPUNIT_TEST(elementlol);
+    CPPUNIT_TEST(elementjoin);
+    CPPUNIT_TEST(cowcopy);
+    CPPUNIT_TEST(cowlifetime);
+    CPPUNIT_TEST(cowassign);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    CConfigurableObject* m_pObject;
+public:
+    void setUp() {
+        m_pObject = new CConfigurableObject("test");
+        m_pObject->addIntListParameter("ints", 4U, std::int64_t(1));
+        m_pObject->addBoolListParameter("bools", 2, false);
+        m_pObject->addFloatListParameter("floats", 1, 4, 2, 1.5);
+        m_pObject->addStringListParameter("strings", 3, "a");
+    }
+    void tearDown() {
+        delete m_pObject;
+    }
+protected:
+    void defaults();
+    void configured();
+    void reconfigured();
+    void badvalue();
+    void listoflists();
+    void copy();
+    void element();
+    void elementbad();
+    void elementlol();
+    void elementjoin();
+    void cowcopy();
+    void cowlifetime();
+    void cowassign();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(configobjtest);
+
+// Defaults are parsed on first use:
+
+void configobjtest::defaults()
+{
+    ASSERT(std::vector<int64_t>({1, 1, 1, 1}) == m_pObject->getIntegerList("ints"));
+    ASSERT(std::vector<bool>({false, false}) == m_pObject->getBoolList("bools"));
+    ASSERT(std::vector<double>({1.5, 1.5}) == m_pObject->getFloatList("floats"));
+    ASSERT(std::vector<std::string>({"a", "a", "a"}) == m_pObject->getList("strings"));
+}
+// Configured values come back parsed and repeated gets give the same storage:
+
+void configobjtest::configured()
+{
+    m_pObject->configure("ints", "1 0x10 -3 4");
+    m_pObject->configure("bools", "on false");
+    m_pObject->configure("floats", "2.5");
+
+    auto& ints = m_pObject->getIntegerList("ints");
+    ASSERT(std::vector<int64_t>({1, 16, -3, 4}) == ints);
+    EQ(&ints, &m_pObject->getIntegerList("ints"));
+    ASSERT(std::vector<uint64_t>({1, 16, uint64_t(-3), 4}) == m_pObject->getUnsignedList("ints"));
+    ASSERT(std::vector<bool>({true, false}) == m_pObject->getBoolList("bools"));
+    ASSERT(std::vector<double>({2.5}) == m_pObject->getFloatList("floats"));
+}
+// Reconfiguring replaces the cached value:
+
+void configobjtest::reconfigured()
+{
+    m_pObject->getIntegerList("ints");
+    m_pObject->getUnsignedList("ints");
+    m_pObject->configure("ints", "5 6 7 8");
+    ASSERT(std::vector<int64_t>({5, 6, 7, 8}) == m_pObject->getIntegerList("ints"));
+    ASSERT(std::vector<uint64_t>({5, 6, 7, 8}) == m_pObject->getUnsignedList("ints"));
+    ASSERT(std::vector<std::string>({"5", "6", "7", "8"}) == m_pObject->getList("ints"));
+}
+// A value that fails validation leaves the cache alone:
+
+void configobjtest::badvalue()
+{
+    m_pObject->configure("ints", "1 2 3 4");
+    EXCEPTION(m_pObject->configure("ints", "1 2 x 4"), std::string);
+    ASSERT(std::vector<int64_t>({1, 2, 3, 4}) == m_pObject->getIntegerList("ints"));
+    EXCEPTION(m_pObject->getIntegerList("nosuch"), std::string);
+}
+// List of enum lists:
+
+void configobjtest::listoflists()
+{
+    const char* values[] = {"x", "y", "z", nullptr};
+    m_pObject->addListOfEnumLists("lol", values, "x", 1, 3, 2);
+    EQ(size_t(2), m_pObject->getListOfLists("lol").size());
+
+    m_pObject->configure("lol", "{x y} {} z");
+    auto& lol = m_pObject->getListOfLists("lol");
+    EQ(size_t(3), lol.size());
+    ASSERT(std::vector<std::string>({"x", "y"}) == lol[0]);
+    EQ(size_t(0), lol[1].size());
+    ASSERT(std::vector<std::string>({"z"}) == lol[2]);
+}
+// Copies carry the parsed values but are independent:
+
+void configobjtest::copy()
+{
+    m_pObject->configure("ints", "1 2 3 4");
+    CConfigurableObject copy(*m_pObject);
+    m_pObject->configure("ints", "4 3 2 1");
+    ASSERT(std::vector<int64_t>({1, 2, 3, 4}) == copy.getIntegerList("ints"));
+    ASSERT(std::vector<int64_t>({4, 3, 2, 1}) == m_pObject->getIntegerList("ints"));
+}
+// Setting a single element updates the parsed forms and the string value:
+
+void configobjtest::element()
+{
+    m_pObject->configure("ints", "1 2 3 4");
+    m_pObject->getUnsignedList("ints");
+    m_pObject->configureListElement("ints", 2, "0x20");
+    ASSERT(std::vector<int64_t>({1, 2, 32, 4}) == m_pObject->getIntegerList("ints"));
+    ASSERT(std::vector<uint64_t>({1, 2, 32, 4}) == m_pObject->getUnsignedList("ints"));
+    EQ(std::string("1 2 0x20 4"), m_pObject->cget("ints"));
+
+    m_pObject->configureListElement("strings", 1, "two words");
+    ASSERT(std::vector<std::string>({"a", "two words", "a"}) == m_pObject->getList("strings"));
+    EQ(std::string("a {two words} a"), m_pObject->cget("strings"));
+
+    m_pObject->configureListElement("bools", 0, "yes");
+    ASSERT(std::vector<bool>({true, false}) == m_pObject->getBoolList("bools"));
+}
+// Bad elements, indices and parameters are rejected leaving the value alone:
+
+void configobjtest::elementbad()
+{
+    m_pObject->configure("ints", "1 2 3 4");
+    EXCEPTION(m_pObject->configureListElement("ints", 1, "junk"), std::string);
+    EXCEPTION(m_pObject->configureListElement("ints", 4, "5"), std::string);
+    EXCEPTION(m_pObject->configureListElement("nosuch", 0, "5"), std::string);
+    EXCEPTION(m_pObject->configureListElement("bools", 0, "maybe"), std::string);
+    ASSERT(std::vector<int64_t>({1, 2, 3, 4}) == m_pObject->getIntegerList("ints"));
+    EQ(std::string("1 2 3 4"), m_pObject->cget("ints"));
+
+    m_pObject->addIntegerParameter("scalar", 1);
+    EXCEPTION(m_pObject->configureListElement("scalar", 0, "5"), std::string);
+}
+// Elements of a list of enum lists are validated as enum lists:
+
+void configobjtest::elementlol()
+{
+    const char* values[] = {"x", "y", "z", nullptr};
+    m_pObject->addListOfEnumLists("lol", values, "x", 1, 3, 2);
+    m_pObject->getListOfLists("lol");
+    m_pObject->configureListElement("lol", 1, "y z");
+    ASSERT(std::vector<std::string>({"y", "z"}) == m_pObject->getListOfLists("lol")[1]);
+    EXCEPTION(m_pObject->configureListElement("lol", 0, "x w"), std::string);
+    ASSERT(std::vector<std::string>({"x"}) == m_pObject->getListOfLists("lol")[0]);
+}
+// The string form of a list set an element at a time is joined when
+// it's needed: by cget, comparison and copying:
+
+void configobjtest::elementjoin()
+{
+    m_pObject->configure("ints", "1 2 3 4");
+    CConfigurableObject before(*m_pObject);
+    for (unsigned i = 0; i < 4; i++) {
+        m_pObject->configureListElement("ints", i, std::to_string(10*i));
+    }
+    m_pObject->configureListElement("strings", 0, "b c");
+
+    CConfigurableObject expected("expected");
+    expected = *m_pObject;
+    expected.configure("ints", "0 10 20 30");
+    expected.configure("strings", "{b c} a a");
+    ASSERT(expected == *m_pObject);                  // Nothing joined yet.
+
+    bool found = false;
+    for (auto& p : m_pObject->cget()) {
+        if (p.first == "ints") {
+            EQ(std::string("0 10 20 30"), p.second);
+            found = true;
+        }
+    }
+    ASSERT(found);
+
+    CConfigurableObject copy(*m_pObject);
+    m_pObject->configureListElement("ints", 0, "5");
+    EQ(std::string("0 10 20 30"), copy.cget("ints"));
+    EQ(std::string("{b c} a a"), copy.cget("strings"));
+    EQ(std::string("5 10 20 30"), m_pObject->cget("ints"));
+    EQ(std::string("1 2 3 4"), before.cget("ints"));
+    ASSERT(std::vector<int64_t>({5, 10, 20, 30}) == m_pObject->getIntegerList("ints"));
+}
+// Copies share parameters but changes to either are not seen by the other:
+
+void configobjtest::cowcopy()
+{
+    m_pObject->configure("ints", "1 2 3 4");
+    CConfigurableObject copy1(*m_pObject);
+    CConfigurableObject copy2(*m_pObject);
+    
+    copy1.configureListElement("ints", 0, "10");
+    copy2.configure("bools", "true true");
+    m_pObject->configure("strings", "x y z");
+    
+    ASSERT(std::vector<int64_t>({10, 2, 3, 4}) == copy1.getIntegerList("ints"));
+    ASSERT(std::vector<int64_t>({1, 2, 3, 4}) == copy2.getIntegerList("ints"));
+    ASSERT(std::vector<int64_t>({1, 2, 3, 4}) == m_pObject->getIntegerList("ints"));
+    ASSERT(std::vector<bool>({true, true}) == copy2.getBoolList("bools"));
+    ASSERT(std::vector<bool>({false, false}) == copy1.getBoolList("bools"));
+    EQ(std::string("a a a"), copy1.cget("strings"));
+    EQ(std::string("x y z"), m_pObject->cget("strings"));
+    
+    // A copy of a copy sees its source's changes:
+    
+    CConfigurableObject copy3(copy1);
+    ASSERT(std::vector<int64_t>({10, 2, 3, 4}) == copy3.getIntegerList("ints"));
+    EQ(m_pObject->cget().size(), copy3.cget().size());
+    
+    CConfigurableObject copy4(copy2);
+    ASSERT(copy4 == copy2);
+    ASSERT(copy4 != copy1);
+}
+// Copies outlive the object they were copied from, including the
+// constraints used by the checkers:
+
+void configobjtest::cowlifetime()
+{
+    m_pObject->addIntegerParameter("limited", 0, 10, 5);
+    m_pObject->addIntListParameter("limitedlist", std::int64_t(0), std::int64_t(10), 1, 4, 2, 1);
+    CConfigurableObject* pCopy = new CConfigurableObject(*m_pObject);
+    delete m_pObject;
+    m_pObject = pCopy;
+    
+    m_pObject->configure("limited", "7");
+    EXCEPTION(m_pObject->configure("limited", "11"), std::string);
+    EQ(std::int64_t(7), m_pObject->getIntegerParameter("limited"));
+    m_pObject->configure("limitedlist", "3 4 5");
+    ASSERT(std::vector<int64_t>({3, 4, 5}) == m_pObject->getIntegerList("limitedlist"));
+}
+// Assignment shares too:
+
+void configobjtest::cowassign()
+{
+    CConfigurableObject other("other");
+    other.addIntegerParameter("x", 3);
+    other = *m_pObject;
+    EXCEPTION(other.cget("x"), std::string);
+    m_pObject->configure("ints", "4 4 4 4");
+    ASSERT(std::vector<int64_t>({1, 1, 1, 1}) == other.getIntegerList("ints"));
+    EQ(std::string("test"), other.getName());
+}
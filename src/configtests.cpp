@@ -29,6 +29,7 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <iostream>
 
 extern std::string connection;
 extern bool        isUsb;
@@ -94,6 +95,9 @@ class cfgtest : public CppUnit::TestFixture {
     CPPUNIT_TEST(filter_1);
     CPPUNIT_TEST(filter_2);
     CPPUNIT_TEST(filter_3);
+    
+    CPPUNIT_TEST(verify_1);
+    CPPUNIT_TEST(verify_2);
     CPPUNIT_TEST_SUITE_END();
     
 private:
@@ -160,6 +164,9 @@ protected:
     void filter_1();
     void filter_2();
     void filter_3();
+    
+    void verify_1();
+    void verify_2();
 private:
     static std::string vecToList(const std::vector<std::string>& strings);
     static std::string vecToListOfIdenticalLists(const std::vector<std::string>& strings, size_t numReps = 64);
@@ -1488,4 +1495,34 @@ void cfgtest::filter_3()
                             
         }
     }
-}
\ No newline at end of file
+}
+
+// A freshly configured module verifies with no mismatches:
+
+void cfgtest::verify_1()
+{
+    m_pConfig->configure("triggerthresholds", itemToList("500"));
+    m_pConfig->configure("inputpolarities", itemToList("Positive"));
+    m_pConfig->configureModule(*m_pModule);
+    
+    auto mismatches = m_pConfig->verifyModule(*m_pModule);
+    for (auto& m : mismatches) {
+        std::cerr << m.s_parameter << " [" << m.s_index << "] "
+            << m.s_expected << " != " << m.s_actual << std::endl;
+    }
+    EQ(size_t(0), mismatches.size());
+}
+// Changing a setting behind the configuration's back is caught:
+
+void cfgtest::verify_2()
+{
+    m_pConfig->configureModule(*m_pModule);
+    m_pModule->setTriggerThreshold(3, 100);
+    
+    auto mismatches = m_pConfig->verifyModule(*m_pModule);
+    EQ(size_t(1), mismatches.size());
+    EQ(std::string("triggerthresholds"), mismatches[0].s_parameter);
+    EQ(3, mismatches[0].s_index);
+    EQ(std::string("1023"), mismatches[0].s_expected);
+    EQ(std::string("100"), mismatches[0].s_actual);
+}
@@ -0,0 +1,117 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  connectionpooltests.cpp
+ *  @brief: Tests of the module connection pool (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "VX2750ConnectionPool.h"
+#include <string>
+#include <vector>
+#include <set>
+
+using namespace caen_nscldaq;
+
+// A pool whose "connections" are just tokens so no modules are needed:
+
+class FakeConnectionPool : public VX2750ConnectionPool {
+public:
+    std::set<VX2750Pha*> m_open;
+    int                  m_connects;
+    FakeConnectionPool() : m_connects(0) {}
+    ~FakeConnectionPool() { clear(); }
+protected:
+    virtual VX2750Pha* connect(const char* pHostOrPid, bool isUsb) {
+        VX2750Pha* pModule = reinterpret_cast<VX2750Pha*>(new char);
+        m_open.insert(pModule);
+        m_connects++;
+        return pModule;
+    }
+    virtual void disconnect(VX2750Pha* pModule) {
+        m_open.erase(pModule);
+        delete reinterpret_cast<char*>(pModule);
+    }
+};
+
+class connectionpooltest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(connectionpooltest);
+    CPPUNIT_TEST(reuse);
+    CPPUNIT_TEST(retain);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+    void tearDown() {}
+protected:
+    void reuse();
+    void retain();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(connectionpooltest);
+
+// Connections are made once per (host, usb) and dropped on request:
+
+void connectionpooltest::reuse()
+{
+    FakeConnectionPool pool;
+    VX2750Pha* p1 = pool.get("host1", false);
+    EQ(p1, pool.get("host1", false));
+    ASSERT(p1 != pool.get("host1", true));
+    EQ(2, pool.m_connects);
+    EQ(size_t(2), pool.size());
+
+    pool.setConfigDigest("host1", false, "digest");
+    EQ(std::string("digest"), pool.getConfigDigest("host1", false));
+    pool.drop("host1", false);
+    ASSERT(!pool.isConnected("host1", false));
+    EQ(std::string(""), pool.getConfigDigest("host1", false));
+    EQ(size_t(1), pool.m_open.size());
+}
+// Connections to modules that aren't listed are closed; the rest survive
+// with their digests:
+
+void connectionpooltest::retain()
+{
+    FakeConnectionPool pool;
+    VX2750Pha* p1 = pool.get("host1", false);
+    pool.get("host2", false);
+    pool.get("1234", true);
+    pool.setConfigDigest("host1", false, "digest");
+
+    std::vector<VX2750ConnectionPool::Key> keys = {
+        VX2750ConnectionPool::Key("host1", false),
+        VX2750ConnectionPool::Key("1234", false),     // Not the USB one.
+        VX2750ConnectionPool::Key("host3", false)     // Never connected.
+    };
+    pool.retain(keys);
+
+    EQ(size_t(1), pool.size());
+    EQ(size_t(1), pool.m_open.size());
+    ASSERT(pool.isConnected("host1", false));
+    ASSERT(!pool.isConnected("host2", false));
+    ASSERT(!pool.isConnected("1234", true));
+    ASSERT(!pool.isConnected("host3", false));
+    EQ(p1, pool.get("host1", false));
+    EQ(std::string("digest"), pool.getConfigDigest("host1", false));
+    EQ(3, pool.m_connects);
+
+    pool.retain(std::vector<VX2750ConnectionPool::Key>());
+    EQ(size_t(0), pool.size());
+    EQ(size_t(0), pool.m_open.size());
+}
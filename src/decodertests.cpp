@@ -0,0 +1,352 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  decodertests.cpp
+ *  @brief: Tests of the offline event file decoder (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "OfflineTestData.h"
+#include "VX2750EventFile.h"
+#include "VX2750OfflineDecoder.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <new>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace caen_offline;
+using namespace offline_test;
+
+// Keeps copies of the hits it sees:
+
+class HitList : public VX2750HitVisitor {
+public:
+    std::vector<VX2750Hit>   m_hits;
+    std::vector<std::string> m_names;
+    virtual void hit(const VX2750Hit& hit) {
+        m_hits.push_back(hit);
+        m_names.push_back(hit.s_moduleName);
+    }
+};
+
+// Throws from the n'th hit:
+
+class FailingVisitor : public VX2750HitVisitor {
+public:
+    unsigned m_left;
+    bool     m_alloc;
+    FailingVisitor(unsigned n, bool alloc) : m_left(n), m_alloc(alloc) {}
+    virtual void hit(const VX2750Hit& hit) {
+        if (--m_left == 0) {
+            if (m_alloc) throw std::bad_alloc();
+            throw std::runtime_error("visitor failed");
+        }
+    }
+};
+
+class decodertest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(decodertest);
+    CPPUNIT_TEST(unbuilt);
+    CPPUNIT_TEST(probes);
+    CPPUNIT_TEST(nobodyheader);
+    CPPUNIT_TEST(eventbuilt);
+    CPPUNIT_TEST(malformed);
+    CPPUNIT_TEST(visitorerror);
+    CPPUNIT_TEST(chunks);
+    CPPUNIT_TEST(partial);
+    CPPUNIT_TEST(parallel);
+    CPPUNIT_TEST(runfile);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+    void tearDown() {}
+protected:
+    void unbuilt();
+    void probes();
+    void nobodyheader();
+    void eventbuilt();
+    void malformed();
+    void visitorerror();
+    void chunks();
+    void partial();
+    void parallel();
+    void runfile();
+private:
+    Bytes manyEvents(unsigned n);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(decodertest);
+
+// n event built events each with two hits, interspersed with
+// non physics items:
+
+Bytes decodertest::manyEvents(unsigned n)
+{
+    Bytes data = item(VX2750EventFile::BEGIN_RUN, Bytes(40, 0));
+    for (unsigned i = 0; i < n; i++) {
+        std::vector<Bytes> frags = {
+            fragment(1, i*100, hit("adc1", i % 64, i*100, i, i % 7)),
+            fragment(2, i*100 + 1, hit("adc2", 3, i*100 + 1, i + 1))
+        };
+        append(data, item(VX2750EventFile::PHYSICS_EVENT, built(frags), 0, i*100));
+        if (i % 10 == 0) {
+            append(data, item(20, Bytes(12, 0), 0));          // Scalers.
+        }
+    }
+    append(data, item(VX2750EventFile::END_RUN, Bytes(40, 0)));
+    return data;
+}
+
+// An unbuilt physics item with a body header decodes to one hit:
+
+void decodertest::unbuilt()
+{
+    Bytes data = item(VX2750EventFile::PHYSICS_EVENT, hit("adc1", 12, 123456, 1000), 7, 123456);
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    HitList hits;
+    auto stats = decoder.decode(file.chunks(1)[0], hits);
+
+    EQ(std::uint64_t(1), stats.s_items);
+    EQ(std::uint64_t(1), stats.s_physicsItems);
+    EQ(std::uint64_t(1), stats.s_hits);
+    EQ(std::uint64_t(0), stats.s_errors);
+    EQ(std::uint64_t(data.size()), stats.s_bytes);
+
+    EQ(size_t(1), hits.m_hits.size());
+    auto& h(hits.m_hits[0]);
+    EQ(std::string("adc1"), hits.m_names[0]);
+    EQ(std::uint32_t(7), h.s_sourceId);
+    EQ(std::uint64_t(0), h.s_itemOffset);
+    EQ(std::uint16_t(12), h.s_channel);
+    EQ(std::uint64_t(123456), h.s_timestamp);
+    EQ(std::uint64_t(123456/8), h.s_rawTimestamp);
+    EQ(std::uint16_t(3), h.s_fineTimestamp);
+    EQ(std::uint16_t(1000), h.s_energy);
+    EQ(std::uint16_t(0x11), h.s_lowPriorityFlags);
+    EQ(std::uint16_t(0x22), h.s_highPriorityFlags);
+    EQ(std::uint16_t(1), h.s_downSampleSelection);
+    EQ(std::uint16_t(0), h.s_failFlags);
+}
+// Probes point at the samples in the data:
+
+void decodertest::probes()
+{
+    Bytes data = item(VX2750EventFile::PHYSICS_EVENT, hit("module", 0, 1, 2, 5), 1);
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    HitList hits;
+    auto stats = decoder.decode(file.chunks(1)[0], hits);
+    EQ(std::uint64_t(0), stats.s_errors);
+
+    auto& h(hits.m_hits[0]);
+    EQ(std::uint16_t(5), h.s_analogProbes[0].s_type);
+    EQ(std::uint32_t(5), h.s_analogProbes[0].s_nSamples);
+    for (unsigned i = 0; i < 5; i++) {
+        EQ(std::uint32_t(i*10), h.s_analogProbes[0].s_pSamples[i]);
+    }
+    EQ(std::uint16_t(6), h.s_analogProbes[1].s_type);
+    EQ(std::uint32_t(0), h.s_analogProbes[1].s_nSamples);
+    for (int p = 0; p < 4; p++) {
+        EQ(std::uint16_t(p), h.s_digitalProbes[p].s_type);
+        EQ(std::uint32_t(5), h.s_digitalProbes[p].s_nSamples);
+        EQ(std::uint8_t(p + 4), h.s_digitalProbes[p].s_pSamples[4]);
+    }
+    const std::uint8_t* pSamples =
+        reinterpret_cast<const std::uint8_t*>(h.s_analogProbes[0].s_pSamples);
+    ASSERT(pSamples > data.data() && pSamples < data.data() + data.size());
+}
+// Without a body header there's no source id:
+
+void decodertest::nobodyheader()
+{
+    Bytes data = item(VX2750EventFile::PHYSICS_EVENT, hit("adc1", 1, 2, 3));
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    HitList hits;
+    decoder.decode(file.chunks(1)[0], hits);
+    EQ(size_t(1), hits.m_hits.size());
+    EQ(VX2750Hit::NO_SOURCE, hits.m_hits[0].s_sourceId);
+}
+// Event built data gives a hit per fragment tagged with the fragment's sid:
+
+void decodertest::eventbuilt()
+{
+    Bytes data = item(VX2750EventFile::BEGIN_RUN, Bytes(40, 0));
+    std::size_t eventOffset = data.size();
+    std::vector<Bytes> frags = {
+        fragment(3, 100, hit("adc1", 1, 100, 10)),
+        fragment(9, 105, hit("adc22", 2, 105, 20, 3))
+    };
+    append(data, item(VX2750EventFile::PHYSICS_EVENT, built(frags), 0, 100));
+
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    HitList hits;
+    auto stats = decoder.decode(file.chunks(1)[0], hits);
+
+    EQ(std::uint64_t(2), stats.s_items);
+    EQ(std::uint64_t(1), stats.s_physicsItems);
+    EQ(std::uint64_t(2), stats.s_hits);
+    EQ(std::uint64_t(0), stats.s_errors);
+
+    EQ(std::string("adc1"), hits.m_names[0]);
+    EQ(std::uint32_t(3), hits.m_hits[0].s_sourceId);
+    EQ(std::uint16_t(10), hits.m_hits[0].s_energy);
+    EQ(std::uint64_t(eventOffset), hits.m_hits[0].s_itemOffset);
+
+    EQ(std::string("adc22"), hits.m_names[1]);
+    EQ(std::uint32_t(9), hits.m_hits[1].s_sourceId);
+    EQ(std::uint64_t(105), hits.m_hits[1].s_timestamp);
+    EQ(std::uint32_t(3), hits.m_hits[1].s_analogProbes[0].s_nSamples);
+    EQ(std::uint64_t(eventOffset), hits.m_hits[1].s_itemOffset);
+}
+// A bad item is counted and skipped:
+
+void decodertest::malformed()
+{
+    Bytes bad = hit("adc1", 1, 2, 3);
+    std::uint32_t words = bad.size()/2 + 2;           // Claims more than it has.
+    memcpy(bad.data(), &words, sizeof(words));
+    bad.push_back(0); bad.push_back(0); bad.push_back(0); bad.push_back(0);
+
+    Bytes data = item(VX2750EventFile::PHYSICS_EVENT, bad, 1);
+    append(data, item(VX2750EventFile::PHYSICS_EVENT, hit("adc1", 4, 5, 6), 1));
+
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    HitList hits;
+    auto stats = decoder.decode(file.chunks(1)[0], hits);
+
+    EQ(std::uint64_t(2), stats.s_physicsItems);
+    EQ(std::uint64_t(1), stats.s_errors);
+    ASSERT(!stats.s_firstError.empty());
+    EQ(std::uint64_t(1), stats.s_hits);
+    EQ(std::uint16_t(4), hits.m_hits.back().s_channel);
+}
+// Exceptions from visitors are not malformed items; they end the decode:
+
+void decodertest::visitorerror()
+{
+    Bytes data = manyEvents(100);
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+
+    FailingVisitor failing(3, false);
+    EXCEPTION(decoder.decode(file.chunks(1)[0], failing), std::runtime_error);
+    EQ(0U, failing.m_left);
+
+    FailingVisitor noMemory(50, true);
+    HitList hits;
+    std::vector<VX2750HitVisitor*> visitors = {&hits, &noMemory};
+    EXCEPTION(decoder.decode(visitors), std::bad_alloc);
+}
+// Chunks start on items, don't overlap and cover the file:
+
+void decodertest::chunks()
+{
+    Bytes data = manyEvents(1000);
+    VX2750EventFile file(data.data(), data.size());
+    auto chunks = file.chunks(7);
+    EQ(size_t(7), chunks.size());
+    EQ(std::uint64_t(0), chunks.front().s_begin);
+    EQ(std::uint64_t(data.size()), chunks.back().s_end);
+    for (int i = 1; i < chunks.size(); i++) {
+        EQ(chunks[i-1].s_end, chunks[i].s_begin);
+        ASSERT(chunks[i].s_end > chunks[i].s_begin);
+    }
+    // More chunks than items:
+
+    Bytes one = item(VX2750EventFile::BEGIN_RUN, Bytes(40, 0));
+    VX2750EventFile small(one.data(), one.size());
+    EQ(size_t(1), small.chunks(4).size());
+
+    VX2750EventFile empty(one.data(), 0);
+    EQ(size_t(0), empty.chunks(4).size());
+}
+// A partial last item is not decoded:
+
+void decodertest::partial()
+{
+    Bytes data = manyEvents(10);
+    std::size_t complete = data.size();
+    Bytes next = item(VX2750EventFile::PHYSICS_EVENT, hit("adc1", 1, 2, 3), 1);
+    data.insert(data.end(), next.begin(), next.begin() + next.size()/2);
+
+    VX2750EventFile file(data.data(), data.size());
+    auto chunks = file.chunks(3);
+    EQ(std::uint64_t(complete), chunks.back().s_end);
+}
+// Parallel decoding sees the same hits, in order, as serial decoding:
+
+void decodertest::parallel()
+{
+    Bytes data = manyEvents(5000);
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+
+    HitList serial;
+    std::vector<VX2750HitVisitor*> one = {&serial};
+    auto serialStats = decoder.decode(one);
+
+    std::vector<HitList> lists(4);
+    std::vector<VX2750HitVisitor*> visitors;
+    for (auto& l : lists) visitors.push_back(&l);
+    auto stats = decoder.decode(visitors);
+
+    EQ(std::uint64_t(10000), serialStats.s_hits);
+    EQ(serialStats.s_hits, stats.s_hits);
+    EQ(serialStats.s_items, stats.s_items);
+    EQ(std::uint64_t(data.size()), stats.s_bytes);
+    EQ(std::uint64_t(0), stats.s_errors);
+
+    size_t n = 0;
+    for (auto& l : lists) {
+        ASSERT(!l.m_hits.empty());
+        for (auto& h : l.m_hits) {
+            EQ(serial.m_hits[n].s_timestamp, h.s_timestamp);
+            EQ(serial.m_hits[n].s_itemOffset, h.s_itemOffset);
+            n++;
+        }
+    }
+    EQ(serial.m_hits.size(), n);
+}
+// The sample run in the SpecTcl example decodes cleanly:
+
+void decodertest::runfile()
+{
+    const char* name = "tclreadout/SpecTcl/run-0001-00.evt";
+    if (access(name, R_OK)) return;                 // Not run from src.
+
+    VX2750EventFile file(name);
+    VX2750OfflineDecoder decoder(file);
+    HitList hits;
+    std::vector<VX2750HitVisitor*> visitors = {&hits};
+    auto stats = decoder.decode(visitors);
+
+    EQ(std::uint64_t(file.size()), stats.s_bytes);
+    EQ(std::uint64_t(0), stats.s_errors);
+    EQ(std::uint64_t(156), stats.s_physicsItems);
+    EQ(std::uint64_t(9984), stats.s_hits);
+    for (auto& name : hits.m_names) {
+        EQ(std::string("adc1"), name);
+    }
+}
@@ -0,0 +1,163 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  enumtabletests.cpp
+ *  @brief: Tests of the string <-> enum conversion tables (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "VX2750EnumTable.h"
+#include "VX2750Pha.h"
+#include <string>
+#include <stdexcept>
+
+using namespace caen_nscldaq;
+
+typedef enum _Color {
+    Red, Green, Blue, Black
+} Color;
+
+class enumtabletest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(enumtabletest);
+    CPPUNIT_TEST(find);
+    CPPUNIT_TEST(caseblind);
+    CPPUNIT_TEST(nomatch);
+    CPPUNIT_TEST(name);
+    CPPUNIT_TEST(firstname);
+    CPPUNIT_TEST(caseduplicate);
+    CPPUNIT_TEST(large);
+    CPPUNIT_TEST(phatables);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    VX2750EnumTable<Color>* m_pTable;
+public:
+    void setUp() {
+        m_pTable = new VX2750EnumTable<Color>({
+            {"Red", Red}, {"Green", Green}, {"Blue", Blue}, {"Cyan", Green}
+        });
+    }
+    void tearDown() {
+        delete m_pTable;
+    }
+protected:
+    void find();
+    void caseblind();
+    void nomatch();
+    void name();
+    void firstname();
+    void caseduplicate();
+    void large();
+    void phatables();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(enumtabletest);
+
+// Every name can be found:
+
+void enumtabletest::find()
+{
+    EQ(size_t(4), m_pTable->size());
+    auto p = m_pTable->find("Red");
+    ASSERT(p);
+    EQ(Red, p->second);
+    EQ(std::string("Red"), p->first);
+    EQ(Green, m_pTable->find("Green")->second);
+    EQ(Blue, m_pTable->find("Blue")->second);
+    EQ(Green, m_pTable->find("Cyan")->second);
+}
+// Lookups ignore case:
+
+void enumtabletest::caseblind()
+{
+    EQ(Red, m_pTable->find("RED")->second);
+    EQ(Blue, m_pTable->find("bLuE")->second);
+    EQ(Green, m_pTable->find(std::string("cyan"))->second);
+}
+// Unknown names (including prefixes/extensions of good ones) give nullptr:
+
+void enumtabletest::nomatch()
+{
+    ASSERT(!m_pTable->find("Black"));
+    ASSERT(!m_pTable->find(""));
+    ASSERT(!m_pTable->find("Re"));
+    ASSERT(!m_pTable->find("Reddish"));
+}
+// enum -> name:
+
+void enumtabletest::name()
+{
+    EQ(std::string("Red"), *(m_pTable->name(Red)));
+    EQ(std::string("Blue"), *(m_pTable->name(Blue)));
+    ASSERT(!m_pTable->name(Black));                 // Has no name.
+    ASSERT(!m_pTable->name(static_cast<Color>(100)));
+}
+// If a value has several names, the first one is used:
+
+void enumtabletest::firstname()
+{
+    EQ(std::string("Green"), *(m_pTable->name(Green)));
+}
+// Names that only differ in case can't be told apart:
+
+void enumtabletest::caseduplicate()
+{
+    EXCEPTION(
+        (VX2750EnumTable<Color>({{"Red", Red}, {"RED", Blue}})),
+        std::logic_error
+    );
+}
+// Plenty of names still hash perfectly:
+
+void enumtabletest::large()
+{
+    VX2750EnumTable<Color> table({
+        {"a0", Red}, {"a1", Red}, {"a2", Red}, {"a3", Red}, {"a4", Red},
+        {"a5", Red}, {"a6", Red}, {"a7", Red}, {"a8", Red}, {"a9", Red},
+        {"b0", Green}, {"b1", Green}, {"b2", Green}, {"b3", Green},
+        {"b4", Green}, {"b5", Green}, {"b6", Green}, {"b7", Green},
+        {"c0", Blue}, {"c1", Blue}, {"c2", Blue}, {"c3", Blue}
+    });
+    for (auto& e : table.entries()) {
+        auto p = table.find(e.first);
+        ASSERT(p);
+        EQ(e.first, p->first);
+    }
+}
+// The digitizer's tables convert both ways for every entry:
+
+void enumtabletest::phatables()
+{
+    for (auto& e : VX2750Pha::stringToClockSource.entries()) {
+        EQ(e.second, VX2750Pha::stringToClockSource.find(e.first)->second);
+        EQ(e.first, *(VX2750Pha::stringToClockSource.name(e.second)));
+    }
+    for (auto& e : VX2750Pha::stringToDigitalProbe.entries()) {
+        EQ(e.second, VX2750Pha::stringToDigitalProbe.find(e.first)->second);
+        EQ(e.first, *(VX2750Pha::stringToDigitalProbe.name(e.second)));
+    }
+    // Regression check (not a fix; the old maps handled Res8 too): both
+    // directions now come from one list, so the reverse lookup must find
+    // every value, including the first.
+
+    EQ(
+        std::string("Res8"),
+        *(VX2750Pha::stringToWaveResolution.name(VX2750Pha::Res8))
+    );
+    EQ(VX2750Pha::FrontPanel, VX2750Pha::stringToClockSource.find("fpclkin")->second);
+}
@@ -0,0 +1,288 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  histtests.cpp
+ *  @brief: Tests of the energy histogrammer (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "OfflineTestData.h"
+#include "VX2750EnergyHistogrammer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+using namespace offline_test;
+
+class histtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(histtest);
+    CPPUNIT_TEST(energy);
+    CPPUNIT_TEST(time);
+    CPPUNIT_TEST(parallel);
+    CPPUNIT_TEST(files);
+    CPPUNIT_TEST(binary);
+    CPPUNIT_TEST(ascii);
+    CPPUNIT_TEST(parameters);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_filename;
+public:
+    void setUp() {
+        char name[] = "/tmp/histtestXXXXXX";
+        close(mkstemp(name));
+        m_filename = name;
+    }
+    void tearDown() {
+        unlink(m_filename.c_str());
+    }
+protected:
+    void energy();
+    void time();
+    void parallel();
+    void files();
+    void binary();
+    void ascii();
+    void parameters();
+private:
+    Bytes hits(const char* module, unsigned n, std::uint64_t spacing);
+    Bytes readFile();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(histtest);
+
+// n unbuilt hits spacing ns apart: hit i is in channel i % 8 with
+// energy (i*97) % 65536.
+
+Bytes histtest::hits(const char* module, unsigned n, std::uint64_t spacing)
+{
+    Bytes data = item(1, Bytes(16, 0));
+    for (unsigned i = 0; i < n; i++) {
+        std::uint64_t t = i*spacing;
+        append(data, item(30, hit(module, i % 8, t, (i*97) % 65536), 1, t));
+    }
+    return data;
+}
+Bytes histtest::readFile()
+{
+    std::ifstream in(m_filename.c_str(), std::ios::binary);
+    std::stringstream s;
+    s << in.rdbuf();
+    std::string text = s.str();
+    return Bytes(text.begin(), text.end());
+}
+
+// Hits land in their channel's energy bin; bad channels are counted:
+
+void histtest::energy()
+{
+    Bytes data = hits("adc1", 1000, 10);
+    append(data, item(30, hit("adc1", 64, 0, 100), 1, 0));     // Bad channel.
+    VX2750EventFile file(data.data(), data.size());
+    VX2750EnergyHistogrammer histogrammer(1024);
+    auto stats = histogrammer.addFile(file);
+    EQ(std::uint64_t(1001), stats.s_hits);
+
+    auto pModule = histogrammer.findModule("adc1");
+    ASSERT(pModule);
+    EQ(std::uint64_t(1001), pModule->s_hits);
+    EQ(std::uint64_t(1), pModule->s_badChannels);
+    EQ(size_t(64*1024), pModule->s_energy.size());
+
+    std::vector<std::uint64_t> expected(64*1024, 0);
+    for (unsigned i = 0; i < 1000; i++) {
+        expected[(i % 8)*1024 + ((i*97) % 65536)/64]++;
+    }
+    ASSERT(expected == pModule->s_energy);
+    ASSERT(!histogrammer.findModule("adc2"));
+}
+// Energy vs. time rows follow the hits, in or out of order:
+
+void histtest::time()
+{
+    Bytes data;
+    std::uint64_t times[] = {5000, 5999, 7000, 2500, 4000000000ULL};
+    for (int i = 0; i < 5; i++) {
+        append(data, item(30, hit("adc1", 0, times[i], 256*i), 1, times[i]));
+    }
+    VX2750EventFile file(data.data(), data.size());
+    VX2750EnergyHistogrammer histogrammer(4096, 256, 1000);
+    histogrammer.addFile(file);
+
+    auto& m(histogrammer.getModules()[0]);
+    EQ(std::uint64_t(2), m.s_firstTimeBin);
+    EQ(size_t(6*256), m.s_energyTime.size());            // 2000..7999
+    EQ(std::uint64_t(1), m.s_energyTime[(5-2)*256 + 0]);
+    EQ(std::uint64_t(1), m.s_energyTime[(5-2)*256 + 1]);
+    EQ(std::uint64_t(1), m.s_energyTime[(7-2)*256 + 2]);
+    EQ(std::uint64_t(1), m.s_energyTime[(2-2)*256 + 3]);
+    EQ(std::uint64_t(1), m.s_timeOverflows);              // Too far away.
+    EQ(std::uint64_t(5), m.s_hits);
+
+    // The limit is in bytes: 65536 energy bins leave room for 128 rows.
+
+    VX2750EnergyHistogrammer fine(4096, 65536, 1);
+    EQ(size_t(128), fine.getMaxTimeBins());
+    Bytes few;
+    std::uint64_t fineTimes[] = {1000, 1127, 1128, 999, 872};
+    for (int i = 0; i < 5; i++) {
+        append(few, item(30, hit("adc1", 0, fineTimes[i], 0), 1, fineTimes[i]));
+    }
+    VX2750EventFile fewFile(few.data(), few.size());
+    fine.addFile(fewFile, 2);
+    auto& f(fine.getModules()[0]);
+    EQ(std::uint64_t(1000), f.s_firstTimeBin);
+    EQ(size_t(128*65536), f.s_energyTime.size());
+    ASSERT(f.s_energyTime.capacity()*sizeof(std::uint64_t) <= VX2750EnergyHistogrammer::MAX_TIME_BYTES);
+    EQ(std::uint64_t(3), f.s_timeOverflows);
+}
+// Histograms filled in parallel are the same as those filled serially:
+
+void histtest::parallel()
+{
+    Bytes data = hits("adc1", 5000, 1000);
+    append(data, hits("adc2", 5000, 700));
+    VX2750EventFile file(data.data(), data.size());
+    VX2750EnergyHistogrammer serial(4096, 64, 100000);
+    VX2750EnergyHistogrammer parallel(4096, 64, 100000);
+    serial.addFile(file, 1);
+    parallel.addFile(file, 4);
+
+    EQ(size_t(2), parallel.getModules().size());
+    for (int i = 0; i < 2; i++) {
+        auto& s(serial.getModules()[i]);
+        auto& p(parallel.getModules()[i]);
+        EQ(s.s_module, p.s_module);
+        EQ(std::uint64_t(5000), p.s_hits);
+        ASSERT(s.s_energy == p.s_energy);
+        EQ(s.s_firstTimeBin, p.s_firstTimeBin);
+        ASSERT(s.s_energyTime == p.s_energyTime);
+    }
+}
+// Files add up and modules are kept in name order:
+
+void histtest::files()
+{
+    Bytes a = hits("adc2", 100, 10);
+    Bytes b = hits("adc1", 100, 10);
+    VX2750EventFile fa(a.data(), a.size());
+    VX2750EventFile fb(b.data(), b.size());
+    VX2750EnergyHistogrammer histogrammer;
+    histogrammer.addFile(fa);
+    histogrammer.addFile(fb);
+    histogrammer.addFile(fa, 2);
+
+    auto& modules(histogrammer.getModules());
+    EQ(size_t(2), modules.size());
+    EQ(std::string("adc1"), modules[0].s_module);
+    EQ(std::uint64_t(100), modules[0].s_hits);
+    EQ(std::string("adc2"), modules[1].s_module);
+    EQ(std::uint64_t(200), modules[1].s_hits);
+    EQ(std::uint64_t(2), modules[1].s_energy[0]);         // Hit 0 twice.
+}
+// The binary form holds each histogram with its axes:
+
+void histtest::binary()
+{
+    Bytes data = hits("adc1", 100, 10);
+    VX2750EventFile file(data.data(), data.size());
+    VX2750EnergyHistogrammer histogrammer(256, 16, 500);
+    histogrammer.addFile(file);
+    histogrammer.writeBinary(m_filename.c_str());
+    Bytes out = readFile();
+
+    typedef VX2750EnergyHistogrammer H;
+    const std::uint8_t* p = out.data();
+    auto pHeader = reinterpret_cast<const H::FileHeader*>(p);
+    EQ(0, memcmp(pHeader->s_magic, H::MAGIC, sizeof(H::MAGIC)));
+    EQ(H::VERSION, pHeader->s_version);
+    EQ(std::uint32_t(2), pHeader->s_histograms);
+    p += sizeof(H::FileHeader);
+
+    auto& m(histogrammer.getModules()[0]);
+    const std::vector<std::uint64_t>* contents[] = {&m.s_energy, &m.s_energyTime};
+    std::uint32_t types[]   = {H::ENERGY_BY_CHANNEL, H::ENERGY_VS_TIME};
+    std::uint32_t xBins[]   = {64, 2};                    // 0..990 ns.
+    std::uint32_t yBins[]   = {256, 16};
+    std::uint64_t xWidths[] = {1, 500};
+    std::uint64_t yWidths[] = {256, 4096};
+    for (int i = 0; i < 2; i++) {
+        H::HistogramHeader h;
+        memcpy(&h, p, sizeof(h));
+        p += sizeof(h);
+        EQ(types[i], h.s_type);
+        EQ(xBins[i], h.s_xBins);
+        EQ(yBins[i], h.s_yBins);
+        EQ(std::uint64_t(0), h.s_xOrigin);
+        EQ(xWidths[i], h.s_xWidth);
+        EQ(yWidths[i], h.s_yWidth);
+        EQ(std::string("adc1"), std::string(reinterpret_cast<const char*>(p), h.s_nameBytes));
+        p += h.s_nameBytes;
+
+        std::vector<std::uint64_t> counts(h.s_xBins*h.s_yBins);
+        memcpy(counts.data(), p, counts.size()*sizeof(std::uint64_t));
+        p += counts.size()*sizeof(std::uint64_t);
+        ASSERT(*contents[i] == counts);
+    }
+    EQ(out.data() + out.size(), p);
+}
+// The text form lists the nonzero bins:
+
+void histtest::ascii()
+{
+    Bytes data;
+    append(data, item(30, hit("adc1", 3, 2500, 1000), 1, 2500));
+    append(data, item(30, hit("adc1", 3, 2600, 1100), 1, 2600));
+    VX2750EventFile file(data.data(), data.size());
+    VX2750EnergyHistogrammer histogrammer(1024, 16, 1000);
+    histogrammer.addFile(file);
+    histogrammer.writeAscii(m_filename.c_str());
+    Bytes out = readFile();
+    std::string text(out.begin(), out.end());
+
+    std::string expected =
+        "# energy-by-channel adc1 64 0 1 1024 64\n"
+        "3 960 1\n"
+        "3 1088 1\n"
+        "\n"
+        "# energy-vs-time adc1 1 2000 1000 16 4096\n"
+        "2000 0 2\n"
+        "\n";
+    EQ(expected, text);
+}
+// Bin counts must be powers of two within the energy range:
+
+void histtest::parameters()
+{
+    EXCEPTION(VX2750EnergyHistogrammer bad(1000), std::invalid_argument);
+    EXCEPTION(VX2750EnergyHistogrammer bad(131072), std::invalid_argument);
+    EXCEPTION(VX2750EnergyHistogrammer bad(1024, 0), std::invalid_argument);
+    EXCEPTION(VX2750EnergyHistogrammer bad(1024, 256, 0), std::invalid_argument);
+    VX2750EnergyHistogrammer one(1, 65536, 1);
+    EQ(1U, one.getEnergyBins());
+
+    VX2750EnergyHistogrammer histogrammer;
+    EXCEPTION(histogrammer.writeBinary("/nonexistent/directory/hists"), std::system_error);
+}
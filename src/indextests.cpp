@@ -0,0 +1,305 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  indextests.cpp
+ *  @brief: Tests of event file indices (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "OfflineTestData.h"
+#include "VX2750OfflineDecoder.h"
+#include "VX2750TimeIndex.h"
+#include "VX2750TimeIndexer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace caen_offline;
+using namespace offline_test;
+
+// Counts the hits in a window from a channel (module empty for any):
+
+class HitCounter : public VX2750HitVisitor {
+public:
+    std::uint64_t m_from, m_to;
+    std::string   m_module;
+    unsigned      m_channel;
+    unsigned      m_hits;
+    HitCounter(std::uint64_t from, std::uint64_t to, const char* module = "", unsigned channel = 0) :
+        m_from(from), m_to(to), m_module(module), m_channel(channel), m_hits(0) {}
+    virtual void hit(const VX2750Hit& hit) {
+        if (hit.s_timestamp < m_from || hit.s_timestamp > m_to) return;
+        if (!m_module.empty() &&
+            (m_module != hit.s_moduleName || hit.s_channel != m_channel)) return;
+        m_hits++;
+    }
+};
+
+class indextest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(indextest);
+    CPPUNIT_TEST(build);
+    CPPUNIT_TEST(time);
+    CPPUNIT_TEST(channel);
+    CPPUNIT_TEST(incremental);
+    CPPUNIT_TEST(parallel);
+    CPPUNIT_TEST(torn);
+    CPPUNIT_TEST(mismatch);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_filename;
+    Bytes       m_data;
+public:
+    void setUp() {
+        char name[] = "/tmp/indextestXXXXXX";
+        int fd = mkstemp(name);
+        close(fd);
+        unlink(name);                      // The indexer creates it.
+        m_filename = name;
+        m_data = events(200);
+    }
+    void tearDown() {
+        unlink(m_filename.c_str());
+    }
+protected:
+    void build();
+    void time();
+    void channel();
+    void incremental();
+    void parallel();
+    void torn();
+    void mismatch();
+private:
+    Bytes    events(unsigned n);
+    void     checkBlocks(const VX2750TimeIndex& index, std::size_t size);
+    unsigned count(
+        const std::vector<VX2750EventFile::Chunk>& chunks, HitCounter& counter
+    );
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(indextest);
+
+// n event built events with two hits each; event i's hits are at i*100
+// (adc1, channel i % 64) and i*100 + 1 (adc2, channel 3).  A begin run
+// item comes first so the first block starts with an item without hits.
+
+Bytes indextest::events(unsigned n)
+{
+    Bytes data = item(1, Bytes(16, 0));
+    for (unsigned i = 0; i < n; i++) {
+        std::vector<Bytes> frags = {
+            fragment(1, i*100, hit("adc1", i % 64, i*100, i)),
+            fragment(2, i*100 + 1, hit("adc2", 3, i*100 + 1, i))
+        };
+        append(data, item(30, built(frags), 0, i*100));
+    }
+    return data;
+}
+// The blocks cover [0, size) with no gaps and hold all the hits:
+
+void indextest::checkBlocks(const VX2750TimeIndex& index, std::size_t size)
+{
+    std::uint64_t offset = 0;
+    std::uint64_t hits = 0;
+    for (auto& b : index.getBlocks()) {
+        EQ(offset, b.s_begin);
+        ASSERT(b.s_end > b.s_begin);
+        offset = b.s_end;
+        hits += b.s_hits;
+    }
+    EQ(std::uint64_t(size), offset);
+    EQ(std::uint64_t(size), index.indexedBytes());
+    EQ(std::uint64_t(400), hits);
+}
+// Hits counted decoding only some chunks of m_data:
+
+unsigned indextest::count(
+    const std::vector<VX2750EventFile::Chunk>& chunks, HitCounter& counter
+)
+{
+    VX2750EventFile file(m_data.data(), m_data.size());
+    VX2750OfflineDecoder decoder(file);
+    for (auto& c : chunks) {
+        decoder.decode(c, counter);
+    }
+    return counter.m_hits;
+}
+
+// Building an index covers the file with blocks of about the right size:
+
+void indextest::build()
+{
+    VX2750EventFile file(m_data.data(), m_data.size());
+    VX2750TimeIndexer indexer(m_filename.c_str(), 2048);
+    auto stats = indexer.update(file);
+    EQ(std::uint64_t(400), stats.s_hits);
+
+    VX2750TimeIndex index(m_filename.c_str());
+    EQ(std::uint32_t(2048), index.getBlockBytes());
+    checkBlocks(index, m_data.size());
+    ASSERT(index.getBlocks().size() > 5);
+    EQ(size_t(2), index.getModules().size());
+    EQ(0, index.findModule("adc1"));
+    EQ(1, index.findModule("adc2"));
+    EQ(-1, index.findModule("adc3"));
+
+    auto& first(index.getBlocks()[0]);
+    EQ(std::uint64_t(0), first.s_minTimestamp);
+    EQ(size_t(2), first.s_modules.size());
+    EQ(VX2750TimeIndex::channelBit(3), first.s_modules[1].s_channels);
+    for (std::size_t i = 0; i + 1 < index.getBlocks().size(); i++) {
+        auto& b(index.getBlocks()[i]);
+        ASSERT(b.s_end - b.s_begin >= 2048);
+        EQ(b.s_hits/2, std::uint64_t(b.s_modules[0].s_hits));
+    }
+}
+// Time queries return fewer bytes and every hit in the window:
+
+void indextest::time()
+{
+    VX2750EventFile file(m_data.data(), m_data.size());
+    VX2750TimeIndexer indexer(m_filename.c_str(), 2048);
+    indexer.update(file);
+    auto& index(indexer.getIndex());
+
+    auto chunks = index.findTime(10000, 10999);
+    ASSERT(!chunks.empty());
+    std::uint64_t bytes = 0;
+    for (auto& c : chunks) bytes += c.s_end - c.s_begin;
+    ASSERT(bytes < m_data.size()/4);
+
+    HitCounter counter(10000, 10999);
+    EQ(20U, count(chunks, counter));
+
+    EQ(size_t(0), index.findTime(100000, 200000).size());
+}
+// Channel queries return the blocks with that channel:
+
+void indextest::channel()
+{
+    VX2750EventFile file(m_data.data(), m_data.size());
+    VX2750TimeIndexer indexer(m_filename.c_str(), 2048);
+    indexer.update(file);
+    auto& index(indexer.getIndex());
+
+    auto chunks = index.findChannel("adc1", 5);   // Events 5, 69, 133, 197.
+    std::uint64_t bytes = 0;
+    for (auto& c : chunks) bytes += c.s_end - c.s_begin;
+    ASSERT(bytes < m_data.size());
+    HitCounter counter(0, ~std::uint64_t(0), "adc1", 5);
+    EQ(4U, count(chunks, counter));
+
+    HitCounter windowed(10000, 19999, "adc1", 5);
+    EQ(2U, count(index.find(10000, 19999, "adc1", 5), windowed));     // 133, 197
+
+    EQ(size_t(0), index.findChannel("adc3", 5).size());
+    EQ(size_t(1), index.findChannel("adc2", 3).size());       // Merged.
+}
+// Indexing a growing file a piece at a time gives a complete index:
+
+void indextest::incremental()
+{
+    std::size_t cuts[] = {1000, 5001, 5002, 12345, m_data.size()};
+    VX2750TimeIndex* pReader = nullptr;
+    for (auto cut : cuts) {
+        VX2750EventFile file(m_data.data(), cut);
+        VX2750TimeIndexer indexer(m_filename.c_str(), 2048);
+        indexer.update(file, 2);
+        ASSERT(indexer.getIndex().indexedBytes() <= cut);
+        ASSERT(cut - indexer.getIndex().indexedBytes() < 400);   // Partial item.
+
+        // A reader that follows the index sees the new blocks:
+
+        if (!pReader) pReader = new VX2750TimeIndex(m_filename.c_str());
+        pReader->refresh();
+        EQ(indexer.getIndex().getBlocks().size(), pReader->getBlocks().size());
+    }
+    checkBlocks(*pReader, m_data.size());
+    HitCounter counter(10000, 10999);
+    EQ(20U, count(pReader->findTime(10000, 10999), counter));
+    delete pReader;
+}
+// Parallel indexing gives the same answers:
+
+void indextest::parallel()
+{
+    VX2750EventFile file(m_data.data(), m_data.size());
+    VX2750TimeIndexer indexer(m_filename.c_str(), 2048);
+    indexer.update(file, 4);
+    checkBlocks(indexer.getIndex(), m_data.size());
+
+    HitCounter counter(5000, 7999);
+    EQ(60U, count(indexer.getIndex().findTime(5000, 7999), counter));
+}
+// A partly written record is ignored and replaced by the next update:
+
+void indextest::torn()
+{
+    {
+        VX2750EventFile file(m_data.data(), 5000);
+        VX2750TimeIndexer indexer(m_filename.c_str(), 2048);
+        indexer.update(file);
+    }
+    int fd = open(m_filename.c_str(), O_WRONLY | O_APPEND);
+    VX2750TimeIndex::RecordHeader header = {VX2750TimeIndex::BLOCK_RECORD, 64};
+    ASSERT(write(fd, &header, sizeof(header)) == sizeof(header));
+    ASSERT(write(fd, "partial", 7) == 7);
+    close(fd);
+
+    VX2750TimeIndex index(m_filename.c_str());
+    struct stat info;
+    stat(m_filename.c_str(), &info);
+    EQ(std::uint64_t(info.st_size) - 15, index.validBytes());
+
+    VX2750EventFile file(m_data.data(), m_data.size());
+    VX2750TimeIndexer indexer(m_filename.c_str());
+    indexer.update(file);
+    VX2750TimeIndex after(m_filename.c_str());
+    checkBlocks(after, m_data.size());
+}
+// Indices are checked against their files and each other:
+
+void indextest::mismatch()
+{
+    VX2750EventFile file(m_data.data(), m_data.size());
+    VX2750TimeIndexer indexer(m_filename.c_str(), 2048);
+    indexer.update(file);
+
+    VX2750EventFile shorter(m_data.data(), m_data.size()/2);
+    EXCEPTION(indexer.update(shorter), std::runtime_error);
+
+    // Only one indexer at a time:
+
+    EXCEPTION(VX2750TimeIndexer other(m_filename.c_str()), std::runtime_error);
+
+    // Not an index:
+
+    char name[] = "/tmp/indextestXXXXXX";
+    int fd = mkstemp(name);
+    ASSERT(write(fd, "This is not an index file", 25) == 25);
+    close(fd);
+    EXCEPTION(VX2750TimeIndex index(name), std::runtime_error);
+    EXCEPTION(VX2750TimeIndexer bad(name), std::runtime_error);
+    unlink(name);
+}
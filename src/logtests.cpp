@@ -0,0 +1,164 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  logtests.cpp
+ *  @brief: Tests of the asynchronous daqlog writer (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "NSCLDAQLog.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+namespace daqlog {
+    void reset();                     // For testing; not in the header.
+}
+
+class logtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(logtest);
+    CPPUNIT_TEST(async);
+    CPPUNIT_TEST(stop);
+    CPPUNIT_TEST(exitflush);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_filename;
+public:
+    void setUp() {
+        char name[] = "/tmp/logtestXXXXXX";
+        close(mkstemp(name));
+        m_filename = name;
+        daqlog::reset();
+        daqlog::setLogFile(m_filename);
+    }
+    void tearDown() {
+        daqlog::reset();
+        daqlog::setFlushPolicy(250, 64*1024);
+        unlink(m_filename.c_str());
+    }
+protected:
+    void async();
+    void stop();
+    void exitflush();
+private:
+    std::vector<std::string> readLines();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(logtest);
+
+std::vector<std::string>
+logtest::readLines()
+{
+    std::vector<std::string> result;
+    std::ifstream in(m_filename.c_str());
+    std::string line;
+    while (std::getline(in, line)) {
+        result.push_back(line);
+    }
+    return result;
+}
+
+// Messages from several threads are all written, in order per thread,
+// once flush returns even though the flush interval hasn't passed:
+
+void logtest::async()
+{
+    daqlog::setFlushPolicy(60000, 1024*1024);
+    daqlog::setAsynchronous(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 1000; i++) {
+                daqlog::info(std::to_string(t) + " " + std::to_string(i));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    daqlog::flush();
+
+    auto lines = readLines();
+    EQ(size_t(4000), lines.size());
+    int next[4] = {0, 0, 0, 0};
+    for (auto& line : lines) {
+        auto colon = line.rfind(" : ");
+        ASSERT(colon != std::string::npos);
+        int t, i;
+        ASSERT(sscanf(line.c_str() + colon + 3, "%d %d", &t, &i) == 2);
+        EQ(next[t], i);
+        next[t]++;
+    }
+    daqlog::setAsynchronous(false);
+}
+// Messages logged while asynchronous logging is being turned off are
+// neither lost nor left in the queue:
+
+void logtest::stop()
+{
+    daqlog::setFlushPolicy(60000, 1024*1024);
+    size_t expected = 0;
+    for (int pass = 0; pass < 200; pass++) {
+        daqlog::setAsynchronous(true);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([]() {
+                for (int i = 0; i < 50; i++) {
+                    daqlog::info("message");
+                }
+            });
+        }
+        daqlog::setAsynchronous(false);     // While they're logging.
+        for (auto& t : threads) t.join();
+        expected += 4*50;
+        
+        // Anything left queued would only be written when the next
+        // pass restarts the writer:
+        
+        EQ(expected, readLines().size());
+    }
+}
+// Messages still queued when the program exits are written:
+
+void logtest::exitflush()
+{
+    std::cout.flush();                  // Or the child writes it again.
+    pid_t pid = fork();
+    if (pid == 0) {
+        daqlog::setFlushPolicy(60000, 1024*1024);
+        daqlog::setAsynchronous(true);
+        for (int i = 0; i < 100; i++) {
+            daqlog::warning("about to exit");
+        }
+        exit(0);                        // No flush.
+    }
+    int status;
+    EQ(pid, waitpid(pid, &status, 0));
+    ASSERT(WIFEXITED(status));
+    EQ(0, WEXITSTATUS(status));
+
+    auto lines = readLines();
+    EQ(size_t(100), lines.size());
+    ASSERT(lines.back().find("Warning : about to exit") != std::string::npos);
+}
@@ -0,0 +1,118 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  pooltests.cpp
+ *  @brief: Tests of the decoded event storage pool (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "VX2750DecodedEventPool.h"
+#include <cstdint>
+
+using namespace caen_nscldaq;
+
+class pooltest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(pooltest);
+    CPPUNIT_TEST(initial);
+    CPPUNIT_TEST(aligned);
+    CPPUNIT_TEST(noregrow);
+    CPPUNIT_TEST(grows);
+    CPPUNIT_TEST(hugepages);
+    CPPUNIT_TEST(roundup);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+    void tearDown() {}
+protected:
+    void initial();
+    void aligned();
+    void noregrow();
+    void grows();
+    void hugepages();
+    void roundup();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(pooltest);
+
+// Nothing is allocated until asked:
+
+void pooltest::initial()
+{
+    VX2750DecodedEventPool pool;
+    ASSERT(!pool.data());
+    EQ(size_t(0), pool.size());
+    ASSERT(!pool.hugePages());
+}
+// Storage is cache line aligned and zeroed:
+
+void pooltest::aligned()
+{
+    VX2750DecodedEventPool pool;
+    auto p = pool.reserve(1000);
+    ASSERT(p);
+    EQ(std::uintptr_t(0), reinterpret_cast<std::uintptr_t>(p) % VX2750DecodedEventPool::CACHE_LINE);
+    ASSERT(pool.size() >= 1000);
+    for (int i =0; i < 1000; i++) {
+        EQ(std::uint8_t(0), p[i]);
+    }
+}
+// Reserving no more than we have does not reallocate:
+
+void pooltest::noregrow()
+{
+    VX2750DecodedEventPool pool;
+    auto p = pool.reserve(4096);
+    EQ(p, pool.reserve(4096));
+    EQ(p, pool.reserve(100));
+}
+// Reserving more gives at least that much:
+
+void pooltest::grows()
+{
+    VX2750DecodedEventPool pool;
+    pool.reserve(100);
+    pool.reserve(100000);
+    ASSERT(pool.size() >= 100000);
+    pool.release();
+    ASSERT(!pool.data());
+    EQ(size_t(0), pool.size());
+}
+// Huge page pools are mapped in huge page multiples:
+
+void pooltest::hugepages()
+{
+    VX2750DecodedEventPool pool(true);
+    auto p = pool.reserve(100);
+    ASSERT(p);
+    if (pool.isMapped()) {
+        EQ(VX2750DecodedEventPool::HUGE_PAGE, pool.size());
+    }
+    pool.setHugePages(false);            // Releases storage.
+    ASSERT(!pool.data());
+    pool.reserve(100);
+    ASSERT(!pool.isMapped());
+}
+
+void pooltest::roundup()
+{
+    EQ(size_t(0), VX2750DecodedEventPool::roundUp(0));
+    EQ(size_t(64), VX2750DecodedEventPool::roundUp(1));
+    EQ(size_t(64), VX2750DecodedEventPool::roundUp(64));
+    EQ(size_t(128), VX2750DecodedEventPool::roundUp(65));
+}
@@ -0,0 +1,168 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  prescalertests.cpp
+ *  @brief: Tests of the rate adaptive trace prescaler (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "VX2750TracePrescaler.h"
+#include <cstdint>
+#include <stdexcept>
+
+using namespace caen_nscldaq;
+
+static const std::uint64_t SECOND(1000000000);
+
+class prescalertest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(prescalertest);
+    CPPUNIT_TEST(disabled);
+    CPPUNIT_TEST(badwindow);
+    CPPUNIT_TEST(underbudget);
+    CPPUNIT_TEST(overbudget_prescale);
+    CPPUNIT_TEST(overbudget_drop);
+    CPPUNIT_TEST(recovers);
+    CPPUNIT_TEST(fairshare);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+    void tearDown() {}
+protected:
+    void disabled();
+    void badwindow();
+    void underbudget();
+    void overbudget_prescale();
+    void overbudget_drop();
+    void recovers();
+    void fairshare();
+private:
+    void hits(
+        VX2750TracePrescaler& p, unsigned ch, unsigned n,
+        std::uint64_t start, std::uint64_t spacing
+    );
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(prescalertest);
+
+// Feed n hits in a channel spaced by spacing ns from start.
+
+void
+prescalertest::hits(
+    VX2750TracePrescaler& p, unsigned ch, unsigned n,
+    std::uint64_t start, std::uint64_t spacing
+)
+{
+    for (int i =0; i < n; i++) {
+        p.decide(ch, start + i*spacing);
+    }
+}
+
+// a zero budget disables everything.
+
+void prescalertest::disabled()
+{
+    VX2750TracePrescaler p(4, 0, 10);
+    p.setTraceBytes(0, 1000);
+    ASSERT(!p.enabled());
+    for (int i =0; i < 10000; i++) {
+        EQ(VX2750TracePrescaler::Keep, p.decide(0, i));
+    }
+}
+// Zero length windows are not allowed:
+
+void prescalertest::badwindow()
+{
+    EXCEPTION(VX2750TracePrescaler(4, 100, 10, 0), std::invalid_argument);
+}
+// 100Hz * 1000 bytes is well under 1Mbyte/sec.
+
+void prescalertest::underbudget()
+{
+    VX2750TracePrescaler p(4, 1000000, 10);
+    p.setTraceBytes(0, 1000);
+    hits(p, 0, 300, 0, SECOND/100);
+    ASSERT(!p.isThrottled(0));
+    EQ(100.0, p.getRate(0));
+    EQ(std::uint64_t(0), p.throttledHits());
+}
+// 10KHz * 1000 bytes = 10Mb/sec - over a 1Mbyte/sec budget.
+// After the first window, 1 in 10 traces are kept:
+
+void prescalertest::overbudget_prescale()
+{
+    VX2750TracePrescaler p(4, 1000000, 10);
+    p.setTraceBytes(0, 1000);
+    hits(p, 0, 10000, 0, SECOND/10000);       // First window - learn rate
+    ASSERT(!p.isThrottled(0));
+
+    unsigned kept(0), dropped(0);
+    for (int i = 0; i < 1000; i++) {
+        auto d = p.decide(0, SECOND + i*(SECOND/10000));
+        if (d == VX2750TracePrescaler::Prescaled) kept++;
+        if (d == VX2750TracePrescaler::Suppressed) dropped++;
+        ASSERT(d != VX2750TracePrescaler::Keep);
+    }
+    ASSERT(p.isThrottled(0));
+    EQ(unsigned(100), kept);
+    EQ(unsigned(900), dropped);
+}
+// prescale of zero drops all traces:
+
+void prescalertest::overbudget_drop()
+{
+    VX2750TracePrescaler p(4, 1000000, 0);
+    p.setTraceBytes(0, 1000);
+    hits(p, 0, 10000, 0, SECOND/10000);
+    for (int i = 0; i < 100; i++) {
+        EQ(
+            VX2750TracePrescaler::Suppressed,
+            p.decide(0, SECOND + i*(SECOND/10000))
+        );
+    }
+}
+// When the rate falls the throttle is lifted at the next window:
+
+void prescalertest::recovers()
+{
+    VX2750TracePrescaler p(4, 1000000, 10);
+    p.setTraceBytes(0, 1000);
+    hits(p, 0, 10000, 0, SECOND/10000);
+    hits(p, 0, 10, SECOND, SECOND/10);         // Throttled 10Hz window.
+    ASSERT(p.isThrottled(0));
+    EQ(VX2750TracePrescaler::Keep, p.decide(0, 2*SECOND));
+    ASSERT(!p.isThrottled(0));
+}
+// Only channels over their share of the budget get throttled:
+
+void prescalertest::fairshare()
+{
+    VX2750TracePrescaler p(4, 1000000, 10);
+    p.setTraceBytes(0, 1000);
+    p.setTraceBytes(1, 1000);
+
+    // channel 0 at 10KHz, channel 1 at 100Hz.
+
+    for (int i = 0; i < 10000; i++) {
+        p.decide(0, i*(SECOND/10000));
+        if ((i % 100) == 0) p.decide(1, i*(SECOND/10000));
+    }
+    p.decide(1, SECOND);
+    ASSERT(p.isThrottled(0));
+    ASSERT(!p.isThrottled(1));
+}
@@ -0,0 +1,323 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  sorttests.cpp
+ *  @brief: Tests of the external hit sorter (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "OfflineTestData.h"
+#include "VX2750OfflineDecoder.h"
+#include "VX2750ExternalSorter.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace caen_offline;
+using namespace offline_test;
+
+// The hits in sorted output:
+
+class SortedHits : public VX2750HitVisitor {
+public:
+    struct Hit {
+        std::uint64_t s_timestamp;
+        std::uint32_t s_sid;
+        std::uint16_t s_energy;
+    };
+    std::vector<Hit> m_hits;
+    virtual void hit(const VX2750Hit& hit) {
+        Hit h = {hit.s_timestamp, hit.s_sourceId, hit.s_energy};
+        m_hits.push_back(h);
+    }
+};
+
+class sorttest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(sorttest);
+    CPPUNIT_TEST(order);
+    CPPUNIT_TEST(parallel);
+    CPPUNIT_TEST(stable);
+    CPPUNIT_TEST(statechanges);
+    CPPUNIT_TEST(builtinput);
+    CPPUNIT_TEST(segments);
+    CPPUNIT_TEST(notfile);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_filename;
+public:
+    void setUp() {
+        char name[] = "/tmp/sorttestXXXXXX";
+        close(mkstemp(name));
+        m_filename = name;
+    }
+    void tearDown() {
+        unlink(m_filename.c_str());
+    }
+protected:
+    void order();
+    void parallel();
+    void stable();
+    void statechanges();
+    void builtinput();
+    void segments();
+    void notfile();
+private:
+    Bytes segment(std::uint32_t sid, unsigned first, unsigned n);
+    Bytes sort(
+        VX2750ExternalSorter& sorter, unsigned threads,
+        VX2750ExternalSorter::Statistics* pStats = nullptr
+    );
+    void  decode(const Bytes& data, SortedHits& hits);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(sorttest);
+
+// Hits first..first+n-1 of a run: hit i is at about i*10 ns but jittered
+// by up to 500 ns so the segment is only roughly in order.  Energy is i.
+
+Bytes sorttest::segment(std::uint32_t sid, unsigned first, unsigned n)
+{
+    Bytes data;
+    for (unsigned i = first; i < first + n; i++) {
+        std::uint64_t t = 1000 + i*10 + (i*7919) % 500;
+        if (i % 3 == 0) t -= (i*104729) % 1000;
+        append(data, item(30, hit("adc", i % 16, t, i), sid, t));
+    }
+    return data;
+}
+// Sort into the temp file and read it back:
+
+Bytes sorttest::sort(
+    VX2750ExternalSorter& sorter, unsigned threads,
+    VX2750ExternalSorter::Statistics* pStats
+)
+{
+    int fd = open(m_filename.c_str(), O_RDWR);
+    auto stats = sorter.sort(fd, threads);
+    close(fd);
+    if (pStats) *pStats = stats;
+
+    struct stat info;
+    stat(m_filename.c_str(), &info);
+    EQ(std::uint64_t(info.st_size), stats.s_bytes);
+    Bytes result(info.st_size);
+    fd = open(m_filename.c_str(), O_RDONLY);
+    ASSERT(read(fd, result.data(), result.size()) == ssize_t(result.size()));
+    close(fd);
+    return result;
+}
+void sorttest::decode(const Bytes& data, SortedHits& hits)
+{
+    VX2750EventFile file(data.data(), data.size());
+    VX2750OfflineDecoder decoder(file);
+    auto stats = decoder.decode(file.chunks(1)[0], hits);
+    EQ(std::uint64_t(0), stats.s_errors);
+    EQ(stats.s_physicsItems, stats.s_hits);         // A hit per item.
+}
+
+// Segments that overlap in time are merged into one ordered stream even
+// when memory only holds a few hits at a time:
+
+void sorttest::order()
+{
+    Bytes a = segment(1, 0, 3000);
+    Bytes b = segment(2, 2900, 3000);
+    VX2750EventFile fa(a.data(), a.size());
+    VX2750EventFile fb(b.data(), b.size());
+    VX2750ExternalSorter sorter("/tmp", 1);            // Minimum size runs.
+    sorter.addFile(fa);
+    sorter.addFile(fb);
+
+    VX2750ExternalSorter::Statistics stats;
+    Bytes data = sort(sorter, 1, &stats);
+    EQ(std::uint64_t(6000), stats.s_hits);
+    EQ(std::uint64_t(6000), stats.s_input.s_hits);
+    ASSERT(stats.s_unsorted > 0);
+    EQ(std::uint64_t(6), stats.s_runs);                // 1024 hits a run.
+    EQ(std::uint64_t(a.size() + b.size()), stats.s_bytes);
+
+    SortedHits hits;
+    decode(data, hits);
+    EQ(size_t(6000), hits.m_hits.size());
+    unsigned fromB = 0;
+    for (std::size_t i = 0; i < hits.m_hits.size(); i++) {
+        if (i) ASSERT(hits.m_hits[i-1].s_timestamp <= hits.m_hits[i].s_timestamp);
+        if (hits.m_hits[i].s_sid == 2) fromB++;
+    }
+    EQ(3000U, fromB);
+
+    // Each item's body header has its hit's timestamp:
+
+    VX2750EventFile out(data.data(), data.size());
+    std::uint64_t offset = out.nextItem(out.nextItem(0));
+    EQ(hits.m_hits[2].s_timestamp, VX2750ExternalSorter::itemTimestamp(data.data() + offset));
+}
+// Parallel run generation and merging give the same output:
+
+void sorttest::parallel()
+{
+    std::vector<Bytes> segments = {segment(1, 0, 20000), segment(1, 19000, 20000)};
+    std::vector<VX2750EventFile*> files;
+    for (auto& s : segments) files.push_back(new VX2750EventFile(s.data(), s.size()));
+
+    VX2750ExternalSorter serialSorter("/tmp", 1024*1024);
+    VX2750ExternalSorter parallelSorter("/tmp", 1);
+    for (auto f : files) {
+        serialSorter.addFile(*f);
+        parallelSorter.addFile(*f);
+    }
+    VX2750ExternalSorter::Statistics serial, parallel;
+    Bytes one = sort(serialSorter, 1, &serial);
+    Bytes many = sort(parallelSorter, 4, &parallel);
+    EQ(std::uint64_t(1), serial.s_partitions);
+    EQ(std::uint64_t(2), serial.s_runs);               // One per file.
+    ASSERT(parallel.s_partitions > 4);
+    ASSERT(parallel.s_runs > 8);
+    EQ(std::uint64_t(40000), parallel.s_hits);
+    ASSERT(one == many);
+
+    for (auto f : files) delete f;
+}
+// Hits with the same timestamp stay in input order:
+
+void sorttest::stable()
+{
+    Bytes a, b;
+    for (unsigned i = 0; i < 2000; i++) {
+        std::uint64_t t = 100*(i % 10);
+        append(a, item(30, hit("adc", 0, t, i), 1, t));
+        append(b, item(30, hit("adc", 0, t, 10000 + i), 2, t));
+    }
+    VX2750EventFile fa(a.data(), a.size());
+    VX2750EventFile fb(b.data(), b.size());
+    VX2750ExternalSorter sorter("/tmp", 1);
+    sorter.addFile(fa);
+    sorter.addFile(fb);
+
+    SortedHits hits;
+    decode(sort(sorter, 3), hits);
+    EQ(size_t(4000), hits.m_hits.size());
+    for (std::size_t i = 1; i < hits.m_hits.size(); i++) {
+        auto& prior(hits.m_hits[i-1]);
+        auto& h(hits.m_hits[i]);
+        ASSERT(prior.s_timestamp <= h.s_timestamp);
+        if (prior.s_timestamp == h.s_timestamp) ASSERT(prior.s_energy < h.s_energy);
+    }
+}
+// Begin runs lead, end runs trail and hits without a source id keep none:
+
+void sorttest::statechanges()
+{
+    Bytes data = item(1, Bytes(16, 1));
+    append(data, item(30, hit("adc", 0, 200, 0), 1, 200));
+    append(data, item(30, hit("adc", 0, 150, 1)));      // No body header.
+    append(data, item(20, Bytes(8, 0)));                // Dropped.
+    append(data, item(2, Bytes(16, 2)));
+    VX2750EventFile file(data.data(), data.size());
+    VX2750ExternalSorter sorter;
+    sorter.addFile(file);
+
+    Bytes out = sort(sorter, 1);
+    VX2750EventFile sorted(out.data(), out.size());
+    std::vector<std::uint32_t> types;
+    for (std::uint64_t offset = 0; offset < out.size(); offset = sorted.nextItem(offset)) {
+        types.push_back(reinterpret_cast<const std::uint32_t*>(out.data() + offset)[1]);
+    }
+    std::vector<std::uint32_t> expected = {1, 30, 30, 2};
+    ASSERT(expected == types);
+
+    SortedHits hits;
+    decode(out, hits);
+    EQ(std::uint64_t(150), hits.m_hits[0].s_timestamp);
+    EQ(VX2750Hit::NO_SOURCE, hits.m_hits[0].s_sid);
+    EQ(std::uint32_t(1), hits.m_hits[1].s_sid);
+}
+// Event built input comes out as a sorted stream of hits:
+
+void sorttest::builtinput()
+{
+    Bytes data;
+    for (std::uint64_t i = 0; i < 100; i++) {
+        std::vector<Bytes> frags = {
+            fragment(1, i*1000 + 60, hit("adc1", 0, i*1000 + 60, i)),
+            fragment(2, i*1000, hit("adc2", 0, i*1000, i))
+        };
+        append(data, item(30, built(frags), 0, i*1000));
+    }
+    VX2750EventFile file(data.data(), data.size());
+    VX2750ExternalSorter sorter;
+    sorter.addFile(file);
+    VX2750ExternalSorter::Statistics stats;
+    Bytes out = sort(sorter, 2, &stats);
+    EQ(std::uint64_t(100), stats.s_unsorted);
+
+    SortedHits hits;
+    decode(out, hits);
+    EQ(size_t(200), hits.m_hits.size());
+    for (std::size_t i = 0; i < 200; i++) {
+        EQ(std::uint32_t(i % 2 ? 1 : 2), hits.m_hits[i].s_sid);
+        EQ(std::uint64_t((i/2)*1000 + (i % 2)*60), hits.m_hits[i].s_timestamp);
+    }
+}
+// The segments of a run are found from the first one:
+
+void sorttest::segments()
+{
+    char dir[] = "/tmp/sorttestXXXXXX";
+    ASSERT(mkdtemp(dir));
+    std::string base = std::string(dir) + "/run-0007-";
+    std::vector<std::string> names = {base + "00.evt", base + "01.evt", base + "02.evt"};
+    for (auto& n : names) close(creat(n.c_str(), 0644));
+    std::string other = std::string(dir) + "/run-0007-04.evt";      // Not contiguous.
+    close(creat(other.c_str(), 0644));
+
+    ASSERT(names == VX2750ExternalSorter::segments(names[0].c_str()));
+    std::vector<std::string> one = {names[1]};
+    ASSERT(one == VX2750ExternalSorter::segments(names[1].c_str()));
+
+    for (auto& n : names) unlink(n.c_str());
+    unlink(other.c_str());
+    rmdir(dir);
+}
+// Output must be a regular file so partitions can be written in place:
+
+void sorttest::notfile()
+{
+    Bytes data = segment(1, 0, 10);
+    VX2750EventFile file(data.data(), data.size());
+    VX2750ExternalSorter sorter;
+    sorter.addFile(file);
+
+    int fds[2];
+    ASSERT(pipe(fds) == 0);
+    EXCEPTION(sorter.sort(fds[1], 1), std::invalid_argument);
+    close(fds[0]);
+    close(fds[1]);
+
+    VX2750ExternalSorter nowhere("/nonexistent/directory");
+    nowhere.addFile(file);
+    int fd = open(m_filename.c_str(), O_RDWR);
+    EXCEPTION(nowhere.sort(fd, 1), std::system_error);
+    close(fd);
+}
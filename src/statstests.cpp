@@ -0,0 +1,240 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  statstests.cpp
+ *  @brief: Tests of the readout statistics (no hardware needed).
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "VX2750ReadoutStatistics.h"
+#include <cstdint>
+
+using namespace caen_nscldaq;
+
+class statstest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(statstest);
+    CPPUNIT_TEST(smallvalues);
+    CPPUNIT_TEST(channels);
+    CPPUNIT_TEST(overflow);
+    CPPUNIT_TEST(percentiles);
+    CPPUNIT_TEST(empty);
+    CPPUNIT_TEST(interval);
+    CPPUNIT_TEST(module);
+    CPPUNIT_TEST(resetinterval);
+    CPPUNIT_TEST(registry);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+    void tearDown() {}
+protected:
+    void smallvalues();
+    void channels();
+    void overflow();
+    void percentiles();
+    void empty();
+    void interval();
+    void module();
+    void resetinterval();
+    void registry();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(statstest);
+
+// Values below 16 get a channel each:
+
+void statstest::smallvalues()
+{
+    for (unsigned i = 0; i < VX2750LatencyHistogram::SUB_COUNT; i++) {
+        EQ(i, VX2750LatencyHistogram::channel(i));
+        EQ(std::uint64_t(i), VX2750LatencyHistogram::lowEdge(i));
+        EQ(std::uint64_t(i), VX2750LatencyHistogram::highEdge(i));
+    }
+}
+// Every value lands in a channel whose edges bracket it and which is no
+// wider than 1/16 of its low edge:
+
+void statstest::channels()
+{
+    for (std::uint64_t v = 1; v < (std::uint64_t(1) << 36); v = v*3 + 7) {
+        unsigned c = VX2750LatencyHistogram::channel(v);
+        ASSERT(c < VX2750LatencyHistogram::CHANNELS);
+        ASSERT(VX2750LatencyHistogram::lowEdge(c) <= v);
+        ASSERT(VX2750LatencyHistogram::highEdge(c) >= v);
+        std::uint64_t width =
+            VX2750LatencyHistogram::highEdge(c) - VX2750LatencyHistogram::lowEdge(c) + 1;
+        ASSERT(width*16 <= VX2750LatencyHistogram::lowEdge(c) || width == 1);
+    }
+    // Channels are contiguous:
+
+    for (unsigned c = 0; c < VX2750LatencyHistogram::CHANNELS - 1; c++) {
+        EQ(
+            VX2750LatencyHistogram::highEdge(c) + 1,
+            VX2750LatencyHistogram::lowEdge(c + 1)
+        );
+    }
+}
+// Huge values land in the last channel:
+
+void statstest::overflow()
+{
+    EQ(
+        VX2750LatencyHistogram::CHANNELS - 1,
+        VX2750LatencyHistogram::channel(~std::uint64_t(0))
+    );
+    VX2750LatencyHistogram h;
+    h.record(~std::uint64_t(0));
+    EQ(std::uint64_t(1), h.snapshot().s_count);
+}
+// Percentiles are right to within a channel width:
+
+void statstest::percentiles()
+{
+    VX2750LatencyHistogram h;
+    for (int i = 1; i <= 1000; i++) {
+        h.record(i*100);                 // 100ns .. 100us.
+    }
+    auto s = h.snapshot();
+    EQ(std::uint64_t(1000), s.s_count);
+    EQ(std::uint64_t(50050), s.mean());
+
+    std::uint64_t p50 = s.percentile(50.0);
+    ASSERT(p50 >= 50000 && p50 <= 50000 + 50000/16);
+    std::uint64_t p99 = s.percentile(99.0);
+    ASSERT(p99 >= 99000 && p99 <= 99000 + 99000/16);
+    std::uint64_t max = s.max();
+    ASSERT(max >= 100000 && max <= 100000 + 100000/16);
+    EQ(VX2750LatencyHistogram::highEdge(VX2750LatencyHistogram::channel(100)),
+       s.percentile(0.0));
+}
+// An empty histogram gives zeroes:
+
+void statstest::empty()
+{
+    VX2750LatencyHistogram h;
+    auto s = h.snapshot();
+    EQ(std::uint64_t(0), s.s_count);
+    EQ(std::uint64_t(0), s.mean());
+    EQ(std::uint64_t(0), s.percentile(50.0));
+    EQ(std::uint64_t(0), s.max());
+}
+// The difference of snapshots is the histogram of the interval:
+
+void statstest::interval()
+{
+    VX2750LatencyHistogram h;
+    for (int i = 0; i < 100; i++) h.record(1000000);   // 1ms.
+    auto before = h.snapshot();
+    for (int i = 0; i < 10; i++) h.record(10);
+    auto diff = h.snapshot() - before;
+
+    EQ(std::uint64_t(10), diff.s_count);
+    EQ(std::uint64_t(10), diff.mean());
+    EQ(std::uint64_t(10), diff.max());
+
+    h.reset();
+    EQ(std::uint64_t(0), h.snapshot().s_count);
+}
+// Module statistics count the stages:
+
+void statstest::module()
+{
+    VX2750ModuleStatistics m;
+    m.poll(100, false);
+    m.poll(200, true);
+    m.hit(1000, 300, 64);
+    m.timeouts(0);
+    m.timeouts(2);
+
+    auto s = m.snapshot();
+    EQ(std::uint64_t(2), s.s_polls);
+    EQ(std::uint64_t(1), s.s_triggers);
+    EQ(std::uint64_t(1), s.s_hits);
+    EQ(std::uint64_t(64), s.s_bytes);
+    EQ(std::uint64_t(2), s.s_timeouts);
+    EQ(std::uint64_t(2), s.s_latencies[VX2750ModuleStatistics::Poll].s_count);
+    EQ(std::uint64_t(1000), s.s_latencies[VX2750ModuleStatistics::Read].s_sum);
+    EQ(std::uint64_t(300), s.s_latencies[VX2750ModuleStatistics::Format].s_sum);
+
+    m.hit(1000, 300, 64);
+    auto d = m.snapshot() - s;
+    EQ(std::uint64_t(0), d.s_polls);
+    EQ(std::uint64_t(1), d.s_hits);
+    EQ(std::uint64_t(64), d.s_bytes);
+
+    m.reset();
+    EQ(std::uint64_t(0), m.snapshot().s_hits);
+    EQ(std::string("format"), std::string(VX2750ModuleStatistics::stageName(VX2750ModuleStatistics::Format)));
+}
+// An interval that spans a reset starts at the reset rather than wrapping:
+
+void statstest::resetinterval()
+{
+    VX2750ModuleStatistics m;
+    for (int i = 0; i < 10; i++) m.hit(1000, 300, 64);
+    auto prior = m.snapshot();
+    for (int i = 0; i < 5; i++) m.hit(1000, 300, 64);
+    auto d = m.interval(prior);
+    EQ(std::uint64_t(5), d.s_hits);
+    EQ(std::uint64_t(15), prior.s_hits);
+
+    m.reset();                                    // Between two reads.
+    m.hit(2000, 300, 32);
+    m.poll(100, true);
+    d = m.interval(prior);
+    EQ(std::uint64_t(1), d.s_hits);
+    EQ(std::uint64_t(32), d.s_bytes);
+    EQ(std::uint64_t(1), d.s_polls);
+    EQ(std::uint64_t(1), d.s_latencies[VX2750ModuleStatistics::Read].s_count);
+    EQ(std::uint64_t(2000), d.s_latencies[VX2750ModuleStatistics::Read].s_sum);
+
+    // Even without the generation, counts that went down aren't wrapped:
+
+    for (int i = 0; i < 3; i++) m.hit(1000, 300, 64);
+    auto later = m.snapshot();
+    m.reset();
+    m.hit(1000, 300, 64);
+    auto wrapped = m.snapshot() - later;
+    EQ(std::uint64_t(1), wrapped.s_hits);
+    EQ(std::uint64_t(64), wrapped.s_bytes);
+    EQ(std::uint64_t(1), wrapped.s_latencies[VX2750ModuleStatistics::Format].s_count);
+
+    d = m.interval(prior);
+    EQ(std::uint64_t(1), d.s_hits);
+}
+// Module statistics are found by name and persist:
+
+void statstest::registry()
+{
+    auto& stats = VX2750ReadoutStatistics::getInstance();
+    ASSERT(!stats.findModule("statstest-nosuch"));
+
+    VX2750ModuleStatistics& m = stats.getModule("statstest-module");
+    EQ(&m, &(stats.getModule("statstest-module")));
+    EQ(&m, stats.findModule("statstest-module"));
+
+    m.poll(10, true);
+    stats.reset();
+    EQ(std::uint64_t(0), m.snapshot().s_polls);
+
+    bool found = false;
+    for (auto& name : stats.listModules()) {
+        if (name == "statstest-module") found = true;
+    }
+    ASSERT(found);
+}
@@ -20,6 +20,8 @@
 #include <CTimedTrigger.h>
 #include <TclConfiguredReadout.h>
 #include <Dig2Device.h>
+#include <VX2750StatisticsCommand.h>
+#include <VX2750StatisticsScaler.h>
 /*
 /*
 ** This file is a skeleton for the production readout software for
@@ -144,6 +146,12 @@ Skeleton::SetupScalers(CExperiment* pExperiment)
 {
   CReadoutMain::SetupScalers(pExperiment);	// null trigger - no scalers.
 
+  // Periodically write the readout statistics of each module
+  // (rates and latencies) to the data stream as scalers:
+
+  auto pStatistics = new caen_nscldaq::VX2750StatisticsScaler;
+  pStatistics->addModule("adc1");
+  pExperiment->AddScalerModule(pStatistics);
 }
 /*!
    Add new Tcl Commands here.  See the CTCLObjectProcessor class.  You can create new
@@ -162,6 +170,10 @@ void
 Skeleton::addCommands(CTCLInterpreter* pInterp)
 {
   CReadoutMain::addCommands(pInterp); // Add standard commands.
+
+  // Lets you look at the readout statistics interactively:
+
+  new caen_nscldaq::VX2750StatisticsCommand(*pInterp, "vx2750stats");
 }
 
 /*!
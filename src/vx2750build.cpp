@@ -0,0 +1,170 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     vx2750build.cpp
+* @brief    Rebuild events from recorded VX2750 hits.
+* @author   Ron Fox
+*
+*/
+
+/**
+ *  Usage:
+ *     vx2750build -w window ?-j threads? ?-s sid? ?-p hits? outfile eventfile...
+ *
+ *  -w window  - coincidence window in ns.
+ *  -j threads - number of threads (default: hardware concurrency).
+ *  -s sid     - source id of the built events (default 0).
+ *  -p hits    - hits per time partition.
+ *
+ *  The hits in the event files (unbuilt or built) are merged by timestamp
+ *  and built into events written to outfile ("-" for stdout).  Event files
+ *  should be given in time order, e.g. the segments of a run in order.
+ */
+#include "VX2750OfflineEventBuilder.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <system_error>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+
+static void
+usage(std::ostream& o, const char* msg)
+{
+    o << msg << std::endl;
+    o << "Usage:\n";
+    o << "   vx2750build -w window ?-j threads? ?-s sid? ?-p hits? outfile eventfile...\n";
+    o << "Where:\n";
+    o << "   -w window  - Coincidence window in ns\n";
+    o << "   -j threads - Number of threads\n";
+    o << "   -s sid     - Source id of the built events (default 0)\n";
+    o << "   -p hits    - Hits per time partition (default "
+      << VX2750OfflineEventBuilder::DEFAULT_PARTITION_HITS << ")\n";
+    o << "   outfile    - Output event file (- for stdout)\n";
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    bool haveWindow = false;
+    std::uint64_t window = 0;
+    std::uint32_t sid = 0;
+    std::size_t   partitionHits = VX2750OfflineEventBuilder::DEFAULT_PARTITION_HITS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:j:s:p:")) != -1) {
+        char* pEnd;
+        switch (opt) {
+        case 'w':
+            window = strtoull(optarg, &pEnd, 0);
+            if (*pEnd || !*optarg) {
+                usage(std::cerr, "The window must be an integer number of ns");
+            }
+            haveWindow = true;
+            break;
+        case 'j':
+            threads = atoi(optarg);
+            if (threads == 0) {
+                usage(std::cerr, "The thread count must be a positive integer");
+            }
+            break;
+        case 's':
+            sid = strtoul(optarg, &pEnd, 0);
+            if (*pEnd || !*optarg) {
+                usage(std::cerr, "The source id must be an integer");
+            }
+            break;
+        case 'p':
+            partitionHits = atol(optarg);
+            if (partitionHits == 0) {
+                usage(std::cerr, "The partition size must be a positive integer");
+            }
+            break;
+        default:
+            usage(std::cerr, "Invalid option");
+        }
+    }
+    if (!haveWindow) {
+        usage(std::cerr, "A coincidence window must be given");
+    }
+    if (optind > argc - 2) {
+        usage(std::cerr, "An output file and at least one event file must be given");
+    }
+    std::string outName = argv[optind];
+    std::ostream& report(outName == "-" ? std::cerr : std::cout);
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        VX2750OfflineEventBuilder builder(window, sid);
+        std::vector<std::unique_ptr<VX2750EventFile>> files;
+        std::uint64_t inputBytes = 0;
+        for (int i = optind + 1; i < argc; i++) {
+            files.emplace_back(new VX2750EventFile(argv[i]));
+            auto stats = builder.addFile(*files.back(), threads);
+            inputBytes += stats.s_bytes;
+            if (stats.s_errors) {
+                std::cerr << stats.s_errors << " malformed ring items; first: "
+                    << stats.s_firstError << std::endl;
+            }
+        }
+        int fd = 1;
+        if (outName != "-") {
+            fd = open(outName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), outName);
+            }
+        }
+        auto stats = builder.build(fd, threads, partitionHits);
+        if (fd != 1 && close(fd)) {
+            throw std::system_error(errno, std::generic_category(), outName);
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        report << "Sources:        " << builder.getStreams().size() << std::endl;
+        report << "Hits:           " << stats.s_hits << std::endl;
+        report << "Events:         " << stats.s_events << std::endl;
+        if (stats.s_events) {
+            report << "Hits/event:     " << double(stats.s_hits)/stats.s_events
+                << " (max " << stats.s_maxFragments << ")" << std::endl;
+        }
+        report << "Out of order:   " << stats.s_unsorted << std::endl;
+        report << "No source id:   " << stats.s_noSource << " (dropped)" << std::endl;
+        report << "Partitions:     " << stats.s_partitions << std::endl;
+        report << "Bytes:          " << inputBytes << " in, " << stats.s_bytes
+            << " out" << std::endl;
+        report << "Seconds:        " << seconds << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << "vx2750build: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
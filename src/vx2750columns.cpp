@@ -0,0 +1,121 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     vx2750columns.cpp
+* @brief    Describe a columnar hit file.
+* @author   Ron Fox
+*
+*/
+
+/**
+ *  Usage:
+ *     vx2750columns ?-g? columnfile
+ *
+ *  Writes the file's schema, module dictionary and, for each column, its
+ *  total size and range over the file.  With -g the size and range of
+ *  each column in each row group are written as well.  Only the
+ *  directories are read; no column data are decoded.
+ */
+#include "VX2750ColumnReader.h"
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+
+static const char* codecs[] = {"plain", "varint", "delta", "rle"};
+static const char* types[]  = {"u8", "u16", "u32", "u64"};
+
+static void
+usage(std::ostream& o, const char* msg)
+{
+    o << msg << std::endl;
+    o << "Usage:\n";
+    o << "   vx2750columns ?-g? columnfile\n";
+    o << "Where:\n";
+    o << "   -g  - Describe each row group\n";
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+    bool perGroup = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "g")) != -1) {
+        switch (opt) {
+        case 'g':
+            perGroup = true;
+            break;
+        default:
+            usage(std::cerr, "Invalid option");
+        }
+    }
+    if (optind != argc - 1) {
+        usage(std::cerr, "Exactly one column file must be given");
+    }
+    try {
+        VX2750ColumnReader reader(argv[optind]);
+        auto& columns(reader.getColumns());
+
+        std::cout << "Rows:       " << reader.rows() << std::endl;
+        std::cout << "Row groups: " << reader.groups() << std::endl;
+        std::cout << "Modules:   ";
+        for (auto& m : reader.getModules()) std::cout << ' ' << m;
+        std::cout << std::endl;
+
+        std::cout << "Columns:\n";
+        for (std::size_t c = 0; c < columns.size(); c++) {
+            std::uint64_t bytes = 0, values = 0;
+            std::uint64_t min = ~std::uint64_t(0), max = 0;
+            for (std::size_t g = 0; g < reader.groups(); g++) {
+                auto& chunk(reader.columnChunk(g, c));
+                bytes  += chunk.s_bytes;
+                values += chunk.s_nValues;
+                if (chunk.s_nValues) {
+                    min = std::min(min, chunk.s_min);
+                    max = std::max(max, chunk.s_max);
+                }
+            }
+            if (values == 0) min = 0;
+            std::cout << "   " << columns[c].s_name << ' ' << types[columns[c].s_type]
+                << ' ' << codecs[columns[c].s_codec] << ": " << values << " values "
+                << bytes << " bytes [" << min << ", " << max << "]\n";
+        }
+        if (perGroup) {
+            for (std::size_t g = 0; g < reader.groups(); g++) {
+                auto& header(reader.groupHeader(g));
+                std::cout << "Group " << g << ": " << header.s_rows
+                    << " rows from event file offset " << header.s_firstItemOffset
+                    << std::endl;
+                for (std::size_t c = 0; c < columns.size(); c++) {
+                    auto& chunk(reader.columnChunk(g, c));
+                    std::cout << "   " << columns[c].s_name << ": " << chunk.s_bytes
+                        << " bytes [" << chunk.s_min << ", " << chunk.s_max << "]\n";
+                }
+            }
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "vx2750columns: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,307 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     vx2750decode.cpp
+* @brief    Decode the VX2750 hits in an event file.
+* @author   Ron Fox
+*
+*/
+
+/**
+ *  Usage:
+ *     vx2750decode ?-j threads? ?-d? ?-t from:to? ?-c module:channel? eventfile
+ *
+ *  -j threads - number of decoding threads (default: hardware concurrency).
+ *  -d         - dump each hit as a line of text (uses one thread so the
+ *               hits come out in file order).
+ *  -t from:to - only hits with timestamps (ns) in [from, to].
+ *  -c module:channel - only hits from that channel.
+ *
+ *  With -t or -c, the event file's index (see vx2750index) is used to
+ *  decode only the parts of the file that can have the hits selected.
+ *  Without an index the whole file is decoded.
+ *
+ *  Without -d, a summary of the file is written: ring items, hits,
+ *  hits per module, errors and the decoding rate.
+ */
+#include "VX2750OfflineDecoder.h"
+#include "VX2750TimeIndex.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <map>
+#include <string>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+
+/**
+ * @class SummaryVisitor
+ *    Counts the hits of each module.  The module name is compared with the
+ *    previous hit's first; that's almost always a match in event built
+ *    data with few modules so there's no per hit hashing.
+ */
+class SummaryVisitor : public VX2750HitVisitor
+{
+public:
+    struct Module {
+        std::string   s_name;
+        std::uint64_t s_hits;
+    };
+    std::vector<Module> m_modules;
+    unsigned            m_last;
+public:
+    SummaryVisitor() : m_last(0) {}
+    virtual void hit(const VX2750Hit& hit) {
+        if (m_last < m_modules.size() && m_modules[m_last].s_name == hit.s_moduleName) {
+            m_modules[m_last].s_hits++;
+            return;
+        }
+        for (m_last = 0; m_last < m_modules.size(); m_last++) {
+            if (m_modules[m_last].s_name == hit.s_moduleName) {
+                m_modules[m_last].s_hits++;
+                return;
+            }
+        }
+        Module m = {hit.s_moduleName, 1};
+        m_modules.push_back(m);
+    }
+};
+/**
+ * @class DumpVisitor
+ *    Write each hit as a line of text.
+ */
+class DumpVisitor : public VX2750HitVisitor
+{
+public:
+    virtual void hit(const VX2750Hit& hit) {
+        std::cout << hit.s_timestamp << ' ' << hit.s_moduleName << ' ';
+        if (hit.s_sourceId == VX2750Hit::NO_SOURCE) {
+            std::cout << '-';
+        } else {
+            std::cout << hit.s_sourceId;
+        }
+        std::cout << ' ' << hit.s_channel << ' ' << hit.s_energy
+            << ' ' << hit.s_fineTimestamp
+            << std::hex << " 0x" << hit.s_lowPriorityFlags
+            << " 0x" << hit.s_highPriorityFlags << " 0x" << hit.s_failFlags
+            << std::dec << ' ' << hit.s_analogProbes[0].s_nSamples << '\n';
+    }
+};
+
+/**
+ * @class FilterVisitor
+ *    Passes the hits in a time window and, optionally, from one channel on
+ *    to another visitor.
+ */
+class FilterVisitor : public VX2750HitVisitor
+{
+    VX2750HitVisitor& m_next;
+    std::uint64_t     m_from;
+    std::uint64_t     m_to;
+    std::string       m_module;             // Empty for any.
+    unsigned          m_channel;
+public:
+    FilterVisitor(
+        VX2750HitVisitor& next, std::uint64_t from, std::uint64_t to,
+        const std::string& module, unsigned channel
+    ) :
+        m_next(next), m_from(from), m_to(to), m_module(module), m_channel(channel)
+    {}
+    virtual void hit(const VX2750Hit& hit) {
+        if (hit.s_timestamp < m_from || hit.s_timestamp > m_to) return;
+        if (!m_module.empty() &&
+            (hit.s_channel != m_channel || m_module != hit.s_moduleName)) return;
+        m_next.hit(hit);
+    }
+};
+
+static void
+usage(std::ostream& o, const char* msg)
+{
+    o << msg << std::endl;
+    o << "Usage:\n";
+    o << "   vx2750decode ?-j threads? ?-d? ?-t from:to? ?-c module:channel? eventfile\n";
+    o << "Where:\n";
+    o << "   -j threads - Number of decoding threads\n";
+    o << "   -d         - Dump each hit (timestamp module sid channel energy\n";
+    o << "                fine-time lowflags highflags failflags trace-length)\n";
+    o << "   -t from:to - Only hits with timestamps (ns) in [from, to]\n";
+    o << "   -c module:channel - Only hits from that channel\n";
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * selectChunks
+ *    Choose the parts of the file to decode.  If hits are being selected
+ *    and the file has an index, only the blocks that can have those hits
+ *    and any part of the file past the index are decoded.
+ *  @return std::vector<VX2750EventFile::Chunk> - the chunks to decode.
+ */
+static std::vector<VX2750EventFile::Chunk>
+selectChunks(
+    const VX2750EventFile& file, unsigned threads, bool select,
+    std::uint64_t from, std::uint64_t to, const std::string& module, unsigned channel
+)
+{
+    if (!select) {
+        return file.chunks(threads);
+    }
+    std::string indexFile = VX2750TimeIndex::indexName(file.getFilename());
+    if (access(indexFile.c_str(), R_OK)) {
+        std::cerr << "No index " << indexFile << "; decoding the whole file\n";
+        return file.chunks(threads);
+    }
+    VX2750TimeIndex index(indexFile.c_str());
+    if (index.indexedBytes() > file.size()) {
+        std::cerr << indexFile << " is not an index of this file; decoding the whole file\n";
+        return file.chunks(threads);
+    }
+    auto result = module.empty() ?
+        index.findTime(from, to) : index.find(from, to, module, channel);
+    for (auto& c : file.chunks(1, index.indexedBytes())) {
+        result.push_back(c);                            // Not yet indexed.
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    bool dump = false;
+    bool select = false;
+    std::uint64_t from = 0;
+    std::uint64_t to = ~std::uint64_t(0);
+    std::string   module;
+    unsigned      channel = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:dt:c:")) != -1) {
+        switch (opt) {
+        case 'j':
+            threads = atoi(optarg);
+            if (threads == 0) {
+                usage(std::cerr, "The thread count must be a positive integer");
+            }
+            break;
+        case 'd':
+            dump = true;
+            break;
+        case 't':
+            {
+                char* pEnd;
+                from = strtoull(optarg, &pEnd, 0);
+                if (*pEnd != ':') usage(std::cerr, "The time window must be from:to");
+                to = strtoull(pEnd + 1, &pEnd, 0);
+                if (*pEnd || to < from) usage(std::cerr, "The time window must be from:to");
+                select = true;
+            }
+            break;
+        case 'c':
+            {
+                const char* pColon = strrchr(optarg, ':');
+                if (!pColon || pColon == optarg || !pColon[1]) {
+                    usage(std::cerr, "The channel must be module:channel");
+                }
+                module.assign(optarg, pColon - optarg);
+                channel = atoi(pColon + 1);
+                select = true;
+            }
+            break;
+        default:
+            usage(std::cerr, "Invalid option");
+        }
+    }
+    if (optind != argc - 1) {
+        usage(std::cerr, "Exactly one event file must be given");
+    }
+    if (dump) threads = 1;
+
+    try {
+        VX2750EventFile file(argv[optind]);
+        VX2750OfflineDecoder decoder(file);
+        VX2750OfflineDecoder::Statistics stats;
+
+        auto start = std::chrono::steady_clock::now();
+        auto chunks = selectChunks(file, threads, select, from, to, module, channel);
+        if (dump) {
+            DumpVisitor visitor;
+            FilterVisitor filter(visitor, from, to, module, channel);
+            std::vector<VX2750HitVisitor*> visitors = {&filter};
+            stats = decoder.decode(chunks, visitors);
+            std::cout.flush();
+        } else {
+            std::vector<SummaryVisitor> summaries(threads);
+            std::vector<FilterVisitor>  filters;
+            std::vector<VX2750HitVisitor*> visitors;
+            for (auto& s : summaries) {
+                filters.push_back(FilterVisitor(s, from, to, module, channel));
+            }
+            for (auto& f : filters) visitors.push_back(&f);
+            stats = decoder.decode(chunks, visitors);
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start
+            ).count();
+
+            std::map<std::string, std::uint64_t> modules;
+            for (auto& s : summaries) {
+                for (auto& m : s.m_modules) {
+                    modules[m.s_name] += m.s_hits;
+                }
+            }
+            std::cout << "File:           " << file.getFilename() << std::endl;
+            std::cout << "Bytes:          " << stats.s_bytes << " of " << file.size() << std::endl;
+            std::cout << "Ring items:     " << stats.s_items << std::endl;
+            std::cout << "Physics items:  " << stats.s_physicsItems << std::endl;
+            std::cout << "Hits:           " << stats.s_hits << std::endl;
+            if (select) {
+                std::uint64_t selected = 0;
+                for (auto& s : summaries) {
+                    for (auto& m : s.m_modules) selected += m.s_hits;
+                }
+                std::cout << "Selected hits:  " << selected << std::endl;
+            }
+            for (auto& m : modules) {
+                std::cout << "   " << m.first << ": " << m.second << std::endl;
+            }
+            std::cout << "Errors:         " << stats.s_errors << std::endl;
+            if (stats.s_errors) {
+                std::cout << "   First: " << stats.s_firstError << std::endl;
+            }
+            std::cout << "Threads:        " << threads << std::endl;
+            std::cout << "Seconds:        " << seconds << std::endl;
+            if (seconds > 0) {
+                std::cout << "MB/s:           " << stats.s_bytes/seconds/1.0e6 << std::endl;
+            }
+        }
+        if (stats.s_errors) {
+            std::cerr << stats.s_errors << " malformed ring items; first: "
+                << stats.s_firstError << std::endl;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "vx2750decode: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
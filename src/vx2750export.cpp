@@ -0,0 +1,126 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     vx2750export.cpp
+* @brief    Export the hits in an event file to a columnar hit file.
+* @author   Ron Fox
+*
+*/
+
+/**
+ *  Usage:
+ *     vx2750export ?-j threads? ?-t? ?-g rows? eventfile columnfile
+ *
+ *  -j threads - number of decoding threads (default: hardware concurrency).
+ *  -t         - include the trace columns.
+ *  -g rows    - rows per row group.
+ */
+#include "VX2750OfflineDecoder.h"
+#include "VX2750ColumnWriter.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+
+static void
+usage(std::ostream& o, const char* msg)
+{
+    o << msg << std::endl;
+    o << "Usage:\n";
+    o << "   vx2750export ?-j threads? ?-t? ?-g rows? eventfile columnfile\n";
+    o << "Where:\n";
+    o << "   -j threads - Number of decoding threads\n";
+    o << "   -t         - Include traces\n";
+    o << "   -g rows    - Rows per row group (default "
+      << VX2750ColumnExporter::DEFAULT_GROUP_ROWS << ")\n";
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    bool traces = false;
+    std::size_t groupRows = VX2750ColumnExporter::DEFAULT_GROUP_ROWS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:tg:")) != -1) {
+        switch (opt) {
+        case 'j':
+            threads = atoi(optarg);
+            if (threads == 0) {
+                usage(std::cerr, "The thread count must be a positive integer");
+            }
+            break;
+        case 't':
+            traces = true;
+            break;
+        case 'g':
+            groupRows = atol(optarg);
+            if (groupRows == 0) {
+                usage(std::cerr, "The rows per group must be a positive integer");
+            }
+            break;
+        default:
+            usage(std::cerr, "Invalid option");
+        }
+    }
+    if (optind != argc - 2) {
+        usage(std::cerr, "An event file and a column file must be given");
+    }
+
+    try {
+        VX2750EventFile file(argv[optind]);
+        VX2750OfflineDecoder decoder(file);
+        VX2750ColumnWriter writer(argv[optind + 1], traces);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<VX2750ColumnExporter>> exporters;
+        std::vector<VX2750HitVisitor*> visitors;
+        for (unsigned i = 0; i < threads; i++) {
+            exporters.emplace_back(new VX2750ColumnExporter(writer, groupRows));
+            visitors.push_back(exporters.back().get());
+        }
+        auto stats = decoder.decode(visitors);
+        for (auto& e : exporters) {
+            e->flush();
+        }
+        writer.close();
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        std::cout << stats.s_hits << " hits exported from " << stats.s_bytes
+            << " bytes in " << seconds << " seconds\n";
+        if (stats.s_errors) {
+            std::cerr << stats.s_errors << " malformed ring items; first: "
+                << stats.s_firstError << std::endl;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "vx2750export: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
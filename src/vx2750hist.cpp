@@ -0,0 +1,164 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     vx2750hist.cpp
+* @brief    Quick look energy histograms from event files.
+* @author   Ron Fox
+*
+*/
+
+/**
+ *  Usage:
+ *     vx2750hist ?-j threads? ?-b bins? ?-e bins? ?-t ns? ?-a? outfile eventfile...
+ *
+ *  -j threads - number of threads (default: hardware concurrency).
+ *  -b bins    - energy bins per channel spectrum (default 4096).
+ *  -e bins    - energy bins of the energy vs. time histograms (default 256).
+ *  -t ns      - time bin of the energy vs. time histograms (default 1 s).
+ *  -a         - write text rather than binary histograms.
+ *
+ *  The hits in the event files (unbuilt or built) are histogrammed by
+ *  module: energy by channel and energy vs. time.
+ */
+#include "VX2750EnergyHistogrammer.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+
+static void
+usage(std::ostream& o, const char* msg)
+{
+    o << msg << std::endl;
+    o << "Usage:\n";
+    o << "   vx2750hist ?-j threads? ?-b bins? ?-e bins? ?-t ns? ?-a? outfile eventfile...\n";
+    o << "Where:\n";
+    o << "   -j threads - Number of threads\n";
+    o << "   -b bins    - Energy bins per channel (default "
+      << VX2750EnergyHistogrammer::DEFAULT_ENERGY_BINS << ")\n";
+    o << "   -e bins    - Energy bins vs. time (default "
+      << VX2750EnergyHistogrammer::DEFAULT_TIME_ENERGY_BINS << ")\n";
+    o << "   -t ns      - Time bin in ns (default "
+      << VX2750EnergyHistogrammer::DEFAULT_TIME_BIN << ")\n";
+    o << "   -a         - Write text rather than binary histograms\n";
+    o << "Bin counts must be powers of 2 no larger than 65536\n";
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    unsigned energyBins = VX2750EnergyHistogrammer::DEFAULT_ENERGY_BINS;
+    unsigned timeEnergyBins = VX2750EnergyHistogrammer::DEFAULT_TIME_ENERGY_BINS;
+    std::uint64_t timeBin = VX2750EnergyHistogrammer::DEFAULT_TIME_BIN;
+    bool ascii = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:b:e:t:a")) != -1) {
+        char* pEnd;
+        switch (opt) {
+        case 'j':
+            threads = atoi(optarg);
+            if (threads == 0) {
+                usage(std::cerr, "The thread count must be a positive integer");
+            }
+            break;
+        case 'b':
+            energyBins = atoi(optarg);
+            break;
+        case 'e':
+            timeEnergyBins = atoi(optarg);
+            break;
+        case 't':
+            timeBin = strtoull(optarg, &pEnd, 0);
+            if (*pEnd || timeBin == 0) {
+                usage(std::cerr, "The time bin must be a positive integer number of ns");
+            }
+            break;
+        case 'a':
+            ascii = true;
+            break;
+        default:
+            usage(std::cerr, "Invalid option");
+        }
+    }
+    if (optind > argc - 2) {
+        usage(std::cerr, "An output file and at least one event file must be given");
+    }
+    const char* outName = argv[optind];
+
+    std::unique_ptr<VX2750EnergyHistogrammer> pHistogrammer;
+    try {
+        pHistogrammer.reset(new VX2750EnergyHistogrammer(energyBins, timeEnergyBins, timeBin));
+    }
+    catch (std::invalid_argument& e) {
+        usage(std::cerr, e.what());
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t bytes = 0;
+        for (int i = optind + 1; i < argc; i++) {
+            VX2750EventFile file(argv[i]);
+            auto stats = pHistogrammer->addFile(file, threads);
+            bytes += stats.s_bytes;
+            if (stats.s_errors) {
+                std::cerr << argv[i] << ": " << stats.s_errors
+                    << " malformed ring items; first: " << stats.s_firstError << std::endl;
+            }
+        }
+        if (ascii) {
+            pHistogrammer->writeAscii(outName);
+        } else {
+            pHistogrammer->writeBinary(outName);
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        for (auto& m : pHistogrammer->getModules()) {
+            std::cout << m.s_module << ": " << m.s_hits << " hits";
+            if (m.s_badChannels) {
+                std::cout << ", " << m.s_badChannels << " with bad channel numbers";
+            }
+            if (m.s_timeOverflows) {
+                std::cout << ", " << m.s_timeOverflows << " outside the time range of "
+                    << pHistogrammer->getMaxTimeBins() << " bins (use a larger -t)";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "Bytes:          " << bytes << std::endl;
+        std::cout << "Seconds:        " << seconds << std::endl;
+        if (seconds > 0) {
+            std::cout << "MB/s:           " << bytes/seconds/1.0e6 << std::endl;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "vx2750hist: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,140 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     vx2750index.cpp
+* @brief    Build or extend the time/channel index of an event file.
+* @author   Ron Fox
+*
+*/
+
+/**
+ *  Usage:
+ *     vx2750index ?-j threads? ?-b bytes? ?-f seconds? eventfile ?indexfile?
+ *
+ *  -j threads - number of decoding threads (default: hardware concurrency).
+ *  -b bytes   - target block size when creating an index.
+ *  -f seconds - follow: keep indexing as the event file grows, checking
+ *               every seconds, until killed.
+ *
+ *  indexfile defaults to eventfile.tidx.  If the index exists only the
+ *  part of the event file that's not yet indexed is indexed.
+ */
+#include "VX2750TimeIndexer.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+using namespace caen_offline;
+
+static void
+usage(std::ostream& o, const char* msg)
+{
+    o << msg << std::endl;
+    o << "Usage:\n";
+    o << "   vx2750index ?-j threads? ?-b bytes? ?-f seconds? eventfile ?indexfile?\n";
+    o << "Where:\n";
+    o << "   -j threads - Number of decoding threads\n";
+    o << "   -b bytes   - Target block size for a new index (default "
+      << VX2750TimeIndexer::DEFAULT_BLOCK_BYTES << ")\n";
+    o << "   -f seconds - Keep indexing as the event file grows\n";
+    o << "   indexfile defaults to eventfile" << VX2750TimeIndex::indexName("") << "\n";
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    std::uint32_t blockBytes = VX2750TimeIndexer::DEFAULT_BLOCK_BYTES;
+    unsigned follow = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:b:f:")) != -1) {
+        switch (opt) {
+        case 'j':
+            threads = atoi(optarg);
+            if (threads == 0) {
+                usage(std::cerr, "The thread count must be a positive integer");
+            }
+            break;
+        case 'b':
+            blockBytes = atol(optarg);
+            if (blockBytes == 0) {
+                usage(std::cerr, "The block size must be a positive integer");
+            }
+            break;
+        case 'f':
+            follow = atoi(optarg);
+            if (follow == 0) {
+                usage(std::cerr, "The follow interval must be a positive integer");
+            }
+            break;
+        default:
+            usage(std::cerr, "Invalid option");
+        }
+    }
+    if (optind != argc - 1 && optind != argc - 2) {
+        usage(std::cerr, "An event file and optionally an index file must be given");
+    }
+    std::string eventFile = argv[optind];
+    std::string indexFile = (optind == argc - 2) ?
+        argv[optind + 1] : VX2750TimeIndex::indexName(eventFile);
+
+    if (access(eventFile.c_str(), R_OK)) {
+        std::cerr << "vx2750index: " << eventFile << ": " << strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    try {
+        VX2750TimeIndexer indexer(indexFile.c_str(), blockBytes);
+        do {
+            // Map the file each time so that we see what's been added:
+
+            VX2750EventFile file(eventFile.c_str());
+            auto start = std::chrono::steady_clock::now();
+            auto stats = indexer.update(file, threads);
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start
+            ).count();
+
+            auto& index(indexer.getIndex());
+            if (stats.s_bytes || !follow) {
+                std::cout << "Indexed " << stats.s_bytes << " bytes (" << stats.s_hits
+                    << " hits) in " << seconds << " seconds; "
+                    << index.indexedBytes() << " of " << file.size()
+                    << " bytes in " << index.getBlocks().size() << " blocks\n";
+                std::cout.flush();
+            }
+            if (stats.s_errors) {
+                std::cerr << stats.s_errors << " malformed ring items; first: "
+                    << stats.s_firstError << std::endl;
+            }
+            if (follow) sleep(follow);
+        } while (follow);
+    }
+    catch (std::exception& e) {
+        std::cerr << "vx2750index: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
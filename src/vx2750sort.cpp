@@ -0,0 +1,157 @@
+/*
+*-------------------------------------------------------------
+
+ CAEN SpA
+ Via Vetraia, 11 - 55049 - Viareggio ITALY
+ +390594388398 - www.caen.it
+
+------------------------------------------------------------
+
+**************************************************************************
+* @note TERMS OF USE:
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License as published by the Free Software
+* Foundation. This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. The user relies on the
+* software, documentation and results solely at his own risk.
+*
+* @file     vx2750sort.cpp
+* @brief    Sort the hits of a run into timestamp order.
+* @author   Ron Fox
+*
+*/
+
+/**
+ *  Usage:
+ *     vx2750sort ?-j threads? ?-m megabytes? ?-T tmpdir? outfile eventfile...
+ *
+ *  -j threads   - number of threads (default: hardware concurrency).
+ *  -m megabytes - memory for hits being sorted (default 512).
+ *  -T tmpdir    - directory for sorted runs (default $TMPDIR or /tmp).
+ *
+ *  The hits in the event files (unbuilt or built) are written to outfile
+ *  in timestamp order, one hit per ring item.  If a single event file is
+ *  given and it's the first segment of a run (run-NNNN-00.evt) all of the
+ *  run's segments are sorted.
+ */
+#include "VX2750ExternalSorter.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <system_error>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace caen_offline;
+
+static void
+usage(std::ostream& o, const char* msg)
+{
+    o << msg << std::endl;
+    o << "Usage:\n";
+    o << "   vx2750sort ?-j threads? ?-m megabytes? ?-T tmpdir? outfile eventfile...\n";
+    o << "Where:\n";
+    o << "   -j threads   - Number of threads\n";
+    o << "   -m megabytes - Memory for hits being sorted (default "
+      << VX2750ExternalSorter::DEFAULT_MEMORY/(1024*1024) << ")\n";
+    o << "   -T tmpdir    - Directory for sorted runs (default $TMPDIR or /tmp)\n";
+    o << "   outfile      - Output event file\n";
+    o << "If only run-NNNN-00.evt is given, all segments of the run are sorted\n";
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    std::size_t memory = VX2750ExternalSorter::DEFAULT_MEMORY;
+    const char* tempDir = getenv("TMPDIR");
+    if (!tempDir || !*tempDir) tempDir = "/tmp";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:m:T:")) != -1) {
+        switch (opt) {
+        case 'j':
+            threads = atoi(optarg);
+            if (threads == 0) {
+                usage(std::cerr, "The thread count must be a positive integer");
+            }
+            break;
+        case 'm':
+            memory = std::size_t(atol(optarg))*1024*1024;
+            if (memory == 0) {
+                usage(std::cerr, "The memory size must be a positive integer");
+            }
+            break;
+        case 'T':
+            tempDir = optarg;
+            break;
+        default:
+            usage(std::cerr, "Invalid option");
+        }
+    }
+    if (optind > argc - 2) {
+        usage(std::cerr, "An output file and at least one event file must be given");
+    }
+    std::string outName = argv[optind];
+    std::vector<std::string> inNames;
+    if (optind == argc - 2) {
+        inNames = VX2750ExternalSorter::segments(argv[optind + 1]);
+    } else {
+        inNames.assign(argv + optind + 1, argv + argc);
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        VX2750ExternalSorter sorter(tempDir, memory);
+        std::vector<std::unique_ptr<VX2750EventFile>> files;
+        struct stat out, in;
+        bool outExists = stat(outName.c_str(), &out) == 0;
+        for (auto& name : inNames) {
+            if (outExists && stat(name.c_str(), &in) == 0 &&
+                in.st_dev == out.st_dev && in.st_ino == out.st_ino) {
+                throw std::invalid_argument(name + " is also the output file");
+            }
+            files.emplace_back(new VX2750EventFile(name.c_str()));
+            sorter.addFile(*files.back());
+        }
+        int fd = open(outName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0664);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), outName);
+        }
+        auto stats = sorter.sort(fd, threads);
+        if (close(fd)) {
+            throw std::system_error(errno, std::generic_category(), outName);
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        if (stats.s_input.s_errors) {
+            std::cerr << stats.s_input.s_errors << " malformed ring items; first: "
+                << stats.s_input.s_firstError << std::endl;
+        }
+        std::cout << "Segments:       " << inNames.size() << std::endl;
+        std::cout << "Hits:           " << stats.s_hits << std::endl;
+        std::cout << "Out of order:   " << stats.s_unsorted << std::endl;
+        std::cout << "Sorted runs:    " << stats.s_runs << std::endl;
+        std::cout << "Partitions:     " << stats.s_partitions << std::endl;
+        std::cout << "Bytes:          " << stats.s_input.s_bytes << " in, "
+            << stats.s_bytes << " out" << std::endl;
+        std::cout << "Seconds:        " << seconds << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << "vx2750sort: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}